@@ -2,4 +2,9 @@
     native <methods>;
     void crashCallback(...);
     void traceCallback(...);
+    java.lang.String profileCallback();
+}
+
+-keep interface xcrash.IArchiveProgress {
+    boolean onProgress(long, long);
 }
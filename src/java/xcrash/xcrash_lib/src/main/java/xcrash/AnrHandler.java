@@ -225,6 +225,16 @@ class AnrHandler {
                     }
                 }
             }
+
+            //section index of the log file
+            try {
+                TombstoneIndex.build(logFile.getAbsolutePath());
+            } catch (Exception e) {
+                XCrash.getLogger().e(Util.TAG, "AnrHandler build index failed", e);
+            }
+
+            //add the log file to the manifest
+            FileManager.getInstance().addManifestEntry(logFile, Util.anrCrashType, anrTime.getTime() * 1000);
         }
 
         //callback
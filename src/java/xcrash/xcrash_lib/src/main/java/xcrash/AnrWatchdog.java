@@ -0,0 +1,99 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Created by agent on 2026-10-17.
+package xcrash;
+
+import android.os.Debug;
+import android.os.Handler;
+import android.os.Looper;
+import android.os.SystemClock;
+
+class AnrWatchdog implements Runnable {
+
+    private static final AnrWatchdog instance = new AnrWatchdog();
+
+    private static final int CHECK_INTERVAL_MS_MIN = 50;
+
+    private Handler mainHandler;
+    private int timeoutMs;
+    private int checkIntervalMs;
+
+    //only changed by the main thread
+    private volatile long tick = 0;
+    private final Runnable ticker = new Runnable() {
+        @Override
+        public void run() {
+            tick++;
+        }
+    };
+
+    private AnrWatchdog() {
+    }
+
+    static AnrWatchdog getInstance() {
+        return instance;
+    }
+
+    void initialize(int timeoutMs) {
+        this.mainHandler = new Handler(Looper.getMainLooper());
+        this.timeoutMs = timeoutMs;
+        this.checkIntervalMs = Math.max(timeoutMs / 5, CHECK_INTERVAL_MS_MIN);
+
+        Thread thd = new Thread(this, "xcrash_anr_watchdog");
+        thd.setDaemon(true);
+        thd.start();
+    }
+
+    @Override
+    public void run() {
+        while (true) {
+            long lastTick = tick;
+            long postTime = SystemClock.uptimeMillis();
+            boolean reported = false;
+
+            //ping the main thread
+            mainHandler.post(ticker);
+
+            //wait for the pong, dump the trace once if the main thread is blocked too long
+            do {
+                try {
+                    Thread.sleep(checkIntervalMs);
+                } catch (InterruptedException ignored) {
+                    return;
+                }
+
+                long blockedMs = SystemClock.uptimeMillis() - postTime;
+                if (!reported && tick == lastTick && blockedMs >= timeoutMs) {
+                    reported = true;
+
+                    //the debugger pauses the main thread too
+                    if (Debug.isDebuggerConnected() || Debug.waitingForDebugger()) {
+                        continue;
+                    }
+
+                    XCrash.getLogger().w(Util.TAG, "AnrWatchdog: main thread blocked for " + blockedMs + " ms");
+                    NativeHandler.getInstance().notifyAnrWatchdog(blockedMs);
+                }
+            } while (tick == lastTick);
+        }
+    }
+}
@@ -25,12 +25,16 @@ package xcrash;
 import java.io.File;
 import java.io.FileOutputStream;
 import java.io.FilenameFilter;
+import java.io.IOException;
 import java.io.RandomAccessFile;
 import java.nio.MappedByteBuffer;
 import java.nio.channels.FileChannel;
+import java.util.ArrayList;
 import java.util.Arrays;
+import java.util.Collections;
 import java.util.Comparator;
 import java.util.Date;
+import java.util.List;
 import java.util.Locale;
 import java.util.Timer;
 import java.util.TimerTask;
@@ -41,15 +45,34 @@ class FileManager {
     private String placeholderPrefix = "placeholder";
     private String placeholderCleanSuffix = ".clean.xcrash";
     private String placeholderDirtySuffix = ".dirty.xcrash";
+    private String reservePrefix = "reserve";
+    private String reserveSuffix = ".reserve.xcrash";
+    private String reserveName = null;
     private String logDir = null;
     private int javaLogCountMax = 0;
     private int nativeLogCountMax = 0;
     private int anrLogCountMax = 0;
     private int traceLogCountMax = 1;
+    private int watchdogLogCountMax = 1;
+    private int profileLogCountMax = 1;
+    private int snapshotLogCountMax = 0;
     private int placeholderCountMax = 0;
     private int placeholderSizeKb = 0;
     private int delayMs = 0;
+    private long logSizeMax = 0;
+    private TombstoneManifest manifest = null;
+    private boolean nativeCompressDict = false;
+    private boolean nativeDumpMapDelta = false;
     private AtomicInteger unique = new AtomicInteger();
+    private static final String[] logSuffixes = {Util.javaLogSuffix, Util.nativeLogSuffix, Util.anrLogSuffix, Util.watchdogLogSuffix, Util.traceLogSuffix, Util.profileLogSuffix, Util.snapshotLogSuffix};
+    private static final int logTypeJava = 0;
+    private static final int logTypeNative = 1;
+    private static final int logTypeAnr = 2;
+    private static final int logTypeWatchdog = 3; //before the trace, they share the suffix
+    private static final int logTypeTrace = 4;
+    private static final int logTypeProfile = 5;
+    private static final int logTypeSnapshot = 6;
+    private static final int reserveCountMax = 8;
     private static final FileManager instance = new FileManager();
 
     private FileManager() {
@@ -59,66 +82,72 @@ class FileManager {
         return instance;
     }
 
-    void initialize(String logDir, int javaLogCountMax, int nativeLogCountMax, int anrLogCountMax, int placeholderCountMax, int placeholderSizeKb, int delayMs) {
+    void initialize(String logDir, int javaLogCountMax, int nativeLogCountMax, int anrLogCountMax, int snapshotLogCountMax, int placeholderCountMax, int placeholderSizeKb, int delayMs, int logSizeMaxKb, boolean nativeCompressDict, boolean nativeDumpMapDelta) {
         this.logDir = logDir;
         this.javaLogCountMax = javaLogCountMax;
         this.nativeLogCountMax = nativeLogCountMax;
         this.anrLogCountMax = anrLogCountMax;
+        this.snapshotLogCountMax = snapshotLogCountMax;
         this.placeholderCountMax = placeholderCountMax;
         this.placeholderSizeKb = placeholderSizeKb;
         this.delayMs = delayMs;
+        this.logSizeMax = logSizeMaxKb * 1024L;
+        this.manifest = new TombstoneManifest(new File(logDir));
+        this.nativeCompressDict = nativeCompressDict;
+        this.nativeDumpMapDelta = nativeDumpMapDelta;
 
         try {
             File dir = new File(logDir);
             if (!dir.exists() || !dir.isDirectory()) {
                 return;
             }
-            File[] files = dir.listFiles();
-            if (files == null) {
+            LogDirScan scan = scanLogDir(dir);
+            if (scan == null) {
                 return;
             }
 
-            int javaLogCount = 0;
-            int nativeLogCount = 0;
-            int anrLogCount = 0;
-            int traceLogCount = 0;
-            int placeholderCleanCount = 0;
-            int placeholderDirtyCount = 0;
-            for (final File file : files) {
-                if (file.isFile()) {
-                    String name = file.getName();
-                    if (name.startsWith(Util.logPrefix + "_")) {
-                        if (name.endsWith(Util.javaLogSuffix)) {
-                            javaLogCount++;
-                        } else if (name.endsWith(Util.nativeLogSuffix)) {
-                            nativeLogCount++;
-                        } else if (name.endsWith(Util.anrLogSuffix)) {
-                            anrLogCount++;
-                        } else if (name.endsWith(Util.traceLogSuffix)) {
-                            traceLogCount++;
-                        }
-                    } else if (name.startsWith(placeholderPrefix + "_")) {
-                        if (name.endsWith(placeholderCleanSuffix)) {
-                            placeholderCleanCount++;
-                        } else if (name.endsWith(placeholderDirtySuffix)) {
-                            placeholderDirtyCount++;
-                        }
-                    }
-                }
-            }
+            int javaLogCount = scan.logs.get(logTypeJava).size();
+            int nativeLogCount = scan.logs.get(logTypeNative).size();
+            int anrLogCount = scan.logs.get(logTypeAnr).size();
+            int traceLogCount = scan.logs.get(logTypeTrace).size();
+            int watchdogLogCount = scan.logs.get(logTypeWatchdog).size();
+            int profileLogCount = scan.logs.get(logTypeProfile).size();
+            int snapshotLogCount = scan.logs.get(logTypeSnapshot).size();
+            int placeholderCleanCount = scan.placeholderClean.size();
+            int placeholderDirtyCount = scan.placeholderDirty.size();
+            int reserveCount = scan.reserve.size();
+            int logCount = javaLogCount + nativeLogCount + anrLogCount + traceLogCount + watchdogLogCount + profileLogCount + snapshotLogCount;
+
+            boolean manifestExists = manifest.exists();
+            boolean logSizeExceeded = (logSizeMax > 0 && manifestExists && manifest.getSize() > logSizeMax);
+
+            //the records appended by other processes while rebuilding may be lost, rebuild it again if it doesn't match the directory
+            boolean manifestStale = (manifestExists && manifest.getEntries(logSuffixes).size() != logCount);
 
             if (javaLogCount <= this.javaLogCountMax
                 && nativeLogCount <= this.nativeLogCountMax
                 && anrLogCount <= this.anrLogCountMax
                 && traceLogCount <= this.traceLogCountMax
+                && watchdogLogCount <= this.watchdogLogCountMax
+                && profileLogCount <= this.profileLogCountMax
+                && snapshotLogCount <= this.snapshotLogCountMax
                 && placeholderCleanCount == this.placeholderCountMax
-                && placeholderDirtyCount == 0) {
+                && placeholderDirtyCount == 0
+                && reserveCount <= reserveCountMax
+                && manifestExists
+                && !manifestStale
+                && !logSizeExceeded
+                && !(nativeCompressDict && TombstoneDict.needUpdate(dir))
+                && !(nativeDumpMapDelta && TombstoneMaps.needClean(dir))) {
                 //everything OK, need to do nothing
                 this.delayMs = -1;
             } else if (javaLogCount > this.javaLogCountMax + 10
                 || nativeLogCount > this.nativeLogCountMax + 10
                 || anrLogCount > this.anrLogCountMax + 10
                 || traceLogCount > this.traceLogCountMax + 10
+                || watchdogLogCount > this.watchdogLogCountMax + 10
+                || profileLogCount > this.profileLogCountMax + 10
+                || snapshotLogCount > this.snapshotLogCountMax + 10
                 || placeholderCleanCount > this.placeholderCountMax + 10
                 || placeholderDirtyCount > 10) {
                 //too many unwanted files, clean up now
@@ -128,8 +157,14 @@ class FileManager {
                 || nativeLogCount > this.nativeLogCountMax
                 || anrLogCount > this.anrLogCountMax
                 || traceLogCount > this.traceLogCountMax
+                || watchdogLogCount > this.watchdogLogCountMax
+                || profileLogCount > this.profileLogCountMax
+                || snapshotLogCount > this.snapshotLogCountMax
                 || placeholderCleanCount > this.placeholderCountMax
-                || placeholderDirtyCount > 0) {
+                || placeholderDirtyCount > 0
+                || reserveCount > reserveCountMax
+                || manifestStale
+                || logSizeExceeded) {
                 //have some unwanted files, clean up as soon as possible
                 this.delayMs = 0;
             }
@@ -174,7 +209,15 @@ class FileManager {
         File dir = new File(logDir);
 
         try {
-            return doMaintainTombstoneType(dir, Util.anrLogSuffix, anrLogCountMax);
+            LogDirScan scan = scanLogDir(dir);
+            if (scan == null) {
+                return false;
+            }
+            boolean result = doMaintainTombstoneType(dir, scan.logs.get(logTypeAnr), anrLogCountMax, null);
+            if (logSizeMax > 0 && !doMaintainLogSize(dir, null)) {
+                result = false;
+            }
+            return result;
         } catch (Exception e) {
             XCrash.getLogger().e(Util.TAG, "FileManager maintainAnr failed", e);
             return false;
@@ -233,9 +276,41 @@ class FileManager {
         }
     }
 
+    //the file reserved for writing a log file without creating it (see "JavaCrashOomWriter.java"), one for each process
+    File createReserveFile(String processName) {
+        if (this.logDir == null) {
+            return null;
+        }
+
+        String reservePath = String.format(Locale.US, "%s/%s__%s%s", logDir, reservePrefix, processName, reserveSuffix);
+        File reserveFile = new File(reservePath);
+        reserveName = reserveFile.getName();
+        if (reserveFile.exists()) {
+            //keep it as the newest one, the maintain task deletes the least recently used ones
+            //noinspection ResultOfMethodCallIgnored
+            reserveFile.setLastModified(System.currentTimeMillis());
+            return reserveFile;
+        }
+
+        //renamed from a clean placeholder file if possible
+        return createLogFile(reservePath);
+    }
+
     boolean appendText(String logPath, String text) {
         RandomAccessFile raf = null;
 
+        //compressed log file, the text is saved as a new concatenated stream
+        if (TombstoneXz.isXz(logPath)) {
+            try {
+                TombstoneXz.append(logPath, text.getBytes("UTF-8"));
+                resizeManifestEntry(new File(logPath));
+                return true;
+            } catch (Exception e) {
+                XCrash.getLogger().e(Util.TAG, "FileManager appendText failed", e);
+                return false;
+            }
+        }
+
         try {
             raf = new RandomAccessFile(logPath, "rws");
 
@@ -254,7 +329,10 @@ class FileManager {
             //write text
             raf.seek(pos);
             raf.write(text.getBytes("UTF-8"));
+            raf.close();
+            raf = null;
 
+            resizeManifestEntry(new File(logPath));
             return true;
         } catch (Exception e) {
             XCrash.getLogger().e(Util.TAG, "FileManager appendText failed", e);
@@ -269,12 +347,104 @@ class FileManager {
         }
     }
 
+    void addManifestEntry(File logFile, String type, long time) {
+        if (manifest == null) {
+            return;
+        }
+
+        try {
+            manifest.add(logFile, type, time, null);
+        } catch (Exception e) {
+            XCrash.getLogger().w(Util.TAG, "FileManager addManifestEntry failed", e);
+        }
+    }
+
+    private void resizeManifestEntry(File logFile) {
+        if (manifest == null || !logFile.getName().startsWith(Util.logPrefix + "_")) {
+            return;
+        }
+
+        try {
+            manifest.resize(logFile);
+        } catch (Exception e) {
+            XCrash.getLogger().w(Util.TAG, "FileManager resizeManifestEntry failed", e);
+        }
+    }
+
+    boolean markLogFileUploaded(File logFile) {
+        if (manifest == null || !logFile.exists()) {
+            return false;
+        }
+
+        try {
+            manifest.markUploaded(logFile);
+            return true;
+        } catch (Exception e) {
+            XCrash.getLogger().e(Util.TAG, "FileManager markLogFileUploaded failed", e);
+            return false;
+        }
+    }
+
+    boolean isLogFileUploaded(File logFile) {
+        if (manifest == null) {
+            return false;
+        }
+
+        try {
+            return manifest.isUploaded(logFile);
+        } catch (Exception e) {
+            XCrash.getLogger().e(Util.TAG, "FileManager isLogFileUploaded failed", e);
+            return false;
+        }
+    }
+
+    //list the log files by the manifest, return null if it's not available (then list the directory instead)
+    File[] getLogFiles(String[] logSuffixes, boolean notUploadedOnly) {
+        if (manifest == null) {
+            return null;
+        }
+
+        List<TombstoneManifest.Entry> entries;
+        try {
+            if (!manifest.exists()) {
+                return null;
+            }
+            entries = manifest.getEntries(logSuffixes);
+        } catch (Exception e) {
+            XCrash.getLogger().e(Util.TAG, "FileManager getLogFiles failed", e);
+            return null;
+        }
+
+        //the log files deleted by others are dropped by the next maintain task
+        List<File> files = new ArrayList<File>(entries.size());
+        for (TombstoneManifest.Entry entry : entries) {
+            if (notUploadedOnly && entry.uploaded) {
+                continue;
+            }
+            File file = new File(logDir, entry.name);
+            if (file.exists()) {
+                files.add(file);
+            }
+        }
+
+        File[] result = files.toArray(new File[files.size()]);
+        Arrays.sort(result, new Comparator<File>() {
+            @Override
+            public int compare(File f1, File f2) {
+                return f1.getName().compareTo(f2.getName());
+            }
+        });
+        return result;
+    }
+
     @SuppressWarnings({"unused"})
     boolean recycleLogFile(File logFile) {
         if (logFile == null) {
             return false;
         }
 
+        deleteLogFileSidecars(logFile);
+
         if (this.logDir == null || this.placeholderCountMax <= 0) {
             try {
                 return logFile.delete();
@@ -322,92 +492,259 @@ class FileManager {
         }
     }
 
+    @SuppressWarnings("ResultOfMethodCallIgnored")
+    private void deleteLogFileSidecars(File logFile) {
+        //remove it from the manifest first, it's rebuilt by the maintain task if the deleting failed
+        if (manifest != null && logFile.getName().startsWith(Util.logPrefix + "_")) {
+            try {
+                manifest.remove(logFile);
+            } catch (Exception e) {
+                XCrash.getLogger().w(Util.TAG, "FileManager remove manifest entry failed", e);
+            }
+        }
+
+        //the protobuf tombstone and the minidump go with the native crash log file
+        if (Util.isLogFile(logFile.getName(), Util.nativeLogSuffix)) {
+            try {
+                String basePath = Util.trimXzSuffix(logFile.getPath());
+                File protoFile = new File(basePath + Util.nativeProtoSuffix);
+                if (protoFile.exists()) {
+                    protoFile.delete();
+                }
+                File minidumpFile = new File(basePath + Util.nativeMinidumpSuffix);
+                if (minidumpFile.exists()) {
+                    minidumpFile.delete();
+                }
+            } catch (Exception ignored) {
+            }
+        }
+
+        //the section index goes with all kinds of log files
+        try {
+            File indexFile = new File(TombstoneIndex.getPath(logFile.getPath()));
+            if (indexFile.exists()) {
+                indexFile.delete();
+            }
+        } catch (Exception ignored) {
+        }
+    }
+
+    //recycle the log file in the batch of the maintain task, the dirty placeholder file is cleaned later by doMaintainPlaceholder()
+    private boolean recycleLogFile(File logFile, LogDirScan scan) {
+        deleteLogFileSidecars(logFile);
+
+        //keep the disk space as a dirty placeholder file if the placeholder files are not enough
+        if (this.placeholderCountMax > 0 && scan.placeholderClean.size() + scan.placeholderDirty.size() < this.placeholderCountMax) {
+            String dirtyName = String.format(Locale.US, "%s_%020d%s", placeholderPrefix, new Date().getTime() * 1000 + getNextUnique(), placeholderDirtySuffix);
+            if (logFile.renameTo(new File(logFile.getParentFile(), dirtyName))) {
+                scan.placeholderDirty.add(dirtyName);
+                return true;
+            }
+        }
+
+        try {
+            return logFile.delete();
+        } catch (Exception ignored) {
+            return false;
+        }
+    }
+
+    //the log directory classified by one listing, the names are sorted (the oldest first)
+    private static class LogDirScan {
+        final List<List<String>> logs = new ArrayList<List<String>>(logSuffixes.length);
+        final List<String> placeholderClean = new ArrayList<String>();
+        final List<String> placeholderDirty = new ArrayList<String>();
+        final List<String> reserve = new ArrayList<String>();
+    }
+
+    private LogDirScan scanLogDir(File dir) {
+        //only the names, no File object or stat for each entry
+        String[] names = dir.list();
+        if (names == null) {
+            return null;
+        }
+        Arrays.sort(names);
+
+        LogDirScan scan = new LogDirScan();
+        for (int i = 0; i < logSuffixes.length; i++) {
+            scan.logs.add(new ArrayList<String>());
+        }
+        for (String name : names) {
+            if (name.startsWith(Util.logPrefix + "_")) {
+                for (int i = 0; i < logSuffixes.length; i++) {
+                    if (Util.isLogFile(name, logSuffixes[i])) {
+                        scan.logs.get(i).add(name);
+                        break;
+                    }
+                }
+            } else if (name.startsWith(placeholderPrefix + "_")) {
+                if (name.endsWith(placeholderCleanSuffix)) {
+                    scan.placeholderClean.add(name);
+                } else if (name.endsWith(placeholderDirtySuffix)) {
+                    scan.placeholderDirty.add(name);
+                }
+            } else if (name.startsWith(reservePrefix + "__") && name.endsWith(reserveSuffix)) {
+                scan.reserve.add(name);
+            }
+        }
+        return scan;
+    }
+
     private void doMaintain() {
         if (!Util.checkAndCreateDir(logDir)) {
             return;
         }
         File dir = new File(logDir);
 
+        //list the log directory only once, the following steps work on the lists
+        LogDirScan scan = null;
         try {
-            doMaintainTombstone(dir);
+            scan = scanLogDir(dir);
         } catch (Exception e) {
-            XCrash.getLogger().e(Util.TAG, "FileManager doMaintainTombstone failed", e);
+            XCrash.getLogger().e(Util.TAG, "FileManager scanLogDir failed", e);
         }
 
-        try {
-            doMaintainPlaceholder(dir);
-        } catch (Exception e) {
-            XCrash.getLogger().e(Util.TAG, "FileManager doMaintainPlaceholder failed", e);
+        if (scan != null) {
+            try {
+                doMaintainManifest(dir, scan);
+            } catch (Exception e) {
+                XCrash.getLogger().e(Util.TAG, "FileManager doMaintainManifest failed", e);
+            }
+
+            try {
+                doMaintainTombstone(dir, scan);
+            } catch (Exception e) {
+                XCrash.getLogger().e(Util.TAG, "FileManager doMaintainTombstone failed", e);
+            }
+
+            if (logSizeMax > 0) {
+                try {
+                    doMaintainLogSize(dir, scan);
+                } catch (Exception e) {
+                    XCrash.getLogger().e(Util.TAG, "FileManager doMaintainLogSize failed", e);
+                }
+            }
+
+            try {
+                doMaintainPlaceholder(dir, scan);
+            } catch (Exception e) {
+                XCrash.getLogger().e(Util.TAG, "FileManager doMaintainPlaceholder failed", e);
+            }
+
+            try {
+                doMaintainReserve(dir, scan);
+            } catch (Exception e) {
+                XCrash.getLogger().e(Util.TAG, "FileManager doMaintainReserve failed", e);
+            }
         }
-    }
 
-    private void doMaintainTombstone(File dir) {
-        doMaintainTombstoneType(dir, Util.nativeLogSuffix, nativeLogCountMax);
-        doMaintainTombstoneType(dir, Util.javaLogSuffix, javaLogCountMax);
-        doMaintainTombstoneType(dir, Util.anrLogSuffix, anrLogCountMax);
-        doMaintainTombstoneType(dir, Util.traceLogSuffix, traceLogCountMax);
+        if (nativeCompressDict) {
+            try {
+                TombstoneDict.update(dir);
+            } catch (Exception e) {
+                XCrash.getLogger().e(Util.TAG, "FileManager doMaintainDictionary failed", e);
+            }
+        }
+
+        if (nativeDumpMapDelta) {
+            try {
+                TombstoneMaps.clean(dir);
+            } catch (Exception e) {
+                XCrash.getLogger().e(Util.TAG, "FileManager doMaintainMapsBaseline failed", e);
+            }
+        }
     }
 
-    private boolean doMaintainTombstoneType(File dir, final String logSuffix, int logCountMax) {
-        File[] files = dir.listFiles(new FilenameFilter() {
-            @Override
-            public boolean accept(File dir, String name) {
-                return name.startsWith(Util.logPrefix + "_") && name.endsWith(logSuffix);
+    private void doMaintainManifest(File dir, LogDirScan scan) throws IOException {
+        List<File> files = new ArrayList<File>();
+        for (List<String> names : scan.logs) {
+            for (String name : names) {
+                files.add(new File(dir, name));
             }
-        });
+        }
+        manifest.rebuild(files.toArray(new File[files.size()]));
+    }
 
+    private void doMaintainTombstone(File dir, LogDirScan scan) {
+        doMaintainTombstoneType(dir, scan.logs.get(logTypeNative), nativeLogCountMax, scan);
+        doMaintainTombstoneType(dir, scan.logs.get(logTypeJava), javaLogCountMax, scan);
+        doMaintainTombstoneType(dir, scan.logs.get(logTypeAnr), anrLogCountMax, scan);
+        doMaintainTombstoneType(dir, scan.logs.get(logTypeTrace), traceLogCountMax, scan);
+        doMaintainTombstoneType(dir, scan.logs.get(logTypeWatchdog), watchdogLogCountMax, scan);
+        doMaintainTombstoneType(dir, scan.logs.get(logTypeProfile), profileLogCountMax, scan);
+        doMaintainTombstoneType(dir, scan.logs.get(logTypeSnapshot), snapshotLogCountMax, scan);
+    }
+
+    //recycle the oldest log files, in the batch of the maintain task if the scan is given
+    private boolean doMaintainTombstoneType(File dir, List<String> names, int logCountMax, LogDirScan scan) {
         boolean result = true;
-        if (files != null && files.length > logCountMax) {
-            if (logCountMax > 0) {
-                Arrays.sort(files, new Comparator<File>() {
-                    @Override
-                    public int compare(File f1, File f2) {
-                        return f1.getName().compareTo(f2.getName());
-                    }
-                });
-            }
-            for (int i = 0; i < files.length - logCountMax; i++) {
-                if (!recycleLogFile(files[i])) {
+        if (names.size() > logCountMax) {
+            List<String> recycled = names.subList(0, names.size() - logCountMax);
+            for (String name : recycled) {
+                File file = new File(dir, name);
+                if (!(scan != null ? recycleLogFile(file, scan) : recycleLogFile(file))) {
                     result = false;
                 }
             }
+            recycled.clear();
         }
         return result;
     }
 
-    @SuppressWarnings("ResultOfMethodCallIgnored")
-    private void doMaintainPlaceholder(File dir) {
-        //get all existing placeholder files
-        File[] cleanFiles = dir.listFiles(new FilenameFilter() {
-            @Override
-            public boolean accept(File dir, String name) {
-                return name.startsWith(placeholderPrefix + "_") && name.endsWith(placeholderCleanSuffix);
-            }
-        });
-        if (cleanFiles == null) {
-            return;
+    private boolean doMaintainLogSize(File dir, LogDirScan scan) throws IOException {
+        if (!manifest.exists()) {
+            return true;
+        }
+
+        List<TombstoneManifest.Entry> entries = manifest.getEntries(logSuffixes);
+        long size = 0;
+        for (TombstoneManifest.Entry entry : entries) {
+            size += entry.size;
         }
-        File[] dirtyFiles = dir.listFiles(new FilenameFilter() {
+        if (size <= logSizeMax) {
+            return true;
+        }
+
+        //delete the uploaded log files first, then the oldest ones
+        Collections.sort(entries, new Comparator<TombstoneManifest.Entry>() {
             @Override
-            public boolean accept(File dir, String name) {
-                return name.startsWith(placeholderPrefix + "_") && name.endsWith(placeholderDirtySuffix);
+            public int compare(TombstoneManifest.Entry e1, TombstoneManifest.Entry e2) {
+                if (e1.uploaded != e2.uploaded) {
+                    return e1.uploaded ? -1 : 1;
+                }
+                return e1.time < e2.time ? -1 : (e1.time == e2.time ? e1.name.compareTo(e2.name) : 1);
             }
         });
-        if (dirtyFiles == null) {
-            return;
+
+        boolean result = true;
+        for (TombstoneManifest.Entry entry : entries) {
+            if (size <= logSizeMax) {
+                break;
+            }
+            File file = new File(dir, entry.name);
+            if (scan != null ? recycleLogFile(file, scan) : recycleLogFile(file)) {
+                size -= entry.size;
+            } else {
+                result = false;
+            }
         }
+        return result;
+    }
+
+    @SuppressWarnings("ResultOfMethodCallIgnored")
+    private void doMaintainPlaceholder(File dir, LogDirScan scan) {
+        List<String> cleanNames = scan.placeholderClean;
+        List<String> dirtyNames = scan.placeholderDirty;
 
-        //create clean placeholder files from dirty placeholder files or new files
+        //create clean placeholder files from dirty placeholder files (the newest first) or new files
         int i = 0;
-        int cleanFilesCount = cleanFiles.length;
-        int dirtyFilesCount = dirtyFiles.length;
+        int cleanFilesCount = cleanNames.size();
         while (cleanFilesCount < this.placeholderCountMax) {
-            if (dirtyFilesCount > 0) {
-                File dirtyFile = dirtyFiles[dirtyFilesCount - 1];
+            if (!dirtyNames.isEmpty()) {
+                File dirtyFile = new File(dir, dirtyNames.remove(dirtyNames.size() - 1));
                 if (cleanTheDirtyFile(dirtyFile)) {
                     cleanFilesCount++;
                 }
-                dirtyFilesCount--;
             } else {
                 try {
                     File dirtyFile = new File(String.format(Locale.US, "%s/%s_%020d%s", logDir, placeholderPrefix, new Date().getTime() * 1000 + getNextUnique(), placeholderDirtySuffix));
@@ -426,34 +763,42 @@ class FileManager {
             }
         }
 
-        //reload clean placeholder files list and dirty placeholder files list if needed
-        if (i > 0) {
-            cleanFiles = dir.listFiles(new FilenameFilter() {
-                @Override
-                public boolean accept(File dir, String name) {
-                    return name.startsWith(placeholderPrefix + "_") && name.endsWith(placeholderCleanSuffix);
-                }
-            });
-            dirtyFiles = dir.listFiles(new FilenameFilter() {
-                @Override
-                public boolean accept(File dir, String name) {
-                    return name.startsWith(placeholderPrefix + "_") && name.endsWith(placeholderDirtySuffix);
-                }
-            });
+        //don't keep too many clean placeholder files (the oldest first)
+        for (i = 0; i < cleanNames.size() - this.placeholderCountMax; i++) {
+            new File(dir, cleanNames.get(i)).delete();
         }
 
-        //don't keep too many clean placeholder files
-        if (cleanFiles != null && cleanFiles.length > this.placeholderCountMax) {
-            for (i = 0; i < cleanFiles.length - this.placeholderCountMax; i++) {
-                cleanFiles[i].delete();
-            }
+        //delete all remaining dirty placeholder files
+        for (String dirtyName : dirtyNames) {
+            new File(dir, dirtyName).delete();
         }
+    }
 
-        //delete all remaining dirty placeholder files
-        if (dirtyFiles != null) {
-            for (File dirtyFile : dirtyFiles) {
-                dirtyFile.delete();
+    //the reserved files are named by the process name, don't keep the ones of too many processes
+    //(the least recently initialized first), the one of this process is always kept
+    @SuppressWarnings("ResultOfMethodCallIgnored")
+    private void doMaintainReserve(File dir, LogDirScan scan) {
+        int deleteCount = scan.reserve.size() - reserveCountMax;
+        if (deleteCount <= 0) {
+            return;
+        }
+
+        List<File> files = new ArrayList<File>(scan.reserve.size());
+        for (String name : scan.reserve) {
+            if (!name.equals(reserveName)) {
+                files.add(new File(dir, name));
+            }
+        }
+        Collections.sort(files, new Comparator<File>() {
+            @Override
+            public int compare(File f1, File f2) {
+                long t1 = f1.lastModified();
+                long t2 = f2.lastModified();
+                return t1 < t2 ? -1 : (t1 == t2 ? f1.getName().compareTo(f2.getName()) : 1);
             }
+        });
+        for (int i = 0; i < deleteCount && i < files.size(); i++) {
+            files.get(i).delete();
         }
     }
 
@@ -0,0 +1,39 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Created by agent on 2026-10-17.
+package xcrash;
+
+/**
+ * Define the progress callback interface of {@link xcrash.TombstoneManager#archiveTombstones(java.io.File[], String, int, long, IArchiveProgress)}.
+ */
+public interface IArchiveProgress {
+
+    /**
+     * Called periodically while archiving, in the thread which called archiveTombstones().
+     *
+     * @param processedSize Bytes of the archive content that have been compressed.
+     * @param totalSize Bytes of the archive content in total.
+     * @return Return false to cancel the archiving, true otherwise.
+     */
+    @SuppressWarnings("unused")
+    boolean onProgress(long processedSize, long totalSize);
+}
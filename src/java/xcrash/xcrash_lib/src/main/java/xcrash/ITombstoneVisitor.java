@@ -0,0 +1,62 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// Created by agent on 2026-10-17.
+package xcrash;
+
+/**
+ * Define the visitor interface for streaming a crash log file.
+ * (see {@link xcrash.TombstoneParser#visit(String, xcrash.ITombstoneVisitor)})
+ *
+ * <p>Note: The keys are defined in {@link xcrash.TombstoneParser}, or they are the titles of the sections
+ * attached by users. The same section (such as "memory near" and "memory info") may be visited more than once.
+ */
+public interface ITombstoneVisitor {
+
+    /**
+     * Called for each item in the head of the crash log file.
+     *
+     * @param key The key of the item.
+     * @param value The value of the item.
+     */
+    @SuppressWarnings("unused")
+    void onHeadItem(String key, String value);
+
+    /**
+     * Called for each line in a section, the line is outdented and ends with '\n'.
+     *
+     * <p>Note: The chunk is reused by the parser, it's only valid during the call.
+     *
+     * @param key The key of the section.
+     * @param chunk A line of the section content.
+     */
+    @SuppressWarnings("unused")
+    void onSectionChunk(String key, CharSequence chunk);
+
+    /**
+     * Called when a section is finished, even if there is no content in it.
+     *
+     * @param key The key of the section.
+     */
+    @SuppressWarnings("unused")
+    void onSectionEnd(String key);
+}
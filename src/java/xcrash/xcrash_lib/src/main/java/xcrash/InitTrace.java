@@ -0,0 +1,75 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Created by agent on 2026-10-17.
+package xcrash;
+
+import android.os.Looper;
+
+import java.util.Locale;
+
+class InitTrace {
+
+    private static final InitTrace instance = new InitTrace();
+
+    private final StringBuilder sb = new StringBuilder();
+    private long startNs = 0;
+    private long lastNs = 0;
+    private volatile String result = null;
+
+    private InitTrace() {
+    }
+
+    static InitTrace getInstance() {
+        return instance;
+    }
+
+    synchronized void start(boolean lazy) {
+        startNs = lastNs = System.nanoTime();
+        sb.append("xCrash init (lazy: ").append(lazy ? "yes" : "no").append(")\n");
+    }
+
+    //record the time spent since the previous step
+    synchronized void step(String name) {
+        if (startNs == 0) {
+            return;
+        }
+
+        long now = System.nanoTime();
+        sb.append(String.format(Locale.US, "  %s: %.3f ms%s\n", name, (now - lastNs) / 1000000.0,
+                Looper.myLooper() == Looper.getMainLooper() ? " (main thread)" : ""));
+        lastNs = now;
+    }
+
+    synchronized void finish() {
+        if (startNs == 0 || result != null) {
+            return;
+        }
+
+        sb.append(String.format(Locale.US, "  total: %.3f ms\n", (System.nanoTime() - startNs) / 1000000.0));
+        result = sb.toString();
+        XCrash.getLogger().i(Util.TAG, result);
+    }
+
+    String getResult() {
+        return result;
+    }
+}
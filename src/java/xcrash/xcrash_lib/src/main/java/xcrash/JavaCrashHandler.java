@@ -22,10 +22,15 @@
 // Created by caikelun on 2019-03-07.
 package xcrash;
 
+import java.io.BufferedWriter;
 import java.io.File;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.io.OutputStreamWriter;
 import java.io.PrintWriter;
 import java.io.RandomAccessFile;
 import java.io.StringWriter;
+import java.io.Writer;
 import java.lang.Thread.UncaughtExceptionHandler;
 import java.text.DateFormat;
 import java.text.SimpleDateFormat;
@@ -33,7 +38,6 @@ import java.util.ArrayList;
 import java.util.Date;
 import java.util.List;
 import java.util.Locale;
-import java.util.Map;
 import java.util.regex.Pattern;
 
 import android.annotation.SuppressLint;
@@ -46,6 +50,9 @@ class JavaCrashHandler implements UncaughtExceptionHandler {
 
     private static final JavaCrashHandler instance = new JavaCrashHandler();
 
+    //how long a crash during the lazy initialization waits for it
+    private static final long LAZY_INIT_WAIT_MS = 3000;
+
     private final Date startTime = new Date();
 
     private int pid;
@@ -60,10 +67,12 @@ class JavaCrashHandler implements UncaughtExceptionHandler {
     private boolean dumpFds;
     private boolean dumpNetworkInfo;
     private boolean dumpAllThreads;
-    private int dumpAllThreadsCountMax;
-    private String[] dumpAllThreadsWhiteList;
+    private JavaCrashThreads otherThreads;
     private ICrashCallback callback;
+    private JavaCrashOomWriter oomWriter = null;
     private UncaughtExceptionHandler defaultHandler = null;
+    private boolean installed = false;
+    private volatile boolean initialized = false;
 
     private JavaCrashHandler() {
     }
@@ -76,8 +85,9 @@ class JavaCrashHandler implements UncaughtExceptionHandler {
                     String logDir, boolean rethrow, int logcatSystemLines,
                     int logcatEventsLines, int logcatMainLines, boolean dumpFds,
                     boolean dumpNetworkInfo, boolean dumpAllThreads,
-                    int dumpAllThreadsCountMax, String[] dumpAllThreadsWhiteList,
-                    ICrashCallback callback) {
+                    int dumpAllThreadsCountMax, int dumpAllThreadsTimeoutMs,
+                    String[] dumpAllThreadsWhiteList,
+                    int oomReserveSizeKb, ICrashCallback callback) {
 
         this.pid = pid;
         this.processName = (TextUtils.isEmpty(processName) ? "unknown" : processName);
@@ -91,13 +101,57 @@ class JavaCrashHandler implements UncaughtExceptionHandler {
         this.dumpFds = dumpFds;
         this.dumpNetworkInfo = dumpNetworkInfo;
         this.dumpAllThreads = dumpAllThreads;
-        this.dumpAllThreadsCountMax = dumpAllThreadsCountMax;
-        this.dumpAllThreadsWhiteList = dumpAllThreadsWhiteList;
         this.callback = callback;
-        this.defaultHandler = Thread.getDefaultUncaughtExceptionHandler();
 
+        //build whitelist regex list, not on the crash
+        List<Pattern> whiteList = null;
+        if (dumpAllThreadsWhiteList != null) {
+            whiteList = new ArrayList<Pattern>();
+            for (String s : dumpAllThreadsWhiteList) {
+                try {
+                    whiteList.add(Pattern.compile(s));
+                } catch (Exception e) {
+                    XCrash.getLogger().w(Util.TAG, "JavaCrashHandler pattern compile failed", e);
+                }
+            }
+        }
+
+        //all the threads are enumerated from the root thread group
+        ThreadGroup group = Thread.currentThread().getThreadGroup();
+        while (group.getParent() != null) {
+            group = group.getParent();
+        }
+        this.otherThreads = new JavaCrashThreads(pid, this.processName, dumpAllThreadsCountMax, dumpAllThreadsTimeoutMs, whiteList, group);
+
+        //prepare the writer for OutOfMemoryError, nothing can be allocated when it occurs
+        if (oomReserveSizeKb > 0) {
+            try {
+                File reserveFile = FileManager.getInstance().createReserveFile(this.processName);
+                if (reserveFile != null) {
+                    this.oomWriter = new JavaCrashOomWriter(reserveFile, getLogPath(), oomReserveSizeKb,
+                            Util.getLogHeader(startTime, startTime, Util.javaCrashType, appId, appVersion),
+                            pid, this.processName, logcatSystemLines, logcatEventsLines, logcatMainLines,
+                            dumpFds, dumpNetworkInfo, dumpAllThreads, otherThreads);
+                }
+            } catch (Exception e) {
+                XCrash.getLogger().e(TAG, "JavaCrashHandler prepare OOM writer failed", e);
+            }
+        }
+
+        this.initialized = true;
+        install();
+    }
+
+    //install the handler before it is initialized, for the lazy initialization
+    synchronized void install() {
+        if (installed) {
+            return;
+        }
+
+        this.defaultHandler = Thread.getDefaultUncaughtExceptionHandler();
         try {
             Thread.setDefaultUncaughtExceptionHandler(this);
+            installed = true;
         } catch (Exception e) {
             XCrash.getLogger().e(TAG, "JavaCrashHandler setDefaultUncaughtExceptionHandler failed", e);
         }
@@ -105,10 +159,23 @@ class JavaCrashHandler implements UncaughtExceptionHandler {
 
     @Override
     public void uncaughtException(Thread thread, Throwable throwable) {
+        //crashed during the lazy initialization, wait for it a while
+        if (!initialized) {
+            XCrash.waitForInit(LAZY_INIT_WAIT_MS);
+        }
+
         if (defaultHandler != null) {
             Thread.setDefaultUncaughtExceptionHandler(defaultHandler);
         }
 
+        //hand it over to the previous handler if still not initialized
+        if (!initialized) {
+            if (defaultHandler != null) {
+                defaultHandler.uncaughtException(thread, throwable);
+            }
+            return;
+        }
+
         try {
             handleException(thread, throwable);
         } catch (Exception e) {
@@ -126,21 +193,32 @@ class JavaCrashHandler implements UncaughtExceptionHandler {
         }
     }
 
+    private String getLogPath() {
+        return String.format(Locale.US, "%s/%s_%020d_%s__%s%s",
+                logDir, Util.logPrefix, startTime.getTime() * 1000,
+                appVersion, processName, Util.javaLogSuffix);
+    }
+
     private void handleException(Thread thread, Throwable throwable) {
-        Date crashTime = new Date();
+        long crashTimeMs = System.currentTimeMillis();
 
         //notify the java crash
         NativeHandler.getInstance().notifyJavaCrashed();
         AnrHandler.getInstance().notifyJavaCrashed();
 
+        //OutOfMemoryError, write by the prepared writer, fall back to the normal way if the log file is not created
+        if (oomWriter != null && JavaCrashOomWriter.isOutOfMemory(throwable)) {
+            if (handleOutOfMemory(crashTimeMs, thread, throwable)) {
+                return;
+            }
+        }
+
+        Date crashTime = new Date(crashTimeMs);
+
         //create log file
         File logFile = null;
         try {
-            String logPath = String.format(Locale.US, "%s/%s_%020d_%s__%s%s",
-                    logDir, Util.logPrefix, startTime.getTime() * 1000,
-                    appVersion, processName, Util.javaLogSuffix);
-
-            logFile = FileManager.getInstance().createLogFile(logPath);
+            logFile = FileManager.getInstance().createLogFile(getLogPath());
         } catch (Exception e) {
             XCrash.getLogger().e(Util.TAG, "JavaCrashHandler createLogFile failed", e);
         }
@@ -195,7 +273,9 @@ class JavaCrashHandler implements UncaughtExceptionHandler {
 
                 //write other threads info
                 if (dumpAllThreads) {
-                    raf.write(getOtherThreadsInfo(thread).getBytes("UTF-8"));
+                    Writer writer = new BufferedWriter(new OutputStreamWriter(new FileOutputStream(raf.getFD()), "UTF-8"));
+                    otherThreads.put(new WriterSink(writer), thread, null);
+                    writer.flush();
                 }
             } catch (Exception e) {
                 XCrash.getLogger().e(Util.TAG, "JavaCrashHandler write log file failed", e);
@@ -207,6 +287,16 @@ class JavaCrashHandler implements UncaughtExceptionHandler {
                     }
                 }
             }
+
+            //section index of the log file
+            try {
+                TombstoneIndex.build(logFile.getAbsolutePath());
+            } catch (Exception e) {
+                XCrash.getLogger().e(Util.TAG, "JavaCrashHandler build index failed", e);
+            }
+
+            //add the log file to the manifest
+            FileManager.getInstance().addManifestEntry(logFile, Util.javaCrashType, crashTime.getTime() * 1000);
         }
 
         //callback
@@ -218,6 +308,32 @@ class JavaCrashHandler implements UncaughtExceptionHandler {
         }
     }
 
+    private boolean handleOutOfMemory(long crashTimeMs, Thread thread, Throwable throwable) {
+        File logFile = oomWriter.write(crashTimeMs, thread, throwable);
+        if (logFile == null) {
+            return false;
+        }
+
+        //the log file is complete, these may fail for lack of memory
+        try {
+            TombstoneIndex.build(logFile.getAbsolutePath());
+        } catch (Throwable ignored) {
+        }
+        try {
+            FileManager.getInstance().addManifestEntry(logFile, Util.javaCrashType, crashTimeMs * 1000);
+        } catch (Throwable ignored) {
+        }
+
+        //callback
+        if (callback != null) {
+            try {
+                callback.onCrash(logFile.getAbsolutePath(), null);
+            } catch (Throwable ignored) {
+            }
+        }
+        return true;
+    }
+
     private String getLibInfo(List<String> libPathList) {
         StringBuilder sb = new StringBuilder();
         for(String libPath : libPathList) {
@@ -298,89 +414,22 @@ class JavaCrashHandler implements UncaughtExceptionHandler {
                 + getBuildId(stacktrace);
     }
 
-    private String getOtherThreadsInfo(Thread crashedThread) {
-
-        int thdMatchedRegex = 0;
-        int thdIgnoredByLimit = 0;
-        int thdDumped = 0;
-
-        //build whitelist regex list
-        ArrayList<Pattern> whiteList = null;
-        if (dumpAllThreadsWhiteList != null) {
-            whiteList = new ArrayList<Pattern>();
-            for (String s : dumpAllThreadsWhiteList) {
-                try {
-                    whiteList.add(Pattern.compile(s));
-                } catch (Exception e) {
-                    XCrash.getLogger().w(Util.TAG, "JavaCrashHandler pattern compile failed", e);
-                }
-            }
-        }
-
-        StringBuilder sb = new StringBuilder();
-        Map<Thread, StackTraceElement[]> map = Thread.getAllStackTraces();
-        for (Map.Entry<Thread, StackTraceElement[]> entry : map.entrySet()) {
-
-            Thread thd = entry.getKey();
-            StackTraceElement[] stacktrace = entry.getValue();
-
-            //skip the crashed thread
-            if (thd.getName().equals(crashedThread.getName())) continue;
-
-            //check regex for thread name
-            if (whiteList != null && !matchThreadName(whiteList, thd.getName())) continue;
-            thdMatchedRegex++;
-
-            //check dump count limit
-            if (dumpAllThreadsCountMax > 0 && thdDumped >= dumpAllThreadsCountMax) {
-                thdIgnoredByLimit++;
-                continue;
-            }
-
-            sb.append(Util.sepOtherThreads + "\n");
-            sb.append("pid: ").append(pid)
-                    .append(", tid: ").append(thd.getId())
-                    .append(", name: ").append(thd.getName())
-                    .append("  >>> ").append(processName).append(" <<<\n");
-
-            sb.append("\n");
-            sb.append("java stacktrace:\n");
-            for (StackTraceElement element : stacktrace) {
-                sb.append("    at ").append(element.toString()).append("\n");
-            }
-            sb.append("\n");
+    //stream the other threads into the log file
+    private static class WriterSink implements JavaCrashThreads.Sink {
+        private final Writer writer;
 
-            thdDumped++;
+        WriterSink(Writer writer) {
+            this.writer = writer;
         }
 
-        if (map.size() > 1) {
-            if (thdDumped == 0) {
-                sb.append(Util.sepOtherThreads + "\n");
-            }
-
-            sb.append("total JVM threads (exclude the crashed thread): ")
-                    .append(map.size() - 1).append("\n");
-
-            if (whiteList != null) {
-                sb.append("JVM threads matched whitelist: ").append(thdMatchedRegex).append("\n");
-            }
-            if (dumpAllThreadsCountMax > 0) {
-                sb.append("JVM threads ignored by max count limit: ")
-                        .append(thdIgnoredByLimit).append("\n");
-            }
-            sb.append("dumped JVM threads:").append(thdDumped).append("\n");
-            sb.append(Util.sepOtherThreadsEnding + "\n");
+        @Override
+        public void putString(String s) throws IOException {
+            writer.write(s);
         }
 
-        return sb.toString();
-    }
-
-    private boolean matchThreadName(ArrayList<Pattern> whiteList, String threadName) {
-        for (Pattern pat : whiteList) {
-            if (pat.matcher(threadName).matches()) {
-                return true;
-            }
+        @Override
+        public void putLong(long value) throws IOException {
+            writer.write(Long.toString(value));
         }
-        return false;
     }
 }
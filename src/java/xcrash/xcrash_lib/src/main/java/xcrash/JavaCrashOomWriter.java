@@ -0,0 +1,399 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// Created by agent on 2026-10-17.
+package xcrash;
+
+import android.os.Process;
+
+import java.io.File;
+import java.io.FileInputStream;
+import java.io.IOException;
+import java.io.RandomAccessFile;
+import java.nio.ByteBuffer;
+import java.nio.channels.FileChannel;
+import java.util.TimeZone;
+
+/**
+ * Writer of the Java crash log file for {@link OutOfMemoryError}.
+ *
+ * <p>The direct buffer, the log file (renamed from a file reserved and opened when initializing) and the constant
+ * parts of the log are prepared in advance. The crash is encoded into the buffer without allocating on the Java
+ * heap, except for the stack traces created by the VM. The logcat, FDs, network info and memory info are recorded
+ * by the native library.
+ */
+class JavaCrashOomWriter {
+
+    private static final int threadsMax = 1024;
+    private static final int causesMax = 16;
+    private static final String crashTimeKey = "Crash time: '";
+
+    private final File reserveFile;
+    private final File logFile;
+    private final String logPath;
+    private final RandomAccessFile raf;
+    private final FileChannel channel;
+    private final ByteBuffer buf;
+    private final byte[] digits = new byte[20];
+    private final Thread[] threads = new Thread[threadsMax];
+    private final JavaCrashThreads otherThreads;
+    private final TimeZone timeZone;
+
+    //the constant parts of the log
+    private final byte[] headBegin;
+    private final byte[] headEnd;
+    private final byte[] pidLabel;
+    private final byte[] processName;
+
+    private final int logcatSystemLines;
+    private final int logcatEventsLines;
+    private final int logcatMainLines;
+    private final boolean dumpFds;
+    private final boolean dumpNetworkInfo;
+    private final boolean dumpAllThreads;
+
+    //the sink of the shared parts, created in advance
+    private final JavaCrashThreads.Sink sink = new JavaCrashThreads.Sink() {
+        @Override
+        public void putString(String s) throws IOException {
+            JavaCrashOomWriter.this.putString(s);
+        }
+
+        @Override
+        public void putLong(long value) throws IOException {
+            JavaCrashOomWriter.this.putLong(value);
+        }
+    };
+
+    JavaCrashOomWriter(File reserveFile, String logPath, int bufferSizeKb, String header, int pid, String processName,
+                       int logcatSystemLines, int logcatEventsLines, int logcatMainLines, boolean dumpFds,
+                       boolean dumpNetworkInfo, boolean dumpAllThreads, JavaCrashThreads otherThreads) throws IOException {
+        this.reserveFile = reserveFile;
+        this.logFile = new File(logPath);
+        this.logPath = logPath;
+        this.raf = new RandomAccessFile(reserveFile, "rw");
+        this.channel = raf.getChannel();
+        this.buf = ByteBuffer.allocateDirect(bufferSizeKb * 1024);
+        this.timeZone = TimeZone.getDefault();
+        this.otherThreads = otherThreads;
+
+        //split the header at the crash time
+        int crashTimeBegin = header.indexOf(crashTimeKey) + crashTimeKey.length();
+        this.headBegin = header.substring(0, crashTimeBegin).getBytes("UTF-8");
+        this.headEnd = header.substring(header.indexOf('\'', crashTimeBegin)).getBytes("UTF-8");
+        this.pidLabel = ("pid: " + pid).getBytes("UTF-8");
+        this.processName = processName.getBytes("UTF-8");
+
+        this.logcatSystemLines = logcatSystemLines;
+        this.logcatEventsLines = logcatEventsLines;
+        this.logcatMainLines = logcatMainLines;
+        this.dumpFds = dumpFds;
+        this.dumpNetworkInfo = dumpNetworkInfo;
+        this.dumpAllThreads = dumpAllThreads;
+    }
+
+    static boolean isOutOfMemory(Throwable throwable) {
+        for (int i = 0; throwable != null && i < causesMax; i++) {
+            if (throwable instanceof OutOfMemoryError) {
+                return true;
+            }
+            throwable = throwable.getCause();
+        }
+        return false;
+    }
+
+    //return the log file, or null if it's not created
+    File write(long crashTime, Thread crashedThread, Throwable throwable) {
+        try {
+            if (!reserveFile.renameTo(logFile)) {
+                return null;
+            }
+        } catch (Throwable e) {
+            return null;
+        }
+
+        boolean truncated = false;
+        try {
+            buf.clear();
+            channel.position(0);
+
+            //head and the crashed thread
+            putBytes(headBegin);
+            putTime(crashTime);
+            putBytes(headEnd);
+            putBytes(pidLabel);
+            putString(", tid: ");
+            putLong(Process.myTid());
+            putString(", name: ");
+            putString(crashedThread.getName());
+            putString("  >>> ");
+            putBytes(processName);
+            putString(" <<<\n\njava stacktrace:\n");
+            putStackTrace(throwable);
+            putString("\n");
+
+            //the reserved file may come from a placeholder file, drop the zero padding before appending
+            flush();
+            channel.truncate(channel.position());
+            truncated = true;
+
+            //logcat, FDs, network info and memory info
+            if (!NativeHandler.getInstance().recordJavaCrash(logPath, logcatSystemLines, logcatEventsLines, logcatMainLines, dumpFds, dumpNetworkInfo)) {
+                channel.position(channel.size());
+                putMemoryInfo();
+            }
+            flush();
+            channel.position(channel.size());
+
+            //background / foreground
+            putString("foreground:\n");
+            putString(ActivityMonitor.getInstance().isApplicationForeground() ? "yes\n\n" : "no\n\n");
+
+            //other threads
+            if (dumpAllThreads) {
+                otherThreads.put(sink, crashedThread, threads);
+            }
+            flush();
+        } catch (Throwable e) {
+            //keep what has been written
+            try {
+                flush();
+            } catch (Throwable ignored) {
+            }
+        } finally {
+            //failed before appending, drop the zero padding after what has been written
+            if (!truncated) {
+                try {
+                    channel.truncate(channel.position());
+                } catch (Throwable ignored) {
+                }
+            }
+            try {
+                raf.close();
+            } catch (Throwable ignored) {
+            }
+        }
+        return logFile;
+    }
+
+    //in the same format as Throwable.printStackTrace()
+    private void putStackTrace(Throwable throwable) throws IOException {
+        StackTraceElement[] enclosingTrace = null;
+
+        for (int i = 0; throwable != null && i < causesMax; i++) {
+            if (i > 0) {
+                putString("Caused by: ");
+            }
+            putString(throwable.getClass().getName());
+            String msg = throwable.getLocalizedMessage();
+            if (msg != null) {
+                putString(": ");
+                putString(msg);
+            }
+            putString("\n");
+
+            StackTraceElement[] trace = throwable.getStackTrace();
+            //the frames in common with the enclosing trace are omitted
+            int m = trace.length - 1;
+            if (enclosingTrace != null) {
+                int n = enclosingTrace.length - 1;
+                while (m >= 0 && n >= 0 && trace[m].equals(enclosingTrace[n])) {
+                    m--;
+                    n--;
+                }
+            }
+            for (int j = 0; j <= m; j++) {
+                JavaCrashThreads.putStackTraceElement(sink, "\tat ", trace[j]);
+            }
+            if (m < trace.length - 1) {
+                putString("\t... ");
+                putLong(trace.length - 1 - m);
+                putString(" more\n");
+            }
+
+            enclosingTrace = trace;
+            if (throwable.getCause() == throwable) {
+                break;
+            }
+            throwable = throwable.getCause();
+        }
+    }
+
+    //the native library is not loaded, only the procfs part of Util.getMemoryInfo()
+    private void putMemoryInfo() throws IOException {
+        putString("memory info:\n");
+        putString(" System Summary (From: /proc/meminfo)\n");
+        putFile("/proc/meminfo");
+        putString("-\n");
+        putString(" Process Status (From: /proc/PID/status)\n");
+        putFile("/proc/self/status");
+        putString("-\n");
+        putString(" Process Limits (From: /proc/PID/limits)\n");
+        putFile("/proc/self/limits");
+        putString("-\n");
+        putString("\n");
+    }
+
+    private void putFile(String path) throws IOException {
+        FileInputStream is = null;
+        try {
+            is = new FileInputStream(path);
+            FileChannel fc = is.getChannel();
+            while (true) {
+                if (!buf.hasRemaining()) {
+                    flush();
+                }
+                if (fc.read(buf) <= 0) {
+                    break;
+                }
+            }
+        } catch (IOException ignored) {
+        } finally {
+            if (is != null) {
+                try {
+                    is.close();
+                } catch (Exception ignored) {
+                }
+            }
+        }
+    }
+
+    //"yyyy-MM-dd'T'HH:mm:ss.SSSZ" (Util.timeFormatterStr) without SimpleDateFormat
+    private void putTime(long ms) throws IOException {
+        int offset = timeZone.getOffset(ms);
+        long local = ms + offset;
+        long days = local / 86400000L;
+        if (local % 86400000L < 0) {
+            days--;
+        }
+        long msOfDay = local - days * 86400000L;
+
+        //civil date from the days since 1970-01-01
+        long z = days + 719468;
+        long era = (z >= 0 ? z : z - 146096) / 146097;
+        long doe = z - era * 146097;
+        long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        long mp = (5 * doy + 2) / 153;
+        long day = doy - (153 * mp + 2) / 5 + 1;
+        long month = (mp < 10 ? mp + 3 : mp - 9);
+        long year = yoe + era * 400 + (month <= 2 ? 1 : 0);
+
+        putDigits(year, 4);
+        putString("-");
+        putDigits(month, 2);
+        putString("-");
+        putDigits(day, 2);
+        putString("T");
+        putDigits(msOfDay / 3600000, 2);
+        putString(":");
+        putDigits(msOfDay / 60000 % 60, 2);
+        putString(":");
+        putDigits(msOfDay / 1000 % 60, 2);
+        putString(".");
+        putDigits(msOfDay % 1000, 3);
+        putString(offset < 0 ? "-" : "+");
+        int absOffset = Math.abs(offset);
+        putDigits(absOffset / 3600000, 2);
+        putDigits(absOffset / 60000 % 60, 2);
+    }
+
+    private void putDigits(long value, int width) throws IOException {
+        ensure(width);
+        for (int i = width - 1; i >= 0; i--) {
+            digits[i] = (byte) ('0' + value % 10);
+            value /= 10;
+        }
+        buf.put(digits, 0, width);
+    }
+
+    private void putLong(long value) throws IOException {
+        ensure(digits.length + 1);
+        if (value < 0) {
+            buf.put((byte) '-');
+            value = -value;
+        }
+        int i = digits.length;
+        do {
+            digits[--i] = (byte) ('0' + value % 10);
+            value /= 10;
+        } while (value > 0 && i > 0);
+        buf.put(digits, i, digits.length - i);
+    }
+
+    //UTF-8 encoded, the same as String.getBytes("UTF-8")
+    private void putString(String s) throws IOException {
+        int len = s.length();
+        for (int i = 0; i < len; i++) {
+            char c = s.charAt(i);
+            ensure(4);
+            if (c < 0x80) {
+                buf.put((byte) c);
+            } else if (c < 0x800) {
+                buf.put((byte) (0xc0 | (c >> 6)));
+                buf.put((byte) (0x80 | (c & 0x3f)));
+            } else if (Character.isHighSurrogate(c) && i + 1 < len && Character.isLowSurrogate(s.charAt(i + 1))) {
+                int cp = Character.toCodePoint(c, s.charAt(++i));
+                buf.put((byte) (0xf0 | (cp >> 18)));
+                buf.put((byte) (0x80 | ((cp >> 12) & 0x3f)));
+                buf.put((byte) (0x80 | ((cp >> 6) & 0x3f)));
+                buf.put((byte) (0x80 | (cp & 0x3f)));
+            } else if (c >= Character.MIN_SURROGATE && c <= Character.MAX_SURROGATE) {
+                buf.put((byte) '?');
+            } else {
+                buf.put((byte) (0xe0 | (c >> 12)));
+                buf.put((byte) (0x80 | ((c >> 6) & 0x3f)));
+                buf.put((byte) (0x80 | (c & 0x3f)));
+            }
+        }
+    }
+
+    private void putBytes(byte[] bytes) throws IOException {
+        putBytes(bytes, 0, bytes.length);
+    }
+
+    private void putBytes(byte[] bytes, int offset, int len) throws IOException {
+        while (len > 0) {
+            if (!buf.hasRemaining()) {
+                flush();
+            }
+            int n = Math.min(len, buf.remaining());
+            buf.put(bytes, offset, n);
+            offset += n;
+            len -= n;
+        }
+    }
+
+    private void ensure(int len) throws IOException {
+        if (buf.remaining() < len) {
+            flush();
+        }
+    }
+
+    private void flush() throws IOException {
+        buf.flip();
+        while (buf.hasRemaining()) {
+            channel.write(buf);
+        }
+        buf.clear();
+    }
+}
@@ -0,0 +1,185 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// Created by agent on 2026-10-17.
+package xcrash;
+
+import android.os.SystemClock;
+
+import java.io.IOException;
+import java.util.List;
+import java.util.regex.Pattern;
+
+/**
+ * The "other threads" section of the Java crash log file, shared by {@link xcrash.JavaCrashHandler} and
+ * {@link xcrash.JavaCrashOomWriter}, only the sink differs.
+ *
+ * <p>Only the matched threads are walked (not suspending all of them as Thread.getAllStackTraces()), within the
+ * count and time limits. Nothing else is allocated here if the threads array is given, so it works for
+ * {@link OutOfMemoryError} with a sink which doesn't allocate either.
+ */
+class JavaCrashThreads {
+
+    interface Sink {
+        void putString(String s) throws IOException;
+
+        void putLong(long value) throws IOException;
+    }
+
+    private final int pid;
+    private final String processName;
+    private final int countMax;
+    private final int timeoutMs;
+    private final List<Pattern> whiteList;
+    private final ThreadGroup rootGroup;
+
+    JavaCrashThreads(int pid, String processName, int countMax, int timeoutMs, List<Pattern> whiteList, ThreadGroup rootGroup) {
+        this.pid = pid;
+        this.processName = processName;
+        this.countMax = countMax;
+        this.timeoutMs = timeoutMs;
+        this.whiteList = whiteList;
+        this.rootGroup = rootGroup;
+    }
+
+    //the threads array is used for enumerating, allocated by the active count if it's null
+    void put(Sink sink, Thread crashedThread, Thread[] threads) throws IOException {
+        long deadline = (timeoutMs > 0 ? SystemClock.uptimeMillis() + timeoutMs : 0);
+
+        int thdTotal = 0;
+        int thdMatchedRegex = 0;
+        int thdIgnoredByLimit = 0;
+        int thdIgnoredByTimeout = 0;
+        int thdDumped = 0;
+
+        if (threads == null) {
+            threads = new Thread[rootGroup.activeCount() + 16];
+        }
+        int count = rootGroup.enumerate(threads, true);
+        for (int i = 0; i < count; i++) {
+            Thread thd = threads[i];
+            threads[i] = null;
+
+            //skip the crashed thread
+            if (thd == null || thd == crashedThread) continue;
+            thdTotal++;
+
+            //check regex for thread name
+            String name = thd.getName();
+            if (whiteList != null && !matchThreadName(name)) continue;
+            thdMatchedRegex++;
+
+            //check dump count limit
+            if (countMax > 0 && thdDumped >= countMax) {
+                thdIgnoredByLimit++;
+                continue;
+            }
+
+            //check dump time limit
+            if (deadline > 0 && SystemClock.uptimeMillis() >= deadline) {
+                thdIgnoredByTimeout++;
+                continue;
+            }
+
+            sink.putString(Util.sepOtherThreads);
+            sink.putString("\npid: ");
+            sink.putLong(pid);
+            sink.putString(", tid: ");
+            sink.putLong(thd.getId());
+            sink.putString(", name: ");
+            sink.putString(name);
+            sink.putString("  >>> ");
+            sink.putString(processName);
+            sink.putString(" <<<\n\njava stacktrace:\n");
+            try {
+                for (StackTraceElement element : thd.getStackTrace()) {
+                    putStackTraceElement(sink, "    at ", element);
+                }
+            } catch (OutOfMemoryError ignored) {
+            }
+            sink.putString("\n");
+
+            thdDumped++;
+        }
+
+        if (thdTotal > 0) {
+            if (thdDumped == 0) {
+                sink.putString(Util.sepOtherThreads);
+                sink.putString("\n");
+            }
+
+            putSummary(sink, "total JVM threads (exclude the crashed thread): ", thdTotal);
+            if (whiteList != null) {
+                putSummary(sink, "JVM threads matched whitelist: ", thdMatchedRegex);
+            }
+            if (countMax > 0) {
+                putSummary(sink, "JVM threads ignored by max count limit: ", thdIgnoredByLimit);
+            }
+            if (deadline > 0) {
+                putSummary(sink, "JVM threads ignored by timeout: ", thdIgnoredByTimeout);
+            }
+            putSummary(sink, "dumped JVM threads:", thdDumped);
+            sink.putString(Util.sepOtherThreadsEnding);
+            sink.putString("\n");
+        }
+    }
+
+    //in the same format as prefix + StackTraceElement.toString()
+    static void putStackTraceElement(Sink sink, String prefix, StackTraceElement element) throws IOException {
+        sink.putString(prefix);
+        sink.putString(element.getClassName());
+        sink.putString(".");
+        sink.putString(element.getMethodName());
+        String fileName = element.getFileName();
+        if (element.isNativeMethod()) {
+            sink.putString("(Native Method)");
+        } else if (fileName != null && element.getLineNumber() >= 0) {
+            sink.putString("(");
+            sink.putString(fileName);
+            sink.putString(":");
+            sink.putLong(element.getLineNumber());
+            sink.putString(")");
+        } else if (fileName != null) {
+            sink.putString("(");
+            sink.putString(fileName);
+            sink.putString(")");
+        } else {
+            sink.putString("(Unknown Source)");
+        }
+        sink.putString("\n");
+    }
+
+    private static void putSummary(Sink sink, String label, int value) throws IOException {
+        sink.putString(label);
+        sink.putLong(value);
+        sink.putString("\n");
+    }
+
+    private boolean matchThreadName(String threadName) {
+        for (Pattern pat : whiteList) {
+            if (pat.matcher(threadName).matches()) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
@@ -25,9 +25,11 @@ package xcrash;
 import android.annotation.SuppressLint;
 import android.content.Context;
 import android.os.Build;
+import android.os.Looper;
 import android.text.TextUtils;
 
 import java.io.File;
+import java.io.IOException;
 import java.util.Map;
 
 @SuppressLint("StaticFieldLeak")
@@ -42,6 +44,9 @@ class NativeHandler {
     private boolean anrCheckProcessState;
     private ICrashCallback anrCallback;
 
+    //how long the main thread had been blocked when the ANR watchdog dumped the trace
+    private volatile long anrWatchdogBlockedMs = 0;
+
     private boolean initNativeLibOk = false;
 
     private NativeHandler() {
@@ -63,11 +68,18 @@ class NativeHandler {
                    int crashLogcatMainLines,
                    boolean crashDumpElfHash,
                    boolean crashDumpMap,
+                   boolean crashDumpMapDelta,
+                   boolean crashDumpMapSummary,
                    boolean crashDumpFds,
                    boolean crashDumpNetworkInfo,
                    boolean crashDumpAllThreads,
                    int crashDumpAllThreadsCountMax,
                    String[] crashDumpAllThreadsWhiteList,
+                   boolean crashDumpBinary,
+                   boolean crashDumpProto,
+                   boolean crashDumpMinidump,
+                   boolean crashCompressLog,
+                   boolean crashCompressDict,
                    ICrashCallback crashCallback,
                    boolean anrEnable,
                    boolean anrRethrow,
@@ -77,6 +89,8 @@ class NativeHandler {
                    int anrLogcatMainLines,
                    boolean anrDumpFds,
                    boolean anrDumpNetworkInfo,
+                   int anrThreadStatIntervalMs,
+                   int anrWatchdogTimeoutMs,
                    ICrashCallback anrCallback) {
 
         // load lib
@@ -95,6 +109,7 @@ class NativeHandler {
                 return Errno.LOAD_LIBRARY_FAILED;
             }
         }
+        InitTrace.getInstance().step("load native library");
 
         this.ctx = ctx;
         this.crashRethrow = crashRethrow;
@@ -105,6 +120,13 @@ class NativeHandler {
         // setting rethrow to "false" is NOT recommended
         this.anrTimeoutMs = anrRethrow ? 15 * 1000 : 30 * 1000;
 
+        //the newest preset dictionary for compressing the log file
+        //(the log directory is not known yet in the lazy mode, it is passed to initializeLate())
+        String crashCompressDictPath = null;
+        if (logDir != null) {
+            crashCompressDictPath = getCrashCompressDictPath(logDir, crashEnable && crashCompressLog && crashCompressDict);
+        }
+
         //init native lib
         try {
             int r = nativeInit(
@@ -126,28 +148,117 @@ class NativeHandler {
                 crashLogcatMainLines,
                 crashDumpElfHash,
                 crashDumpMap,
+                crashDumpMapDelta,
+                crashDumpMapSummary,
                 crashDumpFds,
                 crashDumpNetworkInfo,
                 crashDumpAllThreads,
                 crashDumpAllThreadsCountMax,
                 crashDumpAllThreadsWhiteList,
+                crashDumpBinary,
+                crashDumpProto,
+                crashDumpMinidump,
+                crashCompressLog,
+                crashCompressDictPath,
                 anrEnable,
                 anrRethrow,
                 anrLogcatSystemLines,
                 anrLogcatEventsLines,
                 anrLogcatMainLines,
                 anrDumpFds,
-                anrDumpNetworkInfo);
+                anrDumpNetworkInfo,
+                anrThreadStatIntervalMs);
             if (r != 0) {
                 XCrash.getLogger().e(Util.TAG, "NativeHandler init failed");
                 return Errno.INIT_LIBRARY_FAILED;
             }
             initNativeLibOk = true;
-            return 0; //OK
+            InitTrace.getInstance().step("init native library");
         } catch (Throwable e) {
             XCrash.getLogger().e(Util.TAG, "NativeHandler init failed", e);
             return Errno.INIT_LIBRARY_FAILED;
         }
+
+        //watch the main thread, dump the trace before the system gives up on it
+        if (anrEnable && anrWatchdogTimeoutMs > 0) {
+            try {
+                AnrWatchdog.getInstance().initialize(anrWatchdogTimeoutMs);
+            } catch (Throwable e) {
+                XCrash.getLogger().e(Util.TAG, "NativeHandler start ANR watchdog failed", e);
+            }
+        }
+
+        return 0; //OK
+    }
+
+    //the rest of the lazy initialization, initialize() has been called with a null log directory and the ANR disabled
+    int initializeLate(String logDir,
+                       boolean crashCompressDict,
+                       boolean anrEnable,
+                       boolean anrRethrow,
+                       boolean anrCheckProcessState,
+                       int anrLogcatSystemLines,
+                       int anrLogcatEventsLines,
+                       int anrLogcatMainLines,
+                       boolean anrDumpFds,
+                       boolean anrDumpNetworkInfo,
+                       int anrThreadStatIntervalMs,
+                       int anrWatchdogTimeoutMs,
+                       ICrashCallback anrCallback) {
+
+        if (!initNativeLibOk) {
+            return Errno.INIT_LIBRARY_FAILED;
+        }
+
+        this.anrEnable = anrEnable;
+        this.anrCheckProcessState = anrCheckProcessState;
+        this.anrCallback = anrCallback;
+        // setting rethrow to "false" is NOT recommended
+        this.anrTimeoutMs = anrRethrow ? 15 * 1000 : 30 * 1000;
+
+        try {
+            int r = nativeInitLate(
+                logDir,
+                getCrashCompressDictPath(logDir, crashCompressDict),
+                anrEnable,
+                anrRethrow,
+                anrLogcatSystemLines,
+                anrLogcatEventsLines,
+                anrLogcatMainLines,
+                anrDumpFds,
+                anrDumpNetworkInfo,
+                anrThreadStatIntervalMs);
+            if (r != 0) {
+                XCrash.getLogger().e(Util.TAG, "NativeHandler init late failed");
+                this.anrEnable = false;
+                return Errno.INIT_LIBRARY_FAILED;
+            }
+            InitTrace.getInstance().step("init native library late");
+        } catch (Throwable e) {
+            XCrash.getLogger().e(Util.TAG, "NativeHandler init late failed", e);
+            this.anrEnable = false;
+            return Errno.INIT_LIBRARY_FAILED;
+        }
+
+        //watch the main thread, dump the trace before the system gives up on it
+        if (anrEnable && anrWatchdogTimeoutMs > 0) {
+            try {
+                AnrWatchdog.getInstance().initialize(anrWatchdogTimeoutMs);
+            } catch (Throwable e) {
+                XCrash.getLogger().e(Util.TAG, "NativeHandler start ANR watchdog failed", e);
+            }
+        }
+
+        return 0; //OK
+    }
+
+    private static String getCrashCompressDictPath(String logDir, boolean crashCompressDict) {
+        if (!crashCompressDict) {
+            return null;
+        }
+
+        File dict = TombstoneDict.getCurrent(new File(logDir));
+        return dict == null ? null : dict.getPath();
     }
 
     void notifyJavaCrashed() {
@@ -156,6 +267,146 @@ class NativeHandler {
         }
     }
 
+    boolean notifyAnrWatchdog(long blockedMs) {
+        if (!initNativeLibOk || !anrEnable) {
+            return false;
+        }
+
+        try {
+            anrWatchdogBlockedMs = blockedMs;
+            return NativeHandler.nativeNotifyAnrWatchdog() == 0;
+        } catch (Throwable e) {
+            XCrash.getLogger().e(Util.TAG, "NativeHandler notify ANR watchdog failed", e);
+            return false;
+        }
+    }
+
+    String dumpNativeThreads(String[] threadNameWhiteList, int threadCountMax) {
+        if (!initNativeLibOk) {
+            return null;
+        }
+
+        try {
+            return NativeHandler.nativeDumpThreads(threadNameWhiteList, threadCountMax);
+        } catch (Throwable e) {
+            XCrash.getLogger().e(Util.TAG, "NativeHandler dump threads failed", e);
+            return null;
+        }
+    }
+
+    //append the logcat, FDs, network info and memory info to the Java crash log file, without the Java heap
+    boolean recordJavaCrash(String logPath, int logcatSystemLines, int logcatEventsLines, int logcatMainLines, boolean dumpFds, boolean dumpNetworkInfo) {
+        if (!initNativeLibOk) {
+            return false;
+        }
+
+        try {
+            return NativeHandler.nativeRecordJavaCrash(logPath, logcatSystemLines, logcatEventsLines, logcatMainLines, dumpFds, dumpNetworkInfo) == 0;
+        } catch (Throwable e) {
+            return false;
+        }
+    }
+
+    boolean refreshMapsBaseline() {
+        if (!initNativeLibOk) {
+            return false;
+        }
+
+        try {
+            return NativeHandler.nativeRefreshMapsBaseline() == 0;
+        } catch (Throwable e) {
+            XCrash.getLogger().e(Util.TAG, "NativeHandler refresh maps baseline failed", e);
+            return false;
+        }
+    }
+
+    boolean startProfile(int frequency, int durationMsMax) {
+        if (!initNativeLibOk) {
+            return false;
+        }
+
+        try {
+            return NativeHandler.nativeStartProfile(frequency, durationMsMax) == 0;
+        } catch (Throwable e) {
+            XCrash.getLogger().e(Util.TAG, "NativeHandler start profile failed", e);
+            return false;
+        }
+    }
+
+    String stopProfile() {
+        if (!initNativeLibOk) {
+            return null;
+        }
+
+        try {
+            return NativeHandler.nativeStopProfile();
+        } catch (Throwable e) {
+            XCrash.getLogger().e(Util.TAG, "NativeHandler stop profile failed", e);
+            return null;
+        }
+    }
+
+    boolean renderBinaryLog(String logPath, String textPath) {
+        if (!initNativeLibOk) {
+            return false;
+        }
+
+        try {
+            //XCC_ERRNO_MISSING: truncated, rendered as far as possible and followed by the marker
+            int r = NativeHandler.nativeRenderBinaryLog(logPath, textPath);
+            return r == 0 || r == 1007;
+        } catch (Throwable e) {
+            XCrash.getLogger().e(Util.TAG, "NativeHandler render binary log failed", e);
+            return false;
+        }
+    }
+
+    byte[] xzDecompress(byte[] data, byte[] dict) throws IOException {
+        if (!initNativeLibOk) {
+            throw new IOException("native library is not loaded");
+        }
+
+        byte[] result;
+        try {
+            result = NativeHandler.nativeXzDecompress(data, dict);
+        } catch (Throwable e) {
+            throw new IOException("xz decompress failed", e);
+        }
+        if (result == null) {
+            throw new IOException("xz decompress failed");
+        }
+        return result;
+    }
+
+    void xzAppend(String logPath, byte[] data) throws IOException {
+        if (!initNativeLibOk) {
+            throw new IOException("native library is not loaded");
+        }
+
+        int r;
+        try {
+            r = NativeHandler.nativeXzAppend(logPath, data);
+        } catch (Throwable e) {
+            throw new IOException("xz append failed", e);
+        }
+        if (r != 0) {
+            throw new IOException("xz append failed, errno=" + r);
+        }
+    }
+
+    int archiveLogs(String[] logPaths, String archivePath, int threadCount, long memoryLimit, IArchiveProgress progress) {
+        if (!initNativeLibOk) {
+            return -1;
+        }
+
+        try {
+            return NativeHandler.nativeArchiveLogs(logPaths, archivePath, threadCount, memoryLimit, progress);
+        } catch (Throwable e) {
+            XCrash.getLogger().e(Util.TAG, "NativeHandler archive logs failed", e);
+            return -1;
+        }
+    }
+
     void testNativeCrash(boolean runInNewThread) {
         if (initNativeLibOk) {
             NativeHandler.nativeTestCrash(runInNewThread ? 1 : 0);
@@ -224,7 +475,7 @@ class NativeHandler {
 
     // do NOT obfuscate this method
     @SuppressWarnings("unused")
-    private static void traceCallback(String logPath, String emergency) {
+    private static void traceCallback(String logPath, String emergency, boolean byWatchdog) {
         if (TextUtils.isEmpty(logPath)) {
             return;
         }
@@ -236,8 +487,14 @@ class NativeHandler {
         TombstoneManager.appendSection(logPath, "foreground",
                 ActivityMonitor.getInstance().isApplicationForeground() ? "yes" : "no");
 
+        //the ANR watchdog does not wait for the system, so there is no process ANR state to check
+        if (byWatchdog) {
+            TombstoneManager.appendSection(logPath, "anr watchdog",
+                    "main thread blocked: " + NativeHandler.getInstance().anrWatchdogBlockedMs + " ms");
+        }
+
         //check process ANR state
-        if (NativeHandler.getInstance().anrCheckProcessState) {
+        if (!byWatchdog && NativeHandler.getInstance().anrCheckProcessState) {
             if (!Util.checkProcessAnrState(
                     NativeHandler.getInstance().ctx,
                     NativeHandler.getInstance().anrTimeoutMs)) {
@@ -253,8 +510,9 @@ class NativeHandler {
         }
 
         //rename trace log file to ANR log file
+        String traceLogSuffix = byWatchdog ? Util.watchdogLogSuffix : Util.traceLogSuffix;
         String anrLogPath = logPath.substring(0,
-                logPath.length() - Util.traceLogSuffix.length()) + Util.anrLogSuffix;
+                logPath.length() - traceLogSuffix.length()) + Util.anrLogSuffix;
 
         File traceFile = new File(logPath);
         File anrFile = new File(anrLogPath);
@@ -273,6 +531,21 @@ class NativeHandler {
         }
     }
 
+    // do NOT obfuscate this method
+    @SuppressWarnings("unused")
+    private static String profileCallback() {
+        //"class.method;class.method", outermost frame first, as the folded stacks
+        StackTraceElement[] elements = Looper.getMainLooper().getThread().getStackTrace();
+        StringBuilder sb = new StringBuilder();
+        for (int i = elements.length - 1; i >= 0; i--) {
+            if (sb.length() > 0) {
+                sb.append(';');
+            }
+            sb.append(elements[i].getClassName()).append('.').append(elements[i].getMethodName());
+        }
+        return sb.toString();
+    }
+
     private static native int nativeInit(
             int apiLevel,
             String osVersion,
@@ -292,20 +565,60 @@ class NativeHandler {
             int crashLogcatMainLines,
             boolean crashDumpElfHash,
             boolean crashDumpMap,
+            boolean crashDumpMapDelta,
+            boolean crashDumpMapSummary,
             boolean crashDumpFds,
             boolean crashDumpNetworkInfo,
             boolean crashDumpAllThreads,
             int crashDumpAllThreadsCountMax,
             String[] crashDumpAllThreadsWhiteList,
+            boolean crashDumpBinary,
+            boolean crashDumpProto,
+            boolean crashDumpMinidump,
+            boolean crashCompressLog,
+            String crashCompressDict,
             boolean traceEnable,
             boolean traceRethrow,
             int traceLogcatSystemLines,
             int traceLogcatEventsLines,
             int traceLogcatMainLines,
             boolean traceDumpFds,
-            boolean traceDumpNetworkInfo);
+            boolean traceDumpNetworkInfo,
+            int traceThreadStatIntervalMs);
+
+    private static native int nativeInitLate(
+            String logDir,
+            String crashCompressDict,
+            boolean traceEnable,
+            boolean traceRethrow,
+            int traceLogcatSystemLines,
+            int traceLogcatEventsLines,
+            int traceLogcatMainLines,
+            boolean traceDumpFds,
+            boolean traceDumpNetworkInfo,
+            int traceThreadStatIntervalMs);
 
     private static native void nativeNotifyJavaCrashed();
 
+    private static native int nativeNotifyAnrWatchdog();
+
+    private static native String nativeDumpThreads(String[] threadNameWhiteList, int threadCountMax);
+
+    private static native int nativeRefreshMapsBaseline();
+
+    private static native int nativeStartProfile(int frequency, int durationMsMax);
+
+    private static native String nativeStopProfile();
+
+    private static native int nativeRenderBinaryLog(String logPath, String textPath);
+
+    private static native byte[] nativeXzDecompress(byte[] data, byte[] dict);
+
+    private static native int nativeXzAppend(String logPath, byte[] data);
+
+    private static native int nativeArchiveLogs(String[] logPaths, String archivePath, int threadCount, long memoryLimit, IArchiveProgress progress);
+
+    private static native int nativeRecordJavaCrash(String logPath, int logcatSystemLines, int logcatEventsLines, int logcatMainLines, boolean dumpFds, boolean dumpNetworkInfo);
+
     private static native void nativeTestCrash(int runInNewThread);
 }
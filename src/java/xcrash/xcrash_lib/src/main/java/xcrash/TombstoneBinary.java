@@ -0,0 +1,335 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Created by agent on 2026-10-17.
+package xcrash;
+
+import java.io.File;
+import java.io.FileInputStream;
+import java.io.IOException;
+import java.io.InputStream;
+import java.io.RandomAccessFile;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.List;
+import java.util.Locale;
+
+/**
+ * Render the compact binary native crash log file (see "xcc_binlog.h") to the text format.
+ */
+class TombstoneBinary {
+
+    private static final byte[] magic = {'X', 'C', 'B', 'L'};
+    private static final int version = 2;
+    private static final int versionMin = 1; //the tables are reset by every backtrace section in version 1
+    private static final int headerLen = 6;
+    private static final int mark = 0xFF;
+    private static final int sectionText = 1;
+    private static final int sectionBacktrace = 2;
+    private static final int sectionBuildId = 3;
+    private static final int sectionMemory = 4;
+    private static final int sectionEnd = 0x7F;
+    static final String truncatedMarker = "\n\nxcrash error:\nbinary log truncated\n\n"; //XCC_BINLOG_TRUNCATED_MARKER in "xcc_binlog.h"
+
+    private TombstoneBinary() {
+    }
+
+    static boolean isBinary(String logPath) {
+        RandomAccessFile raf = null;
+        try {
+            raf = new RandomAccessFile(logPath, "r");
+            byte[] head = new byte[magic.length];
+            raf.readFully(head);
+            return Arrays.equals(head, magic);
+        } catch (Exception ignored) {
+            return false;
+        } finally {
+            if (raf != null) {
+                try {
+                    raf.close();
+                } catch (Exception ignored) {
+                }
+            }
+        }
+    }
+
+    static boolean isBinary(byte[] data) {
+        return data.length >= magic.length && Arrays.equals(Arrays.copyOf(data, magic.length), magic);
+    }
+
+    static String render(String logPath) throws IOException {
+        return render(TombstoneXz.isXz(logPath) ? TombstoneXz.decompress(logPath) : readFile(logPath));
+    }
+
+    static String render(byte[] data) throws IOException {
+        if (data.length < headerLen || !Arrays.equals(Arrays.copyOf(data, magic.length), magic)
+            || data[4] < versionMin || data[4] > version || (data[5] != 4 && data[5] != 8)) {
+            throw new IOException("not a binary log file");
+        }
+        int logVersion = data[4];
+        int wordSize = data[5];
+
+        //log-wide interned tables
+        List<String> modules = new ArrayList<String>();
+        List<Long> offsets = new ArrayList<Long>();
+        List<String> funcs = new ArrayList<String>();
+
+        StringBuilder sb = new StringBuilder();
+        int pos = headerLen;
+
+        //sections
+        while (true) {
+            if (pos + 2 > data.length) {
+                return sb.append(truncatedMarker).toString(); //incomplete, render as much as we can
+            }
+            if ((data[pos] & 0xFF) != mark) {
+                throw new IOException("bad section mark");
+            }
+            int type = data[pos + 1] & 0xFF;
+            pos += 2;
+            if (type == sectionEnd) {
+                break;
+            }
+            if (pos + 4 > data.length) {
+                return sb.append(truncatedMarker).toString();
+            }
+            long len = (data[pos] & 0xFFL) | ((data[pos + 1] & 0xFFL) << 8) | ((data[pos + 2] & 0xFFL) << 16) | ((data[pos + 3] & 0xFFL) << 24);
+            pos += 4;
+            if (pos + len > data.length) {
+                return sb.append(truncatedMarker).toString();
+            }
+
+            Cursor c = new Cursor(data, pos, pos + (int) len);
+            switch (type) {
+                case sectionText:
+                    sb.append(new String(data, pos, (int) len, "UTF-8"));
+                    break;
+                case sectionBacktrace:
+                    if (logVersion == 1) {
+                        modules.clear();
+                        offsets.clear();
+                        funcs.clear();
+                    }
+                    renderBacktrace(sb, c, wordSize, modules, offsets, funcs);
+                    break;
+                case sectionBuildId:
+                    renderBuildId(sb, c);
+                    break;
+                case sectionMemory:
+                    renderMemory(sb, c, wordSize);
+                    break;
+                default:
+                    //unknown sections from a newer writer are skipped
+                    break;
+            }
+            pos += (int) len;
+        }
+
+        //the text appended after the binary part, up to the placeholder padding
+        int end = pos;
+        while (end < data.length && data[end] != 0) {
+            end++;
+        }
+        sb.append(new String(data, pos, end - pos, "UTF-8"));
+
+        return sb.toString();
+    }
+
+    private static void renderBacktrace(StringBuilder sb, Cursor c, int wordSize,
+                                        List<String> modules, List<Long> offsets, List<String> funcs) throws IOException {
+        long framesNum = c.varint();
+
+        //new entries of the interned tables
+        int n = c.count();
+        for (int i = 0; i < n; i++) {
+            modules.add(c.string());
+            offsets.add(c.varint());
+        }
+        n = c.count();
+        for (int i = 0; i < n; i++) {
+            funcs.add(c.string());
+        }
+
+        String addrFmt = "%0" + (wordSize * 2) + "x";
+        sb.append("backtrace:\n");
+        for (long i = 0; i < framesNum; i++) {
+            int module = (int) c.varint();
+            long relPc = c.varint();
+            int func = (int) c.varint();
+            long funcOffset = c.varint();
+            if (module < 0 || module > modules.size() || func < 0 || func > funcs.size()) {
+                throw new IOException("bad frame");
+            }
+
+            sb.append(String.format(Locale.US, "    #%02d pc " + addrFmt + "  ", i, relPc));
+            sb.append(module == 0 ? "<unknown>" : modules.get(module - 1));
+            if (module != 0 && offsets.get(module - 1) != 0) {
+                sb.append(String.format(Locale.US, " (offset 0x%x)", offsets.get(module - 1)));
+            }
+            if (func != 0) {
+                sb.append(" (").append(funcs.get(func - 1));
+                if (funcOffset > 0) {
+                    sb.append('+').append(funcOffset);
+                }
+                sb.append(')');
+            }
+            sb.append('\n');
+        }
+        sb.append('\n');
+    }
+
+    private static void renderBuildId(StringBuilder sb, Cursor c) throws IOException {
+        sb.append("build id:\n");
+        while (c.pos < c.end) {
+            String name = c.string();
+            byte[] buildId = c.bytes();
+            String tail = c.string();
+
+            sb.append("    ").append(name).append(" (BuildId: ");
+            if (buildId.length == 0) {
+                sb.append("unknown");
+            } else {
+                for (byte b : buildId) {
+                    sb.append(String.format(Locale.US, "%02x", b & 0xFF));
+                }
+            }
+            sb.append(tail);
+        }
+        sb.append('\n');
+    }
+
+    private static void renderMemory(StringBuilder sb, Cursor c, int wordSize) throws IOException {
+        String wordFmt = " %0" + (wordSize * 2) + "x";
+        while (c.pos < c.end) {
+            String label = c.string();
+            long addr = c.varint();
+            long start = c.varint();
+            long total = c.varint();
+            byte[] data = c.bytes();
+
+            sb.append("memory near ").append(label).append(":\n");
+
+            //16 bytes per line, only the readable words are saved in data
+            int dataIdx = 0;
+            long current = 0;
+            for (int j = 0; j < data.length / 16; j++) {
+                StringBuilder ascii = new StringBuilder();
+                sb.append(String.format(Locale.US, "    %0" + (wordSize * 2) + "x", addr));
+                addr += 16;
+
+                for (int i = 0; i < 16 / wordSize; i++) {
+                    if (current >= start && current + wordSize <= total && dataIdx + wordSize <= data.length) {
+                        long word = 0;
+                        for (int k = wordSize - 1; k >= 0; k--) {
+                            word = (word << 8) | (data[dataIdx + k] & 0xFFL);
+                        }
+                        sb.append(String.format(Locale.US, wordFmt, word));
+                        for (int k = 0; k < wordSize; k++) {
+                            int ch = data[dataIdx + k] & 0xFF;
+                            ascii.append((ch >= 0x20 && ch < 0x7f) ? (char) ch : '.');
+                        }
+                        dataIdx += wordSize;
+                    } else {
+                        sb.append(' ');
+                        for (int k = 0; k < wordSize * 2; k++) {
+                            sb.append('-');
+                        }
+                        for (int k = 0; k < wordSize; k++) {
+                            ascii.append('.');
+                        }
+                    }
+                    current += wordSize;
+                }
+                sb.append("  ").append(ascii).append('\n');
+            }
+            sb.append('\n');
+        }
+    }
+
+    static byte[] readFile(String logPath) throws IOException {
+        File file = new File(logPath);
+        byte[] data = new byte[(int) file.length()];
+        InputStream is = new FileInputStream(file);
+        try {
+            int n = 0;
+            while (n < data.length) {
+                int r = is.read(data, n, data.length - n);
+                if (r < 0) {
+                    break;
+                }
+                n += r;
+            }
+            return n == data.length ? data : Arrays.copyOf(data, n);
+        } finally {
+            is.close();
+        }
+    }
+
+    private static class Cursor {
+        private final byte[] buf;
+        private int pos;
+        private final int end;
+
+        Cursor(byte[] buf, int pos, int end) {
+            this.buf = buf;
+            this.pos = pos;
+            this.end = end;
+        }
+
+        long varint() throws IOException {
+            long v = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                if (pos >= end) {
+                    throw new IOException("truncated varint");
+                }
+                byte b = buf[pos++];
+                v |= (long) (b & 0x7F) << shift;
+                if ((b & 0x80) == 0) {
+                    return v;
+                }
+            }
+            throw new IOException("bad varint");
+        }
+
+        //every entry takes at least one byte
+        int count() throws IOException {
+            long n = varint();
+            if (n < 0 || n > end - pos) {
+                throw new IOException("bad count");
+            }
+            return (int) n;
+        }
+
+        byte[] bytes() throws IOException {
+            int n = count();
+            byte[] b = Arrays.copyOfRange(buf, pos, pos + n);
+            pos += n;
+            return b;
+        }
+
+        String string() throws IOException {
+            int n = count();
+            String s = new String(buf, pos, n, "UTF-8");
+            pos += n;
+            return s;
+        }
+    }
+}
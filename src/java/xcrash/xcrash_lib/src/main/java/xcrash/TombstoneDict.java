@@ -0,0 +1,242 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// Created by agent on 2026-10-17.
+package xcrash;
+
+import java.io.File;
+import java.io.FileOutputStream;
+import java.io.FilenameFilter;
+import java.io.IOException;
+import java.util.Arrays;
+import java.util.Comparator;
+import java.util.HashMap;
+import java.util.HashSet;
+import java.util.Locale;
+import java.util.Map;
+import java.util.Set;
+import java.util.zip.CRC32;
+
+/**
+ * The preset dictionary for compressing the native crash log files (see "xcd_util_xz_compress_dict()" in "xcd_util.c").
+ *
+ * <p>It's built from the lines shared by the recent native crash log files, and saved in the log directory
+ * named by its ID (CRC32 of the content). The newest one is used by the native crash handler, the old ones are
+ * kept until no log file refers to them. A log file compressed with it is decoded with the dictionary file only.
+ */
+class TombstoneDict {
+
+    private static final String prefix = "dictionary";
+    private static final String suffix = ".dict.xcrash";
+    private static final int sizeMax = 64 * 1024; //XCC_UTIL_XZ_DICT_SIZE_MAX in "xcc_util.h"
+    private static final int sampleCountMax = 4;
+
+    private static final FilenameFilter dictFilter = new FilenameFilter() {
+        @Override
+        public boolean accept(File dir, String name) {
+            return name.startsWith(prefix + "_") && name.endsWith(suffix);
+        }
+    };
+
+    private static final FilenameFilter nativeLogFilter = new FilenameFilter() {
+        @Override
+        public boolean accept(File dir, String name) {
+            return name.startsWith(Util.logPrefix + "_") && Util.isLogFile(name, Util.nativeLogSuffix);
+        }
+    };
+
+    private TombstoneDict() {
+    }
+
+    static String getName(int id) {
+        return String.format(Locale.US, "%s_%08x%s", prefix, id, suffix);
+    }
+
+    static File getCurrent(File dir) {
+        File[] files = dir.listFiles(dictFilter);
+        File current = null;
+        if (files != null) {
+            for (File file : files) {
+                if (current == null || file.lastModified() > current.lastModified()) {
+                    current = file;
+                }
+            }
+        }
+        return current;
+    }
+
+    static byte[] load(File dir, int id) throws IOException {
+        File file = new File(dir, getName(id));
+        if (!file.exists()) {
+            throw new IOException("xz dictionary not found: " + file.getName());
+        }
+        byte[] dict = TombstoneBinary.readFile(file.getPath());
+        if (crc32(dict) != id) {
+            throw new IOException("xz dictionary mismatch: " + file.getName());
+        }
+        return dict;
+    }
+
+    //rebuild the dictionary if there are newer native crash log files
+    static boolean needUpdate(File dir) {
+        File newest = getNewestLog(dir);
+        File current = getCurrent(dir);
+        return newest != null && (current == null || newest.lastModified() > current.lastModified());
+    }
+
+    @SuppressWarnings("ResultOfMethodCallIgnored")
+    static void update(File dir) throws IOException {
+        File[] logs = dir.listFiles(nativeLogFilter);
+        if (logs == null) {
+            return;
+        }
+
+        //newest first
+        Arrays.sort(logs, new Comparator<File>() {
+            @Override
+            public int compare(File f1, File f2) {
+                return f2.getName().compareTo(f1.getName());
+            }
+        });
+
+        //build and save the new dictionary
+        if (needUpdate(dir)) {
+            byte[] dict = build(logs);
+            if (dict != null) {
+                File file = new File(dir, getName(crc32(dict)));
+                if (file.exists()) {
+                    file.setLastModified(System.currentTimeMillis());
+                } else {
+                    File tmp = new File(file.getPath() + ".tmp");
+                    FileOutputStream fos = new FileOutputStream(tmp);
+                    try {
+                        fos.write(dict);
+                    } finally {
+                        fos.close();
+                    }
+                    if (!tmp.renameTo(file)) {
+                        tmp.delete();
+                    }
+                }
+            }
+        }
+
+        //remove the old dictionaries which are not used by any log file
+        Set<Long> used = new HashSet<Long>();
+        for (File log : logs) {
+            used.add(TombstoneXz.getDictId(log.getPath()));
+        }
+        File current = getCurrent(dir);
+        File[] files = dir.listFiles(dictFilter);
+        if (files != null) {
+            for (File file : files) {
+                if (!file.equals(current) && !used.contains(parseId(file.getName()))) {
+                    file.delete();
+                }
+            }
+        }
+    }
+
+    private static File getNewestLog(File dir) {
+        File[] logs = dir.listFiles(nativeLogFilter);
+        File newest = null;
+        if (logs != null) {
+            for (File log : logs) {
+                if (newest == null || log.lastModified() > newest.lastModified()) {
+                    newest = log;
+                }
+            }
+        }
+        return newest;
+    }
+
+    private static byte[] build(File[] logs) throws IOException {
+        //read the recent log files as lines, newest first
+        String[][] samples = new String[Math.min(logs.length, sampleCountMax)][];
+        int sampleCount = 0;
+        for (int i = 0; i < logs.length && sampleCount < samples.length; i++) {
+            try {
+                samples[sampleCount] = readLines(logs[i].getPath());
+                sampleCount++;
+            } catch (Exception ignored) {
+            }
+        }
+        if (sampleCount == 0) {
+            return null;
+        }
+
+        //count the log files containing each line
+        Map<String, Integer> counts = new HashMap<String, Integer>();
+        for (int i = 0; i < sampleCount; i++) {
+            for (String line : new HashSet<String>(Arrays.asList(samples[i]))) {
+                Integer count = counts.get(line);
+                counts.put(line, count == null ? 1 : count + 1);
+            }
+        }
+
+        //the shared lines in the order of the newest log file (the whole file if there is only one)
+        int countMin = Math.min(2, sampleCount);
+        Set<String> added = new HashSet<String>();
+        StringBuilder sb = new StringBuilder();
+        for (String line : samples[0]) {
+            if (line.length() == 0 || counts.get(line) < countMin || !added.add(line)) {
+                continue;
+            }
+            if (sb.length() + line.length() + 1 > sizeMax) {
+                break;
+            }
+            sb.append(line).append('\n');
+        }
+        if (sb.length() == 0) {
+            return null;
+        }
+
+        byte[] dict = sb.toString().getBytes("UTF-8");
+        return dict.length > sizeMax ? Arrays.copyOf(dict, sizeMax) : dict;
+    }
+
+    static String[] readLines(String logPath) throws IOException {
+        byte[] data = (TombstoneXz.isXz(logPath) ? TombstoneXz.decompress(logPath) : TombstoneBinary.readFile(logPath));
+        String text = (TombstoneBinary.isBinary(data) ? TombstoneBinary.render(data) : new String(data, "UTF-8"));
+
+        //the log file may come from a placeholder file, drop the zero padding at the end
+        int end = text.length();
+        while (end > 0 && text.charAt(end - 1) == '\0') {
+            end--;
+        }
+        return text.substring(0, end).split("\n");
+    }
+
+    private static long parseId(String name) {
+        try {
+            return Long.parseLong(name.substring(prefix.length() + 1, name.length() - suffix.length()), 16);
+        } catch (Exception ignored) {
+            return -1;
+        }
+    }
+
+    private static int crc32(byte[] data) {
+        CRC32 crc = new CRC32();
+        crc.update(data, 0, data.length);
+        return (int) crc.getValue();
+    }
+}
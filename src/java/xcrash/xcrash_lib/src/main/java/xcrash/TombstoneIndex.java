@@ -0,0 +1,228 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// Created by agent on 2026-10-17.
+package xcrash;
+
+import java.io.File;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.io.RandomAccessFile;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.util.Arrays;
+
+/**
+ * Section index of the crash log file (see "xcc_index.h").
+ *
+ * <p>The index file is saved next to the log file when it's finished, it holds the offset and length of the head
+ * and each section in the plain text (before compressing), so a single section can be read without parsing the
+ * whole log file. The sections appended later (after the indexed length) are not indexed.
+ */
+class TombstoneIndex {
+
+    static final String keyHead = "head"; //XCC_INDEX_KEY_HEAD in "xcc_index.h"
+    static final int keyLen = 48;
+
+    private static final byte[] magic = {'X', 'C', 'I', 'X'};
+    private static final int version = 1;
+    private static final int headerLen = 16;
+    private static final int entryLen = keyLen + 8;
+    private static final int entriesMax = 4096;
+
+    private static final int statusUnknown = 0;
+    private static final int statusHead = 1;
+    private static final int statusSection = 2;
+    private static final int statusThreads = 3;
+
+    final int indexedLen;
+    final String[] keys;
+    final int[] offsets;
+    final int[] lengths;
+
+    private TombstoneIndex(int indexedLen, int count) {
+        this.indexedLen = indexedLen;
+        this.keys = new String[count];
+        this.offsets = new int[count];
+        this.lengths = new int[count];
+    }
+
+    static String getPath(String logPath) {
+        return Util.trimXzSuffix(logPath) + Util.indexSuffix;
+    }
+
+    //the same rules as "xcc_index_build()" in "xcc_index.c"
+    static void build(String logPath) throws IOException {
+        byte[] data = TombstoneBinary.readFile(logPath);
+        byte[] head = Util.sepHead.getBytes("UTF-8");
+        byte[] threadSep = Util.sepOtherThreads.getBytes("UTF-8");
+        byte[] threadEnd = Util.sepOtherThreadsEnding.getBytes("UTF-8");
+
+        //the placeholder file is padded with zeros
+        int end = 0;
+        while (end < data.length && data[end] != 0) {
+            end++;
+        }
+
+        ByteBuffer entries = ByteBuffer.allocate(entryLen * 32).order(ByteOrder.LITTLE_ENDIAN);
+        int status = statusUnknown;
+        byte[] key = null;
+        int begin = 0;
+        int lineEnd;
+        for (int line = 0; line < end; line = Math.min(lineEnd + 1, end)) {
+            lineEnd = line;
+            while (lineEnd < end && data[lineEnd] != '\n') {
+                lineEnd++;
+            }
+            int next = Math.min(lineEnd + 1, end);
+            int len = lineEnd - line;
+
+            boolean finished = false;
+            switch (status) {
+                case statusUnknown:
+                    begin = line;
+                    if (regionEquals(data, line, len, head)) {
+                        status = statusHead;
+                        key = keyHead.getBytes("UTF-8");
+                    } else if (regionEquals(data, line, len, threadSep)) {
+                        status = statusThreads;
+                        key = TombstoneParser.keyOtherThreads.getBytes("UTF-8");
+                    } else if (len > 1 && data[lineEnd - 1] == ':') {
+                        status = statusSection;
+                        key = (len - 1 < keyLen ? Arrays.copyOfRange(data, line, lineEnd - 1) : null);
+                    }
+                    break;
+                case statusHead:
+                case statusSection:
+                    finished = (len == 0);
+                    break;
+                case statusThreads:
+                    finished = regionEquals(data, line, len, threadEnd);
+                    break;
+                default:
+                    break;
+            }
+
+            if (finished || (status != statusUnknown && next == end)) {
+                //the unfinished entry ends at the indexed length
+                entries = putEntry(entries, key, begin, next - begin);
+                status = statusUnknown;
+            }
+        }
+
+        ByteBuffer header = ByteBuffer.allocate(headerLen).order(ByteOrder.LITTLE_ENDIAN);
+        header.put(magic).putInt(version).putInt(entries.position() / entryLen).putInt(end);
+
+        File file = new File(getPath(logPath));
+        File tmp = new File(file.getPath() + ".tmp");
+        FileOutputStream os = new FileOutputStream(tmp);
+        try {
+            os.write(header.array());
+            os.write(entries.array(), 0, entries.position());
+        } finally {
+            os.close();
+        }
+        if (!tmp.renameTo(file)) {
+            //noinspection ResultOfMethodCallIgnored
+            tmp.delete();
+            throw new IOException("rename index file failed");
+        }
+    }
+
+    static TombstoneIndex load(String logPath) {
+        RandomAccessFile raf = null;
+        try {
+            File file = new File(getPath(logPath));
+            if (!file.exists()) {
+                return null;
+            }
+
+            raf = new RandomAccessFile(file, "r");
+            byte[] data = new byte[(int) raf.length()];
+            raf.readFully(data);
+            ByteBuffer buf = ByteBuffer.wrap(data).order(ByteOrder.LITTLE_ENDIAN);
+
+            byte[] fileMagic = new byte[magic.length];
+            buf.get(fileMagic);
+            if (!Arrays.equals(fileMagic, magic) || buf.getInt() != version) {
+                return null;
+            }
+            int count = buf.getInt();
+            int indexedLen = buf.getInt();
+            if (count < 0 || count > entriesMax || data.length != headerLen + count * entryLen) {
+                return null;
+            }
+
+            TombstoneIndex index = new TombstoneIndex(indexedLen, count);
+            byte[] key = new byte[keyLen];
+            for (int i = 0; i < count; i++) {
+                buf.get(key);
+                int n = 0;
+                while (n < keyLen && key[n] != 0) {
+                    n++;
+                }
+                index.keys[i] = new String(key, 0, n, "UTF-8");
+                index.offsets[i] = buf.getInt();
+                index.lengths[i] = buf.getInt();
+                if (index.offsets[i] < 0 || index.lengths[i] < 0 || index.offsets[i] + index.lengths[i] > indexedLen) {
+                    return null;
+                }
+            }
+            return index;
+        } catch (Exception ignored) {
+            return null;
+        } finally {
+            if (raf != null) {
+                try {
+                    raf.close();
+                } catch (Exception ignored) {
+                }
+            }
+        }
+    }
+
+    private static ByteBuffer putEntry(ByteBuffer entries, byte[] key, int offset, int length) {
+        if (key == null || entries.position() >= entriesMax * entryLen) {
+            return entries;
+        }
+        if (entries.remaining() < entryLen) {
+            ByteBuffer bigger = ByteBuffer.allocate(entries.capacity() * 2).order(ByteOrder.LITTLE_ENDIAN);
+            entries.flip();
+            bigger.put(entries);
+            entries = bigger;
+        }
+        entries.put(key).put(new byte[keyLen - key.length]).putInt(offset).putInt(length);
+        return entries;
+    }
+
+    private static boolean regionEquals(byte[] data, int offset, int len, byte[] str) {
+        if (len != str.length) {
+            return false;
+        }
+        for (int i = 0; i < len; i++) {
+            if (data[offset + i] != str[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
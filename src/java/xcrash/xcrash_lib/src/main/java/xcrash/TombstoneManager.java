@@ -25,9 +25,12 @@ package xcrash;
 import android.text.TextUtils;
 
 import java.io.File;
+import java.io.FileOutputStream;
 import java.io.FilenameFilter;
 import java.util.Arrays;
 import java.util.Comparator;
+import java.util.HashMap;
+import java.util.Map;
 
 /**
  * Tombstone (crash) log file manager.
@@ -62,6 +65,80 @@ public class TombstoneManager {
         return FileManager.getInstance().appendText(logPath, "\n\n" + key + ":\n" + content + "\n\n");
     }
 
+    /**
+     * Convert a native crash log file written in the compact binary format
+     * (see {@link xcrash.XCrash.InitParameters#setNativeDumpBinary(boolean)}) to the text format.
+     *
+     * <p>Note: {@link xcrash.TombstoneParser} reads the binary format directly,
+     * this method is only needed when you want to view or upload the text version.
+     * A truncated binary log file (the dumper was killed before it finished) is rendered as far as possible,
+     * followed by an "xcrash error" section saying "binary log truncated".
+     *
+     * @param logPath Absolute path of the binary crash log file.
+     * @param textPath Absolute path of the text file to write.
+     * @return Return true if successful, false otherwise.
+     */
+    @SuppressWarnings("unused")
+    public static boolean renderBinaryTombstone(String logPath, String textPath) {
+        if (TextUtils.isEmpty(logPath) || TextUtils.isEmpty(textPath)) {
+            return false;
+        }
+
+        //try the native converter first
+        if (NativeHandler.getInstance().renderBinaryLog(logPath, textPath)) {
+            return true;
+        }
+
+        FileOutputStream os = null;
+        try {
+            String text = TombstoneBinary.render(logPath);
+            os = new FileOutputStream(textPath);
+            os.write(text.getBytes("UTF-8"));
+            return true;
+        } catch (Exception e) {
+            XCrash.getLogger().e(Util.TAG, "TombstoneManager renderBinaryTombstone failed", e);
+            return false;
+        } finally {
+            if (os != null) {
+                try {
+                    os.close();
+                } catch (Exception ignored) {
+                }
+            }
+        }
+    }
+
+    /**
+     * Pack the tombstone files into one XZ compressed tar archive (*.tar.xz), for uploading them at one time.
+     *
+     * <p>Note: The files are compressed by the native threads, each of them writes an independent XZ stream
+     * to the archive, it can be extracted by "tar -xJf". This method blocks until the archiving finished
+     * or cancelled, please call it in a worker thread.
+     *
+     * @param files The tombstone files (and the files go with them, such as the protobuf tombstone and the minidump).
+     * @param archivePath Absolute path of the archive file to write.
+     * @param threadCount Count of the compressing threads, 0 for the count of the CPU cores (8 at most).
+     * @param memoryLimit Memory limit of the compressing threads in bytes, 0 for the default (64MB).
+     * @param progress The progress callback, it can be null.
+     * @return Return true if successful, false otherwise (including cancelled by the progress callback).
+     */
+    @SuppressWarnings("unused")
+    public static boolean archiveTombstones(File[] files, String archivePath, int threadCount, long memoryLimit, IArchiveProgress progress) {
+        if (files == null || files.length == 0 || TextUtils.isEmpty(archivePath) || threadCount < 0 || memoryLimit < 0) {
+            return false;
+        }
+
+        String[] logPaths = new String[files.length];
+        for (int i = 0; i < files.length; i++) {
+            if (files[i] == null) {
+                return false;
+            }
+            logPaths[i] = files[i].getAbsolutePath();
+        }
+
+        return NativeHandler.getInstance().archiveLogs(logPaths, archivePath, threadCount, memoryLimit, progress) == 0;
+    }
+
     /**
      * Determines if the current log file recorded a Java exception.
      *
@@ -81,7 +158,7 @@ public class TombstoneManager {
      */
     @SuppressWarnings("unused")
     public static boolean isNativeCrash(File log) {
-        return log.getName().endsWith(Util.nativeLogSuffix);
+        return Util.isLogFile(log.getName(), Util.nativeLogSuffix);
     }
 
     /**
@@ -95,6 +172,120 @@ public class TombstoneManager {
         return log.getName().endsWith(Util.anrLogSuffix);
     }
 
+    /**
+     * Get the protobuf tombstone (Android platform's tombstone.proto) saved next to a native crash log file.
+     *
+     * @param log Object of the native crash log file.
+     * @return The protobuf tombstone file, or null if it does not exist.
+     */
+    @SuppressWarnings("unused")
+    public static File getNativeTombstoneProto(File log) {
+        if (log == null || !Util.isLogFile(log.getName(), Util.nativeLogSuffix)) {
+            return null;
+        }
+
+        File proto = new File(Util.trimXzSuffix(log.getPath()) + Util.nativeProtoSuffix);
+        return proto.exists() ? proto : null;
+    }
+
+    /**
+     * Get the Breakpad compatible minidump saved next to a native crash log file.
+     *
+     * @param log Object of the native crash log file.
+     * @return The minidump file, or null if it does not exist.
+     */
+    @SuppressWarnings("unused")
+    public static File getNativeTombstoneMinidump(File log) {
+        if (log == null || !Util.isLogFile(log.getName(), Util.nativeLogSuffix)) {
+            return null;
+        }
+
+        File minidump = new File(Util.trimXzSuffix(log.getPath()) + Util.nativeMinidumpSuffix);
+        return minidump.exists() ? minidump : null;
+    }
+
+    /**
+     * Get the preset dictionary needed for decoding a native crash log file compressed with it.
+     *
+     * <p>Note: Upload it together with the log file if the log file is decoded on the server side.
+     *
+     * @param log Object of the native crash log file.
+     * @return The dictionary file, or null if the log file is not compressed with a dictionary or the dictionary does not exist.
+     */
+    @SuppressWarnings("unused")
+    public static File getNativeTombstoneDictionary(File log) {
+        if (log == null || !Util.isLogFile(log.getName(), Util.nativeLogSuffix)) {
+            return null;
+        }
+
+        long id = TombstoneXz.getDictId(log.getPath());
+        if (id < 0) {
+            return null;
+        }
+        File dict = new File(log.getParentFile(), TombstoneDict.getName((int) id));
+        return dict.exists() ? dict : null;
+    }
+
+    /**
+     * Get the counters of the native crash signatures, the most frequent one first.
+     *
+     * <p>Note: The crashes are still counted after their log files are deleted.
+     *
+     * @return An array of the counters.
+     */
+    @SuppressWarnings("unused")
+    public static TombstoneSignature[] getNativeCrashSignatures() {
+        String logDir = XCrash.getLogDir();
+        if (logDir == null) {
+            return new TombstoneSignature[0];
+        }
+        return TombstoneSignature.load(new File(logDir));
+    }
+
+    /**
+     * Delete the native crash log files which have the same signature as a newer one,
+     * only the newest log file of each signature is kept.
+     *
+     * <p>Note: How many times each crash occurred can be got by {@link #getNativeCrashSignatures()}.
+     *
+     * @return The number of deleted log files.
+     */
+    @SuppressWarnings("unused")
+    public static int deleteDuplicateNativeTombstones() {
+        Map<String, File> newest = new HashMap<String, File>();
+        int deleted = 0;
+
+        for (File file : getNativeTombstones()) {
+            String signature;
+            try {
+                signature = TombstoneParser.parseSection(file.getAbsolutePath(), TombstoneParser.keyCrashSignature);
+            } catch (Exception ignored) {
+                continue;
+            }
+            if (TextUtils.isEmpty(signature)) {
+                continue;
+            }
+
+            File kept = newest.get(signature);
+            if (kept == null) {
+                newest.put(signature, file);
+                continue;
+            }
+
+            File older = kept;
+            if (file.lastModified() < kept.lastModified()) {
+                older = file;
+            } else {
+                newest.put(signature, file);
+            }
+            if (FileManager.getInstance().recycleLogFile(older)) {
+                deleted++;
+            }
+        }
+
+        return deleted;
+    }
+
     /**
      * Get all Java exception log files.
      *
@@ -135,6 +326,44 @@ public class TombstoneManager {
         return getTombstones(new String[]{Util.javaLogSuffix, Util.nativeLogSuffix, Util.anrLogSuffix});
     }
 
+    /**
+     * Get the Java exception, native crash and ANR log files which have not been marked as uploaded
+     * by {@link #markTombstoneUploaded(File)}.
+     *
+     * @return An array of File objects of the log files not uploaded yet.
+     */
+    @SuppressWarnings("unused")
+    public static File[] getNotUploadedTombstones() {
+        String[] logSuffixes = new String[]{Util.javaLogSuffix, Util.nativeLogSuffix, Util.anrLogSuffix};
+        File[] files = FileManager.getInstance().getLogFiles(logSuffixes, true);
+        return files != null ? files : getTombstones(logSuffixes);
+    }
+
+    /**
+     * Mark the tombstone file as uploaded.
+     *
+     * <p>Note: The uploaded tombstone files are deleted first when the total size of the log files exceeds
+     * the limit set by {@link XCrash.InitParameters#setLogSizeMaxKb(int)}.
+     *
+     * @param file The tombstone file object.
+     * @return Return true if successful, false otherwise.
+     */
+    @SuppressWarnings("unused")
+    public static boolean markTombstoneUploaded(File file) {
+        return file != null && FileManager.getInstance().markLogFileUploaded(file);
+    }
+
+    /**
+     * Determines if the tombstone file has been marked as uploaded.
+     *
+     * @param file The tombstone file object.
+     * @return Return true if YES, false otherwise.
+     */
+    @SuppressWarnings("unused")
+    public static boolean isTombstoneUploaded(File file) {
+        return file != null && FileManager.getInstance().isLogFileUploaded(file);
+    }
+
     /**
      * Delete the tombstone file.
      *
@@ -209,6 +438,12 @@ public class TombstoneManager {
             return new File[0];
         }
 
+        //read the manifest instead of listing the directory
+        File[] manifestFiles = FileManager.getInstance().getLogFiles(logPrefixes, false);
+        if (manifestFiles != null) {
+            return manifestFiles;
+        }
+
         File dir = new File(logDir);
         if (!dir.exists() || !dir.isDirectory()) {
             return new File[0];
@@ -221,7 +456,7 @@ public class TombstoneManager {
                     return false;
                 }
                 for (String logPrefix : logPrefixes) {
-                    if (name.endsWith(logPrefix)) {
+                    if (Util.isLogFile(name, logPrefix)) {
                         return true;
                     }
                 }
@@ -261,7 +496,7 @@ public class TombstoneManager {
                     return false;
                 }
                 for (String logPrefix : logPrefixes) {
-                    if (name.endsWith(logPrefix)) {
+                    if (Util.isLogFile(name, logPrefix)) {
                         return true;
                     }
                 }
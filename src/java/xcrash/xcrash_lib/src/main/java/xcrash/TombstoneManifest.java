@@ -0,0 +1,329 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// Created by agent on 2026-10-17.
+package xcrash;
+
+import java.io.File;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.io.RandomAccessFile;
+import java.util.ArrayList;
+import java.util.HashMap;
+import java.util.List;
+import java.util.Locale;
+import java.util.Map;
+
+/**
+ * Manifest of the log files in the log directory (see "xcc_manifest.h").
+ *
+ * <p>It's a journal of text records appended by all the writers (the Java handlers, the native dumper and
+ * the ANR trace dumper), one record per line:
+ * <pre>
+ * + type time size signature name    a new log file (time in microseconds, signature in hex or "-")
+ * s size name                        the size of the log file changed, or it has been compressed
+ * u name                             the log file has been uploaded
+ * - name                             the log file has been deleted
+ * </pre>
+ * The entries are keyed by the name without the XZ suffix. The maintain task rebuilds it from the directory
+ * listing and compacts it, the first line of the compacted file holds a generation, so the records appended
+ * later can be loaded incrementally.
+ */
+class TombstoneManifest {
+
+    static final String fileName = "manifest.xcrash"; //XCC_MANIFEST_FILENAME in "xcc_manifest.h"
+
+    private static final String generationPrefix = "#XCM1 ";
+    private static final String profileType = "profile"; //XCC_UTIL_CRASH_TYPE_PROFILE in "xcc_util.h"
+    private static final String snapshotType = "snapshot"; //XCC_UTIL_CRASH_TYPE_SNAPSHOT in "xcc_util.h"
+
+    static class Entry {
+        String type;
+        String name;
+        long time;
+        long size;
+        String signature;
+        boolean uploaded;
+    }
+
+    private final File file;
+    private final Map<String, Entry> entries = new HashMap<String, Entry>();
+    private String generation = null;
+    private long loadedLen = 0;
+
+    TombstoneManifest(File dir) {
+        this.file = new File(dir, fileName);
+    }
+
+    //the records appended by the writers are not complete until it has been rebuilt by the maintain task
+    synchronized boolean exists() throws IOException {
+        load();
+
+        return generation != null && generation.length() > 0;
+    }
+
+    synchronized List<Entry> getEntries(String[] logSuffixes) throws IOException {
+        load();
+
+        List<Entry> result = new ArrayList<Entry>();
+        for (Entry entry : entries.values()) {
+            for (String logSuffix : logSuffixes) {
+                if (Util.isLogFile(entry.name, logSuffix)) {
+                    result.add(entry);
+                    break;
+                }
+            }
+        }
+        return result;
+    }
+
+    synchronized long getSize() throws IOException {
+        load();
+
+        long size = 0;
+        for (Entry entry : entries.values()) {
+            size += entry.size;
+        }
+        return size;
+    }
+
+    synchronized boolean isUploaded(File logFile) throws IOException {
+        load();
+
+        Entry entry = entries.get(Util.trimXzSuffix(logFile.getName()));
+        return entry != null && entry.uploaded;
+    }
+
+    synchronized void add(File logFile, String type, long time, String signature) throws IOException {
+        append(String.format(Locale.US, "+ %s %d %d %s %s\n", type, time, getSize(logFile), signature == null ? "-" : signature, logFile.getName()));
+    }
+
+    synchronized void resize(File logFile) throws IOException {
+        append(String.format(Locale.US, "s %d %s\n", getSize(logFile), logFile.getName()));
+    }
+
+    synchronized void markUploaded(File logFile) throws IOException {
+        append("u " + logFile.getName() + "\n");
+    }
+
+    synchronized void remove(File logFile) throws IOException {
+        append("- " + logFile.getName() + "\n");
+    }
+
+    /**
+     * Rebuild the manifest from the log files listed in the directory, and compact it.
+     *
+     * <p>The records appended by this process are serialized with it, so they are either loaded before compacting
+     * or appended to the compacted file. The records appended by other processes while compacting may be lost,
+     * the log files are recovered from the directory listing next time (FileManager.initialize() schedules
+     * a rebuild when the number of the entries doesn't match the directory).
+     */
+    synchronized void rebuild(File[] logFiles) throws IOException {
+        load();
+
+        //keep the known entries (with the current name and size), add the unknown ones
+        Map<String, Entry> rebuilt = new HashMap<String, Entry>();
+        for (File logFile : logFiles) {
+            String name = logFile.getName();
+            String key = Util.trimXzSuffix(name);
+            Entry entry = entries.get(key);
+            if (entry == null) {
+                entry = new Entry();
+                entry.type = getType(name);
+                entry.time = getTime(logFile);
+                entry.signature = null;
+                entry.uploaded = false;
+            }
+            entry.name = name;
+            entry.size = getSize(logFile);
+            rebuilt.put(key, entry);
+        }
+
+        String newGeneration = generationPrefix + Long.toHexString(System.currentTimeMillis()) + Long.toHexString(System.nanoTime());
+        StringBuilder sb = new StringBuilder(newGeneration).append('\n');
+        for (Entry entry : rebuilt.values()) {
+            sb.append(String.format(Locale.US, "+ %s %d %d %s %s\n", entry.type, entry.time, entry.size, entry.signature == null ? "-" : entry.signature, entry.name));
+            if (entry.uploaded) {
+                sb.append("u ").append(entry.name).append('\n');
+            }
+        }
+        byte[] data = sb.toString().getBytes("UTF-8");
+
+        File tmp = new File(file.getPath() + ".tmp");
+        FileOutputStream os = new FileOutputStream(tmp);
+        try {
+            os.write(data);
+        } finally {
+            os.close();
+        }
+        if (!tmp.renameTo(file)) {
+            //noinspection ResultOfMethodCallIgnored
+            tmp.delete();
+            throw new IOException("rename manifest failed");
+        }
+
+        entries.clear();
+        entries.putAll(rebuilt);
+        generation = newGeneration;
+        loadedLen = data.length;
+    }
+
+    //the caller holds the lock, so the record is not lost by a concurrent rebuild()
+    private void append(String record) throws IOException {
+        //one record by one write, the other writers may be appending at the same time
+        FileOutputStream os = new FileOutputStream(file, true);
+        try {
+            os.write(record.getBytes("UTF-8"));
+        } finally {
+            os.close();
+        }
+    }
+
+    //load the records appended since the last time, or all of them if the file has been compacted
+    private void load() throws IOException {
+        if (!file.exists()) {
+            entries.clear();
+            generation = null;
+            loadedLen = 0;
+            return;
+        }
+
+        RandomAccessFile raf = new RandomAccessFile(file, "r");
+        try {
+            long len = raf.length();
+            String firstLine = raf.readLine();
+            String gen = (firstLine != null && firstLine.startsWith(generationPrefix)) ? firstLine : "";
+            if (!gen.equals(generation) || len < loadedLen) {
+                entries.clear();
+                generation = gen;
+                loadedLen = 0;
+            }
+            if (len == loadedLen) {
+                return;
+            }
+
+            byte[] data = new byte[(int) (len - loadedLen)];
+            raf.seek(loadedLen);
+            raf.readFully(data);
+
+            //only the complete lines, the last one may be being written
+            int begin = 0;
+            for (int i = 0; i < data.length; i++) {
+                if (data[i] == '\n') {
+                    parseRecord(new String(data, begin, i - begin, "UTF-8"));
+                    begin = i + 1;
+                }
+            }
+            loadedLen += begin;
+        } finally {
+            raf.close();
+        }
+    }
+
+    private void parseRecord(String record) {
+        if (record.length() < 3 || record.charAt(1) != ' ') {
+            return;
+        }
+
+        try {
+            switch (record.charAt(0)) {
+                case '+': {
+                    String[] fields = record.split(" ", 6);
+                    if (fields.length == 6) {
+                        Entry entry = new Entry();
+                        entry.type = fields[1];
+                        entry.time = Long.parseLong(fields[2]);
+                        entry.size = Long.parseLong(fields[3]);
+                        entry.signature = fields[4].equals("-") ? null : fields[4];
+                        entry.name = fields[5];
+                        entry.uploaded = false;
+                        entries.put(Util.trimXzSuffix(entry.name), entry);
+                    }
+                    break;
+                }
+                case 's': {
+                    String[] fields = record.split(" ", 3);
+                    if (fields.length == 3) {
+                        Entry entry = entries.get(Util.trimXzSuffix(fields[2]));
+                        if (entry != null) {
+                            entry.size = Long.parseLong(fields[1]);
+                            entry.name = fields[2];
+                        }
+                    }
+                    break;
+                }
+                case 'u': {
+                    Entry entry = entries.get(Util.trimXzSuffix(record.substring(2)));
+                    if (entry != null) {
+                        entry.uploaded = true;
+                    }
+                    break;
+                }
+                case '-':
+                    entries.remove(Util.trimXzSuffix(record.substring(2)));
+                    break;
+                default:
+                    break;
+            }
+        } catch (NumberFormatException ignored) {
+        }
+    }
+
+    //the log file and its sidecar files
+    private static long getSize(File logFile) {
+        String basePath = Util.trimXzSuffix(logFile.getPath());
+        long size = logFile.length();
+        size += new File(basePath + Util.indexSuffix).length();
+        size += new File(basePath + Util.nativeProtoSuffix).length();
+        size += new File(basePath + Util.nativeMinidumpSuffix).length();
+        return size;
+    }
+
+    private static String getType(String name) {
+        if (Util.isLogFile(name, Util.nativeLogSuffix)) {
+            return Util.nativeCrashType;
+        } else if (name.endsWith(Util.javaLogSuffix)) {
+            return Util.javaCrashType;
+        } else if (name.endsWith(Util.anrLogSuffix)) {
+            return Util.anrCrashType;
+        } else if (name.endsWith(Util.traceLogSuffix)) {
+            return Util.traceCrashType;
+        } else if (name.endsWith(Util.snapshotLogSuffix)) {
+            return snapshotType;
+        } else {
+            return profileType;
+        }
+    }
+
+    //the log files are named by the start time in microseconds: "tombstone_%020d_..."
+    private static long getTime(File logFile) {
+        String name = logFile.getName();
+        int begin = Util.logPrefix.length() + 1;
+        if (name.length() > begin + 20) {
+            try {
+                return Long.parseLong(name.substring(begin, begin + 20));
+            } catch (NumberFormatException ignored) {
+            }
+        }
+        return logFile.lastModified() * 1000;
+    }
+}
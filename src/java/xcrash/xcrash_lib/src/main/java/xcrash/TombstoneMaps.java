@@ -0,0 +1,239 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// Created by agent on 2026-10-17.
+package xcrash;
+
+import java.io.BufferedReader;
+import java.io.File;
+import java.io.FileReader;
+import java.io.FilenameFilter;
+import java.io.IOException;
+import java.math.BigInteger;
+import java.util.Comparator;
+import java.util.HashSet;
+import java.util.Locale;
+import java.util.Map;
+import java.util.Set;
+import java.util.TreeMap;
+import java.util.regex.Matcher;
+import java.util.regex.Pattern;
+
+/**
+ * The maps baseline for recording the memory map of native crashes (see "xcd_maps_record_delta()" in "xcd_maps.c").
+ *
+ * <p>The native crash handler saves the maps of the process in the log directory when it's inited, named by the
+ * hash of the content. Only the difference from the baseline is recorded in the log file, the full memory map is
+ * rebuilt from the baseline file and the difference in the same format as "xcd_maps_record()".
+ */
+class TombstoneMaps {
+
+    private static final String prefix = "maps_baseline_"; //XCC_UTIL_MAPS_BASELINE_PREFIX in "xcc_util.h"
+    private static final String suffix = ".maps.xcrash"; //XCC_UTIL_MAPS_BASELINE_SUFFIX in "xcc_util.h"
+    private static final String baselineTitle = "baseline: ";
+    private static final String totalSizeTitle = "TOTAL SIZE: ";
+
+    private static final Pattern patBaseline = Pattern.compile(
+        "^([0-9a-f]+)-([0-9a-f]+)\\s+(\\S{3})\\S?\\s+([0-9a-f]+)\\s+\\S+\\s+\\d+\\s*(.*)$");
+
+    private static final Pattern patChanged = Pattern.compile(
+        "^[+*]\\s([0-9a-f]+)-([0-9a-f]+)\\s(\\S{3})\\s([0-9a-f]+)\\s[0-9a-f]+\\s(.*?)((?:\\s\\(load base 0x[0-9a-f]+\\))?)$");
+
+    private static final Pattern patRemoved = Pattern.compile("^-\\s([0-9a-f]+)-([0-9a-f]+)$");
+
+    private static final FilenameFilter baselineFilter = new FilenameFilter() {
+        @Override
+        public boolean accept(File dir, String name) {
+            return name.startsWith(prefix) && name.endsWith(suffix);
+        }
+    };
+
+    private static final FilenameFilter nativeLogFilter = new FilenameFilter() {
+        @Override
+        public boolean accept(File dir, String name) {
+            return name.startsWith(Util.logPrefix + "_") && Util.isLogFile(name, Util.nativeLogSuffix);
+        }
+    };
+
+    //addresses are compared as unsigned numbers
+    private static final Comparator<Long> addrComparator = new Comparator<Long>() {
+        @Override
+        public int compare(Long a1, Long a2) {
+            long x1 = a1 ^ Long.MIN_VALUE;
+            long x2 = a2 ^ Long.MIN_VALUE;
+            return x1 < x2 ? -1 : (x1 == x2 ? 0 : 1);
+        }
+    };
+
+    private static class Entry {
+        long start;
+        long end;
+        long offset;
+        String flags;
+        String name;
+        String loadBase;
+    }
+
+    private TombstoneMaps() {
+    }
+
+    //a new baseline is saved every time the native crash handler is inited
+    static boolean needClean(File dir) {
+        File[] files = dir.listFiles(baselineFilter);
+        return files != null && files.length > 1;
+    }
+
+    @SuppressWarnings("ResultOfMethodCallIgnored")
+    static void clean(File dir) {
+        File[] files = dir.listFiles(baselineFilter);
+        if (files == null || files.length <= 1) {
+            return;
+        }
+
+        //the baselines used by the log files
+        Set<String> used = new HashSet<String>();
+        File[] logs = dir.listFiles(nativeLogFilter);
+        if (logs != null) {
+            for (File log : logs) {
+                try {
+                    for (String line : TombstoneDict.readLines(log.getPath())) {
+                        if (line.startsWith("    " + baselineTitle)) {
+                            used.add(line.substring(4 + baselineTitle.length()));
+                            break;
+                        }
+                    }
+                } catch (Exception ignored) {
+                }
+            }
+        }
+
+        //keep the newest one for the current process
+        File newest = null;
+        for (File file : files) {
+            if (newest == null || file.lastModified() > newest.lastModified()) {
+                newest = file;
+            }
+        }
+
+        //the dumper falls back to the full memory map if the baseline is missing
+        for (File file : files) {
+            if (!file.equals(newest) && !used.contains(file.getName())) {
+                file.delete();
+            }
+        }
+    }
+
+    static String rebuild(File dir, String delta, String abi) throws IOException {
+        String[] lines = delta.split("\n");
+        if (lines.length == 0 || !lines[0].startsWith(baselineTitle)) {
+            throw new IOException("maps baseline not specified");
+        }
+        String baselineName = lines[0].substring(baselineTitle.length());
+        if (!baselineName.startsWith(prefix) || !baselineName.endsWith(suffix) || baselineName.indexOf('/') >= 0) {
+            throw new IOException("maps baseline invalid: " + baselineName);
+        }
+        File baseline = new File(dir, baselineName);
+        if (!baseline.exists()) {
+            throw new IOException("maps baseline not found: " + baselineName);
+        }
+
+        //load the baseline
+        Map<Long, Entry> entries = new TreeMap<Long, Entry>(addrComparator);
+        BufferedReader br = new BufferedReader(new FileReader(baseline));
+        try {
+            String line;
+            while ((line = br.readLine()) != null) {
+                Matcher matcher = patBaseline.matcher(line);
+                if (matcher.find()) {
+                    Entry entry = new Entry();
+                    entry.start = parseHex(matcher.group(1));
+                    entry.end = parseHex(matcher.group(2));
+                    entry.flags = matcher.group(3);
+                    entry.offset = parseHex(matcher.group(4));
+                    entry.name = matcher.group(5).trim();
+                    entry.loadBase = "";
+                    entries.put(entry.start, entry);
+                }
+            }
+        } finally {
+            br.close();
+        }
+
+        //apply the difference
+        String totalSize = null;
+        for (int i = 1; i < lines.length; i++) {
+            String line = lines[i];
+            Matcher matcher;
+            if ((matcher = patChanged.matcher(line)).find()) {
+                Entry entry = new Entry();
+                entry.start = parseHex(matcher.group(1));
+                entry.end = parseHex(matcher.group(2));
+                entry.flags = matcher.group(3);
+                entry.offset = parseHex(matcher.group(4));
+                entry.name = matcher.group(5);
+                entry.loadBase = matcher.group(6);
+                entries.put(entry.start, entry);
+            } else if ((matcher = patRemoved.matcher(line)).find()) {
+                entries.remove(parseHex(matcher.group(1)));
+            } else if (line.startsWith(totalSizeTitle)) {
+                totalSize = line;
+            }
+        }
+
+        //get width of size and offset columns
+        long maxSize = 0;
+        long maxOffset = 0;
+        for (Entry entry : entries.values()) {
+            if (addrComparator.compare(entry.end - entry.start, maxSize) > 0) {
+                maxSize = entry.end - entry.start;
+            }
+            if (addrComparator.compare(entry.offset, maxOffset) > 0) {
+                maxOffset = entry.offset;
+            }
+        }
+        int widthAddr = (abi != null && abi.endsWith("64") ? 16 : 8);
+        int widthSize = Long.toHexString(maxSize).length();
+        int widthOffset = Long.toHexString(maxOffset).length();
+
+        //the same format as "xcd_maps_record()"
+        StringBuilder sb = new StringBuilder();
+        String prevName = null;
+        for (Entry entry : entries.values()) {
+            String name = entry.name;
+            if (!name.isEmpty() && name.equals(prevName)) {
+                name = ">"; //same as prev line
+            }
+            prevName = (entry.name.isEmpty() ? null : entry.name);
+
+            sb.append(String.format(Locale.US, "%0" + widthAddr + "x-%0" + widthAddr + "x %s %" + widthOffset + "x %" + widthSize + "x %s%s\n",
+                entry.start, entry.end, entry.flags, entry.offset, entry.end - entry.start, name, entry.loadBase));
+        }
+        if (totalSize != null) {
+            sb.append(totalSize).append('\n');
+        }
+        return sb.toString();
+    }
+
+    private static long parseHex(String str) {
+        return new BigInteger(str, 16).longValue();
+    }
+}
@@ -25,11 +25,14 @@ package xcrash;
 import android.os.Build;
 import android.text.TextUtils;
 
-import java.io.BufferedReader;
+import java.io.ByteArrayInputStream;
+import java.io.ByteArrayOutputStream;
 import java.io.File;
-import java.io.FileReader;
+import java.io.FileInputStream;
 import java.io.IOException;
-import java.io.StringReader;
+import java.io.RandomAccessFile;
+import java.nio.channels.Channels;
+import java.nio.channels.ReadableByteChannel;
 import java.text.DateFormat;
 import java.text.SimpleDateFormat;
 import java.util.Arrays;
@@ -55,7 +58,7 @@ public class TombstoneParser {
     public static final String keyTombstoneMaker = "Tombstone maker";
 
     /**
-     * Crash type. ("java" or "native" or "anr")
+     * Crash type. ("java" or "native" or "anr" or "trace")
      */
     @SuppressWarnings("WeakerAccess")
     public static final String keyCrashType = "Crash type";
@@ -193,6 +196,13 @@ public class TombstoneParser {
     @SuppressWarnings("WeakerAccess")
     public static final String keyAbortMessage = "Abort message";
 
+    /**
+     * Native crash signature, the same for the same crash (signal, code, top frames and abort message).
+     * (see {@link xcrash.TombstoneManager#getNativeCrashSignatures()})
+     */
+    @SuppressWarnings("WeakerAccess")
+    public static final String keyCrashSignature = "Crash signature";
+
     /**
      * Native crash registers values.
      */
@@ -229,6 +239,25 @@ public class TombstoneParser {
     @SuppressWarnings("WeakerAccess")
     public static final String keyMemoryMap = "memory map";
 
+    /**
+     * Native crash memory map, the difference from the maps baseline.
+     * (see {@link xcrash.TombstoneParser#getMemoryMap(String, java.util.Map)})
+     */
+    @SuppressWarnings("WeakerAccess")
+    public static final String keyMemoryMapDelta = "memory map delta";
+
+    /**
+     * Native crash memory map, the mappings grouped by the path or the anonymous tag.
+     */
+    @SuppressWarnings("WeakerAccess")
+    public static final String keyMemoryMapSummary = "memory map summary";
+
+    /**
+     * Native crash memory map, the mappings kept in full with the summary.
+     */
+    @SuppressWarnings("WeakerAccess")
+    public static final String keyMemoryMapExcerpt = "memory map excerpt";
+
     /**
      * Logcat.
      */
@@ -247,6 +276,18 @@ public class TombstoneParser {
     @SuppressWarnings("WeakerAccess")
     public static final String keyNetworkInfo = "network info";
 
+    /**
+     * Per-thread CPU and scheduler statistics. (From: /proc/PID/task/TID/stat, schedstat and status)
+     */
+    @SuppressWarnings("WeakerAccess")
+    public static final String keyThreadsCpu = "threads cpu";
+
+    /**
+     * System pressure. (From: /proc/pressure/*, /proc/loadavg, cpufreq and thermal zones)
+     */
+    @SuppressWarnings("WeakerAccess")
+    public static final String keySystemPressure = "system pressure";
+
     /**
      * Memory info. (From: /proc/PID/smaps)
      */
@@ -284,19 +325,9 @@ public class TombstoneParser {
     @SuppressWarnings("WeakerAccess")
     public static final String keyXCrashErrorDebug = "xcrash error debug";
 
-    private static final Pattern patHeadItem = Pattern.compile("^(.*):\\s'(.*?)'$");
-
-    private static final Pattern patProcessThread = Pattern.compile(
-            "^pid:\\s(.*),\\stid:\\s(.*),\\sname:\\s(.*)\\s+>>>\\s(.*)\\s<<<$");
-
-    private static final Pattern patProcess = Pattern.compile("^pid:\\s(.*)\\s+>>>\\s(.*)\\s<<<$");
-
-    private static final Pattern patSignalCode = Pattern.compile(
-            "^signal\\s(.*),\\scode\\s(.*),\\sfault\\saddr\\s(.*)$");
-
     private static final Pattern patAppVersionProcessName = Pattern.compile("^(\\d{20})_(.*)__(.*)$");
 
-    private static final Set<String> keyHeadItems = new HashSet<String>(Arrays.asList(
+    static final Set<String> keyHeadItems = new HashSet<String>(Arrays.asList(
         keyTombstoneMaker,
         keyCrashType,
         keyStartTime,
@@ -313,16 +344,33 @@ public class TombstoneParser {
         keyModel,
         keyBuildFingerprint,
         keyAbi,
-        keyAbortMessage
+        keyAbortMessage,
+        keyCrashSignature
+    ));
+
+    private static final Set<String> keyHeadOthers = new HashSet<String>(Arrays.asList(
+        keyProcessId,
+        keyThreadId,
+        keyThreadName,
+        keyProcessName,
+        keySignal,
+        keyCode,
+        keyFaultAddr,
+        keyRegisters
     ));
 
-    private static final Set<String> keySections = new HashSet<String>(Arrays.asList(
+    static final Set<String> keySections = new HashSet<String>(Arrays.asList(
         keyBacktrace,
         keyBuildId,
         keyStack,
         keyMemoryMap,
+        keyMemoryMapDelta,
+        keyMemoryMapSummary,
+        keyMemoryMapExcerpt,
         keyLogcat,
         keyOpenFiles,
+        keyThreadsCpu,
+        keySystemPressure,
         keyJavaStacktrace,
         keyXCrashError,
         keyXCrashErrorDebug
@@ -332,11 +380,11 @@ public class TombstoneParser {
         keyForeground
     ));
 
-    private enum Status {
-        UNKNOWN,
-        HEAD,
-        SECTION
-    }
+    private static final Set<String> keyAppendSections = new HashSet<String>(Arrays.asList(
+        keyMemoryNear,
+        keyMemoryInfo,
+        keyXCrashError
+    ));
 
     private TombstoneParser() {
     }
@@ -384,18 +432,127 @@ public class TombstoneParser {
 
         //parse content from log file
         if (logPath != null) {
-            BufferedReader br = new BufferedReader(new FileReader(logPath));
-            parseFromReader(map, br, true);
-            br.close();
+            visit(logPath, new MapVisitor(map));
         }
 
         //parse content from emergency buffer
         if (emergency != null) {
-            BufferedReader br = new BufferedReader(new StringReader(emergency));
-            parseFromReader(map, br, false);
-            br.close();
+            new TombstoneStream(new MapVisitor(map)).parse(newChannel(emergency.getBytes("UTF-8")), false);
+        }
+
+        //complete the items in head
+        completeHead(map, logPath);
+
+        return map;
+    }
+
+    /**
+     * Stream a crash log file to a visitor, without building the whole content in memory.
+     *
+     * <p>Note: The items got from the log path and the system are not visited,
+     * they are only added by {@link xcrash.TombstoneParser#parse(String, String)}.
+     *
+     * @param logPath Absolute path of the crash log file.
+     * @param visitor The visitor which receives the head items and the section chunks.
+     * @throws IOException If an I/O error occurs.
+     */
+    @SuppressWarnings("unused")
+    public static void visit(String logPath, ITombstoneVisitor visitor) throws IOException {
+        ReadableByteChannel channel;
+        if (TombstoneXz.isXz(logPath)) {
+            byte[] data = TombstoneXz.decompress(logPath);
+            channel = newChannel(TombstoneBinary.isBinary(data) ? TombstoneBinary.render(data).getBytes("UTF-8") : data);
+        } else if (TombstoneBinary.isBinary(logPath)) {
+            channel = newChannel(TombstoneBinary.render(logPath).getBytes("UTF-8"));
+        } else {
+            channel = new FileInputStream(logPath).getChannel();
+        }
+
+        try {
+            new TombstoneStream(visitor).parse(channel, true);
+        } finally {
+            channel.close();
+        }
+    }
+
+    /**
+     * Parse the head of a crash log file into an instance of {@link java.util.Map}.
+     * Map's string keys are defined in {@link xcrash.TombstoneParser}.
+     *
+     * <p>Note: Only the head (basic information, signal, abort message and registers) is read
+     * if the section index of the log file is available, otherwise the whole log file is parsed.
+     *
+     * @param logPath Absolute path of the crash log file.
+     * @return The parsed map.
+     * @throws IOException If an I/O error occurs.
+     */
+    @SuppressWarnings("unused")
+    public static Map<String, String> parseHeader(String logPath) throws IOException {
+        Map<String, String> map = parseIndexed(logPath, TombstoneIndex.keyHead);
+        if (map == null) {
+            return parse(logPath, null);
+        }
+
+        //complete the items in head
+        completeHead(map, logPath);
+
+        return map;
+    }
+
+    /**
+     * Parse a single section or item of a crash log file.
+     *
+     * <p>Note: Only the indexed section and the sections appended after the crash are read
+     * if the section index of the log file is available, otherwise the whole log file is parsed.
+     *
+     * @param logPath Absolute path of the crash log file.
+     * @param key One of the keys defined in {@link xcrash.TombstoneParser}, or the title of a section attached by users.
+     * @return The content of the section, or null if it's not found.
+     * @throws IOException If an I/O error occurs.
+     */
+    @SuppressWarnings("unused")
+    public static String parseSection(String logPath, String key) throws IOException {
+        if (key == null) {
+            return null;
         }
 
+        Map<String, String> map = parseIndexed(logPath, key);
+        if (map == null) {
+            map = parse(logPath, null);
+        } else if (isHeadKey(key) && !map.containsKey(key)) {
+            completeHead(map, logPath);
+        }
+        return map.get(key);
+    }
+
+    /**
+     * Get the full memory map of a native crash.
+     *
+     * <p>Note: If the log file only contains the difference from the maps baseline
+     * (see {@link xcrash.XCrash.InitParameters#setNativeDumpMapDelta(boolean)}), the memory map is rebuilt
+     * from the baseline file in the same directory as the log file.
+     *
+     * @param logPath Absolute path of the crash log file.
+     * @param map The map parsed from the crash log file.
+     * @return The memory map, or null if there is no full memory map in the log file
+     *         (such as only the summary is recorded).
+     * @throws IOException If the baseline file is missing or an I/O error occurs.
+     */
+    @SuppressWarnings("unused")
+    public static String getMemoryMap(String logPath, Map<String, String> map) throws IOException {
+        String memoryMap = map.get(keyMemoryMap);
+        if (memoryMap != null) {
+            return memoryMap;
+        }
+
+        String delta = map.get(keyMemoryMapDelta);
+        if (delta == null) {
+            return null;
+        }
+        return TombstoneMaps.rebuild(new File(logPath).getParentFile(), delta, map.get(keyAbi));
+    }
+
+    private static void completeHead(Map<String, String> map, String logPath) {
         //try to parse APP version, process name, crash type, start time and crash time from log path
         parseFromLogPath(map, logPath);
 
@@ -408,10 +565,114 @@ public class TombstoneParser {
 
         //add system info if there were missing
         addSystemInfo(map);
+    }
+
+    private static boolean isHeadKey(String key) {
+        return keyHeadItems.contains(key) || keyHeadOthers.contains(key);
+    }
+
+    //read the indexed sections matched by the key, return null if the section index is unavailable
+    private static Map<String, String> parseIndexed(String logPath, String key) throws IOException {
+        //the long titles are not indexed
+        if (logPath == null || key.getBytes("UTF-8").length >= TombstoneIndex.keyLen) {
+            return null;
+        }
+
+        TombstoneIndex index = TombstoneIndex.load(logPath);
+        if (index == null) {
+            return null;
+        }
+
+        boolean head = (key.equals(TombstoneIndex.keyHead) || isHeadKey(key));
+        ByteArrayOutputStream text = new ByteArrayOutputStream();
+        byte[] data = null;
+        RandomAccessFile raf = null;
+        try {
+            //offsets in the index are in the plain text
+            if (TombstoneXz.isXz(logPath)) {
+                data = TombstoneXz.decompress(logPath);
+                if (data.length < index.indexedLen) {
+                    return null;
+                }
+            } else {
+                raf = new RandomAccessFile(logPath, "r");
+                if (raf.length() < index.indexedLen) {
+                    return null;
+                }
+            }
+
+            for (int i = 0; i < index.keys.length; i++) {
+                String indexKey = index.keys[i];
+                if (head ? indexKey.equals(TombstoneIndex.keyHead) :
+                        (key.equals(keyMemoryNear) ? indexKey.startsWith(keyMemoryNear + " ") : indexKey.equals(key))) {
+                    byte[] buf;
+                    if (data != null) {
+                        buf = Arrays.copyOfRange(data, index.offsets[i], index.offsets[i] + index.lengths[i]);
+                    } else {
+                        buf = new byte[index.lengths[i]];
+                        raf.seek(index.offsets[i]);
+                        raf.readFully(buf);
+                    }
+                    appendText(text, buf, buf.length);
+                }
+            }
 
+            //the sections appended after the crash (java stacktrace, memory info, foreground, ...)
+            if (!head) {
+                ByteArrayOutputStream tail = new ByteArrayOutputStream();
+                if (data != null) {
+                    int end = index.indexedLen;
+                    while (end < data.length && data[end] != 0) {
+                        end++;
+                    }
+                    tail.write(data, index.indexedLen, end - index.indexedLen);
+                } else {
+                    byte[] buf = new byte[4096];
+                    int n;
+                    raf.seek(index.indexedLen);
+                    while ((n = raf.read(buf)) > 0) {
+                        int end = 0;
+                        while (end < n && buf[end] != 0) {
+                            end++;
+                        }
+                        tail.write(buf, 0, end);
+                        if (end < n) {
+                            //the placeholder file is padded with zeros
+                            break;
+                        }
+                    }
+                }
+                appendText(text, tail.toByteArray(), tail.size());
+            }
+        } finally {
+            if (raf != null) {
+                try {
+                    raf.close();
+                } catch (Exception ignored) {
+                }
+            }
+        }
+
+        Map<String, String> map = new HashMap<String, String>();
+        new TombstoneStream(new MapVisitor(map)).parse(newChannel(text.toByteArray()), false);
         return map;
     }
 
+    //each piece of text ends with '\n'
+    private static void appendText(ByteArrayOutputStream text, byte[] buf, int len) {
+        if (len == 0) {
+            return;
+        }
+        text.write(buf, 0, len);
+        if (buf[len - 1] != '\n') {
+            text.write('\n');
+        }
+    }
+
+    private static ReadableByteChannel newChannel(byte[] data) {
+        return Channels.newChannel(new ByteArrayInputStream(data));
+    }
+
     private static void parseFromLogPath(Map<String, String> map, String logPath) {
         if (logPath == null) {
             return;
@@ -434,7 +695,7 @@ public class TombstoneParser {
                 TextUtils.isEmpty(crashType)) {
 
             //get file name
-            String filename = logPath.substring(logPath.lastIndexOf('/') + 1);
+            String filename = Util.trimXzSuffix(logPath.substring(logPath.lastIndexOf('/') + 1));
             if (filename.isEmpty()) return;
 
             //ignore prefix
@@ -457,6 +718,21 @@ public class TombstoneParser {
                     map.put(keyCrashType, Util.anrCrashType);
                 }
                 filename = filename.substring(0, filename.length() - Util.anrLogSuffix.length());
+            } else if (filename.endsWith(Util.watchdogLogSuffix)) {
+                if (TextUtils.isEmpty(crashType)) {
+                    map.put(keyCrashType, Util.traceCrashType);
+                }
+                filename = filename.substring(0, filename.length() - Util.watchdogLogSuffix.length());
+            } else if (filename.endsWith(Util.traceLogSuffix)) {
+                if (TextUtils.isEmpty(crashType)) {
+                    map.put(keyCrashType, Util.traceCrashType);
+                }
+                filename = filename.substring(0, filename.length() - Util.traceLogSuffix.length());
+            } else if (filename.endsWith(Util.snapshotLogSuffix)) {
+                if (TextUtils.isEmpty(crashType)) {
+                    map.put(keyCrashType, Util.traceCrashType);
+                }
+                filename = filename.substring(0, filename.length() - Util.snapshotLogSuffix.length());
             } else {
                 return;
             }
@@ -530,178 +806,38 @@ public class TombstoneParser {
         }
     }
 
-    private static String readLineInBinary(BufferedReader br) throws IOException {
-
-        // Peek the next 2 characters to determine if there is still valid text.
+    //build the map for parse()
+    private static class MapVisitor implements ITombstoneVisitor {
+        private final Map<String, String> map;
+        private final StringBuilder sectionContent = new StringBuilder();
 
-        try {
-            br.mark(2);
-        } catch (Exception ignored) {
-            return br.readLine();
+        MapVisitor(Map<String, String> map) {
+            this.map = map;
         }
 
-        try {
-            for (int i = 0; i < 2; i++) {
-                int c = br.read();
-                if (c == -1) {
-                    br.reset();
-                    return null;
-                } else if (c > 0) {
-                    br.reset();
-                    return br.readLine();
-                }
-            }
-            br.reset();
-            return null;
-        } catch (Exception ignored) {
-            br.reset();
-            return br.readLine();
+        @Override
+        public void onHeadItem(String key, String value) {
+            putKeyValue(map, key, value);
         }
-    }
 
-    private static void parseFromReader(Map<String, String> map,
-                                        BufferedReader br, boolean binary)
-                                        throws IOException {
-
-        String next, line;
-        String sectionTitle = null;
-        StringBuilder sectionContent = new StringBuilder();
-        String sectionContentEnding = "";
-        boolean sectionContentOutdent = false;
-        boolean sectionContentAppend = false;
-        Matcher matcher;
-        Status status = Status.UNKNOWN;
-
-        line = (binary ? readLineInBinary(br) : br.readLine());
-        for (boolean last = (line == null); !last; line = next) {
-            last = ((next = (binary ? readLineInBinary(br) : br.readLine())) == null);
-            switch (status) {
-                case UNKNOWN:
-                    if (line.equals(Util.sepHead)) {
-                        status = Status.HEAD;
-                    } else if (line.equals(Util.sepOtherThreads)) {
-                        //special case
-                        status = Status.SECTION;
-                        sectionTitle = keyOtherThreads;
-                        sectionContentEnding = Util.sepOtherThreadsEnding;
-                        sectionContentOutdent = false;
-                        sectionContentAppend = false;
-                        sectionContent.append(line).append('\n');
-                    } else if (line.length() > 1 && line.endsWith(":")) {
-                        status = Status.SECTION;
-                        sectionTitle = line.substring(0, line.length() - 1);
-                        sectionContentEnding = "";
-                        if (keySections.contains(sectionTitle)) {
-                            sectionContentOutdent = (sectionTitle.equals(keyBacktrace)
-                                || sectionTitle.equals(keyBuildId)
-                                || sectionTitle.equals(keyStack)
-                                || sectionTitle.equals(keyMemoryMap)
-                                || sectionTitle.equals(keyOpenFiles)
-                                || sectionTitle.equals(keyJavaStacktrace)
-                                || sectionTitle.equals(keyXCrashErrorDebug));
-                            sectionContentAppend = sectionTitle.equals(keyXCrashError);
-                        } else if (sectionTitle.equals(keyMemoryInfo)) {
-                            sectionContentOutdent = false;
-                            sectionContentAppend = true;
-                        } else if (sectionTitle.startsWith("memory near ")) {
-                            //special case
-                            sectionTitle = keyMemoryNear;
-                            sectionContentOutdent = false;
-                            sectionContentAppend = true;
-                            sectionContent.append(line).append('\n');
-                        } else {
-                            //additional information section attached by users
-                            sectionContentOutdent = false;
-                            sectionContentAppend = false;
-                        }
-                    }
-                    break;
-                case HEAD:
-                    if (line.startsWith("pid: ")) {
-                        //try parse for native/java crash
-                        matcher = patProcessThread.matcher(line);
-                        if (matcher.find() && matcher.groupCount() == 4) {
-                            //pid, process name, tid, thread name
-                            putKeyValue(map, keyProcessId, matcher.group(1));
-                            putKeyValue(map, keyThreadId, matcher.group(2));
-                            putKeyValue(map, keyThreadName, matcher.group(3));
-                            putKeyValue(map, keyProcessName, matcher.group(4));
-                        } else {
-                            //try parse for ANR
-                            matcher = patProcess.matcher(line);
-                            if (matcher.find() && matcher.groupCount() == 2) {
-                                //pid, process name
-                                putKeyValue(map, keyProcessId, matcher.group(1));
-                                putKeyValue(map, keyProcessName, matcher.group(2));
-                            }
-                        }
-                    } else if (line.startsWith("signal ")) {
-                        matcher = patSignalCode.matcher(line);
-                        if (matcher.find() && matcher.groupCount() == 3) {
-                            //signal, code, fault address
-                            putKeyValue(map, keySignal, matcher.group(1));
-                            putKeyValue(map, keyCode, matcher.group(2));
-                            putKeyValue(map, keyFaultAddr, matcher.group(3));
-                        }
-                    } else {
-                        //other items in head section
-                        matcher = patHeadItem.matcher(line);
-                        if (matcher.find() && matcher.groupCount() == 2) {
-                            if (keyHeadItems.contains(matcher.group(1))) {
-                                putKeyValue(map, matcher.group(1), matcher.group(2));
-                            }
-                        }
-                    }
+        @Override
+        public void onSectionChunk(String key, CharSequence chunk) {
+            sectionContent.append(chunk);
+        }
 
-                    //special case
-                    if (next != null && (next.startsWith("    r0 ") ||
-                            next.startsWith("    x0 ") ||
-                            next.startsWith("    eax ") ||
-                            next.startsWith("    rax "))) {
-
-                        //registers
-                        status = Status.SECTION;
-                        sectionTitle = keyRegisters;
-                        sectionContentEnding = "";
-                        sectionContentOutdent = true;
-                        sectionContentAppend = false;
-                    }
+        @Override
+        public void onSectionEnd(String key) {
+            if (keySingleLineSections.contains(key)) {
+                if (sectionContent.length() > 0 &&
+                        sectionContent.charAt(sectionContent.length() - 1) == '\n') {
 
-                    if (next == null || next.isEmpty()) {
-                        //the end of head
-                        status = Status.UNKNOWN;
-                    }
-                    break;
-                case SECTION:
-                    if (line.equals(sectionContentEnding) || last) {
-                        if (keySingleLineSections.contains(sectionTitle)) {
-                            if (sectionContent.length() > 0 &&
-                                    sectionContent.charAt(sectionContent.length() - 1) == '\n') {
-
-                                // If there is only one line in the content,
-                                // then delete the newline character at the end.
-                                sectionContent.deleteCharAt(sectionContent.length() - 1);
-                            }
-                        }
-                        putKeyValue(map, sectionTitle, sectionContent.toString(), sectionContentAppend);
-                        sectionContent.setLength(0);
-                        status = Status.UNKNOWN;
-                    } else {
-                        if (sectionContentOutdent) {
-                            if (sectionTitle.equals(keyJavaStacktrace) && line.startsWith(" ")) {
-                                //java stacktrace in native crash
-                                line = line.trim();
-                            } else if (line.startsWith("    ")) {
-                                //other sections
-                                line = line.substring(4);
-                            }
-                        }
-                        sectionContent.append(line).append('\n');
-                    }
-                    break;
-                default:
-                    break;
+                    // If there is only one line in the content,
+                    // then delete the newline character at the end.
+                    sectionContent.deleteCharAt(sectionContent.length() - 1);
+                }
             }
+            putKeyValue(map, key, sectionContent.toString(), keyAppendSections.contains(key));
+            sectionContent.setLength(0);
         }
     }
 
@@ -0,0 +1,140 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// Created by agent on 2026-10-17.
+package xcrash;
+
+import java.io.File;
+import java.io.RandomAccessFile;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.Collections;
+import java.util.Comparator;
+import java.util.List;
+import java.util.Locale;
+
+/**
+ * The counter of a native crash signature.
+ *
+ * <p>The dumper counts the native crashes by the signature in a store file in the log directory
+ * (see "xcd_signature.h"), so only one log file per signature needs to be kept (see
+ * {@link xcrash.TombstoneManager#deleteDuplicateNativeTombstones()}).
+ */
+@SuppressWarnings("unused")
+public class TombstoneSignature {
+
+    static final String storeName = "signatures.xcrash"; //XCC_UTIL_SIGNATURE_STORE_FILENAME in "xcc_util.h"
+
+    private static final byte[] magic = {'X', 'C', 'S', 'G'};
+    private static final int version = 1;
+    private static final int headerLen = 16;
+    private static final int slotLen = 32;
+
+    /**
+     * The signature, same as {@link xcrash.TombstoneParser#keyCrashSignature} in the log file.
+     */
+    public final String signature;
+
+    /**
+     * How many times the crash occurred.
+     */
+    public final int count;
+
+    /**
+     * The time of the first crash, in milliseconds since the epoch.
+     */
+    public final long firstTime;
+
+    /**
+     * The time of the last crash, in milliseconds since the epoch.
+     */
+    public final long lastTime;
+
+    private TombstoneSignature(String signature, int count, long firstTime, long lastTime) {
+        this.signature = signature;
+        this.count = count;
+        this.firstTime = firstTime;
+        this.lastTime = lastTime;
+    }
+
+    //sorted by count, the most frequent one first
+    static TombstoneSignature[] load(File dir) {
+        File file = new File(dir, storeName);
+        if (!file.exists()) {
+            return new TombstoneSignature[0];
+        }
+
+        RandomAccessFile raf = null;
+        try {
+            raf = new RandomAccessFile(file, "r");
+
+            //the dumper updates it under an exclusive lock, it's released when raf is closed
+            raf.getChannel().lock(0, Long.MAX_VALUE, true);
+            byte[] data = new byte[(int) raf.length()];
+            raf.readFully(data);
+            ByteBuffer buf = ByteBuffer.wrap(data).order(ByteOrder.LITTLE_ENDIAN);
+
+            byte[] fileMagic = new byte[magic.length];
+            buf.get(fileMagic);
+            if (!Arrays.equals(fileMagic, magic) || buf.getInt() != version) {
+                return new TombstoneSignature[0];
+            }
+            int slots = buf.getInt();
+            if (slots <= 0 || data.length != headerLen + slots * slotLen) {
+                return new TombstoneSignature[0];
+            }
+
+            List<TombstoneSignature> list = new ArrayList<TombstoneSignature>();
+            for (int i = 0; i < slots; i++) {
+                buf.position(headerLen + i * slotLen);
+                long signature = buf.getLong();
+                int count = buf.getInt();
+                buf.getInt();
+                long firstTime = buf.getLong() / 1000;
+                long lastTime = buf.getLong() / 1000;
+                if (signature != 0 && count != 0) {
+                    list.add(new TombstoneSignature(String.format(Locale.US, "%016x", signature), count, firstTime, lastTime));
+                }
+            }
+
+            Collections.sort(list, new Comparator<TombstoneSignature>() {
+                @Override
+                public int compare(TombstoneSignature s1, TombstoneSignature s2) {
+                    return s1.count == s2.count ? 0 : (s1.count > s2.count ? -1 : 1);
+                }
+            });
+            return list.toArray(new TombstoneSignature[0]);
+        } catch (Exception e) {
+            XCrash.getLogger().w(Util.TAG, "TombstoneSignature load failed", e);
+            return new TombstoneSignature[0];
+        } finally {
+            if (raf != null) {
+                try {
+                    raf.close();
+                } catch (Exception ignored) {
+                }
+            }
+        }
+    }
+}
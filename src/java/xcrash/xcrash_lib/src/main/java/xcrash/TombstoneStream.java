@@ -0,0 +1,321 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// Created by agent on 2026-10-17.
+package xcrash;
+
+import java.io.IOException;
+import java.nio.ByteBuffer;
+import java.nio.channels.ReadableByteChannel;
+import java.util.regex.Matcher;
+import java.util.regex.Pattern;
+
+/**
+ * Streaming crash log file parser, the head items and the section chunks are sent to a visitor.
+ *
+ * <p>The log file is read from a channel through a reusable buffer, and each line is decoded into a reusable
+ * builder. Only the lines in head are converted to strings and matched by the patterns, the section lines are
+ * only compared with the titles and the endings.
+ */
+class TombstoneStream {
+
+    private static final int bufferSize = 64 * 1024;
+
+    private static final Pattern patHeadItem = Pattern.compile("^(.*):\\s'(.*?)'$");
+
+    private static final Pattern patProcessThread = Pattern.compile(
+            "^pid:\\s(.*),\\stid:\\s(.*),\\sname:\\s(.*)\\s+>>>\\s(.*)\\s<<<$");
+
+    private static final Pattern patProcess = Pattern.compile("^pid:\\s(.*)\\s+>>>\\s(.*)\\s<<<$");
+
+    private static final Pattern patSignalCode = Pattern.compile(
+            "^signal\\s(.*),\\scode\\s(.*),\\sfault\\saddr\\s(.*)$");
+
+    private static final String[] regsPrefixes = {"    r0 ", "    x0 ", "    eax ", "    rax "};
+
+    private static final String memoryNearPrefix = TombstoneParser.keyMemoryNear + " ";
+
+    private enum Status {
+        UNKNOWN,
+        HEAD,
+        SECTION
+    }
+
+    private final ITombstoneVisitor visitor;
+    private final ByteBuffer buffer = ByteBuffer.allocate(bufferSize);
+    private final StringBuilder line = new StringBuilder(256);
+    private byte[] lineBytes = new byte[256];
+    private int lineLen = 0;
+
+    private Status status = Status.UNKNOWN;
+    private String sectionTitle = null;
+    private String sectionContentEnding = "";
+    private boolean sectionContentOutdent = false;
+
+    TombstoneStream(ITombstoneVisitor visitor) {
+        this.visitor = visitor;
+    }
+
+    /**
+     * Parse the text from the channel, the text in a binary (placeholder) file ends with two zeros at
+     * the beginning of a line, the same as "readLineInBinary()" did.
+     */
+    void parse(ReadableByteChannel channel, boolean binary) throws IOException {
+        boolean lineBegin = true;
+        boolean zero = false; //a line beginning with zero
+
+        outer:
+        while (channel.read(buffer) >= 0) {
+            buffer.flip();
+            byte[] buf = buffer.array();
+            int end = buffer.limit();
+            for (int i = 0; i < end; i++) {
+                byte b = buf[i];
+                if (binary) {
+                    if (zero && b == 0) {
+                        //the end of text
+                        zero = false;
+                        lineLen = 0;
+                        break outer;
+                    }
+                    zero = (lineBegin && b == 0);
+                    lineBegin = false;
+                }
+
+                if (b == '\n') {
+                    onLine();
+                    lineBegin = true;
+                } else {
+                    if (lineLen == lineBytes.length) {
+                        byte[] bigger = new byte[lineBytes.length * 2];
+                        System.arraycopy(lineBytes, 0, bigger, 0, lineLen);
+                        lineBytes = bigger;
+                    }
+                    lineBytes[lineLen++] = b;
+                }
+            }
+            buffer.clear();
+        }
+        buffer.clear();
+
+        //the last line without '\n'
+        if (lineLen > 0 && !zero) {
+            onLine();
+        }
+        lineLen = 0;
+
+        //the unfinished section
+        if (status == Status.SECTION) {
+            visitor.onSectionEnd(sectionTitle);
+        }
+        status = Status.UNKNOWN;
+    }
+
+    private void onLine() throws IOException {
+        decodeLine();
+        lineLen = 0;
+
+        switch (status) {
+            case UNKNOWN:
+                onUnknownLine();
+                break;
+            case HEAD:
+                if (startsWithAny(regsPrefixes)) {
+                    //registers
+                    status = Status.SECTION;
+                    sectionTitle = TombstoneParser.keyRegisters;
+                    sectionContentEnding = "";
+                    sectionContentOutdent = true;
+                    onSectionLine();
+                } else if (line.length() == 0) {
+                    //the end of head
+                    status = Status.UNKNOWN;
+                } else {
+                    onHeadLine(line.toString());
+                }
+                break;
+            case SECTION:
+                onSectionLine();
+                break;
+            default:
+                break;
+        }
+    }
+
+    private void onUnknownLine() {
+        int len = line.length();
+
+        if (equalsLine(Util.sepHead)) {
+            status = Status.HEAD;
+        } else if (equalsLine(Util.sepOtherThreads)) {
+            //special case
+            status = Status.SECTION;
+            sectionTitle = TombstoneParser.keyOtherThreads;
+            sectionContentEnding = Util.sepOtherThreadsEnding;
+            sectionContentOutdent = false;
+            visitor.onSectionChunk(sectionTitle, line.append('\n'));
+        } else if (len > 1 && line.charAt(len - 1) == ':') {
+            status = Status.SECTION;
+            sectionTitle = line.substring(0, len - 1);
+            sectionContentEnding = "";
+            if (TombstoneParser.keySections.contains(sectionTitle)) {
+                sectionContentOutdent = (sectionTitle.equals(TombstoneParser.keyBacktrace)
+                    || sectionTitle.equals(TombstoneParser.keyBuildId)
+                    || sectionTitle.equals(TombstoneParser.keyStack)
+                    || sectionTitle.equals(TombstoneParser.keyMemoryMap)
+                    || sectionTitle.equals(TombstoneParser.keyMemoryMapDelta)
+                    || sectionTitle.equals(TombstoneParser.keyMemoryMapSummary)
+                    || sectionTitle.equals(TombstoneParser.keyMemoryMapExcerpt)
+                    || sectionTitle.equals(TombstoneParser.keyOpenFiles)
+                    || sectionTitle.equals(TombstoneParser.keyThreadsCpu)
+                    || sectionTitle.equals(TombstoneParser.keyJavaStacktrace)
+                    || sectionTitle.equals(TombstoneParser.keyXCrashErrorDebug));
+            } else if (sectionTitle.startsWith(memoryNearPrefix)) {
+                //special case
+                sectionTitle = TombstoneParser.keyMemoryNear;
+                sectionContentOutdent = false;
+                visitor.onSectionChunk(sectionTitle, line.append('\n'));
+            } else {
+                //memory info, or additional information section attached by users
+                sectionContentOutdent = false;
+            }
+        }
+    }
+
+    private void onHeadLine(String str) {
+        Matcher matcher;
+
+        if (str.startsWith("pid: ")) {
+            //try parse for native/java crash
+            matcher = patProcessThread.matcher(str);
+            if (matcher.find() && matcher.groupCount() == 4) {
+                //pid, process name, tid, thread name
+                visitor.onHeadItem(TombstoneParser.keyProcessId, matcher.group(1));
+                visitor.onHeadItem(TombstoneParser.keyThreadId, matcher.group(2));
+                visitor.onHeadItem(TombstoneParser.keyThreadName, matcher.group(3));
+                visitor.onHeadItem(TombstoneParser.keyProcessName, matcher.group(4));
+            } else {
+                //try parse for ANR
+                matcher = patProcess.matcher(str);
+                if (matcher.find() && matcher.groupCount() == 2) {
+                    //pid, process name
+                    visitor.onHeadItem(TombstoneParser.keyProcessId, matcher.group(1));
+                    visitor.onHeadItem(TombstoneParser.keyProcessName, matcher.group(2));
+                }
+            }
+        } else if (str.startsWith("signal ")) {
+            matcher = patSignalCode.matcher(str);
+            if (matcher.find() && matcher.groupCount() == 3) {
+                //signal, code, fault address
+                visitor.onHeadItem(TombstoneParser.keySignal, matcher.group(1));
+                visitor.onHeadItem(TombstoneParser.keyCode, matcher.group(2));
+                visitor.onHeadItem(TombstoneParser.keyFaultAddr, matcher.group(3));
+            }
+        } else {
+            //other items in head section
+            matcher = patHeadItem.matcher(str);
+            if (matcher.find() && matcher.groupCount() == 2) {
+                if (TombstoneParser.keyHeadItems.contains(matcher.group(1))) {
+                    visitor.onHeadItem(matcher.group(1), matcher.group(2));
+                }
+            }
+        }
+    }
+
+    private void onSectionLine() {
+        if (equalsLine(sectionContentEnding)) {
+            visitor.onSectionEnd(sectionTitle);
+            status = Status.UNKNOWN;
+            return;
+        }
+
+        if (sectionContentOutdent) {
+            if (sectionTitle.equals(TombstoneParser.keyJavaStacktrace) && line.length() > 0 && line.charAt(0) == ' ') {
+                //java stacktrace in native crash
+                trimLine();
+            } else if (startsWith("    ")) {
+                //other sections
+                line.delete(0, 4);
+            }
+        }
+        visitor.onSectionChunk(sectionTitle, line.append('\n'));
+    }
+
+    private void decodeLine() throws IOException {
+        int len = lineLen;
+        if (len > 0 && lineBytes[len - 1] == '\r') {
+            len--;
+        }
+
+        line.setLength(0);
+        for (int i = 0; i < len; i++) {
+            if (lineBytes[i] < 0) {
+                //not ASCII
+                line.append(new String(lineBytes, 0, len, "UTF-8"));
+                return;
+            }
+        }
+        for (int i = 0; i < len; i++) {
+            line.append((char) lineBytes[i]);
+        }
+    }
+
+    //the same as String.trim()
+    private void trimLine() {
+        int end = line.length();
+        while (end > 0 && line.charAt(end - 1) <= ' ') {
+            end--;
+        }
+        line.setLength(end);
+
+        int start = 0;
+        while (start < end && line.charAt(start) <= ' ') {
+            start++;
+        }
+        line.delete(0, start);
+    }
+
+    private boolean equalsLine(String str) {
+        return line.length() == str.length() && startsWith(str);
+    }
+
+    private boolean startsWith(String prefix) {
+        if (line.length() < prefix.length()) {
+            return false;
+        }
+        for (int i = 0; i < prefix.length(); i++) {
+            if (line.charAt(i) != prefix.charAt(i)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    private boolean startsWithAny(String[] prefixes) {
+        for (String prefix : prefixes) {
+            if (startsWith(prefix)) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
@@ -0,0 +1,108 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Created by agent on 2026-10-17.
+package xcrash;
+
+
+import java.io.File;
+import java.io.IOException;
+import java.io.RandomAccessFile;
+import java.util.Arrays;
+
+/**
+ * Read and append the XZ compressed native crash log file (see "xcd_util_xz_compress()" in "xcd_util.c").
+ *
+ * <p>The decoding and encoding are done by the LZMA SDK bundled in the native library (see "xc_xz.h"),
+ * so it's only available after the native library has been loaded by {@link xcrash.XCrash#init}.
+ * The text appended after the crash is saved as additional concatenated streams.
+ *
+ * <p>The log file compressed with a preset dictionary (see "xcd_util_xz_compress_dict()" in "xcd_util.c")
+ * begins with a raw LZMA2 member instead of an XZ stream: magic, dictionary ID (CRC32 of the dictionary),
+ * dictionary size, LZMA2 dictionary size, LZMA2 chunks, and the CRC32 of the data. The dictionary is loaded
+ * by the ID from the directory of the log file (see {@link xcrash.TombstoneDict}). It's not an XZ file, so it's
+ * named "*.xcdz" instead of "*.xz", use "src/tools/xcrash_unxz.py" to decompress it on the host.
+ */
+class TombstoneXz {
+
+    private static final byte[] magic = {(byte) 0xFD, '7', 'z', 'X', 'Z', 0};
+    private static final byte[] dictMagic = {(byte) 0xFD, 'X', 'C', 'D', 'Z', 0};
+    private static final int dictHeaderLen = 15;
+
+    private TombstoneXz() {
+    }
+
+    static boolean isXz(String logPath) {
+        RandomAccessFile raf = null;
+        try {
+            raf = new RandomAccessFile(logPath, "r");
+            byte[] head = new byte[magic.length];
+            raf.readFully(head);
+            return Arrays.equals(head, magic) || Arrays.equals(head, dictMagic);
+        } catch (Exception ignored) {
+            return false;
+        } finally {
+            if (raf != null) {
+                try {
+                    raf.close();
+                } catch (Exception ignored) {
+                }
+            }
+        }
+    }
+
+    //returns -1 if the log file is not compressed with a preset dictionary
+    static long getDictId(String logPath) {
+        RandomAccessFile raf = null;
+        try {
+            raf = new RandomAccessFile(logPath, "r");
+            byte[] head = new byte[dictHeaderLen];
+            raf.readFully(head);
+            if (!Arrays.equals(Arrays.copyOf(head, dictMagic.length), dictMagic)) {
+                return -1;
+            }
+            int pos = dictMagic.length;
+            return ((head[pos] & 0xFF) | ((head[pos + 1] & 0xFF) << 8) | ((head[pos + 2] & 0xFF) << 16) | ((long) (head[pos + 3] & 0xFF) << 24));
+        } catch (Exception ignored) {
+            return -1;
+        } finally {
+            if (raf != null) {
+                try {
+                    raf.close();
+                } catch (Exception ignored) {
+                }
+            }
+        }
+    }
+
+    static byte[] decompress(String logPath) throws IOException {
+        byte[] data = TombstoneBinary.readFile(logPath);
+
+        long dictId = getDictId(logPath);
+        byte[] dict = (dictId < 0 ? null : TombstoneDict.load(new File(logPath).getAbsoluteFile().getParentFile(), (int) dictId));
+
+        return NativeHandler.getInstance().xzDecompress(data, dict);
+    }
+
+    static void append(String logPath, byte[] data) throws IOException {
+        NativeHandler.getInstance().xzAppend(logPath, data);
+    }
+}
@@ -66,12 +66,36 @@ class Util {
     static final String javaCrashType = "java";
     static final String nativeCrashType = "native";
     static final String anrCrashType = "anr";
+    static final String traceCrashType = "trace";
 
     static final String logPrefix = "tombstone";
     static final String javaLogSuffix = ".java.xcrash";
     static final String nativeLogSuffix = ".native.xcrash";
     static final String anrLogSuffix = ".anr.xcrash";
     static final String traceLogSuffix = ".trace.xcrash";
+    static final String watchdogLogSuffix = ".watchdog.trace.xcrash";
+    static final String snapshotLogSuffix = ".snapshot.xcrash";
+    static final String profileLogSuffix = ".profile.xcrash";
+    static final String nativeProtoSuffix = ".pb";
+    static final String nativeMinidumpSuffix = ".dmp";
+    static final String xzSuffix = ".xz";
+    static final String xcdzSuffix = ".xcdz";
+    static final String indexSuffix = ".idx";
+
+    //the compressed native crash log file has an additional suffix (".xcdz" if compressed with the preset dictionary)
+    static boolean isLogFile(String name, String logSuffix) {
+        return name.endsWith(logSuffix) || name.endsWith(logSuffix + xzSuffix) || name.endsWith(logSuffix + xcdzSuffix);
+    }
+
+    static String trimXzSuffix(String path) {
+        if (path.endsWith(xzSuffix)) {
+            return path.substring(0, path.length() - xzSuffix.length());
+        } else if (path.endsWith(xcdzSuffix)) {
+            return path.substring(0, path.length() - xcdzSuffix.length());
+        } else {
+            return path;
+        }
+    }
 
     static String getProcessName(Context ctx, int pid) {
 
@@ -27,6 +27,9 @@ import android.content.Context;
 import android.os.Build;
 import android.text.TextUtils;
 
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.TimeUnit;
+
 /**
  * xCrash is a crash reporting library for Android APP.
  */
@@ -34,6 +37,8 @@ import android.text.TextUtils;
 public final class XCrash {
 
     private static boolean initialized = false;
+    private static final CountDownLatch initLatch = new CountDownLatch(1);
+    private static volatile Thread initThread = null;
     private static String appId = null;
     private static String appVersion = null;
     private static String logDir = null;
@@ -59,7 +64,8 @@ public final class XCrash {
     /**
      * Initialize xCrash with custom parameters.
      *
-     * <p>Note: This is a synchronous operation.
+     * <p>Note: This is a synchronous operation, unless the lazy initialization is enabled by
+     * {@link InitParameters#setLazyInit(boolean)}.
      *
      * @param ctx The context of the application object of the current process.
      * @param params An initialization parameter set.
@@ -93,9 +99,83 @@ public final class XCrash {
             XCrash.logger = params.logger;
         }
 
+        InitTrace.getInstance().start(params.lazyInit);
+
+        if (params.enableJavaCrashHandler || params.enableNativeCrashHandler || params.enableAnrHandler) {
+            if (ctx instanceof Application) {
+                ActivityMonitor.getInstance().initialize((Application) ctx);
+            }
+        }
+        InitTrace.getInstance().step("init activity monitor");
+
+        if (!params.lazyInit) {
+            initApp(ctx, params);
+            int r = initInternal(ctx, params);
+            initLatch.countDown();
+            InitTrace.getInstance().finish();
+            return r;
+        }
+
+        //install the UncaughtExceptionHandler, load the native library and register the signal handlers here,
+        //everything else is done in a background thread
+        if (params.enableJavaCrashHandler) {
+            JavaCrashHandler.getInstance().install();
+        }
+        InitTrace.getInstance().step("install java crash handler");
+
+        initApp(ctx, params);
+
+        //the log directory is passed later, and the ANR handler waits for the process name
+        int r = Errno.OK;
+        if (params.enableNativeCrashHandler || (params.enableAnrHandler && Build.VERSION.SDK_INT >= 21)) {
+            r = initNativeHandler(ctx, params, null, false);
+        }
+
+        final Context fCtx = ctx;
+        final InitParameters fParams = params;
+        initThread = new Thread(new Runnable() {
+            @Override
+            public void run() {
+                try {
+                    int r = initInternal(fCtx, fParams);
+                    if (r != Errno.OK) {
+                        XCrash.getLogger().e(Util.TAG, "XCrash lazy init failed: " + r);
+                    }
+                } catch (Throwable e) {
+                    XCrash.getLogger().e(Util.TAG, "XCrash lazy init failed", e);
+                } finally {
+                    initLatch.countDown();
+                    InitTrace.getInstance().finish();
+                }
+            }
+        }, "xcrash_init");
+        initThread.start();
+
+        return r;
+    }
+
+    //wait for the lazy initialization, return false if it has not finished within the timeout
+    static boolean waitForInit(long timeoutMs) {
+        if (initLatch.getCount() == 0) {
+            return true;
+        }
+
+        //a crash of the initializer itself
+        if (Thread.currentThread() == initThread) {
+            return false;
+        }
+
+        try {
+            return initLatch.await(timeoutMs, TimeUnit.MILLISECONDS);
+        } catch (InterruptedException ignored) {
+            return false;
+        }
+    }
+
+    //the app info is needed by the native library before the signal handlers are registered
+    private static void initApp(Context ctx, InitParameters params) {
         //save app id
-        String packageName = ctx.getPackageName();
-        XCrash.appId = packageName;
+        XCrash.appId = ctx.getPackageName();
         if (TextUtils.isEmpty(XCrash.appId)) {
             XCrash.appId = "unknown";
         }
@@ -105,14 +185,20 @@ public final class XCrash {
             params.appVersion = Util.getAppVersion(ctx);
         }
         XCrash.appVersion = params.appVersion;
+        InitTrace.getInstance().step("get app version");
 
         XCrash.nativeLibDir = ctx.getApplicationInfo().nativeLibraryDir;
+    }
+
+    private static int initInternal(Context ctx, InitParameters params) {
+        String packageName = ctx.getPackageName();
 
         //save log dir
         if (TextUtils.isEmpty(params.logDir)) {
             params.logDir = ctx.getFilesDir() + "/tombstones";
         }
         XCrash.logDir = params.logDir;
+        InitTrace.getInstance().step("get log dir");
 
         //get PID and process name
         int pid = android.os.Process.myPid();
@@ -127,6 +213,7 @@ public final class XCrash {
                 }
             }
         }
+        InitTrace.getInstance().step("get process name");
 
         //init file manager
         FileManager.getInstance().initialize(
@@ -134,15 +221,14 @@ public final class XCrash {
             params.javaLogCountMax,
             params.nativeLogCountMax,
             params.anrLogCountMax,
+            params.nativeSnapshotLogCountMax,
             params.placeholderCountMax,
             params.placeholderSizeKb,
-            params.logFileMaintainDelayMs);
-
-        if (params.enableJavaCrashHandler || params.enableNativeCrashHandler || params.enableAnrHandler) {
-            if (ctx instanceof Application) {
-                ActivityMonitor.getInstance().initialize((Application) ctx);
-            }
-        }
+            params.logFileMaintainDelayMs,
+            params.logSizeMaxKb,
+            params.enableNativeCrashHandler && params.nativeCompressLog && params.nativeCompressDict,
+            params.enableNativeCrashHandler && params.nativeDumpMap && params.nativeDumpMapDelta && !params.nativeDumpMapSummary);
+        InitTrace.getInstance().step("init file manager");
 
         //init java crash handler
         if (params.enableJavaCrashHandler) {
@@ -160,8 +246,11 @@ public final class XCrash {
                 params.javaDumpNetworkInfo,
                 params.javaDumpAllThreads,
                 params.javaDumpAllThreadsCountMax,
+                params.javaDumpAllThreadsTimeoutMs,
                 params.javaDumpAllThreadsWhiteList,
+                params.javaOomReserveSizeKb,
                 params.javaCallback);
+            InitTrace.getInstance().step("init java crash handler");
         }
 
         //init ANR handler (API level < 21)
@@ -180,47 +269,79 @@ public final class XCrash {
                 params.anrDumpFds,
                 params.anrDumpNetworkInfo,
                 params.anrCallback);
+            InitTrace.getInstance().step("init ANR handler");
         }
 
         //init native crash handler / ANR handler (API level >= 21)
         int r = Errno.OK;
         if (params.enableNativeCrashHandler || (params.enableAnrHandler && Build.VERSION.SDK_INT >= 21)) {
-            r = NativeHandler.getInstance().initialize(
-                ctx,
-                params.libLoader,
-                appId,
-                params.appVersion,
-                params.logDir,
-                params.enableNativeCrashHandler,
-                params.nativeRethrow,
-                params.nativeLogcatSystemLines,
-                params.nativeLogcatEventsLines,
-                params.nativeLogcatMainLines,
-                params.nativeDumpElfHash,
-                params.nativeDumpMap,
-                params.nativeDumpFds,
-                params.nativeDumpNetworkInfo,
-                params.nativeDumpAllThreads,
-                params.nativeDumpAllThreadsCountMax,
-                params.nativeDumpAllThreadsWhiteList,
-                params.nativeCallback,
-                params.enableAnrHandler && Build.VERSION.SDK_INT >= 21,
-                params.anrRethrow,
-                params.anrCheckProcessState,
-                params.anrLogcatSystemLines,
-                params.anrLogcatEventsLines,
-                params.anrLogcatMainLines,
-                params.anrDumpFds,
-                params.anrDumpNetworkInfo,
-                params.anrCallback);
+            if (!params.lazyInit) {
+                r = initNativeHandler(ctx, params, params.logDir, params.enableAnrHandler && Build.VERSION.SDK_INT >= 21);
+            } else {
+                r = NativeHandler.getInstance().initializeLate(
+                    params.logDir,
+                    params.enableNativeCrashHandler && params.nativeCompressLog && params.nativeCompressDict,
+                    params.enableAnrHandler && Build.VERSION.SDK_INT >= 21,
+                    params.anrRethrow,
+                    params.anrCheckProcessState,
+                    params.anrLogcatSystemLines,
+                    params.anrLogcatEventsLines,
+                    params.anrLogcatMainLines,
+                    params.anrDumpFds,
+                    params.anrDumpNetworkInfo,
+                    params.anrThreadStatIntervalMs,
+                    params.anrWatchdogTimeoutMs,
+                    params.anrCallback);
+            }
         }
 
         //maintain tombstone and placeholder files in a background thread with some delay
         FileManager.getInstance().maintain();
+        InitTrace.getInstance().step("start maintenance");
 
         return r;
     }
 
+    private static int initNativeHandler(Context ctx, InitParameters params, String logDir, boolean anrEnable) {
+        return NativeHandler.getInstance().initialize(
+            ctx,
+            params.libLoader,
+            appId,
+            params.appVersion,
+            logDir,
+            params.enableNativeCrashHandler,
+            params.nativeRethrow,
+            params.nativeLogcatSystemLines,
+            params.nativeLogcatEventsLines,
+            params.nativeLogcatMainLines,
+            params.nativeDumpElfHash,
+            params.nativeDumpMap,
+            params.nativeDumpMapDelta,
+            params.nativeDumpMapSummary,
+            params.nativeDumpFds,
+            params.nativeDumpNetworkInfo,
+            params.nativeDumpAllThreads,
+            params.nativeDumpAllThreadsCountMax,
+            params.nativeDumpAllThreadsWhiteList,
+            params.nativeDumpBinary,
+            params.nativeDumpProto,
+            params.nativeDumpMinidump,
+            params.nativeCompressLog,
+            params.nativeCompressDict,
+            params.nativeCallback,
+            anrEnable,
+            params.anrRethrow,
+            params.anrCheckProcessState,
+            params.anrLogcatSystemLines,
+            params.anrLogcatEventsLines,
+            params.anrLogcatMainLines,
+            params.anrDumpFds,
+            params.anrDumpNetworkInfo,
+            params.anrThreadStatIntervalMs,
+            params.anrWatchdogTimeoutMs,
+            params.anrCallback);
+    }
+
     /**
      * An initialization parameter set.
      */
@@ -230,8 +351,10 @@ public final class XCrash {
         String     appVersion             = null;
         String     logDir                 = null;
         int        logFileMaintainDelayMs = 5000;
+        int        logSizeMaxKb           = 0;
         ILogger    logger                 = null;
         ILibLoader libLoader              = null;
+        boolean    lazyInit               = false;
 
         /**
          * Set App version. You can use this method to set an internal test/gray version number.
@@ -259,6 +382,28 @@ public final class XCrash {
             return this;
         }
 
+        /**
+         * Set whether to initialize xCrash lazily. (Default: false)
+         *
+         * <p>If <code>true</code>, {@link XCrash#init(Context, InitParameters)} only installs the UncaughtExceptionHandler,
+         * loads the native library and registers the native crash signal handlers, getting the process name, creating
+         * the log directory, initializing the log files and everything else are done in a background thread.
+         * A Java or native crash before that is finished waits for it for a while, then the Java crash is handed over
+         * to the previous UncaughtExceptionHandler, and the native crash is only passed to the native crash callback
+         * without a log file, if it is still not finished. ANRs are not captured until that is finished.
+         *
+         * <p>Note: The return value of {@link XCrash#init(Context, InitParameters)} includes the errors of loading and
+         * initializing the native library, but not the errors of the background initialization, they are only logged.
+         *
+         * @param lazy If <code>true</code>, initialize lazily.
+         * @return The InitParameters object.
+         */
+        @SuppressWarnings("unused")
+        public InitParameters setLazyInit(boolean lazy) {
+            this.lazyInit = lazy;
+            return this;
+        }
+
         /**
          * Set delay in milliseconds before the log file maintain task is to be executed. (Default: 5000)
          *
@@ -271,6 +416,22 @@ public final class XCrash {
             return this;
         }
 
+        /**
+         * Set the maximum total size of the log files in the log directory, in KB. (Default: 0)
+         *
+         * <p>Note: Set this value to 0 means no limit. When exceeded, the log file maintain task deletes
+         * the uploaded log files (see {@link xcrash.TombstoneManager#markTombstoneUploaded(java.io.File)}) first,
+         * then the oldest ones of all types. The placeholder files are not counted.
+         *
+         * @param sizeMaxKb The maximum total size of the log files.
+         * @return The InitParameters object.
+         */
+        @SuppressWarnings("unused")
+        public InitParameters setLogSizeMaxKb(int sizeMaxKb) {
+            this.logSizeMaxKb = (sizeMaxKb < 0 ? 0 : sizeMaxKb);
+            return this;
+        }
+
         /**
          * Set a logger implementation for xCrash to log message and exception.
          *
@@ -334,7 +495,9 @@ public final class XCrash {
         boolean        javaDumpNetworkInfo         = true;
         boolean        javaDumpAllThreads          = true;
         int            javaDumpAllThreadsCountMax  = 0;
+        int            javaDumpAllThreadsTimeoutMs = 1000;
         String[]       javaDumpAllThreadsWhiteList = null;
+        int            javaOomReserveSizeKb        = 256;
         ICrashCallback javaCallback                = null;
 
         /**
@@ -472,6 +635,21 @@ public final class XCrash {
             return this;
         }
 
+        /**
+         * Set the maximum time in milliseconds for dumping other threads when a Java exception occurred.
+         * The threads not dumped in time are counted but skipped. "0" means no limit. (Default: 1000)
+         *
+         * <p>Note: This option is only useful when "JavaDumpAllThreads" is enabled by calling {@link InitParameters#setJavaDumpAllThreads(boolean)}.
+         *
+         * @param timeoutMs The maximum time for dumping other threads.
+         * @return The InitParameters object.
+         */
+        @SuppressWarnings("unused")
+        public InitParameters setJavaDumpAllThreadsTimeoutMs(int timeoutMs) {
+            this.javaDumpAllThreadsTimeoutMs = (timeoutMs < 0 ? 0 : timeoutMs);
+            return this;
+        }
+
         /**
          * Set a thread name (regular expression) whitelist to filter which threads need to be dumped when a Java exception occurred.
          * "null" means no filtering. (Default: null)
@@ -487,6 +665,23 @@ public final class XCrash {
             return this;
         }
 
+        /**
+         * Set the size of the buffer reserved for writing the log of an {@link OutOfMemoryError}, in KB. (Default: 256)
+         *
+         * <p>Note: The buffer and the log file are prepared when initializing, so the log of an {@link OutOfMemoryError}
+         * is written without allocating on the Java heap. The logcat, FDs, network info and memory info are recorded
+         * by the native library if it's loaded. Set this value to 0 means write it in the same way as the other
+         * Java exceptions.
+         *
+         * @param sizeKb The size of the buffer.
+         * @return The InitParameters object.
+         */
+        @SuppressWarnings("unused")
+        public InitParameters setJavaOomReserveSizeKb(int sizeKb) {
+            this.javaOomReserveSizeKb = (sizeKb < 0 ? 0 : sizeKb);
+            return this;
+        }
+
         /**
          * Set a callback to be executed when a Java exception occurred. (If not set, nothing will be happened.)
          *
@@ -508,11 +703,19 @@ public final class XCrash {
         int            nativeLogcatMainLines         = 200;
         boolean        nativeDumpElfHash             = true;
         boolean        nativeDumpMap                 = true;
+        boolean        nativeDumpMapDelta            = false;
+        boolean        nativeDumpMapSummary          = false;
         boolean        nativeDumpFds                 = true;
         boolean        nativeDumpNetworkInfo         = true;
         boolean        nativeDumpAllThreads          = true;
         int            nativeDumpAllThreadsCountMax  = 0;
         String[]       nativeDumpAllThreadsWhiteList = null;
+        int            nativeSnapshotLogCountMax     = 5;
+        boolean        nativeDumpBinary              = false;
+        boolean        nativeDumpProto               = false;
+        boolean        nativeDumpMinidump            = false;
+        boolean        nativeCompressLog             = false;
+        boolean        nativeCompressDict            = false;
         ICrashCallback nativeCallback                = null;
 
         /**
@@ -562,6 +765,20 @@ public final class XCrash {
             return this;
         }
 
+        /**
+         * Set the maximum number of thread snapshot log files to save in the log directory. (Default: 5)
+         *
+         * <p>Note: The snapshot log files are generated by {@link xcrash.XCrash#dumpNativeThreads()}.
+         *
+         * @param countMax The maximum number of thread snapshot log files.
+         * @return The InitParameters object.
+         */
+        @SuppressWarnings("unused")
+        public InitParameters setNativeSnapshotLogCountMax(int countMax) {
+            this.nativeSnapshotLogCountMax = (countMax < 1 ? 1 : countMax);
+            return this;
+        }
+
         /**
          * Set the maximum number of rows to get from "logcat -b system" when a native crash occurred. (Default: 50)
          *
@@ -622,6 +839,42 @@ public final class XCrash {
             return this;
         }
 
+        /**
+         * Set if dumping only the difference of memory map from the maps baseline when a native crash occurred.
+         * (Default: disable)
+         *
+         * <p>Note: It works with {@link #setNativeDumpMap(boolean)}. The maps of the process are saved in the log
+         * directory as the baseline when the native crash handler is inited, and can be refreshed by
+         * {@link xcrash.XCrash#refreshNativeMapsBaseline()}. The full memory map can be rebuilt by
+         * {@link xcrash.TombstoneParser#getMemoryMap(String, java.util.Map)} while the baseline file exists.
+         *
+         * @param flag True or false.
+         * @return The InitParameters object.
+         */
+        @SuppressWarnings("unused")
+        public InitParameters setNativeDumpMapDelta(boolean flag) {
+            this.nativeDumpMapDelta = flag;
+            return this;
+        }
+
+        /**
+         * Set if dumping a summary of memory map instead of the full one when a native crash occurred.
+         * (Default: disable)
+         *
+         * <p>Note: It works with {@link #setNativeDumpMap(boolean)}, and takes precedence over
+         * {@link #setNativeDumpMapDelta(boolean)}. The mappings are grouped by the path or the anonymous tag
+         * (such as "[anon:dalvik-*]") with count, total size and permission breakdown. Only the mappings around
+         * the fault address and the executable ones of the ELFs used by the backtrace are kept in full.
+         *
+         * @param flag True or false.
+         * @return The InitParameters object.
+         */
+        @SuppressWarnings("unused")
+        public InitParameters setNativeDumpMapSummary(boolean flag) {
+            this.nativeDumpMapSummary = flag;
+            return this;
+        }
+
         /**
          * Set if dumping FD list when a native crash occurred. (Default: enable)
          *
@@ -693,6 +946,87 @@ public final class XCrash {
             return this;
         }
 
+        /**
+         * Set if writing the native crash log file in the compact binary format. (Default: disable)
+         *
+         * <p>Note: The binary log file keeps the same file name. {@link xcrash.TombstoneParser} reads it transparently,
+         * and {@link xcrash.TombstoneManager#renderBinaryTombstone(String, String)} converts it to the text format.
+         *
+         * @param flag True or false.
+         * @return The InitParameters object.
+         */
+        @SuppressWarnings("unused")
+        public InitParameters setNativeDumpBinary(boolean flag) {
+            this.nativeDumpBinary = flag;
+            return this;
+        }
+
+        /**
+         * Set if writing an additional protobuf tombstone (Android platform's tombstone.proto) for each native crash. (Default: disable)
+         *
+         * <p>Note: The protobuf tombstone is saved next to the native crash log file,
+         * see {@link xcrash.TombstoneManager#getNativeTombstoneProto(java.io.File)}.
+         *
+         * @param flag True or false.
+         * @return The InitParameters object.
+         */
+        @SuppressWarnings("unused")
+        public InitParameters setNativeDumpProto(boolean flag) {
+            this.nativeDumpProto = flag;
+            return this;
+        }
+
+        /**
+         * Set if writing an additional Breakpad compatible minidump for each native crash. (Default: disable)
+         *
+         * <p>Note: The minidump is saved next to the native crash log file,
+         * see {@link xcrash.TombstoneManager#getNativeTombstoneMinidump(java.io.File)}.
+         * It can be symbolized on the server side by minidump_stackwalk with the symbol files.
+         *
+         * @param flag True or false.
+         * @return The InitParameters object.
+         */
+        @SuppressWarnings("unused")
+        public InitParameters setNativeDumpMinidump(boolean flag) {
+            this.nativeDumpMinidump = flag;
+            return this;
+        }
+
+        /**
+         * Set if compressing the native crash log file with XZ. (Default: disable)
+         *
+         * <p>Note: The compressed log file is named "*.native.xcrash.xz", it is compressed by the dumper
+         * process after the crash is captured. If it's compressed with the preset dictionary built from the
+         * recent logs, it's named "*.native.xcrash.xcdz" instead (decompress it by "src/tools/xcrash_unxz.py"). {@link xcrash.TombstoneParser} and {@link xcrash.TombstoneManager}
+         * read it directly, the protobuf tombstone and the minidump keep the uncompressed name.
+         *
+         * @param flag True or false.
+         * @return The InitParameters object.
+         */
+        @SuppressWarnings("unused")
+        public InitParameters setNativeCompressLog(boolean flag) {
+            this.nativeCompressLog = flag;
+            return this;
+        }
+
+        /**
+         * Set if compressing the native crash log file with a preset dictionary. (Default: disable)
+         *
+         * <p>Note: It works with {@link #setNativeCompressLog(boolean)}. The dictionary is built from the recent
+         * native crash log files when maintaining the log directory, and saved in the log directory with its ID
+         * in the name. Small and similar crash logs are compressed much better with it. The compressed log file
+         * is not a standard XZ file, it can be decoded with the dictionary file only
+         * (see {@link xcrash.TombstoneManager#getNativeTombstoneDictionary(java.io.File)}).
+         *
+         * @param flag True or false.
+         * @return The InitParameters object.
+         */
+        @SuppressWarnings("unused")
+        public InitParameters setNativeCompressDict(boolean flag) {
+            this.nativeCompressDict = flag;
+            return this;
+        }
+
         /**
          * Set a callback to be executed when a native crash occurred. (If not set, nothing will be happened.)
          *
@@ -715,6 +1049,8 @@ public final class XCrash {
         int            anrLogcatMainLines   = 200;
         boolean        anrDumpFds           = true;
         boolean        anrDumpNetworkInfo   = true;
+        int            anrThreadStatIntervalMs = 100;
+        int            anrWatchdogTimeoutMs = 0;
         ICrashCallback anrCallback          = null;
 
         /**
@@ -842,6 +1178,40 @@ public final class XCrash {
             return this;
         }
 
+        /**
+         * Set the interval between the two samples of per-thread CPU statistics when an ANR occurred.
+         * The threads that used the most CPU time within the interval are dumped.
+         * "0" means only one sample is taken, and the threads are ranked by their total CPU time. (Default: 100)
+         *
+         * <p>Note: This only works on Android 5.0 (API level 21) and above. When a native crash occurred,
+         * all threads have been stopped, so they are always ranked by their total CPU time.
+         *
+         * @param intervalMs The interval in milliseconds.
+         * @return The InitParameters object.
+         */
+        @SuppressWarnings("unused")
+        public InitParameters setAnrThreadStatInterval(int intervalMs) {
+            this.anrThreadStatIntervalMs = (intervalMs < 0 ? 0 : (intervalMs > 1000 ? 1000 : intervalMs));
+            return this;
+        }
+
+        /**
+         * Set the timeout of the ANR watchdog. The watchdog posts a message to the main thread continuously,
+         * and dumps the trace of this process when the message has not been handled within the timeout,
+         * without waiting for the system to send SIGQUIT. "0" means the watchdog is disabled. (Default: 0)
+         *
+         * <p>Note: This only works on Android 5.0 (API level 21) and above. The process ANR state is not checked
+         * for the traces dumped by the watchdog, since the system may not have noticed the blocked main thread yet.
+         *
+         * @param timeoutMs The timeout in milliseconds.
+         * @return The InitParameters object.
+         */
+        @SuppressWarnings("unused")
+        public InitParameters setAnrWatchdogTimeoutMs(int timeoutMs) {
+            this.anrWatchdogTimeoutMs = (timeoutMs < 0 ? 0 : (timeoutMs > 0 && timeoutMs < 1000 ? 1000 : timeoutMs));
+            return this;
+        }
+
         /**
          * Set a callback to be executed when an ANR occurred. (If not set, nothing will be happened.)
          *
@@ -871,6 +1241,96 @@ public final class XCrash {
         return logger;
     }
 
+    /**
+     * Get the time spent on each step of the initialization.
+     *
+     * @return The startup trace, or null if the initialization has not finished.
+     */
+    @SuppressWarnings("unused")
+    public static String getInitTrace() {
+        return InitTrace.getInstance().getResult();
+    }
+
+    /**
+     * Dump registers, backtrace and stack of all threads in the current process, without a crash.
+     *
+     * <p>Note: Each thread is only stopped for a very short time while its registers and stack
+     * are copied, the unwinding is done after all threads have been resumed.
+     * The native crash capturing must be enabled.
+     *
+     * @return Absolute path of the generated snapshot log file, or null if failed.
+     */
+    @SuppressWarnings("unused")
+    public static String dumpNativeThreads() {
+        return dumpNativeThreads(null, 0);
+    }
+
+    /**
+     * Dump registers, backtrace and stack of the selected threads in the current process, without a crash.
+     *
+     * <p>Note: Each thread is only stopped for a very short time while its registers and stack
+     * are copied, the unwinding is done after all threads have been resumed.
+     * The native crash capturing must be enabled.
+     *
+     * @param threadNameWhiteList A list of regular expressions to match thread names, null means all threads.
+     * @param threadCountMax The maximum number of threads to dump, 0 means no limit.
+     * @return Absolute path of the generated snapshot log file, or null if failed.
+     */
+    @SuppressWarnings({"unused", "WeakerAccess"})
+    public static String dumpNativeThreads(String[] threadNameWhiteList, int threadCountMax) {
+        return NativeHandler.getInstance().dumpNativeThreads(threadNameWhiteList,
+            threadCountMax < 0 ? 0 : threadCountMax);
+    }
+
+    /**
+     * Save the current maps of the process as the new baseline, for keeping the memory map delta small
+     * after lots of libraries have been loaded.
+     *
+     * <p>Note: It works with {@link xcrash.XCrash.InitParameters#setNativeDumpMapDelta(boolean)}.
+     * The native crash capturing must be enabled.
+     *
+     * @return Whether the baseline has been saved.
+     */
+    @SuppressWarnings("unused")
+    public static boolean refreshNativeMapsBaseline() {
+        return NativeHandler.getInstance().refreshMapsBaseline();
+    }
+
+    /**
+     * Start sampling the main thread's Java and native stack, for finding out where a jank episode spends its time.
+     *
+     * <p>Note: The main thread is interrupted by a signal at the given frequency, only its registers
+     * and the top of its stack are copied in the signal handler. Sampling is throttled when the time
+     * spent in the signal handler exceeds 2% of the wall time, and stops automatically after
+     * {@code durationMsMax} milliseconds, or when the raw samples reach 32MB. The Java stack is taken right
+     * after each native sample (the main thread is paused until its next suspend point, which is counted
+     * in the 2%), the native frames follow the innermost Java frame.
+     * The native crash capturing must be enabled.
+     *
+     * @param samplingFrequency Samples per second, 1 to 1000, 0 means the default value (100).
+     * @param durationMsMax The maximum sampling duration in milliseconds, 0 means the default value (10000),
+     *                      values above 30000 are clamped.
+     * @return Whether the sampling has been started.
+     */
+    @SuppressWarnings({"unused", "WeakerAccess"})
+    public static boolean startMainThreadProfiling(int samplingFrequency, int durationMsMax) {
+        return NativeHandler.getInstance().startProfile(samplingFrequency < 0 ? 0 : samplingFrequency,
+            durationMsMax < 0 ? 0 : durationMsMax);
+    }
+
+    /**
+     * Stop sampling the main thread, and write the samples to a profile file in the log directory.
+     *
+     * <p>Note: The profile file contains one "frame;frame;frame count" line per distinct stack
+     * (outermost frame first), which can be rendered by the flame graph tools directly.
+     *
+     * @return Absolute path of the generated profile file, or null if failed.
+     */
+    @SuppressWarnings("unused")
+    public static String stopMainThreadProfiling() {
+        return NativeHandler.getInstance().stopProfile();
+    }
+
     /**
      * Force a java exception.
      *
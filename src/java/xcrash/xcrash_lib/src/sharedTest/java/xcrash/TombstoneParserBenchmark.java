@@ -0,0 +1,394 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// Created by agent on 2026-10-17.
+package xcrash;
+
+import android.util.Log;
+
+import org.junit.After;
+import org.junit.Assert;
+import org.junit.Before;
+import org.junit.Test;
+
+import java.io.BufferedReader;
+import java.io.File;
+import java.io.FileOutputStream;
+import java.io.FileReader;
+import java.io.IOException;
+import java.io.OutputStreamWriter;
+import java.io.Writer;
+import java.util.HashMap;
+import java.util.Locale;
+import java.util.Map;
+import java.util.regex.Matcher;
+import java.util.regex.Pattern;
+
+/**
+ * Compare the streaming parser ({@link xcrash.TombstoneStream}) with the line based parser it replaced,
+ * on a generated multi-MB native crash log.
+ *
+ * <p>Run it on a device by "./gradlew :xcrash_lib:connectedAndroidTest", the results are logged with the tag
+ * "xcrash_benchmark". It also runs on the local JVM by "./gradlew :xcrash_lib:testDebugUnitTest"
+ * (the results are in the standard output of the test report), the Android APIs return the default values there.
+ */
+public class TombstoneParserBenchmark {
+
+    private static final String TAG = "xcrash_benchmark";
+    private static final int warmupRounds = 3;
+    private static final int rounds = 10;
+
+    private File log;
+
+    @Before
+    public void setUp() throws IOException {
+        log = File.createTempFile("tombstone_benchmark_", Util.nativeLogSuffix);
+        generateLog(log, 4 * 1024 * 1024);
+    }
+
+    @After
+    public void tearDown() {
+        if (log != null) {
+            //noinspection ResultOfMethodCallIgnored
+            log.delete();
+        }
+    }
+
+    @Test
+    public void parseLargeLog() throws IOException {
+        String logPath = log.getAbsolutePath();
+
+        //the same items and sections
+        Map<String, String> oldMap = LegacyParser.parse(logPath);
+        Map<String, String> newMap = TombstoneParser.parse(logPath);
+        for (Map.Entry<String, String> entry : oldMap.entrySet()) {
+            Assert.assertEquals(entry.getKey(), entry.getValue(), newMap.get(entry.getKey()));
+        }
+
+        for (int i = 0; i < warmupRounds; i++) {
+            LegacyParser.parse(logPath);
+            TombstoneParser.parse(logPath);
+        }
+
+        long oldNanos = 0, newNanos = 0;
+        for (int i = 0; i < rounds; i++) {
+            //interleaved, so both of them see the same page cache and GC pressure
+            System.gc();
+            long start = System.nanoTime();
+            LegacyParser.parse(logPath);
+            oldNanos += System.nanoTime() - start;
+
+            System.gc();
+            start = System.nanoTime();
+            TombstoneParser.parse(logPath);
+            newNanos += System.nanoTime() - start;
+        }
+
+        String result = String.format(Locale.US, "log size: %d bytes, rounds: %d, old parser: %.2f ms/round, new parser: %.2f ms/round, speedup: %.2fx",
+            log.length(), rounds, oldNanos / 1e6 / rounds, newNanos / 1e6 / rounds, (double) oldNanos / newNanos);
+        Log.i(TAG, result);
+        System.out.println(TAG + ": " + result);
+    }
+
+    //head, registers, backtrace, a large memory map, logcat and other threads, like a native crash with all the options on
+    private static void generateLog(File file, int minSize) throws IOException {
+        Writer w = new OutputStreamWriter(new FileOutputStream(file), "UTF-8");
+        try {
+            StringBuilder sb = new StringBuilder();
+            sb.append(Util.sepHead).append('\n');
+            sb.append("Tombstone maker: 'xCrash 2.5.7'\n");
+            sb.append("Crash type: 'native'\n");
+            sb.append("Start time: '2019-10-12T03:18:02.523+0800'\n");
+            sb.append("Crash time: '2019-10-12T03:18:21.127+0800'\n");
+            sb.append("App ID: 'xcrash.sample'\n");
+            sb.append("App version: '1.2.3'\n");
+            sb.append("Rooted: 'No'\n");
+            sb.append("API level: '29'\n");
+            sb.append("OS version: '10'\n");
+            sb.append("ABI list: 'arm64-v8a,armeabi-v7a,armeabi'\n");
+            sb.append("Manufacturer: 'Google'\n");
+            sb.append("Brand: 'google'\n");
+            sb.append("Model: 'Pixel'\n");
+            sb.append("Build fingerprint: 'google/sailfish/sailfish:10/QP1A.190711.020/5800535:user/release-keys'\n");
+            sb.append("ABI: 'arm64'\n");
+            sb.append("pid: 20501, tid: 20501, name: xcrash.sample  >>> xcrash.sample <<<\n");
+            sb.append("signal 11 (SIGSEGV), code 1 (SEGV_MAPERR), fault addr 0x0\n");
+            for (int i = 0; i < 28; i += 4) {
+                sb.append(String.format(Locale.US, "    x%-2d 0000000000000003  x%-2d 0000000000000000  x%-2d 000000751128fd60  x%-2d 0000007511290020\n", i, i + 1, i + 2, i + 3));
+            }
+            sb.append("    sp  0000007fe0ef2070  lr  00000074b9bcc8cc  pc  00000074b9bcc884\n\n");
+            appendBacktrace(sb, "backtrace:\n", 64);
+            sb.append('\n');
+            w.write(sb.toString());
+            sb.setLength(0);
+
+            int size = 0;
+            int i = 0;
+            sb.append("memory map:\n");
+            while (size < minSize / 2) {
+                sb.append(String.format(Locale.US, "    %08x-%08x r-xp %08x 103:0e %-8d /data/app/xcrash.sample-WeCpVYjROKKgYtuzbHflHg==/lib/arm64/libtest_%d.so\n",
+                    0x70000000 + i * 0x1000, 0x70001000 + i * 0x1000, i * 0x1000, 1000 + i, i));
+                size += sb.length();
+                w.write(sb.toString());
+                sb.setLength(0);
+                i++;
+            }
+            w.write("\n");
+
+            sb.append("logcat:\n");
+            i = 0;
+            while (size < minSize * 3 / 4) {
+                sb.append(String.format(Locale.US, "--------- tail end of log main\n10-12 03:18:%02d.%03d 20501 20501 I xcrash_sample: message %d, the quick brown fox jumps over the lazy dog\n",
+                    i % 60, i % 1000, i));
+                size += sb.length();
+                w.write(sb.toString());
+                sb.setLength(0);
+                i++;
+            }
+            w.write("\n");
+
+            i = 0;
+            while (size < minSize) {
+                sb.append(Util.sepOtherThreads).append('\n');
+                sb.append(String.format(Locale.US, "pid: 20501, tid: %d, name: Thread-%d  >>> xcrash.sample <<<\n\n", 20600 + i, i));
+                appendBacktrace(sb, "backtrace:\n", 24);
+                sb.append(Util.sepOtherThreadsEnding).append('\n');
+                size += sb.length();
+                w.write(sb.toString());
+                sb.setLength(0);
+                i++;
+            }
+            w.write("\nforeground:\nyes\n\n");
+        } finally {
+            w.close();
+        }
+    }
+
+    private static void appendBacktrace(StringBuilder sb, String title, int frames) {
+        sb.append(title);
+        for (int i = 0; i < frames; i++) {
+            sb.append(String.format(Locale.US, "    #%02d pc %016x  /apex/com.android.runtime/lib64/libart.so (art_quick_invoke_stub+%d)\n", i, 0x136334 + i * 16, i * 4));
+        }
+    }
+
+    /**
+     * The line based parser replaced by {@link xcrash.TombstoneStream} (parseFromReader() in TombstoneParser),
+     * kept here only as the baseline.
+     */
+    private static class LegacyParser {
+
+        private static final Pattern patHeadItem = Pattern.compile("^(.*):\\s'(.*?)'$");
+
+        private static final Pattern patProcessThread = Pattern.compile(
+                "^pid:\\s(.*),\\stid:\\s(.*),\\sname:\\s(.*)\\s+>>>\\s(.*)\\s<<<$");
+
+        private static final Pattern patProcess = Pattern.compile("^pid:\\s(.*)\\s+>>>\\s(.*)\\s<<<$");
+
+        private static final Pattern patSignalCode = Pattern.compile(
+                "^signal\\s(.*),\\scode\\s(.*),\\sfault\\saddr\\s(.*)$");
+
+        private enum Status {
+            UNKNOWN,
+            HEAD,
+            SECTION
+        }
+
+        static Map<String, String> parse(String logPath) throws IOException {
+            Map<String, String> map = new HashMap<String, String>();
+            BufferedReader br = new BufferedReader(new FileReader(logPath));
+            try {
+                parseFromReader(map, br);
+            } finally {
+                br.close();
+            }
+            return map;
+        }
+
+        private static String readLineInBinary(BufferedReader br) throws IOException {
+
+            // Peek the next 2 characters to determine if there is still valid text.
+            try {
+                br.mark(2);
+            } catch (Exception ignored) {
+                return br.readLine();
+            }
+            try {
+                for (int i = 0; i < 2; i++) {
+                    int c = br.read();
+                    if (c == -1) {
+                        br.reset();
+                        return null;
+                    } else if (c > 0) {
+                        br.reset();
+                        return br.readLine();
+                    }
+                }
+                br.reset();
+                return null;
+            } catch (Exception ignored) {
+                br.reset();
+                return br.readLine();
+            }
+        }
+
+        private static void parseFromReader(Map<String, String> map, BufferedReader br) throws IOException {
+            String next, line;
+            String sectionTitle = null;
+            StringBuilder sectionContent = new StringBuilder();
+            String sectionContentEnding = "";
+            boolean sectionContentOutdent = false;
+            boolean sectionContentAppend = false;
+            Matcher matcher;
+            Status status = Status.UNKNOWN;
+
+            line = readLineInBinary(br);
+            for (boolean last = (line == null); !last; line = next) {
+                last = ((next = readLineInBinary(br)) == null);
+                switch (status) {
+                    case UNKNOWN:
+                        if (line.equals(Util.sepHead)) {
+                            status = Status.HEAD;
+                        } else if (line.equals(Util.sepOtherThreads)) {
+                            status = Status.SECTION;
+                            sectionTitle = TombstoneParser.keyOtherThreads;
+                            sectionContentEnding = Util.sepOtherThreadsEnding;
+                            sectionContentOutdent = false;
+                            sectionContentAppend = false;
+                            sectionContent.append(line).append('\n');
+                        } else if (line.length() > 1 && line.endsWith(":")) {
+                            status = Status.SECTION;
+                            sectionTitle = line.substring(0, line.length() - 1);
+                            sectionContentEnding = "";
+                            if (TombstoneParser.keySections.contains(sectionTitle)) {
+                                sectionContentOutdent = (sectionTitle.equals(TombstoneParser.keyBacktrace)
+                                    || sectionTitle.equals(TombstoneParser.keyBuildId)
+                                    || sectionTitle.equals(TombstoneParser.keyStack)
+                                    || sectionTitle.equals(TombstoneParser.keyMemoryMap)
+                                    || sectionTitle.equals(TombstoneParser.keyMemoryMapDelta)
+                                    || sectionTitle.equals(TombstoneParser.keyMemoryMapSummary)
+                                    || sectionTitle.equals(TombstoneParser.keyMemoryMapExcerpt)
+                                    || sectionTitle.equals(TombstoneParser.keyOpenFiles)
+                                    || sectionTitle.equals(TombstoneParser.keyThreadsCpu)
+                                    || sectionTitle.equals(TombstoneParser.keyJavaStacktrace)
+                                    || sectionTitle.equals(TombstoneParser.keyXCrashErrorDebug));
+                                sectionContentAppend = sectionTitle.equals(TombstoneParser.keyXCrashError);
+                            } else if (sectionTitle.equals(TombstoneParser.keyMemoryInfo)) {
+                                sectionContentOutdent = false;
+                                sectionContentAppend = true;
+                            } else if (sectionTitle.startsWith("memory near ")) {
+                                sectionTitle = TombstoneParser.keyMemoryNear;
+                                sectionContentOutdent = false;
+                                sectionContentAppend = true;
+                                sectionContent.append(line).append('\n');
+                            } else {
+                                sectionContentOutdent = false;
+                                sectionContentAppend = false;
+                            }
+                        }
+                        break;
+                    case HEAD:
+                        if (line.startsWith("pid: ")) {
+                            matcher = patProcessThread.matcher(line);
+                            if (matcher.find() && matcher.groupCount() == 4) {
+                                putKeyValue(map, TombstoneParser.keyProcessId, matcher.group(1), false);
+                                putKeyValue(map, TombstoneParser.keyThreadId, matcher.group(2), false);
+                                putKeyValue(map, TombstoneParser.keyThreadName, matcher.group(3), false);
+                                putKeyValue(map, TombstoneParser.keyProcessName, matcher.group(4), false);
+                            } else {
+                                matcher = patProcess.matcher(line);
+                                if (matcher.find() && matcher.groupCount() == 2) {
+                                    putKeyValue(map, TombstoneParser.keyProcessId, matcher.group(1), false);
+                                    putKeyValue(map, TombstoneParser.keyProcessName, matcher.group(2), false);
+                                }
+                            }
+                        } else if (line.startsWith("signal ")) {
+                            matcher = patSignalCode.matcher(line);
+                            if (matcher.find() && matcher.groupCount() == 3) {
+                                putKeyValue(map, TombstoneParser.keySignal, matcher.group(1), false);
+                                putKeyValue(map, TombstoneParser.keyCode, matcher.group(2), false);
+                                putKeyValue(map, TombstoneParser.keyFaultAddr, matcher.group(3), false);
+                            }
+                        } else {
+                            matcher = patHeadItem.matcher(line);
+                            if (matcher.find() && matcher.groupCount() == 2) {
+                                if (TombstoneParser.keyHeadItems.contains(matcher.group(1))) {
+                                    putKeyValue(map, matcher.group(1), matcher.group(2), false);
+                                }
+                            }
+                        }
+                        if (next != null && (next.startsWith("    r0 ") ||
+                                next.startsWith("    x0 ") ||
+                                next.startsWith("    eax ") ||
+                                next.startsWith("    rax "))) {
+                            status = Status.SECTION;
+                            sectionTitle = TombstoneParser.keyRegisters;
+                            sectionContentEnding = "";
+                            sectionContentOutdent = true;
+                            sectionContentAppend = false;
+                        }
+                        if (next == null || next.isEmpty()) {
+                            status = Status.UNKNOWN;
+                        }
+                        break;
+                    case SECTION:
+                        if (line.equals(sectionContentEnding) || last) {
+                            if (sectionTitle.equals(TombstoneParser.keyForeground)) {
+                                if (sectionContent.length() > 0 &&
+                                        sectionContent.charAt(sectionContent.length() - 1) == '\n') {
+                                    sectionContent.deleteCharAt(sectionContent.length() - 1);
+                                }
+                            }
+                            putKeyValue(map, sectionTitle, sectionContent.toString(), sectionContentAppend);
+                            sectionContent.setLength(0);
+                            status = Status.UNKNOWN;
+                        } else {
+                            if (sectionContentOutdent) {
+                                if (sectionTitle.equals(TombstoneParser.keyJavaStacktrace) && line.startsWith(" ")) {
+                                    line = line.trim();
+                                } else if (line.startsWith("    ")) {
+                                    line = line.substring(4);
+                                }
+                            }
+                            sectionContent.append(line).append('\n');
+                        }
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+
+        private static void putKeyValue(Map<String, String> map, String k, String v, boolean append) {
+            if (k == null || k.isEmpty() || v == null) return;
+
+            String oldValue = map.get(k);
+
+            if (append) {
+                map.put(k, (oldValue == null ? v : oldValue + v));
+            } else {
+                if (oldValue == null || (oldValue.isEmpty() && !v.isEmpty())) {
+                    map.put(k, v);
+                }
+            }
+        }
+    }
+}
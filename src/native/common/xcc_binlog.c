@@ -0,0 +1,651 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Created by agent on 2026-10-17.
+
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/types.h>
+#include "xcc_errno.h"
+#include "xcc_util.h"
+#include "xcc_binlog.h"
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wgnu-statement-expression"
+
+#define XCC_BINLOG_PAYLOAD_MAX (32 * 1024 * 1024)
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wpadded"
+typedef struct
+{
+    const uint8_t *p;
+    const uint8_t *end;
+    int            err;
+} xcc_binlog_cursor_t;
+
+typedef struct
+{
+    const char *str;
+    int         len;
+} xcc_binlog_str_t;
+
+typedef struct
+{
+    char       *str;
+    uint64_t    offset;
+} xcc_binlog_entry_t;
+
+typedef struct
+{
+    xcc_binlog_entry_t *items;
+    size_t              num;
+    size_t              cap;
+} xcc_binlog_entries_t;
+#pragma clang diagnostic pop
+
+int xcc_binlog_write_header(int fd)
+{
+    uint8_t buf[XCC_BINLOG_HEADER_LEN];
+
+    memcpy(buf, XCC_BINLOG_MAGIC, XCC_BINLOG_MAGIC_LEN);
+    buf[4] = XCC_BINLOG_VERSION;
+    buf[5] = (uint8_t)sizeof(uintptr_t);
+    return xcc_util_write(fd, (const char *)buf, sizeof(buf));
+}
+
+int xcc_binlog_write_end(int fd)
+{
+    uint8_t buf[2] = {XCC_BINLOG_MARK, XCC_BINLOG_SECTION_END};
+
+    //the last byte is never 0, so the placeholder padding can still be found after it
+    return xcc_util_write(fd, (const char *)buf, sizeof(buf));
+}
+
+int xcc_binlog_section_begin(xcc_binlog_t *self, int fd, uint8_t type)
+{
+    uint8_t head[XCC_BINLOG_SECTION_HEAD_LEN] = {XCC_BINLOG_MARK, type, 0, 0, 0, 0};
+
+    self->fd = fd;
+    self->r = 0;
+    self->len = 0;
+
+    //the length is filled in when the section ends
+    if((self->section_offset = lseek(fd, 0, SEEK_CUR)) < 0) return XCC_ERRNO_SYS;
+    return xcc_util_write(fd, (const char *)head, sizeof(head));
+}
+
+static void xcc_binlog_flush(xcc_binlog_t *self)
+{
+    if(0 == self->r && self->len > 0)
+        self->r = xcc_util_write(self->fd, (const char *)self->buf, self->len);
+    self->len = 0;
+}
+
+void xcc_binlog_put_bytes(xcc_binlog_t *self, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    size_t         n;
+
+    while(len > 0)
+    {
+        if(self->len == sizeof(self->buf)) xcc_binlog_flush(self);
+
+        n = sizeof(self->buf) - self->len;
+        if(n > len) n = len;
+        memcpy(self->buf + self->len, p, n);
+        self->len += n;
+        p += n;
+        len -= n;
+    }
+}
+
+void xcc_binlog_put_varint(xcc_binlog_t *self, uint64_t v)
+{
+    uint8_t buf[10];
+    size_t  n = 0;
+
+    do
+    {
+        buf[n] = (uint8_t)(v & 0x7F);
+        v >>= 7;
+        if(0 != v) buf[n] |= 0x80;
+        n++;
+    } while(0 != v);
+
+    xcc_binlog_put_bytes(self, buf, n);
+}
+
+void xcc_binlog_put_str(xcc_binlog_t *self, const char *str)
+{
+    size_t len = (NULL == str ? 0 : strlen(str));
+
+    xcc_binlog_put_varint(self, len);
+    if(len > 0) xcc_binlog_put_bytes(self, str, len);
+}
+
+int xcc_binlog_section_end(xcc_binlog_t *self)
+{
+    off_t    offset;
+    uint64_t len;
+    uint8_t  buf[4];
+
+    xcc_binlog_flush(self);
+    if(0 != self->r) return self->r;
+
+    if((offset = lseek(self->fd, 0, SEEK_CUR)) < 0) return XCC_ERRNO_SYS;
+    len = (uint64_t)(offset - self->section_offset - XCC_BINLOG_SECTION_HEAD_LEN);
+    if(len > UINT32_MAX) return XCC_ERRNO_FORMAT;
+
+    buf[0] = (uint8_t)(len & 0xFF);
+    buf[1] = (uint8_t)((len >> 8) & 0xFF);
+    buf[2] = (uint8_t)((len >> 16) & 0xFF);
+    buf[3] = (uint8_t)((len >> 24) & 0xFF);
+    if(sizeof(buf) != XCC_UTIL_TEMP_FAILURE_RETRY(pwrite(self->fd, buf, sizeof(buf), self->section_offset + 2)))
+        return XCC_ERRNO_SYS;
+
+    return 0;
+}
+
+static size_t xcc_binlog_hash(const void *key, int is_str)
+{
+    const uint8_t *p;
+    size_t         h;
+
+    if(!is_str) return (size_t)((uintptr_t)key >> 4) * 2654435761u;
+
+    //FNV-1a
+    h = 2166136261u;
+    for(p = (const uint8_t *)key; '\0' != *p; p++)
+        h = (h ^ *p) * 16777619u;
+    return h;
+}
+
+static int xcc_binlog_table_grow(xcc_binlog_table_t *t, int is_str)
+{
+    const void **keys;
+    size_t      *ids, cap, i, j;
+
+    cap = (0 == t->cap ? 64 : t->cap * 2);
+    if(NULL == (keys = calloc(cap, sizeof(const void *)))) return XCC_ERRNO_NOMEM;
+    if(NULL == (ids = calloc(cap, sizeof(size_t))))
+    {
+        free(keys);
+        return XCC_ERRNO_NOMEM;
+    }
+
+    for(i = 0; i < t->cap; i++)
+    {
+        if(NULL == t->keys[i]) continue;
+        j = xcc_binlog_hash(t->keys[i], is_str) & (cap - 1);
+        while(NULL != keys[j]) j = (j + 1) & (cap - 1);
+        keys[j] = t->keys[i];
+        ids[j] = t->ids[i];
+    }
+
+    free(t->keys);
+    free(t->ids);
+    t->keys = keys;
+    t->ids = ids;
+    t->cap = cap;
+    return 0;
+}
+
+//open addressing, the load factor is kept under 1/2
+static size_t xcc_binlog_table_intern(xcc_binlog_table_t *t, const void *key, int is_str, int *added)
+{
+    size_t i;
+
+    *added = 0;
+    if((t->num + 1) * 2 > t->cap && 0 != xcc_binlog_table_grow(t, is_str)) return 0;
+
+    for(i = xcc_binlog_hash(key, is_str) & (t->cap - 1); NULL != t->keys[i]; i = (i + 1) & (t->cap - 1))
+    {
+        if(is_str ? 0 == strcmp((const char *)t->keys[i], (const char *)key) : t->keys[i] == key)
+            return t->ids[i];
+    }
+
+    //the names are copied, they may be freed with the thread's frames
+    if(is_str && NULL == (key = strdup((const char *)key))) return 0;
+    t->keys[i] = key;
+    t->ids[i] = ++(t->num);
+    *added = 1;
+    return t->ids[i];
+}
+
+size_t xcc_binlog_intern_module(xcc_binlog_t *self, const void *map, int *added)
+{
+    return xcc_binlog_table_intern(&(self->modules), map, 0, added);
+}
+
+size_t xcc_binlog_intern_func(xcc_binlog_t *self, const char *name, int *added)
+{
+    return xcc_binlog_table_intern(&(self->funcs), name, 1, added);
+}
+
+static int xcc_binlog_read(int fd, void *buf, size_t len)
+{
+    uint8_t *p = (uint8_t *)buf;
+    ssize_t  n;
+
+    while(len > 0)
+    {
+        n = XCC_UTIL_TEMP_FAILURE_RETRY(read(fd, p, len));
+        if(n <= 0) return XCC_ERRNO_MISSING;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static uint32_t xcc_binlog_get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static int xcc_binlog_read_header(int fd, size_t *word_size, int *version)
+{
+    uint8_t head[XCC_BINLOG_HEADER_LEN];
+
+    if(lseek(fd, 0, SEEK_SET) < 0) return XCC_ERRNO_SYS;
+    if(0 != xcc_binlog_read(fd, head, sizeof(head))) return XCC_ERRNO_NOTFND;
+    if(0 != memcmp(head, XCC_BINLOG_MAGIC, XCC_BINLOG_MAGIC_LEN)) return XCC_ERRNO_NOTFND;
+    if(head[4] < XCC_BINLOG_VERSION_MIN || head[4] > XCC_BINLOG_VERSION) return XCC_ERRNO_FORMAT;
+    if(4 != head[5] && 8 != head[5]) return XCC_ERRNO_FORMAT;
+
+    if(NULL != word_size) *word_size = head[5];
+    if(NULL != version) *version = head[4];
+    return 0;
+}
+
+//only read(2) and lseek(2) are used here, it's called in the signal handler
+int xcc_binlog_check(int fd, off_t *end, int *backtrace_found)
+{
+    uint8_t head[XCC_BINLOG_SECTION_HEAD_LEN];
+    uint8_t frames_num;
+    off_t   offset = XCC_BINLOG_HEADER_LEN;
+    int     r;
+
+    *end = 0;
+    if(NULL != backtrace_found) *backtrace_found = 0;
+    if(0 != (r = xcc_binlog_read_header(fd, NULL, NULL))) return r;
+
+    //an incomplete binary log (without the end mark) is treated as broken
+    while(1)
+    {
+        if(0 != xcc_binlog_read(fd, head, 2) || XCC_BINLOG_MARK != head[0]) return XCC_ERRNO_FORMAT;
+        if(XCC_BINLOG_SECTION_END == head[1])
+        {
+            *end = offset + 2;
+            return 0;
+        }
+        if(0 != xcc_binlog_read(fd, head + 2, 4)) return XCC_ERRNO_FORMAT;
+
+        //the varint frames_num is the first byte of the payload, 0 means no frames
+        if(NULL != backtrace_found && XCC_BINLOG_SECTION_BACKTRACE == head[1] && xcc_binlog_get_u32(head + 2) > 0)
+        {
+            if(0 != xcc_binlog_read(fd, &frames_num, 1)) return XCC_ERRNO_FORMAT;
+            if(0 != frames_num) *backtrace_found = 1;
+        }
+
+        offset += XCC_BINLOG_SECTION_HEAD_LEN + (off_t)xcc_binlog_get_u32(head + 2);
+        if(lseek(fd, offset, SEEK_SET) < 0) return XCC_ERRNO_SYS;
+    }
+}
+
+static uint64_t xcc_binlog_get_varint(xcc_binlog_cursor_t *c)
+{
+    uint64_t v = 0;
+    unsigned shift = 0;
+
+    while(1)
+    {
+        if(c->p >= c->end || shift > 63)
+        {
+            c->err = 1;
+            return 0;
+        }
+        v |= (uint64_t)(*(c->p) & 0x7F) << shift;
+        if(0 == (*(c->p++) & 0x80)) return v;
+        shift += 7;
+    }
+}
+
+static const uint8_t *xcc_binlog_get_bytes(xcc_binlog_cursor_t *c, size_t *len)
+{
+    const uint8_t *p;
+    uint64_t       n = xcc_binlog_get_varint(c);
+
+    if(c->err || n > (uint64_t)(c->end - c->p))
+    {
+        c->err = 1;
+        *len = 0;
+        return (const uint8_t *)"";
+    }
+    p = c->p;
+    c->p += n;
+    *len = (size_t)n;
+    return p;
+}
+
+static void xcc_binlog_get_str(xcc_binlog_cursor_t *c, xcc_binlog_str_t *s)
+{
+    size_t len;
+
+    s->str = (const char *)xcc_binlog_get_bytes(c, &len);
+    s->len = (int)len;
+}
+
+static int xcc_binlog_entries_add(xcc_binlog_entries_t *t, xcc_binlog_str_t *s, uint64_t offset)
+{
+    xcc_binlog_entry_t *items;
+    size_t              cap;
+
+    if(t->num == t->cap)
+    {
+        cap = (0 == t->cap ? 64 : t->cap * 2);
+        if(NULL == (items = realloc(t->items, cap * sizeof(xcc_binlog_entry_t)))) return XCC_ERRNO_NOMEM;
+        t->items = items;
+        t->cap = cap;
+    }
+
+    //the payload is freed after the section is rendered
+    if(NULL == (t->items[t->num].str = malloc((size_t)s->len + 1))) return XCC_ERRNO_NOMEM;
+    memcpy(t->items[t->num].str, s->str, (size_t)s->len);
+    t->items[t->num].str[s->len] = '\0';
+    t->items[t->num].offset = offset;
+    t->num++;
+    return 0;
+}
+
+static void xcc_binlog_entries_clear(xcc_binlog_entries_t *t)
+{
+    size_t i;
+
+    for(i = 0; i < t->num; i++)
+        free(t->items[i].str);
+    t->num = 0;
+}
+
+static int xcc_binlog_render_backtrace(xcc_binlog_cursor_t *c, size_t word_size, int version,
+                                       xcc_binlog_entries_t *modules, xcc_binlog_entries_t *funcs, int out_fd)
+{
+    uint64_t            frames_num, new_num, i;
+    uint64_t            module, rel_pc, func, func_offset, module_offset;
+    xcc_binlog_str_t    str;
+    xcc_binlog_entry_t *name;
+    char                offset[64], func_buf[512];
+    int                 r;
+
+    //the tables are per section in version 1
+    if(1 == version)
+    {
+        xcc_binlog_entries_clear(modules);
+        xcc_binlog_entries_clear(funcs);
+    }
+
+    frames_num = xcc_binlog_get_varint(c);
+
+    //new entries of the interned tables, every entry takes at least one byte
+    new_num = xcc_binlog_get_varint(c);
+    if(c->err || new_num > (uint64_t)(c->end - c->p)) return XCC_ERRNO_FORMAT;
+    for(i = 0; i < new_num; i++)
+    {
+        xcc_binlog_get_str(c, &str);
+        module_offset = xcc_binlog_get_varint(c);
+        if(c->err) return XCC_ERRNO_FORMAT;
+        if(0 != (r = xcc_binlog_entries_add(modules, &str, module_offset))) return r;
+    }
+    new_num = xcc_binlog_get_varint(c);
+    if(c->err || new_num > (uint64_t)(c->end - c->p)) return XCC_ERRNO_FORMAT;
+    for(i = 0; i < new_num; i++)
+    {
+        xcc_binlog_get_str(c, &str);
+        if(c->err) return XCC_ERRNO_FORMAT;
+        if(0 != (r = xcc_binlog_entries_add(funcs, &str, 0))) return r;
+    }
+
+    if(0 != (r = xcc_util_write_str(out_fd, "backtrace:\n"))) return r;
+    for(i = 0; i < frames_num; i++)
+    {
+        module = xcc_binlog_get_varint(c);
+        rel_pc = xcc_binlog_get_varint(c);
+        func = xcc_binlog_get_varint(c);
+        func_offset = xcc_binlog_get_varint(c);
+        if(c->err || module > modules->num || func > funcs->num) return XCC_ERRNO_FORMAT;
+
+        name = (0 == module ? NULL : &(modules->items[module - 1]));
+
+        offset[0] = '\0';
+        if(NULL != name && 0 != name->offset)
+            snprintf(offset, sizeof(offset), " (offset 0x%"PRIx64")", name->offset);
+
+        func_buf[0] = '\0';
+        if(0 != func && func_offset > 0)
+            snprintf(func_buf, sizeof(func_buf), " (%s+%"PRIu64")", funcs->items[func - 1].str, func_offset);
+        else if(0 != func)
+            snprintf(func_buf, sizeof(func_buf), " (%s)", funcs->items[func - 1].str);
+
+        if(0 != (r = xcc_util_write_format(out_fd, "    #%02"PRIu64" pc %0*"PRIx64"  %s%s%s\n",
+                                           i, (int)(word_size * 2), rel_pc, NULL == name ? "<unknown>" : name->str, offset, func_buf))) return r;
+    }
+    return xcc_util_write_str(out_fd, "\n");
+}
+
+static int xcc_binlog_render_buildid(xcc_binlog_cursor_t *c, int out_fd)
+{
+    xcc_binlog_str_t name, tail;
+    const uint8_t   *build_id;
+    size_t           build_id_len, i;
+    int              r;
+
+    if(0 != (r = xcc_util_write_str(out_fd, "build id:\n"))) return r;
+    while(c->p < c->end)
+    {
+        xcc_binlog_get_str(c, &name);
+        build_id = xcc_binlog_get_bytes(c, &build_id_len);
+        xcc_binlog_get_str(c, &tail);
+        if(c->err) return XCC_ERRNO_FORMAT;
+
+        if(0 != (r = xcc_util_write_format(out_fd, "    %.*s (BuildId: ", name.len, name.str))) return r;
+        if(0 == build_id_len)
+        {
+            if(0 != (r = xcc_util_write_str(out_fd, "unknown"))) return r;
+        }
+        else
+        {
+            for(i = 0; i < build_id_len; i++)
+                if(0 != (r = xcc_util_write_format(out_fd, "%02hhx", build_id[i]))) return r;
+        }
+        if(0 != (r = xcc_util_write(out_fd, tail.str, (size_t)tail.len))) return r;
+    }
+    return xcc_util_write_str(out_fd, "\n");
+}
+
+static uint64_t xcc_binlog_get_word(const uint8_t *p, size_t word_size)
+{
+    uint64_t v = 0;
+    size_t   i;
+
+    //all the supported ABIs are little-endian
+    for(i = word_size; i > 0; i--)
+        v = (v << 8) | p[i - 1];
+    return v;
+}
+
+static int xcc_binlog_render_memory(xcc_binlog_cursor_t *c, size_t word_size, int out_fd)
+{
+    xcc_binlog_str_t label;
+    const uint8_t   *data;
+    size_t           data_len, data_idx, lines, j, i, k;
+    uint64_t         addr, start, total, current;
+    char             line[128];
+    size_t           line_len;
+    char             ascii[17];
+    size_t           ascii_idx;
+    int              r;
+
+    while(c->p < c->end)
+    {
+        xcc_binlog_get_str(c, &label);
+        addr = xcc_binlog_get_varint(c);
+        start = xcc_binlog_get_varint(c);
+        total = xcc_binlog_get_varint(c);
+        data = xcc_binlog_get_bytes(c, &data_len);
+        if(c->err) return XCC_ERRNO_FORMAT;
+
+        if(0 != (r = xcc_util_write_format(out_fd, "memory near %.*s:\n", label.len, label.str))) return r;
+
+        //16 bytes per line, only the readable words are saved in data
+        lines = data_len / 16;
+        data_idx = 0;
+        current = 0;
+        for(j = 0; j < lines; j++)
+        {
+            ascii_idx = 0;
+            line_len = (size_t)snprintf(line, sizeof(line), "    %0*"PRIx64, (int)(word_size * 2), addr);
+            addr += 16;
+
+            for(i = 0; i < 16 / word_size; i++)
+            {
+                if(current >= start && current + word_size <= total && data_idx + word_size <= data_len)
+                {
+                    line_len += (size_t)snprintf(line + line_len, sizeof(line) - line_len, " %0*"PRIx64,
+                                                 (int)(word_size * 2), xcc_binlog_get_word(data + data_idx, word_size));
+                    for(k = 0; k < word_size; k++)
+                        ascii[ascii_idx++] = ((data[data_idx + k] >= 0x20 && data[data_idx + k] < 0x7f) ? (char)data[data_idx + k] : '.');
+                    data_idx += word_size;
+                }
+                else
+                {
+                    line_len += (size_t)snprintf(line + line_len, sizeof(line) - line_len, " ");
+                    for(k = 0; k < word_size * 2; k++)
+                        line_len += (size_t)snprintf(line + line_len, sizeof(line) - line_len, "-");
+                    for(k = 0; k < word_size; k++)
+                        ascii[ascii_idx++] = '.';
+                }
+                current += word_size;
+            }
+            ascii[ascii_idx] = '\0';
+
+            if(0 != (r = xcc_util_write_format(out_fd, "%s  %s\n", line, ascii))) return r;
+        }
+
+        if(0 != (r = xcc_util_write_str(out_fd, "\n"))) return r;
+    }
+    return 0;
+}
+
+int xcc_binlog_render(int in_fd, int out_fd)
+{
+    uint8_t               head[XCC_BINLOG_SECTION_HEAD_LEN];
+    uint8_t              *payload = NULL;
+    uint32_t              len;
+    size_t                word_size, i;
+    int                   version;
+    char                  buf[1024];
+    ssize_t               n;
+    xcc_binlog_cursor_t   c;
+    xcc_binlog_entries_t  modules = {NULL, 0, 0}, funcs = {NULL, 0, 0};
+    int                   r;
+
+    if(0 != (r = xcc_binlog_read_header(in_fd, &word_size, &version))) return r;
+
+    //sections
+    while(1)
+    {
+        if(0 != xcc_binlog_read(in_fd, head, 2)) goto truncated; //incomplete, render as much as we can
+        if(XCC_BINLOG_MARK != head[0])
+        {
+            r = XCC_ERRNO_FORMAT;
+            goto end;
+        }
+        if(XCC_BINLOG_SECTION_END == head[1]) break;
+        if(0 != xcc_binlog_read(in_fd, head + 2, 4)) goto truncated;
+        if((len = xcc_binlog_get_u32(head + 2)) > XCC_BINLOG_PAYLOAD_MAX)
+        {
+            r = XCC_ERRNO_FORMAT;
+            goto end;
+        }
+
+        if(NULL == (payload = malloc(len > 0 ? len : 1)))
+        {
+            r = XCC_ERRNO_NOMEM;
+            goto end;
+        }
+        if(0 != xcc_binlog_read(in_fd, payload, len)) goto truncated;
+        c.p = payload;
+        c.end = payload + len;
+        c.err = 0;
+
+        switch(head[1])
+        {
+        case XCC_BINLOG_SECTION_TEXT:
+            r = xcc_util_write(out_fd, (const char *)payload, len);
+            break;
+        case XCC_BINLOG_SECTION_BACKTRACE:
+            r = xcc_binlog_render_backtrace(&c, word_size, version, &modules, &funcs, out_fd);
+            break;
+        case XCC_BINLOG_SECTION_BUILDID:
+            r = xcc_binlog_render_buildid(&c, out_fd);
+            break;
+        case XCC_BINLOG_SECTION_MEMORY:
+            r = xcc_binlog_render_memory(&c, word_size, out_fd);
+            break;
+        default:
+            //unknown sections from a newer writer are skipped
+            r = 0;
+            break;
+        }
+        free(payload);
+        payload = NULL;
+        if(0 != r) goto end;
+    }
+
+    //the text appended after the binary part, up to the placeholder padding
+    while((n = XCC_UTIL_TEMP_FAILURE_RETRY(read(in_fd, buf, sizeof(buf)))) > 0)
+    {
+        for(i = 0; i < (size_t)n; i++)
+            if('\0' == buf[i]) break;
+        if(0 != (r = xcc_util_write(out_fd, buf, i))) goto end;
+        if(i < (size_t)n) break;
+    }
+    r = 0;
+    goto end;
+
+ truncated:
+    if(0 == (r = xcc_util_write_str(out_fd, XCC_BINLOG_TRUNCATED_MARKER))) r = XCC_ERRNO_MISSING;
+
+ end:
+    if(NULL != payload) free(payload);
+    xcc_binlog_entries_clear(&modules);
+    xcc_binlog_entries_clear(&funcs);
+    if(NULL != modules.items) free(modules.items);
+    if(NULL != funcs.items) free(funcs.items);
+    return r;
+}
+
+#pragma clang diagnostic pop
@@ -0,0 +1,115 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Created by agent on 2026-10-17.
+
+#ifndef XCC_BINLOG_H
+#define XCC_BINLOG_H 1
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//binary tombstone:
+//  header:  "XCBL" version(u8) word_size(u8)
+//  section: 0xFF type(u8) length(u32, LE) payload
+//  end:     0xFF XCC_BINLOG_SECTION_END
+//anything appended after the end mark is plain text, and it's rendered as is.
+//the module and function tables are log-wide since version 2, every backtrace section
+//only lists the entries which are not in the previous sections.
+//all integers in the payloads are unsigned LEB128 varints,
+//strings and byte arrays are prefixed by a varint length.
+
+#define XCC_BINLOG_MAGIC            "XCBL"
+#define XCC_BINLOG_MAGIC_LEN        4
+#define XCC_BINLOG_VERSION          2
+#define XCC_BINLOG_VERSION_MIN      1
+#define XCC_BINLOG_HEADER_LEN       6
+#define XCC_BINLOG_MARK             0xFF
+#define XCC_BINLOG_SECTION_HEAD_LEN 6
+
+//payload: raw text
+#define XCC_BINLOG_SECTION_TEXT      1
+
+//payload: frames_num new_modules_num {name elf_start_offset}... new_funcs_num {name}...
+//         {module(0: unknown, N: modules[N-1]) rel_pc func(0: none, N: funcs[N-1]) func_offset}...
+//(version 1: the tables are reset by every backtrace section)
+#define XCC_BINLOG_SECTION_BACKTRACE 2
+
+//payload: {name build_id(bytes, empty: unknown) tail}...
+#define XCC_BINLOG_SECTION_BUILDID   3
+
+//payload: {label addr start total data(bytes)}...
+#define XCC_BINLOG_SECTION_MEMORY    4
+
+#define XCC_BINLOG_SECTION_END       0x7F
+
+//appended to the rendered text when the binary log ends in the middle (the dumper was killed or crashed)
+#define XCC_BINLOG_TRUNCATED_MARKER  "\n\nxcrash error:\nbinary log truncated\n\n"
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wpadded"
+typedef struct
+{
+    const void **keys;
+    size_t      *ids;
+    size_t       num;
+    size_t       cap;
+} xcc_binlog_table_t;
+
+typedef struct
+{
+    int                fd;
+    int                r;
+    off_t              section_offset;
+    size_t             len;
+    uint8_t            buf[1024];
+    xcc_binlog_table_t modules;
+    xcc_binlog_table_t funcs;
+} xcc_binlog_t;
+#pragma clang diagnostic pop
+
+//writer
+int xcc_binlog_write_header(int fd);
+int xcc_binlog_write_end(int fd);
+int xcc_binlog_section_begin(xcc_binlog_t *self, int fd, uint8_t type);
+void xcc_binlog_put_varint(xcc_binlog_t *self, uint64_t v);
+void xcc_binlog_put_bytes(xcc_binlog_t *self, const void *data, size_t len);
+void xcc_binlog_put_str(xcc_binlog_t *self, const char *str);
+int xcc_binlog_section_end(xcc_binlog_t *self);
+//log-wide interned tables (the writer must be zero-initialized),
+//returns the 1-based index, or 0 if out of memory. *added is set for a new entry.
+size_t xcc_binlog_intern_module(xcc_binlog_t *self, const void *map, int *added);
+size_t xcc_binlog_intern_func(xcc_binlog_t *self, const char *name, int *added);
+
+//reader
+int xcc_binlog_check(int fd, off_t *end, int *backtrace_found);
+//returns XCC_ERRNO_MISSING if the log is truncated, what has been rendered is kept
+int xcc_binlog_render(int in_fd, int out_fd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
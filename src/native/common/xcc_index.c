@@ -0,0 +1,221 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// Created by agent on 2026-10-17.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include "xcc_errno.h"
+#include "xcc_util.h"
+#include "xcc_index.h"
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wgnu-statement-expression"
+
+#define XCC_INDEX_STATUS_UNKNOWN 0
+#define XCC_INDEX_STATUS_HEAD    1
+#define XCC_INDEX_STATUS_SECTION 2
+#define XCC_INDEX_STATUS_THREADS 3
+
+#define XCC_INDEX_LINE_MAX    80
+#define XCC_INDEX_ENTRIES_MAX 4096
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wpadded"
+typedef struct
+{
+    uint8_t  *entries;
+    size_t    entries_cnt;
+    size_t    entries_cap;
+    int       status;
+    int       ignored; //the title is too long to be a key
+    uint8_t   key[XCC_INDEX_KEY_LEN];
+    uint32_t  begin;
+
+    //current line, only the beginning is kept
+    uint32_t  line_offset;
+    size_t    line_len;
+    char      line_last;
+    char      line[XCC_INDEX_LINE_MAX];
+} xcc_index_t;
+#pragma clang diagnostic pop
+
+static void xcc_index_put_u32(uint8_t *buf, uint32_t v)
+{
+    buf[0] = (uint8_t)v;
+    buf[1] = (uint8_t)(v >> 8);
+    buf[2] = (uint8_t)(v >> 16);
+    buf[3] = (uint8_t)(v >> 24);
+}
+
+static int xcc_index_line_equals(xcc_index_t *self, const char *str)
+{
+    size_t len = strlen(str) - 1; //without '\n'
+
+    return (self->line_len == len && 0 == memcmp(self->line, str, len)) ? 1 : 0;
+}
+
+static void xcc_index_begin(xcc_index_t *self, int status, const char *key, size_t key_len)
+{
+    self->status = status;
+    self->ignored = (key_len >= XCC_INDEX_KEY_LEN ? 1 : 0);
+    self->begin = self->line_offset;
+    memset(self->key, 0, sizeof(self->key));
+    if(!self->ignored) memcpy(self->key, key, key_len);
+}
+
+static int xcc_index_end(xcc_index_t *self, uint32_t end)
+{
+    uint8_t *entries;
+    uint8_t *entry;
+
+    self->status = XCC_INDEX_STATUS_UNKNOWN;
+    if(self->ignored) return 0;
+    if(self->entries_cnt >= XCC_INDEX_ENTRIES_MAX) return 0;
+
+    if(self->entries_cnt == self->entries_cap)
+    {
+        self->entries_cap = (0 == self->entries_cap ? 32 : self->entries_cap * 2);
+        if(NULL == (entries = realloc(self->entries, self->entries_cap * XCC_INDEX_ENTRY_LEN))) return XCC_ERRNO_NOMEM;
+        self->entries = entries;
+    }
+
+    entry = self->entries + self->entries_cnt * XCC_INDEX_ENTRY_LEN;
+    memcpy(entry, self->key, XCC_INDEX_KEY_LEN);
+    xcc_index_put_u32(entry + XCC_INDEX_KEY_LEN, self->begin);
+    xcc_index_put_u32(entry + XCC_INDEX_KEY_LEN + 4, end - self->begin);
+    self->entries_cnt++;
+    return 0;
+}
+
+//the same rules as parseFromReader() in "TombstoneParser.java"
+static int xcc_index_line(xcc_index_t *self, uint32_t end)
+{
+    switch(self->status)
+    {
+    case XCC_INDEX_STATUS_UNKNOWN:
+        if(xcc_index_line_equals(self, XCC_UTIL_TOMB_HEAD))
+            xcc_index_begin(self, XCC_INDEX_STATUS_HEAD, XCC_INDEX_KEY_HEAD, strlen(XCC_INDEX_KEY_HEAD));
+        else if(xcc_index_line_equals(self, XCC_UTIL_THREAD_SEP))
+            xcc_index_begin(self, XCC_INDEX_STATUS_THREADS, "other threads", strlen("other threads"));
+        else if(self->line_len > 1 && ':' == self->line_last)
+            xcc_index_begin(self, XCC_INDEX_STATUS_SECTION, self->line, self->line_len - 1);
+        return 0;
+    case XCC_INDEX_STATUS_HEAD:
+    case XCC_INDEX_STATUS_SECTION:
+        return (0 == self->line_len ? xcc_index_end(self, end) : 0);
+    case XCC_INDEX_STATUS_THREADS:
+        return (xcc_index_line_equals(self, XCC_UTIL_THREAD_END) ? xcc_index_end(self, end) : 0);
+    default:
+        return 0;
+    }
+}
+
+static int xcc_index_write(xcc_index_t *self, const char *log_pathname, uint32_t indexed_len)
+{
+    char     pathname[1024];
+    char     pathname_tmp[1024];
+    uint8_t  header[XCC_INDEX_HEADER_LEN];
+    int      fd;
+    int      r = 0;
+
+    snprintf(pathname, sizeof(pathname), "%s"XCC_INDEX_SUFFIX, log_pathname);
+    snprintf(pathname_tmp, sizeof(pathname_tmp), "%s.tmp", pathname);
+
+    memcpy(header, XCC_INDEX_MAGIC, 4);
+    xcc_index_put_u32(header + 4, XCC_INDEX_VERSION);
+    xcc_index_put_u32(header + 8, (uint32_t)self->entries_cnt);
+    xcc_index_put_u32(header + 12, indexed_len);
+
+    if(0 > (fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(pathname_tmp, O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644)))) return XCC_ERRNO_SYS;
+    if(0 != (r = xcc_util_write(fd, (const char *)header, sizeof(header)))) goto end;
+    if(self->entries_cnt > 0)
+        if(0 != (r = xcc_util_write(fd, (const char *)self->entries, self->entries_cnt * XCC_INDEX_ENTRY_LEN))) goto end;
+
+ end:
+    close(fd);
+    if(0 == r && 0 != rename(pathname_tmp, pathname)) r = XCC_ERRNO_SYS;
+    if(0 != r) unlink(pathname_tmp);
+    return r;
+}
+
+int xcc_index_build(const char *log_pathname)
+{
+    xcc_index_t self;
+    char        buf[4096];
+    ssize_t     len, i;
+    uint32_t    offset = 0;
+    int         fd;
+    int         done = 0;
+    int         r = 0;
+
+    memset(&self, 0, sizeof(self));
+
+    if(0 > (fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(log_pathname, O_RDONLY | O_CLOEXEC)))) return XCC_ERRNO_SYS;
+
+    while(!done && (len = XCC_UTIL_TEMP_FAILURE_RETRY(read(fd, buf, sizeof(buf)))) > 0)
+    {
+        for(i = 0; i < len; i++, offset++)
+        {
+            //the placeholder file is padded with zeros
+            if('\0' == buf[i])
+            {
+                done = 1;
+                break;
+            }
+
+            if('\n' == buf[i])
+            {
+                if(0 != (r = xcc_index_line(&self, offset + 1))) goto end;
+                self.line_offset = offset + 1;
+                self.line_len = 0;
+            }
+            else
+            {
+                if(self.line_len < XCC_INDEX_LINE_MAX) self.line[self.line_len] = buf[i];
+                self.line_last = buf[i];
+                self.line_len++;
+            }
+        }
+    }
+
+    //the last line without '\n', and the unfinished entry
+    if(self.line_len > 0)
+        if(0 != (r = xcc_index_line(&self, offset))) goto end;
+    if(XCC_INDEX_STATUS_UNKNOWN != self.status)
+        if(0 != (r = xcc_index_end(&self, offset))) goto end;
+
+    r = xcc_index_write(&self, log_pathname, offset);
+
+ end:
+    close(fd);
+    if(NULL != self.entries) free(self.entries);
+    return r;
+}
+
+#pragma clang diagnostic pop
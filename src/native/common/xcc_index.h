@@ -0,0 +1,55 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// Created by agent on 2026-10-17.
+
+#ifndef XCC_INDEX_H
+#define XCC_INDEX_H 1
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//section index of the text log file, saved next to the log file (see "TombstoneIndex.java"):
+//  header: "XCIX" version(u32, LE) count(u32, LE) indexed_len(u32, LE)
+//  entry:  key(char[48], NUL padded) offset(u32, LE) length(u32, LE)
+//the head of the log file is keyed by "head", the other sections by their titles (without ':').
+//offsets are in the plain text (before compressing), the content after indexed_len is not indexed.
+
+#define XCC_INDEX_SUFFIX     ".idx"
+#define XCC_INDEX_MAGIC      "XCIX"
+#define XCC_INDEX_VERSION    1
+#define XCC_INDEX_HEADER_LEN 16
+#define XCC_INDEX_KEY_LEN    48
+#define XCC_INDEX_ENTRY_LEN  (XCC_INDEX_KEY_LEN + 8)
+#define XCC_INDEX_KEY_HEAD   "head"
+
+int xcc_index_build(const char *log_pathname);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,142 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// Created by agent on 2026-10-17.
+
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "xcc_errno.h"
+#include "xcc_util.h"
+#include "xcc_fmt.h"
+#include "xcc_index.h"
+#include "xcc_manifest.h"
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wgnu-statement-expression"
+
+static const char *xcc_manifest_sidecar_suffixes[] = {XCC_INDEX_SUFFIX, XCC_UTIL_PROTO_SUFFIX, XCC_UTIL_MINIDUMP_SUFFIX};
+
+static uint64_t xcc_manifest_get_size(const char *log_pathname)
+{
+    struct stat st;
+    char        pathname[1024];
+    size_t      len, i;
+    uint64_t    size = 0;
+
+    if(0 == stat(log_pathname, &st)) size += (uint64_t)st.st_size;
+
+    //the sidecar files keep the plain name
+    len = strlen(log_pathname);
+    if(len > strlen(XCC_UTIL_XZ_SUFFIX) && 0 == strcmp(log_pathname + len - strlen(XCC_UTIL_XZ_SUFFIX), XCC_UTIL_XZ_SUFFIX))
+        len -= strlen(XCC_UTIL_XZ_SUFFIX);
+    else if(len > strlen(XCC_UTIL_XCDZ_SUFFIX) && 0 == strcmp(log_pathname + len - strlen(XCC_UTIL_XCDZ_SUFFIX), XCC_UTIL_XCDZ_SUFFIX))
+        len -= strlen(XCC_UTIL_XCDZ_SUFFIX);
+    if(len >= sizeof(pathname)) return size;
+    memcpy(pathname, log_pathname, len);
+    for(i = 0; i < sizeof(xcc_manifest_sidecar_suffixes) / sizeof(xcc_manifest_sidecar_suffixes[0]); i++)
+    {
+        strncpy(pathname + len, xcc_manifest_sidecar_suffixes[i], sizeof(pathname) - len - 1);
+        pathname[sizeof(pathname) - 1] = '\0';
+        if(0 == stat(pathname, &st)) size += (uint64_t)st.st_size;
+    }
+
+    return size;
+}
+
+static int xcc_manifest_append(const char *log_pathname, const char *record, size_t record_len)
+{
+    const char *name;
+    char        pathname[1024];
+    size_t      len;
+    int         fd;
+    ssize_t     n;
+
+    if(NULL == (name = strrchr(log_pathname, '/'))) return XCC_ERRNO_INVAL;
+    len = (size_t)(name - log_pathname) + 1;
+    if(len + strlen(XCC_MANIFEST_FILENAME) >= sizeof(pathname)) return XCC_ERRNO_NOSPACE;
+    memcpy(pathname, log_pathname, len);
+    strcpy(pathname + len, XCC_MANIFEST_FILENAME);
+
+    //one record by one write, the other writers may be appending at the same time
+    if(0 > (fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(pathname, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644)))) return XCC_ERRNO_SYS;
+    n = XCC_UTIL_TEMP_FAILURE_RETRY(write(fd, record, record_len));
+    close(fd);
+
+    return (n == (ssize_t)record_len ? 0 : XCC_ERRNO_SYS);
+}
+
+static const char *xcc_manifest_get_name(const char *log_pathname)
+{
+    const char *name = strrchr(log_pathname, '/');
+
+    return (NULL == name ? log_pathname : name + 1);
+}
+
+int xcc_manifest_add(const char *log_pathname, const char *type, uint64_t time, uint64_t signature)
+{
+    char   record[1280];
+    char   sig[20];
+    size_t len;
+
+    if(0 == signature)
+        strncpy(sig, "-", sizeof(sig));
+    else
+        xcc_fmt_snprintf(sig, sizeof(sig), "%016"PRIx64, signature);
+
+    len = xcc_fmt_snprintf(record, sizeof(record), "+ %s %"PRIu64" %"PRIu64" %s %s\n",
+                   type, time, xcc_manifest_get_size(log_pathname), sig, xcc_manifest_get_name(log_pathname));
+    if(len >= sizeof(record)) return XCC_ERRNO_NOSPACE;
+
+    return xcc_manifest_append(log_pathname, record, len);
+}
+
+int xcc_manifest_resize(const char *log_pathname)
+{
+    char   record[1280];
+    size_t len;
+
+    len = xcc_fmt_snprintf(record, sizeof(record), "s %"PRIu64" %s\n",
+                   xcc_manifest_get_size(log_pathname), xcc_manifest_get_name(log_pathname));
+    if(len >= sizeof(record)) return XCC_ERRNO_NOSPACE;
+
+    return xcc_manifest_append(log_pathname, record, len);
+}
+
+int xcc_manifest_remove(const char *log_pathname)
+{
+    char   record[1280];
+    size_t len;
+
+    len = xcc_fmt_snprintf(record, sizeof(record), "- %s\n", xcc_manifest_get_name(log_pathname));
+    if(len >= sizeof(record)) return XCC_ERRNO_NOSPACE;
+
+    return xcc_manifest_append(log_pathname, record, len);
+}
+
+#pragma clang diagnostic pop
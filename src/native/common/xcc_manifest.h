@@ -0,0 +1,54 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// Created by agent on 2026-10-17.
+
+#ifndef XCC_MANIFEST_H
+#define XCC_MANIFEST_H 1
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//manifest of the log files in the log directory, a journal appended by all the writers (see "TombstoneManifest.java"):
+//  "+ type time size signature name\n"  a new log file (time in microseconds, signature in hex or "-")
+//  "s size name\n"                      the size of the log file changed, or it has been compressed
+//  "u name\n"                           the log file has been uploaded
+//  "- name\n"                           the log file has been deleted
+//each record is written by one write() with O_APPEND, the entries are keyed by the name without the XZ suffix.
+//the size includes the sidecar files (the section index, the protobuf tombstone and the minidump).
+//the functions are async-signal-safe, the native crash handler adds the log file written without the dumper.
+
+#define XCC_MANIFEST_FILENAME "manifest.xcrash"
+
+int xcc_manifest_add(const char *log_pathname, const char *type, uint64_t time, uint64_t signature);
+int xcc_manifest_resize(const char *log_pathname);
+int xcc_manifest_remove(const char *log_pathname);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
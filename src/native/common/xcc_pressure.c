@@ -0,0 +1,323 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Created by agent on 2026-10-17.
+
+#include <stdint.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include "xcc_errno.h"
+#include "xcc_util.h"
+#include "xcc_fmt.h"
+#include "xcc_pressure.h"
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wgnu-statement-expression"
+
+#define XCC_PRESSURE_BUF_SIZE          (8 * 1024)
+#define XCC_PRESSURE_SOURCE_BUDGET_MS  50  //for each source
+#define XCC_PRESSURE_WAIT_MS           200 //for the collector, counted from recording
+#define XCC_PRESSURE_CPUS_MAX          64
+#define XCC_PRESSURE_THERMAL_ZONES_MAX 64
+
+#define XCC_PRESSURE_STATE_RUNNING   0
+#define XCC_PRESSURE_STATE_DONE      1
+#define XCC_PRESSURE_STATE_ABANDONED 2
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wpadded"
+struct xcc_pressure
+{
+    int    state;
+    size_t len;
+    char   buf[XCC_PRESSURE_BUF_SIZE];
+};
+#pragma clang diagnostic pop
+
+static uint64_t xcc_pressure_get_monotonic_ms(void)
+{
+    struct timespec ts;
+
+    if(0 != clock_gettime(CLOCK_MONOTONIC, &ts)) return 0;
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+//read a small procfs or sysfs file, without the trailing newlines
+static int xcc_pressure_read(const char *path, char *buf, size_t len)
+{
+    int     fd;
+    ssize_t n;
+
+    if((fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(path, O_RDONLY | O_CLOEXEC))) < 0)
+        return ENOENT == errno ? XCC_ERRNO_NOTFND : XCC_ERRNO_SYS;
+    n = XCC_UTIL_TEMP_FAILURE_RETRY(read(fd, buf, len - 1));
+    close(fd);
+    if(n <= 0) return XCC_ERRNO_SYS;
+
+    while(n > 0 && '\n' == buf[n - 1]) n--;
+    buf[n] = '\0';
+    return 0 == n ? XCC_ERRNO_MISSING : 0;
+}
+
+static void xcc_pressure_append(xcc_pressure_t *self, const char *format, ...)
+{
+    va_list ap;
+    size_t  n;
+
+    if(self->len >= sizeof(self->buf) - 1) return;
+
+    va_start(ap, format);
+    n = xcc_fmt_vsnprintf(self->buf + self->len, sizeof(self->buf) - self->len, format, ap);
+    va_end(ap);
+
+    self->len += n;
+    if(self->len > sizeof(self->buf) - 1) self->len = sizeof(self->buf) - 1;
+}
+
+//sub-sections are only kept when they got some content
+static size_t xcc_pressure_begin(xcc_pressure_t *self, const char *title)
+{
+    size_t mark = self->len;
+
+    xcc_pressure_append(self, "%s", title);
+    return mark;
+}
+
+static void xcc_pressure_end(xcc_pressure_t *self, size_t mark, size_t items)
+{
+    if(0 == items)
+    {
+        self->len = mark;
+        self->buf[self->len] = '\0';
+    }
+    else
+    {
+        xcc_pressure_append(self, "-\n");
+    }
+}
+
+static void xcc_pressure_collect_psi(xcc_pressure_t *self)
+{
+    const char *resources[] = {"cpu", "memory", "io"};
+    char        path[64];
+    char        buf[256];
+    char       *line, *next;
+    size_t      mark, items = 0, i;
+    uint64_t    start = xcc_pressure_get_monotonic_ms();
+
+    mark = xcc_pressure_begin(self, " Pressure Stall Information (From: /proc/pressure/*)\n");
+    for(i = 0; i < sizeof(resources) / sizeof(resources[0]); i++)
+    {
+        if(xcc_pressure_get_monotonic_ms() - start > XCC_PRESSURE_SOURCE_BUDGET_MS) break;
+
+        //"some avg10=0.00 avg60=0.00 avg300=0.00 total=0", and "full ..." except for cpu on older kernels
+        xcc_fmt_snprintf(path, sizeof(path), "/proc/pressure/%s", resources[i]);
+        if(0 != xcc_pressure_read(path, buf, sizeof(buf))) continue;
+        for(line = buf; NULL != line; line = next)
+        {
+            if(NULL != (next = strchr(line, '\n'))) *next++ = '\0';
+            if('\0' == *line) continue;
+            xcc_pressure_append(self, "  %-6s %s\n", resources[i], line);
+            items++;
+        }
+    }
+    xcc_pressure_end(self, mark, items);
+}
+
+static void xcc_pressure_collect_loadavg(xcc_pressure_t *self)
+{
+    char   buf[128];
+    size_t mark;
+
+    //"0.50 0.40 0.30 2/345 6789"
+    mark = xcc_pressure_begin(self, " Load Average (From: /proc/loadavg)\n");
+    if(0 == xcc_pressure_read("/proc/loadavg", buf, sizeof(buf)))
+    {
+        xcc_pressure_append(self, "  %s\n", buf);
+        xcc_pressure_end(self, mark, 1);
+    }
+    else
+    {
+        xcc_pressure_end(self, mark, 0);
+    }
+}
+
+static int xcc_pressure_read_freq(int cpu, const char *name, char *buf, size_t len)
+{
+    char path[128];
+
+    xcc_fmt_snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/%s", cpu, name);
+    return xcc_pressure_read(path, buf, len);
+}
+
+static void xcc_pressure_collect_cpufreq(xcc_pressure_t *self)
+{
+    char     related[128], cur[32], max[32], hw_max[32];
+    int      cpu, cpus;
+    size_t   mark, items = 0;
+    uint64_t start = xcc_pressure_get_monotonic_ms();
+
+    if((cpus = (int)sysconf(_SC_NPROCESSORS_CONF)) <= 0) return;
+    if(cpus > XCC_PRESSURE_CPUS_MAX) cpus = XCC_PRESSURE_CPUS_MAX;
+
+    mark = xcc_pressure_begin(self, " CPU Frequency (From: /sys/devices/system/cpu/cpuN/cpufreq)\n");
+    for(cpu = 0; cpu < cpus; cpu++)
+    {
+        if(xcc_pressure_get_monotonic_ms() - start > XCC_PRESSURE_SOURCE_BUDGET_MS)
+        {
+            if(items > 0) xcc_pressure_append(self, "  (time budget exceeded)\n");
+            break;
+        }
+
+        //one line for each cluster, the cpufreq dir is missing for offline cpus
+        if(0 != xcc_pressure_read_freq(cpu, "related_cpus", related, sizeof(related))) continue;
+        if(cpu != (int)strtol(related, NULL, 10)) continue;
+
+        if(0 != xcc_pressure_read_freq(cpu, "scaling_cur_freq", cur, sizeof(cur))) strncpy(cur, "-", sizeof(cur));
+        if(0 != xcc_pressure_read_freq(cpu, "scaling_max_freq", max, sizeof(max))) strncpy(max, "-", sizeof(max));
+        if(0 != xcc_pressure_read_freq(cpu, "cpuinfo_max_freq", hw_max, sizeof(hw_max))) strncpy(hw_max, "-", sizeof(hw_max));
+
+        //scaling_max_freq below cpuinfo_max_freq usually means thermal throttling
+        xcc_pressure_append(self, "  cpu %s: cur %s kHz, max %s kHz, hw max %s kHz%s\n", related, cur, max, hw_max,
+                            ('-' != max[0] && '-' != hw_max[0] && strtoul(max, NULL, 10) < strtoul(hw_max, NULL, 10)) ? " (capped)" : "");
+        items++;
+    }
+    xcc_pressure_end(self, mark, items);
+}
+
+static void xcc_pressure_collect_thermal(xcc_pressure_t *self)
+{
+    char     path[64], type[64], temp[32];
+    long     t;
+    int      zone, r;
+    size_t   mark, items = 0;
+    uint64_t start = xcc_pressure_get_monotonic_ms();
+
+    mark = xcc_pressure_begin(self, " Thermal Zones (From: /sys/class/thermal/thermal_zoneN)\n");
+    for(zone = 0; zone < XCC_PRESSURE_THERMAL_ZONES_MAX; zone++)
+    {
+        if(xcc_pressure_get_monotonic_ms() - start > XCC_PRESSURE_SOURCE_BUDGET_MS)
+        {
+            if(items > 0) xcc_pressure_append(self, "  (time budget exceeded)\n");
+            break;
+        }
+
+        //zones are numbered contiguously
+        xcc_fmt_snprintf(path, sizeof(path), "/sys/class/thermal/thermal_zone%d/type", zone);
+        if(0 != (r = xcc_pressure_read(path, type, sizeof(type))))
+        {
+            if(XCC_ERRNO_NOTFND == r) break;
+            continue;
+        }
+
+        //some sensors are not readable when they are powered down
+        xcc_fmt_snprintf(path, sizeof(path), "/sys/class/thermal/thermal_zone%d/temp", zone);
+        if(0 != xcc_pressure_read(path, temp, sizeof(temp))) continue;
+        t = strtol(temp, NULL, 10);
+
+        //millidegree Celsius, but a few vendors report degree Celsius
+        if(t >= 1000 || t <= -1000)
+            xcc_pressure_append(self, "  %-24s %s%ld.%ld C\n", type, t < 0 ? "-" : "", labs(t) / 1000, labs(t) % 1000 / 100);
+        else
+            xcc_pressure_append(self, "  %-24s %ld C\n", type, t);
+        items++;
+    }
+    xcc_pressure_end(self, mark, items);
+}
+
+static void *xcc_pressure_collector(void *arg)
+{
+    xcc_pressure_t *self = (xcc_pressure_t *)arg;
+    int             expected = XCC_PRESSURE_STATE_RUNNING;
+
+    pthread_detach(pthread_self());
+
+    xcc_pressure_collect_psi(self);
+    xcc_pressure_collect_loadavg(self);
+    xcc_pressure_collect_cpufreq(self);
+    xcc_pressure_collect_thermal(self);
+
+    //the owner has gone, we are the last user
+    if(!__atomic_compare_exchange_n(&(self->state), &expected, XCC_PRESSURE_STATE_DONE, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        free(self);
+
+    return NULL;
+}
+
+int xcc_pressure_create(xcc_pressure_t **self)
+{
+    pthread_t thd;
+
+    if(NULL == (*self = calloc(1, sizeof(xcc_pressure_t)))) return XCC_ERRNO_NOMEM;
+    (*self)->state = XCC_PRESSURE_STATE_RUNNING;
+
+    //collect in parallel with the unwinding
+    if(0 != pthread_create(&thd, NULL, xcc_pressure_collector, (void *)(*self)))
+    {
+        free(*self);
+        *self = NULL;
+        return XCC_ERRNO_SYS;
+    }
+
+    return 0;
+}
+
+void xcc_pressure_destroy(xcc_pressure_t **self)
+{
+    int expected = XCC_PRESSURE_STATE_RUNNING;
+
+    if(NULL == self || NULL == *self) return;
+
+    //the collector frees it when it's still running
+    if(!__atomic_compare_exchange_n(&((*self)->state), &expected, XCC_PRESSURE_STATE_ABANDONED, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        free(*self);
+
+    *self = NULL;
+}
+
+int xcc_pressure_record(xcc_pressure_t *self, int log_fd)
+{
+    int      r;
+    uint64_t deadline = xcc_pressure_get_monotonic_ms() + XCC_PRESSURE_WAIT_MS;
+
+    if(NULL == self) return 0;
+
+    //never block the dumping on a stuck sysfs node
+    while(XCC_PRESSURE_STATE_DONE != __atomic_load_n(&(self->state), __ATOMIC_ACQUIRE))
+    {
+        if(xcc_pressure_get_monotonic_ms() >= deadline) return 0;
+        usleep(1000);
+    }
+    if(0 == self->len) return 0;
+
+    if(0 != (r = xcc_util_write_str(log_fd, "system pressure:\n"))) return r;
+    if(0 != (r = xcc_util_write(log_fd, self->buf, self->len))) return r;
+    return xcc_util_write_str(log_fd, "\n");
+}
+
+#pragma clang diagnostic pop
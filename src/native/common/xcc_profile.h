@@ -0,0 +1,78 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Created by agent on 2026-10-17.
+
+#ifndef XCC_PROFILE_H
+#define XCC_PROFILE_H 1
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include <ucontext.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//raw samples in the profile log file, written by the sampler and folded by the dumper
+#define XCC_PROFILE_MAGIC        0x78637066 //"xcpf"
+#define XCC_PROFILE_STACK_SIZE   (16 * 1024)
+#define XCC_PROFILE_JAVA_SIZE    (2 * 1024)
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wpadded"
+
+typedef struct {
+    uint32_t     magic;
+    unsigned int frequency;
+    pid_t        pid;
+    pid_t        tid;
+    uint64_t     start_time;   //us, realtime
+    uint64_t     duration;     //us
+    uint64_t     samples;      //samples written to the log file
+    uint64_t     dropped;      //samples dropped because the buffer was full
+    uint64_t     skipped;      //ticks skipped because of the overhead budget
+    uint64_t     handler_time; //us, total time spent in the signal handler
+    uint64_t     java_time;    //us, total time spent getting the Java stacks (the main thread is paused meanwhile)
+    uint64_t     truncated;    //1 if the sampling stopped early because the log file reached its size limit
+} xcc_profile_header_t;
+
+typedef struct {
+    uint64_t     time;         //us, monotonic
+    ucontext_t   uc;
+    uintptr_t    stack_addr;
+    size_t       stack_len;
+    size_t       java_len;     //the Java stack follows the stack in the log file
+    uint8_t      stack[XCC_PROFILE_STACK_SIZE];
+    char         java[XCC_PROFILE_JAVA_SIZE]; //"class.method;class.method", outermost frame first
+} xcc_profile_sample_t;
+
+#pragma clang diagnostic pop
+
+//only the used part of the stack is written to the log file
+#define XCC_PROFILE_SAMPLE_HEAD_LEN offsetof(xcc_profile_sample_t, stack)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -243,3 +243,35 @@ void xcc_signal_trace_unregister(void) {
   pthread_sigmask(SIG_SETMASK, &xcc_signal_trace_oldset, NULL);
   sigaction(SIGQUIT, &xcc_signal_trace_oldact, NULL);
 }
+
+static struct sigaction xcc_signal_profile_oldact;
+
+int xcc_signal_profile_register(void (*handler) (int, siginfo_t*, void*)) {
+  struct sigaction act;
+
+  //register new signal handler for SIGPROF, SA_RESTART keeps the sampled thread's syscalls going
+  memset(&act, 0, sizeof(act));
+  sigfillset(&act.sa_mask);
+  act.sa_sigaction = handler;
+  act.sa_flags = SA_RESTART | SA_SIGINFO;
+  if (0 != sigaction(SIGPROF, &act, &xcc_signal_profile_oldact)) return XCC_ERRNO_SYS;
+
+  return 0;
+}
+
+void xcc_signal_profile_unregister(void) {
+  sigaction(SIGPROF, &xcc_signal_profile_oldact, NULL);
+}
+
+//hand a SIGPROF which is not ours (setitimer(ITIMER_PROF), other profilers) over to the previous action
+void xcc_signal_profile_chain(int sig, siginfo_t* si, void* uc) {
+  if (xcc_signal_profile_oldact.sa_flags & SA_SIGINFO) {
+    if (NULL != xcc_signal_profile_oldact.sa_sigaction) xcc_signal_profile_oldact.sa_sigaction(sig, si, uc);
+  } else if (SIG_DFL == xcc_signal_profile_oldact.sa_handler) {
+    //the default action terminates the process, as it would have done without us
+    sigaction(SIGPROF, &xcc_signal_profile_oldact, NULL);
+    syscall(SYS_rt_tgsigqueueinfo, getpid(), gettid(), sig, si);
+  } else if (SIG_IGN != xcc_signal_profile_oldact.sa_handler) {
+    xcc_signal_profile_oldact.sa_handler(sig);
+  }
+}
@@ -40,6 +40,10 @@ int xcc_signal_crash_queue(siginfo_t* si);
 int xcc_signal_trace_register(void (*handler)(int, siginfo_t*, void*));
 void xcc_signal_trace_unregister();
 
+int xcc_signal_profile_register(void (*handler)(int, siginfo_t*, void*));
+void xcc_signal_profile_unregister();
+void xcc_signal_profile_chain(int sig, siginfo_t* si, void* uc);
+
 #ifdef __cplusplus
 }
 #endif
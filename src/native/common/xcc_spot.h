@@ -43,6 +43,15 @@ typedef struct {
     ucontext_t   ucontext;
     uint64_t     crash_time;
 
+    //set when dumping live threads on demand (no crash)
+    int          snapshot;
+
+    //set when folding the main thread profile samples in the log file
+    int          profile;
+
+    //set when the crash dumper waits to compress the finished log file (on its stdout)
+    int          compress;
+
     //set when inited
     int          api_level;
     pid_t        crash_pid;
@@ -52,11 +61,14 @@ typedef struct {
     unsigned int logcat_events_lines;
     unsigned int logcat_main_lines;
     int          dump_elf_hash;
-    int          dump_map;
+    int          dump_map; //XCC_UTIL_DUMP_MAP_*
     int          dump_fds;
     int          dump_network_info;
     int          dump_all_threads;
     unsigned int dump_all_threads_count_max;
+    int          dump_binary;
+    int          dump_proto;
+    int          dump_minidump;
 
     //set when crashed (content lenghts after this struct)
     size_t       log_pathname_len;
@@ -71,6 +83,8 @@ typedef struct {
     size_t       build_fingerprint_len;
     size_t       app_id_len;
     size_t       app_version_len;
+    size_t       compress_dict_pathname_len;
+    size_t       maps_baseline_pathname_len;
     size_t       dump_all_threads_whitelist_len;
 } xcc_spot_t;
 
@@ -0,0 +1,363 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Created by agent on 2026-10-17.
+
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/syscall.h>
+#include "xcc_errno.h"
+#include "xcc_util.h"
+#include "xcc_fmt.h"
+#include "xcc_threadstat.h"
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wgnu-statement-expression"
+#pragma clang diagnostic ignored "-Wcast-align"
+
+#define XCC_THREADSTAT_THREADS_MAX 4096
+#define XCC_THREADSTAT_STAT_FIELD_UTIME     14
+#define XCC_THREADSTAT_STAT_FIELD_STIME     15
+#define XCC_THREADSTAT_STAT_FIELD_NICE      19
+#define XCC_THREADSTAT_STAT_FIELD_PROCESSOR 39
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wpadded"
+typedef struct
+{
+    int      valid;
+    char     name[16];
+    char     state;
+    long     nice;
+    long     processor;
+    uint64_t utime;  //clock ticks
+    uint64_t stime;  //clock ticks
+    int      has_schedstat;
+    uint64_t run_ns;
+    uint64_t wait_ns;
+    uint64_t nvcsw;
+    uint64_t nivcsw;
+} xcc_threadstat_t;
+
+typedef struct
+{
+    size_t   idx;
+    uint64_t cpu; //ns
+} xcc_threadstat_rank_t;
+#pragma clang diagnostic pop
+
+static int xcc_threadstat_read(const char *path, char *buf, size_t len)
+{
+    int     fd;
+    ssize_t n;
+
+    if((fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(path, O_RDONLY | O_CLOEXEC))) < 0) return XCC_ERRNO_SYS;
+    n = XCC_UTIL_TEMP_FAILURE_RETRY(read(fd, buf, len - 1));
+    close(fd);
+    if(n <= 0) return XCC_ERRNO_MISSING;
+
+    buf[n] = '\0';
+    return 0;
+}
+
+static const char *xcc_threadstat_skip_field(const char *p)
+{
+    while(' ' == *p) p++;
+    while('\0' != *p && ' ' != *p && '\n' != *p) p++;
+    return p;
+}
+
+static const char *xcc_threadstat_parse_u64(const char *p, uint64_t *v)
+{
+    *v = 0;
+    while(' ' == *p) p++;
+    while(*p >= '0' && *p <= '9') *v = *v * 10 + (uint64_t)(*p++ - '0');
+    return xcc_threadstat_skip_field(p);
+}
+
+static const char *xcc_threadstat_parse_long(const char *p, long *v)
+{
+    int neg = 0;
+
+    *v = 0;
+    while(' ' == *p) p++;
+    if('-' == *p)
+    {
+        neg = 1;
+        p++;
+    }
+    while(*p >= '0' && *p <= '9') *v = *v * 10 + (long)(*p++ - '0');
+    if(neg) *v = -(*v);
+    return xcc_threadstat_skip_field(p);
+}
+
+// "tid (comm) state ppid ... utime stime ... nice ... processor ..."
+static int xcc_threadstat_parse_stat(const char *buf, xcc_threadstat_t *st)
+{
+    const char *name_start, *name_end, *p;
+    size_t      name_len;
+    int         field;
+
+    //the comm may contain spaces and parentheses
+    if(NULL == (name_start = strchr(buf, '('))) return XCC_ERRNO_FORMAT;
+    if(NULL == (name_end = strrchr(buf, ')'))) return XCC_ERRNO_FORMAT;
+    if(name_end < name_start) return XCC_ERRNO_FORMAT;
+    name_len = (size_t)(name_end - name_start - 1);
+    if(name_len > sizeof(st->name) - 1) name_len = sizeof(st->name) - 1;
+    memcpy(st->name, name_start + 1, name_len);
+    st->name[name_len] = '\0';
+
+    p = name_end + 1;
+    while(' ' == *p) p++;
+    if('\0' == *p) return XCC_ERRNO_FORMAT;
+    st->state = *p++;
+
+    for(field = 4; field <= XCC_THREADSTAT_STAT_FIELD_PROCESSOR; field++)
+    {
+        if('\0' == *p || '\n' == *p) return XCC_ERRNO_FORMAT;
+
+        switch(field)
+        {
+        case XCC_THREADSTAT_STAT_FIELD_UTIME:
+            p = xcc_threadstat_parse_u64(p, &(st->utime));
+            break;
+        case XCC_THREADSTAT_STAT_FIELD_STIME:
+            p = xcc_threadstat_parse_u64(p, &(st->stime));
+            break;
+        case XCC_THREADSTAT_STAT_FIELD_NICE:
+            p = xcc_threadstat_parse_long(p, &(st->nice));
+            break;
+        case XCC_THREADSTAT_STAT_FIELD_PROCESSOR:
+            p = xcc_threadstat_parse_long(p, &(st->processor));
+            break;
+        default:
+            p = xcc_threadstat_skip_field(p);
+            break;
+        }
+    }
+
+    return 0;
+}
+
+static void xcc_threadstat_parse_status_item(const char *buf, const char *key, uint64_t *v)
+{
+    const char *p;
+
+    *v = 0;
+    if(NULL == (p = strstr(buf, key))) return;
+    p += strlen(key);
+    while('\t' == *p) p++;
+    xcc_threadstat_parse_u64(p, v);
+}
+
+static void xcc_threadstat_load(pid_t pid, pid_t tid, char *buf, size_t buf_len, xcc_threadstat_t *st)
+{
+    char path[64];
+
+    memset(st, 0, sizeof(xcc_threadstat_t));
+
+    //state, nice, processor, utime, stime
+    xcc_fmt_snprintf(path, sizeof(path), "/proc/%d/task/%d/stat", pid, tid);
+    if(0 != xcc_threadstat_read(path, buf, buf_len)) return;
+    if(0 != xcc_threadstat_parse_stat(buf, st)) return;
+    st->valid = 1;
+
+    //time on the cpu and waiting on a runqueue (only with CONFIG_SCHEDSTATS)
+    xcc_fmt_snprintf(path, sizeof(path), "/proc/%d/task/%d/schedstat", pid, tid);
+    if(0 == xcc_threadstat_read(path, buf, buf_len))
+    {
+        xcc_threadstat_parse_u64(xcc_threadstat_parse_u64(buf, &(st->run_ns)), &(st->wait_ns));
+        st->has_schedstat = 1;
+    }
+
+    //context switches
+    xcc_fmt_snprintf(path, sizeof(path), "/proc/%d/task/%d/status", pid, tid);
+    if(0 == xcc_threadstat_read(path, buf, buf_len))
+    {
+        xcc_threadstat_parse_status_item(buf, "\nvoluntary_ctxt_switches:", &(st->nvcsw));
+        xcc_threadstat_parse_status_item(buf, "\nnonvoluntary_ctxt_switches:", &(st->nivcsw));
+    }
+}
+
+static size_t xcc_threadstat_list_tids(pid_t pid, pid_t **tids)
+{
+    char               path[64];
+    char               buf[512];
+    int                fd;
+    long               n, i;
+    int                tid;
+    size_t             cnt = 0, cap = 0;
+    pid_t             *tmp;
+    xcc_util_dirent_t *ent;
+
+    *tids = NULL;
+
+    xcc_fmt_snprintf(path, sizeof(path), "/proc/%d/task", pid);
+    if((fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC))) < 0) return 0;
+
+    while((n = syscall(XCC_UTIL_SYSCALL_GETDENTS, fd, buf, sizeof(buf))) > 0)
+    {
+        for(i = 0; i < n; i += ent->d_reclen)
+        {
+            ent = (xcc_util_dirent_t *)(buf + i);
+            if(0 != xcc_util_atoi(ent->d_name, &tid) || tid <= 0) continue;
+            if(cnt >= XCC_THREADSTAT_THREADS_MAX) goto end;
+
+            if(cnt == cap)
+            {
+                cap = (0 == cap ? 64 : cap * 2);
+                if(NULL == (tmp = realloc(*tids, cap * sizeof(pid_t)))) goto end;
+                *tids = tmp;
+            }
+            (*tids)[cnt++] = tid;
+        }
+    }
+
+ end:
+    close(fd);
+    return cnt;
+}
+
+static int xcc_threadstat_rank_cmp(const void *a, const void *b)
+{
+    uint64_t cpu_a = ((const xcc_threadstat_rank_t *)a)->cpu;
+    uint64_t cpu_b = ((const xcc_threadstat_rank_t *)b)->cpu;
+
+    if(cpu_a == cpu_b) return 0;
+    return cpu_a > cpu_b ? -1 : 1;
+}
+
+#define XCC_THREADSTAT_DELTA(field) (NULL == first ? second->field : (second->field > first->field ? second->field - first->field : 0))
+
+int xcc_threadstat_record(int log_fd, pid_t pid, unsigned int interval_ms, size_t top_n)
+{
+    pid_t                 *tids = NULL;
+    size_t                 tids_cnt, ranks_cnt = 0, i;
+    xcc_threadstat_t      *stats1 = NULL, *stats2 = NULL;
+    xcc_threadstat_t      *first, *second;
+    xcc_threadstat_rank_t *ranks = NULL;
+    char                   buf[2048];
+    struct timespec        ts;
+    long                   ticks_per_sec;
+    uint64_t               utime_ms, stime_ms;
+    int                    r = 0;
+
+    if(0 == (tids_cnt = xcc_threadstat_list_tids(pid, &tids))) return 0;
+    if(0 == (ticks_per_sec = sysconf(_SC_CLK_TCK))) ticks_per_sec = 100;
+
+    if(NULL == (stats1 = calloc(tids_cnt, sizeof(xcc_threadstat_t)))) goto end;
+    if(NULL == (ranks = calloc(tids_cnt, sizeof(xcc_threadstat_rank_t)))) goto end;
+
+    //first sample
+    for(i = 0; i < tids_cnt; i++)
+        xcc_threadstat_load(pid, tids[i], buf, sizeof(buf), &(stats1[i]));
+
+    //second sample of the same threads after the interval
+    if(interval_ms > 0)
+    {
+        if(NULL == (stats2 = calloc(tids_cnt, sizeof(xcc_threadstat_t)))) goto end;
+
+        ts.tv_sec = (time_t)(interval_ms / 1000);
+        ts.tv_nsec = (long)(interval_ms % 1000) * 1000 * 1000;
+        while(0 != nanosleep(&ts, &ts) && EINTR == errno);
+
+        for(i = 0; i < tids_cnt; i++)
+            xcc_threadstat_load(pid, tids[i], buf, sizeof(buf), &(stats2[i]));
+    }
+
+    //rank by cpu time (delta within the interval, or the total without an interval),
+    //the run time from schedstat is in ns, the utime and stime ticks are too coarse for a short interval
+    for(i = 0; i < tids_cnt; i++)
+    {
+        first = (NULL == stats2 ? NULL : &(stats1[i]));
+        second = (NULL == stats2 ? &(stats1[i]) : &(stats2[i]));
+        if(!second->valid || (NULL != first && !first->valid)) continue;
+
+        ranks[ranks_cnt].idx = i;
+        if(second->has_schedstat && (NULL == first || first->has_schedstat))
+            ranks[ranks_cnt].cpu = XCC_THREADSTAT_DELTA(run_ns);
+        else
+            ranks[ranks_cnt].cpu = (XCC_THREADSTAT_DELTA(utime) + XCC_THREADSTAT_DELTA(stime)) * 1000000000 / (uint64_t)ticks_per_sec;
+        ranks_cnt++;
+    }
+    qsort(ranks, ranks_cnt, sizeof(xcc_threadstat_rank_t), xcc_threadstat_rank_cmp);
+    if(0 == top_n || top_n > ranks_cnt) top_n = ranks_cnt;
+
+    //dump
+    if(0 != (r = xcc_util_write_str(log_fd, "threads cpu:\n"))) goto end;
+    if(NULL != stats2)
+    {
+        if(0 != (r = xcc_util_write_format(log_fd, "    top %zu of %zu threads by cpu time within %u ms\n",
+                                           top_n, ranks_cnt, interval_ms))) goto end;
+    }
+    else
+    {
+        if(0 != (r = xcc_util_write_format(log_fd, "    top %zu of %zu threads by cpu time since started\n",
+                                           top_n, ranks_cnt))) goto end;
+    }
+    if(0 != (r = xcc_util_write_format(log_fd, "    %8s %-15s %s %4s %3s %6s %8s %8s %8s %8s %8s %8s\n",
+                                       "tid", "name", "s", "nice", "cpu", "%cpu", "utime", "stime",
+                                       "run", "wait", "vcsw", "nvcsw"))) goto end;
+    for(i = 0; i < top_n; i++)
+    {
+        first = (NULL == stats2 ? NULL : &(stats1[ranks[i].idx]));
+        second = (NULL == stats2 ? &(stats1[ranks[i].idx]) : &(stats2[ranks[i].idx]));
+
+        utime_ms = XCC_THREADSTAT_DELTA(utime) * 1000 / (uint64_t)ticks_per_sec;
+        stime_ms = XCC_THREADSTAT_DELTA(stime) * 1000 / (uint64_t)ticks_per_sec;
+
+        if(0 != (r = xcc_util_write_format(log_fd, "    %8d %-15s %c %4ld %3ld ", tids[ranks[i].idx],
+                                           second->name, second->state, second->nice, second->processor))) goto end;
+        if(NULL != stats2)
+            r = xcc_util_write_format(log_fd, "%4"PRIu64".%"PRIu64" ",
+                                      ranks[i].cpu / 10000 / interval_ms,
+                                      ranks[i].cpu / 1000 / interval_ms % 10);
+        else
+            r = xcc_util_write_format(log_fd, "%6s ", "-");
+        if(0 != r) goto end;
+        if(0 != (r = xcc_util_write_format(log_fd, "%6"PRIu64"ms %6"PRIu64"ms ", utime_ms, stime_ms))) goto end;
+        if(second->has_schedstat)
+            r = xcc_util_write_format(log_fd, "%6"PRIu64"ms %6"PRIu64"ms ",
+                                      XCC_THREADSTAT_DELTA(run_ns) / 1000000, XCC_THREADSTAT_DELTA(wait_ns) / 1000000);
+        else
+            r = xcc_util_write_format(log_fd, "%8s %8s ", "-", "-");
+        if(0 != r) goto end;
+        if(0 != (r = xcc_util_write_format(log_fd, "%8"PRIu64" %8"PRIu64"\n",
+                                           XCC_THREADSTAT_DELTA(nvcsw), XCC_THREADSTAT_DELTA(nivcsw)))) goto end;
+    }
+    r = xcc_util_write_str(log_fd, "\n");
+
+ end:
+    if(NULL != tids) free(tids);
+    if(NULL != stats1) free(stats1);
+    if(NULL != stats2) free(stats2);
+    if(NULL != ranks) free(ranks);
+    return r;
+}
+
+#pragma clang diagnostic pop
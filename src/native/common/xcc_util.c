@@ -47,8 +47,6 @@
 #pragma clang diagnostic ignored "-Wcast-align"
 #pragma clang diagnostic ignored "-Wformat-nonliteral"
 
-#define XCC_UTIL_TIME_FORMAT "%04d-%02d-%02dT%02d:%02d:%02d.%03ld%c%02ld%02ld"
-
 const char* xcc_util_get_signame(const siginfo_t* si)
 {
     switch (si->si_signo)
@@ -483,6 +481,19 @@ int xcc_util_is_root(void)
     return 0;
 }
 
+uint64_t xcc_util_fnv1a(uint64_t hash, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    size_t         i;
+
+    for(i = 0; i < len; i++)
+    {
+        hash ^= p[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
 size_t xcc_util_get_dump_header(char *buf,
                                 size_t buf_len,
                                 const char *crash_type,
@@ -551,16 +562,11 @@ size_t xcc_util_get_dump_header(char *buf,
                             build_fingerprint);
 }
 
-static int xcc_util_record_logcat_buffer(int fd, pid_t pid, int api_level,
-                                         const char *buffer, unsigned int lines, char priority)
+int xcc_util_get_logcat_cmd(char *cmd, size_t cmd_len, pid_t pid, int api_level,
+                            const char *buffer, unsigned int lines, char priority)
 {
-    FILE *fp;
-    char  cmd[128];
-    char  buf[1025];
-    int   with_pid;
-    char  pid_filter[64] = "";
-    char  pid_label[32] = "";
-    int   r = 0;
+    int  with_pid;
+    char pid_filter[64] = "";
 
     //Since Android 7.0 Nougat (API level 24), logcat has --pid filter option.
     with_pid = (api_level >= 24 ? 1 : 0);
@@ -574,12 +580,27 @@ static int xcc_util_record_logcat_buffer(int fd, pid_t pid, int api_level,
     {
         //API level < 24, filtered by ourself, so we need to read more lines
         lines = (unsigned int)(lines * 1.2);
-        xcc_fmt_snprintf(pid_label, sizeof(pid_label), " %d ", pid);
     }
     
-    xcc_fmt_snprintf(cmd, sizeof(cmd), "/system/bin/logcat -b %s -d -v threadtime -t %u %s*:%c",
+    xcc_fmt_snprintf(cmd, cmd_len, "/system/bin/logcat -b %s -d -v threadtime -t %u %s*:%c",
                      buffer, lines, pid_filter, priority);
 
+    return with_pid;
+}
+
+static int xcc_util_record_logcat_buffer(int fd, pid_t pid, int api_level,
+                                         const char *buffer, unsigned int lines, char priority)
+{
+    FILE *fp;
+    char  cmd[128];
+    char  buf[1025];
+    int   with_pid;
+    char  pid_label[32] = "";
+    int   r = 0;
+
+    with_pid = xcc_util_get_logcat_cmd(cmd, sizeof(cmd), pid, api_level, buffer, lines, priority);
+    if(!with_pid) xcc_fmt_snprintf(pid_label, sizeof(pid_label), " %d ", pid);
+
     if(0 != (r = xcc_util_write_format_safe(fd, "--------- tail end of log %s (%s)\n", buffer, cmd))) return r;
 
     if(NULL != (fp = popen(cmd, "r")))
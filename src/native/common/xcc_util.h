@@ -42,6 +42,42 @@ extern "C" {
 
 #define XCC_UTIL_CRASH_TYPE_NATIVE "native"
 #define XCC_UTIL_CRASH_TYPE_ANR    "anr"
+#define XCC_UTIL_CRASH_TYPE_TRACE  "trace"
+#define XCC_UTIL_CRASH_TYPE_SNAPSHOT "snapshot"
+#define XCC_UTIL_CRASH_TYPE_PROFILE "profile"
+
+//the protobuf tombstone is saved next to the native crash log file, named by appending this suffix
+#define XCC_UTIL_PROTO_SUFFIX ".pb"
+
+//the minidump is saved next to the native crash log file too
+#define XCC_UTIL_MINIDUMP_SUFFIX ".dmp"
+
+//the compressed native crash log file is named by appending this suffix (the sidecar files keep the plain name)
+#define XCC_UTIL_XZ_SUFFIX ".xz"
+
+//the native crash log file compressed with the preset dictionary is not an XZ file (see "xcd_util_xz_compress_dict()"),
+//it's named by appending this suffix instead, "src/tools/xcrash_unxz.py" decompresses both of them
+#define XCC_UTIL_XCDZ_SUFFIX ".xcdz"
+
+//the preset dictionary for compressing the native crash log file is built from the recent ones (see "TombstoneDict.java")
+#define XCC_UTIL_XZ_DICT_SIZE_MAX (64 * 1024)
+
+//the levels of recording the memory map of the native crash
+#define XCC_UTIL_DUMP_MAP_NONE    0
+#define XCC_UTIL_DUMP_MAP_FULL    1
+#define XCC_UTIL_DUMP_MAP_SUMMARY 2
+
+//the maps of the process saved when inited, the dumper only records the difference from it (see "TombstoneMaps.java")
+#define XCC_UTIL_MAPS_BASELINE_PREFIX "maps_baseline_"
+#define XCC_UTIL_MAPS_BASELINE_SUFFIX ".maps.xcrash"
+
+//the counters of the native crash signatures (see "xcd_signature.h" and "TombstoneSignature.java")
+#define XCC_UTIL_SIGNATURE_STORE_FILENAME "signatures.xcrash"
+
+//FNV-1a 64-bit hash
+#define XCC_UTIL_FNV1A_INIT 0xcbf29ce484222325ULL
+
+#define XCC_UTIL_TIME_FORMAT "%04d-%02d-%02dT%02d:%02d:%02d.%03ld%c%02ld%02ld"
 
 #if defined(__arm__)
 #define XCC_UTIL_ABI_STRING "arm"
@@ -161,6 +197,8 @@ int xcc_util_record_sub_section_from(int log_fd, const char *path, const char *t
 
 int xcc_util_is_root(void);
 
+uint64_t xcc_util_fnv1a(uint64_t hash, const void *data, size_t len);
+
 size_t xcc_util_get_dump_header(char *buf,
                                 size_t buf_len,
                                 const char *crash_type,
@@ -178,6 +216,8 @@ size_t xcc_util_get_dump_header(char *buf,
                                 const char *model,
                                 const char *build_fingerprint);
 
+int xcc_util_get_logcat_cmd(char *cmd, size_t cmd_len, pid_t pid, int api_level,
+                            const char *buffer, unsigned int lines, char priority);
 int xcc_util_record_logcat(int fd,
                            pid_t pid,
                            int api_level,
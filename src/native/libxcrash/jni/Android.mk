@@ -12,14 +12,18 @@ LOCAL_MODULE           := xcrash
 LOCAL_CFLAGS           := -std=c11 -Weverything -Werror -fvisibility=hidden -Oz -flto
 LOCAL_LDFLAGS          := -flto
 LOCAL_LDLIBS           := -ldl -llog
-LOCAL_STATIC_LIBRARIES := test
+LOCAL_STATIC_LIBRARIES := test lzma
 LOCAL_C_INCLUDES       := $(LOCAL_PATH) $(LOCAL_PATH)/../../common  $(LOCAL_PATH)/../../libxcrash_dumper/jni
 LOCAL_SRC_FILES        := xc_jni.c      \
                           xc_common.c   \
                           xc_crash.c    \
                           xc_trace.c    \
+                          xc_profile.c  \
+                          xc_archive.c  \
+                          xc_xz.c       \
                           xc_dl.c       \
                           xc_fallback.c \
                           xc_util.c     \
                           $(wildcard $(LOCAL_PATH)/../../common/*.c)
 include $(BUILD_SHARED_LIBRARY)
+include $(LOCAL_PATH)/../../libxcrash_dumper/jni/lzma/Android.mk
@@ -0,0 +1,516 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// Created by agent on 2026-10-17.
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wreserved-id-macro"
+#define _GNU_SOURCE
+#pragma clang diagnostic pop
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "xcc_errno.h"
+#include "xcc_util.h"
+#include "xc_archive.h"
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wreserved-id-macro"
+#pragma clang diagnostic ignored "-Wpadded"
+#include "7zCrc.h"
+#include "XzCrc64.h"
+#include "XzEnc.h"
+#pragma clang diagnostic pop
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wgnu-statement-expression"
+
+#define XC_ARCHIVE_THREADS_MAX          8
+#define XC_ARCHIVE_MEMORY_LIMIT_DEFAULT (64 * 1024 * 1024)
+
+//the encoder (level 5, bt4 match finder) takes about 12 times of the dictionary size
+#define XC_ARCHIVE_MEMORY_PER_DICT      12
+#define XC_ARCHIVE_DICT_SIZE_MIN        (1 << 16)
+#define XC_ARCHIVE_DICT_SIZE_MAX        (1 << 23)
+
+#define XC_ARCHIVE_PROGRESS_INTERVAL_MS 100
+
+//ustar
+#define XC_ARCHIVE_TAR_BLOCK            512
+#define XC_ARCHIVE_TAR_NAME_LEN         100
+#define XC_ARCHIVE_TAR_LONG_NAME        "././@LongLink"
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wpadded"
+typedef struct {
+    const char *name;
+    int         fd;
+    size_t      size;
+} xc_archive_file_t;
+
+struct xc_archive_job;
+
+typedef struct {
+    ISeqInStream           in;
+    ISeqOutStream          out;
+    ICompressProgress      progress;
+    struct xc_archive_job *job;
+    pthread_t              thd;
+    size_t                 file_begin;
+    size_t                 file_end;
+    int                    fd;
+    int                    r;
+    uint64_t               total_size;
+    uint64_t               processed_size; //updated by the worker, read by the caller
+
+    //tar stream
+    size_t                 file_idx;
+    uint8_t                header[XC_ARCHIVE_TAR_BLOCK * 3];
+    size_t                 header_len;
+    uint8_t               *data;
+    size_t                 pos;
+    size_t                 pad_len;
+    size_t                 end_len;
+    int                    opened;
+} xc_archive_worker_t;
+
+typedef struct xc_archive_job {
+    xc_archive_file_t   *files;
+    xc_archive_worker_t *workers;
+    size_t               workers_len;
+    uint32_t             dict_size;
+    int                  cancelled;
+    size_t               finished;
+    pthread_mutex_t      lock;
+    pthread_cond_t       cond;
+} xc_archive_job_t;
+#pragma clang diagnostic pop
+
+static uint64_t xc_archive_tar_size(xc_archive_file_t *file) {
+    size_t header_len = XC_ARCHIVE_TAR_BLOCK * (strlen(file->name) >= XC_ARCHIVE_TAR_NAME_LEN ? 3 : 1);
+
+    return header_len + ((uint64_t)file->size + XC_ARCHIVE_TAR_BLOCK - 1) / XC_ARCHIVE_TAR_BLOCK * XC_ARCHIVE_TAR_BLOCK;
+}
+
+static pthread_once_t xc_archive_crc_once = PTHREAD_ONCE_INIT;
+
+static void xc_archive_crc_init(void) {
+    CrcGenerateTable();
+    Crc64GenerateTable();
+}
+
+static void *xc_archive_alloc(ISzAllocPtr p, size_t size) {
+    (void)p;
+    return malloc(size);
+}
+
+static void xc_archive_free(ISzAllocPtr p, void *address) {
+    (void)p;
+    free(address);
+}
+
+static void xc_archive_tar_octal(uint8_t *field, size_t field_len, uint64_t value) {
+    //digits with a terminating NUL
+    field[--field_len] = '\0';
+    while (field_len > 0) {
+        field[--field_len] = (uint8_t)('0' + (value & 7));
+        value >>= 3;
+    }
+}
+
+static void xc_archive_tar_header(uint8_t *header, const char *name, size_t name_len, uint64_t size, char type) {
+    unsigned int sum = 0;
+    size_t       i;
+
+    memset(header, 0, XC_ARCHIVE_TAR_BLOCK);
+    memcpy(header, name, name_len < XC_ARCHIVE_TAR_NAME_LEN ? name_len : XC_ARCHIVE_TAR_NAME_LEN - 1);
+    xc_archive_tar_octal(header + 100, 8, 0644);
+    xc_archive_tar_octal(header + 108, 8, 0);
+    xc_archive_tar_octal(header + 116, 8, 0);
+    xc_archive_tar_octal(header + 124, 12, size);
+    xc_archive_tar_octal(header + 136, 12, (uint64_t)time(NULL));
+    memset(header + 148, ' ', 8);
+    header[156] = (uint8_t)type;
+    memcpy(header + 257, "ustar", 6);
+    memcpy(header + 263, "00", 2);
+
+    for (i = 0; i < XC_ARCHIVE_TAR_BLOCK; i++) sum += header[i];
+    xc_archive_tar_octal(header + 148, 7, sum);
+}
+
+static int xc_archive_open_next(xc_archive_worker_t *self) {
+    xc_archive_file_t *file = &(self->job->files[self->file_idx]);
+    size_t             name_len = strlen(file->name);
+    size_t             long_len;
+
+    //the name longer than the ustar field is saved in a GNU long name entry
+    self->header_len = 0;
+    if (name_len >= XC_ARCHIVE_TAR_NAME_LEN) {
+        long_len = (name_len + 1 < XC_ARCHIVE_TAR_BLOCK ? name_len + 1 : XC_ARCHIVE_TAR_BLOCK);
+        xc_archive_tar_header(self->header, XC_ARCHIVE_TAR_LONG_NAME, strlen(XC_ARCHIVE_TAR_LONG_NAME), long_len, 'L');
+        memset(self->header + XC_ARCHIVE_TAR_BLOCK, 0, XC_ARCHIVE_TAR_BLOCK);
+        memcpy(self->header + XC_ARCHIVE_TAR_BLOCK, file->name, long_len - 1);
+        self->header_len = XC_ARCHIVE_TAR_BLOCK * 2;
+    }
+    xc_archive_tar_header(self->header + self->header_len, file->name, name_len, file->size, '0');
+    self->header_len += XC_ARCHIVE_TAR_BLOCK;
+
+    //stream the file content through mmap
+    self->data = NULL;
+    if (file->size > 0) {
+        if (MAP_FAILED == (self->data = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, file->fd, 0))) {
+            self->data = NULL;
+            return XCC_ERRNO_SYS;
+        }
+        madvise(self->data, file->size, MADV_SEQUENTIAL);
+    }
+    self->pad_len = (XC_ARCHIVE_TAR_BLOCK - file->size % XC_ARCHIVE_TAR_BLOCK) % XC_ARCHIVE_TAR_BLOCK;
+    self->pos = 0;
+    self->opened = 1;
+    return 0;
+}
+
+static void xc_archive_close_current(xc_archive_worker_t *self) {
+    if (NULL != self->data) {
+        munmap(self->data, self->job->files[self->file_idx].size);
+        self->data = NULL;
+    }
+    self->opened = 0;
+}
+
+static SRes xc_archive_read(const ISeqInStream *p, void *buf, size_t *size) {
+    xc_archive_worker_t *self = (xc_archive_worker_t *)((uintptr_t)p - offsetof(xc_archive_worker_t, in));
+    xc_archive_file_t   *file;
+    size_t               len = 0, n;
+    uint8_t             *dst = (uint8_t *)buf;
+
+    if (__atomic_load_n(&(self->job->cancelled), __ATOMIC_RELAXED)) return SZ_ERROR_PROGRESS;
+
+    while (len < *size) {
+        if (self->file_idx >= self->file_end) {
+            //end of the tar archive (two zero blocks), only after the last file
+            if (0 == self->end_len) break;
+            n = (*size - len < self->end_len ? *size - len : self->end_len);
+            memset(dst + len, 0, n);
+            self->end_len -= n;
+            len += n;
+            continue;
+        }
+
+        if (!self->opened && 0 != (self->r = xc_archive_open_next(self))) return SZ_ERROR_READ;
+        file = &(self->job->files[self->file_idx]);
+
+        if (self->pos < self->header_len) {
+            //header
+            n = (*size - len < self->header_len - self->pos ? *size - len : self->header_len - self->pos);
+            memcpy(dst + len, self->header + self->pos, n);
+        } else if (self->pos < self->header_len + file->size) {
+            //content
+            n = self->header_len + file->size - self->pos;
+            if (n > *size - len) n = *size - len;
+            memcpy(dst + len, self->data + (self->pos - self->header_len), n);
+        } else if (self->pos < self->header_len + file->size + self->pad_len) {
+            //padding
+            n = self->header_len + file->size + self->pad_len - self->pos;
+            if (n > *size - len) n = *size - len;
+            memset(dst + len, 0, n);
+        } else {
+            xc_archive_close_current(self);
+            self->file_idx++;
+            continue;
+        }
+        self->pos += n;
+        len += n;
+    }
+
+    *size = len;
+    return SZ_OK;
+}
+
+static size_t xc_archive_write(const ISeqOutStream *p, const void *buf, size_t size) {
+    xc_archive_worker_t *self = (xc_archive_worker_t *)((uintptr_t)p - offsetof(xc_archive_worker_t, out));
+
+    if (0 != (self->r = xcc_util_write(self->fd, (const char *)buf, size))) return 0;
+    return size;
+}
+
+static SRes xc_archive_progress(const ICompressProgress *p, UInt64 in_size, UInt64 out_size) {
+    xc_archive_worker_t *self = (xc_archive_worker_t *)((uintptr_t)p - offsetof(xc_archive_worker_t, progress));
+
+    (void)out_size;
+
+    if (in_size > self->total_size) in_size = self->total_size;
+    __atomic_store_n(&(self->processed_size), in_size, __ATOMIC_RELAXED);
+
+    return __atomic_load_n(&(self->job->cancelled), __ATOMIC_RELAXED) ? SZ_ERROR_PROGRESS : SZ_OK;
+}
+
+static void *xc_archive_worker(void *arg) {
+    xc_archive_worker_t *self = (xc_archive_worker_t *)arg;
+    ISzAlloc             alloc = {.Alloc = xc_archive_alloc, .Free = xc_archive_free};
+    CXzProps             props;
+    CXzEncHandle         xz;
+    SRes                 res;
+
+    pthread_setname_np(pthread_self(), "xcrash_archive");
+
+    //each worker writes an independent xz stream, the concatenated streams are still a valid xz file
+    XzProps_Init(&props);
+    props.lzma2Props.lzmaProps.level = 5;
+    props.lzma2Props.lzmaProps.dictSize = self->job->dict_size;
+    props.lzma2Props.lzmaProps.reduceSize = self->total_size;
+    props.checkId = XZ_CHECK_CRC32;
+    props.blockSize = XZ_PROPS__BLOCK_SIZE__SOLID;
+    props.numTotalThreads = 1;
+    props.reduceSize = self->total_size;
+
+    if (NULL == (xz = XzEnc_Create(&alloc, &alloc))) {
+        res = SZ_ERROR_MEM;
+    } else {
+        if (SZ_OK == (res = XzEnc_SetProps(xz, &props)))
+            res = XzEnc_Encode(xz, &(self->out), &(self->in), &(self->progress));
+        XzEnc_Destroy(xz);
+    }
+    if (self->opened) xc_archive_close_current(self);
+
+    if (__atomic_load_n(&(self->job->cancelled), __ATOMIC_RELAXED)) {
+        self->r = XCC_ERRNO_CANCEL;
+    } else if (0 == self->r) {
+        if (SZ_ERROR_PROGRESS == res)
+            self->r = XCC_ERRNO_CANCEL;
+        else if (SZ_ERROR_MEM == res)
+            self->r = XCC_ERRNO_NOMEM;
+        else if (SZ_OK != res)
+            self->r = XCC_ERRNO_UNKNOWN;
+    }
+    __atomic_store_n(&(self->processed_size), self->total_size, __ATOMIC_RELAXED);
+
+    pthread_mutex_lock(&(self->job->lock));
+    self->job->finished++;
+    pthread_cond_signal(&(self->job->cond));
+    pthread_mutex_unlock(&(self->job->lock));
+    return NULL;
+}
+
+static int xc_archive_append(int dst_fd, int src_fd) {
+    char    buf[4096];
+    ssize_t n;
+    int     r;
+
+    if (lseek(src_fd, 0, SEEK_SET) < 0) return XCC_ERRNO_SYS;
+    while (0 < (n = XCC_UTIL_TEMP_FAILURE_RETRY(read(src_fd, buf, sizeof(buf))))) {
+        if (0 != (r = xcc_util_write(dst_fd, buf, (size_t)n))) return r;
+    }
+    return (0 == n ? 0 : XCC_ERRNO_SYS);
+}
+
+int xc_archive_create(const char **pathnames,
+                      size_t pathnames_len,
+                      const char *archive_pathname,
+                      unsigned int threads,
+                      uint64_t memory_limit,
+                      xc_archive_progress_t progress,
+                      void *progress_arg) {
+    xc_archive_job_t     job;
+    xc_archive_worker_t *worker;
+    struct stat          st;
+    struct timespec      deadline;
+    const char          *name;
+    char                 tmp_pathname[1024];
+    uint64_t             total_size = 0, archive_size = 0, processed_size, target;
+    size_t               i, j, started = 0;
+    long                 cpus;
+    int                  archive_fd = -1;
+    int                  r = 0;
+
+    if (NULL == pathnames || 0 == pathnames_len || NULL == archive_pathname) return XCC_ERRNO_INVAL;
+
+    memset(&job, 0, sizeof(job));
+    pthread_mutex_init(&(job.lock), NULL);
+    pthread_cond_init(&(job.cond), NULL);
+    pthread_once(&xc_archive_crc_once, xc_archive_crc_init);
+
+    //open all files first, the sizes are needed to split them between the workers
+    if (NULL == (job.files = calloc(pathnames_len, sizeof(xc_archive_file_t)))) {
+        r = XCC_ERRNO_NOMEM;
+        goto end;
+    }
+    for (i = 0; i < pathnames_len; i++) job.files[i].fd = -1;
+    for (i = 0; i < pathnames_len; i++) {
+        if (NULL == pathnames[i]) {
+            r = XCC_ERRNO_INVAL;
+            goto end;
+        }
+        name = strrchr(pathnames[i], '/');
+        job.files[i].name = (NULL == name ? pathnames[i] : name + 1);
+        if (0 > (job.files[i].fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(pathnames[i], O_RDONLY | O_CLOEXEC)))) {
+            r = XCC_ERRNO_SYS;
+            goto end;
+        }
+        if (0 != fstat(job.files[i].fd, &st)) {
+            r = XCC_ERRNO_SYS;
+            goto end;
+        }
+        job.files[i].size = (size_t)st.st_size;
+        total_size += (uint64_t)st.st_size;
+    }
+
+    //threads
+    if (0 == threads) {
+        cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (cpus > 0 ? (unsigned int)cpus : 1);
+    }
+    if (threads > XC_ARCHIVE_THREADS_MAX) threads = XC_ARCHIVE_THREADS_MAX;
+    if (threads > pathnames_len) threads = (unsigned int)pathnames_len;
+
+    //dictionary size, fewer threads when the memory limit is too small
+    if (0 == memory_limit) memory_limit = XC_ARCHIVE_MEMORY_LIMIT_DEFAULT;
+    job.dict_size = XC_ARCHIVE_DICT_SIZE_MAX;
+    while (job.dict_size > XC_ARCHIVE_DICT_SIZE_MIN && (uint64_t)job.dict_size * XC_ARCHIVE_MEMORY_PER_DICT * threads > memory_limit)
+        job.dict_size >>= 1;
+    while (threads > 1 && (uint64_t)job.dict_size * XC_ARCHIVE_MEMORY_PER_DICT * threads > memory_limit)
+        threads--;
+
+    //split the files (in order) between the workers by size, every worker gets one file at least
+    if (NULL == (job.workers = calloc(threads, sizeof(xc_archive_worker_t)))) {
+        r = XCC_ERRNO_NOMEM;
+        goto end;
+    }
+    job.workers_len = threads;
+    for (i = 0; i < threads; i++) job.workers[i].fd = -1;
+    for (i = 0, j = 0, processed_size = 0; i < threads; i++) {
+        worker = &(job.workers[i]);
+        worker->job = &job;
+        worker->in.Read = xc_archive_read;
+        worker->out.Write = xc_archive_write;
+        worker->progress.Progress = xc_archive_progress;
+        worker->file_begin = j;
+        worker->file_idx = j;
+        target = total_size * (i + 1) / threads;
+        do {
+            processed_size += job.files[j].size;
+            worker->total_size += xc_archive_tar_size(&(job.files[j]));
+            j++;
+        } while (j < pathnames_len - (threads - 1 - i) && (processed_size < target || i == threads - 1));
+        worker->file_end = j;
+
+        //end of the tar archive
+        if (i == threads - 1) {
+            worker->end_len = XC_ARCHIVE_TAR_BLOCK * 2;
+            worker->total_size += worker->end_len;
+        }
+        archive_size += worker->total_size;
+    }
+
+    //the first worker writes to the archive file directly, others to the anonymous temporary files
+    if (0 > (archive_fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(archive_pathname, O_CREAT | O_RDWR | O_TRUNC | O_CLOEXEC, 0644)))) {
+        r = XCC_ERRNO_SYS;
+        goto end;
+    }
+    job.workers[0].fd = archive_fd;
+    for (i = 1; i < threads; i++) {
+        snprintf(tmp_pathname, sizeof(tmp_pathname), "%s.%zu.tmp", archive_pathname, i);
+        if (0 > (job.workers[i].fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(tmp_pathname, O_CREAT | O_RDWR | O_TRUNC | O_CLOEXEC, 0644)))) {
+            r = XCC_ERRNO_SYS;
+            goto end;
+        }
+        unlink(tmp_pathname);
+    }
+
+    //start the workers
+    for (i = 0; i < threads; i++) {
+        if (0 != pthread_create(&(job.workers[i].thd), NULL, xc_archive_worker, &(job.workers[i]))) {
+            r = XCC_ERRNO_SYS;
+            __atomic_store_n(&(job.cancelled), 1, __ATOMIC_RELAXED);
+            break;
+        }
+        started++;
+    }
+
+    //report the progress in the caller's thread, until all the workers finished
+    pthread_mutex_lock(&(job.lock));
+    while (job.finished < started) {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += XC_ARCHIVE_PROGRESS_INTERVAL_MS * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&(job.cond), &(job.lock), &deadline);
+        if (job.finished >= started) break;
+
+        if (NULL != progress && !__atomic_load_n(&(job.cancelled), __ATOMIC_RELAXED)) {
+            processed_size = 0;
+            for (i = 0; i < started; i++)
+                processed_size += __atomic_load_n(&(job.workers[i].processed_size), __ATOMIC_RELAXED);
+            pthread_mutex_unlock(&(job.lock));
+            if (0 != progress(progress_arg, processed_size, archive_size))
+                __atomic_store_n(&(job.cancelled), 1, __ATOMIC_RELAXED);
+            pthread_mutex_lock(&(job.lock));
+        }
+    }
+    pthread_mutex_unlock(&(job.lock));
+
+    for (i = 0; i < started; i++) {
+        pthread_join(job.workers[i].thd, NULL);
+        if (0 == r) r = job.workers[i].r;
+    }
+    if (0 == r && __atomic_load_n(&(job.cancelled), __ATOMIC_RELAXED)) r = XCC_ERRNO_CANCEL;
+    if (0 != r) goto end;
+
+    //concatenate the xz streams
+    for (i = 1; i < threads; i++)
+        if (0 != (r = xc_archive_append(archive_fd, job.workers[i].fd))) goto end;
+
+    if (NULL != progress) progress(progress_arg, archive_size, archive_size);
+
+ end:
+    if (NULL != job.workers) {
+        for (i = 1; i < job.workers_len; i++)
+            if (job.workers[i].fd >= 0) close(job.workers[i].fd);
+        free(job.workers);
+    }
+    if (NULL != job.files) {
+        for (i = 0; i < pathnames_len; i++)
+            if (job.files[i].fd >= 0) close(job.files[i].fd);
+        free(job.files);
+    }
+    if (archive_fd >= 0) {
+        close(archive_fd);
+        if (0 != r) unlink(archive_pathname);
+    }
+    pthread_cond_destroy(&(job.cond));
+    pthread_mutex_destroy(&(job.lock));
+    return r;
+}
+
+#pragma clang diagnostic pop
@@ -35,6 +35,8 @@
 #include "xcc_errno.h"
 #include "xcc_fmt.h"
 #include "xcc_util.h"
+#include "xcc_binlog.h"
+#include "xcc_meminfo.h"
 #include "xc_common.h"
 #include "xc_jni.h"
 #include "xc_util.h"
@@ -48,6 +50,10 @@
 #define XC_COMMON_OPEN_NEW_FILE_FLAGS (O_CREAT | O_WRONLY | O_CLOEXEC | O_TRUNC | O_APPEND)
 #define XC_COMMON_OPEN_NEW_FILE_MODE  (S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) //644
 
+//a crash before the background initializer is done waits for the log directory
+#define XC_COMMON_READY_WAIT_MS          3000
+#define XC_COMMON_READY_WAIT_INTERVAL_MS 10
+
 //system info
 int           xc_common_api_level         = 0;
 char         *xc_common_os_version        = NULL;
@@ -80,6 +86,9 @@ sig_atomic_t  xc_common_java_crashed      = 0;
 static int    xc_common_crash_prepared_fd = -1;
 static int    xc_common_trace_prepared_fd = -1;
 
+//the log directory and the process info are saved (they may be saved later in the lazy mode)
+static int    xc_common_ready             = 0;
+
 static void xc_common_open_prepared_fd(int is_crash) {
     int fd = (is_crash ? xc_common_crash_prepared_fd : xc_common_trace_prepared_fd);
     if (fd >= 0) 
@@ -134,9 +143,6 @@ int xc_common_init(int         api_level,
     int             r = 0;
     struct timeval  tv;
     struct tm       tm;
-    char            buf[256];
-    char           *kernel_version;
-    char           *process_name;
 
 #define XC_COMMON_DUP_STR(v) do {                                       \
         if (NULL == v || 0 == strlen(v))                                \
@@ -176,18 +182,9 @@ int xc_common_init(int         api_level,
     XC_COMMON_DUP_STR(app_id);
     XC_COMMON_DUP_STR(app_version);
     XC_COMMON_DUP_STR(app_lib_dir);
-    XC_COMMON_DUP_STR(log_dir);
     
-    //save kernel version
-    xc_util_get_kernel_version(buf, sizeof(buf));
-    kernel_version = buf;
-    XC_COMMON_DUP_STR(kernel_version);
-
-    //save process id and process name
+    //save process id
     xc_common_process_id = getpid();
-    xcc_util_get_process_name(xc_common_process_id, buf, sizeof(buf));
-    process_name = buf;
-    XC_COMMON_DUP_STR(process_name);
 
     //to /dev/null
     if ((xc_common_fd_null = XCC_UTIL_TEMP_FAILURE_RETRY(open("/dev/null", O_RDWR))) < 0) {
@@ -195,13 +192,16 @@ int xc_common_init(int         api_level,
         goto err;
     }
 
-    //check or create log directory
-    if(0 != (r = xc_util_mkdirs(log_dir))) goto err;
+    //lazy mode, the rest is saved by xc_common_init_late() from the background initializer
+    if (NULL == log_dir) {
+        xc_common_kernel_version = "unknown";
+        xc_common_process_name = "unknown";
+        return 0;
+    }
 
-    //create prepared FD for FD exhausted case
-    xc_common_open_prepared_fd(1);
-    xc_common_open_prepared_fd(0);
+    if (0 != (r = xc_common_init_late(log_dir))) goto err;
 
+    xc_common_set_ready();
     return 0;
 
  err:
@@ -214,14 +214,67 @@ int xc_common_init(int         api_level,
     XC_COMMON_FREE_STR(app_id);
     XC_COMMON_FREE_STR(app_version);
     XC_COMMON_FREE_STR(app_lib_dir);
-    XC_COMMON_FREE_STR(log_dir);
-    XC_COMMON_FREE_STR(kernel_version);
-    XC_COMMON_FREE_STR(process_name);
     
     return r;
 }
 
-static int xc_common_open_log(int is_crash, uint64_t timestamp,
+int xc_common_init_late(const char *log_dir) {
+    char  buf[256];
+    char *c_log_dir = NULL;
+    char *kernel_version = NULL;
+    char *process_name = NULL;
+    int   r;
+
+    if (NULL == log_dir || 0 == strlen(log_dir)) return XCC_ERRNO_INVAL;
+
+    //check or create log directory
+    if (0 != (r = xc_util_mkdirs(log_dir))) return r;
+
+    if (NULL == (c_log_dir = strdup(log_dir))) goto err;
+
+    //save kernel version
+    xc_util_get_kernel_version(buf, sizeof(buf));
+    if (0 != strlen(buf) && NULL == (kernel_version = strdup(buf))) goto err;
+
+    //save process name
+    xcc_util_get_process_name(xc_common_process_id, buf, sizeof(buf));
+    if (0 != strlen(buf) && NULL == (process_name = strdup(buf))) goto err;
+
+    //nothing reads them before xc_common_set_ready() in the lazy mode
+    xc_common_log_dir = c_log_dir;
+    xc_common_kernel_version = (NULL == kernel_version ? "unknown" : kernel_version);
+    xc_common_process_name = (NULL == process_name ? "unknown" : process_name);
+
+    //create prepared FD for FD exhausted case
+    xc_common_open_prepared_fd(1);
+    xc_common_open_prepared_fd(0);
+
+    return 0;
+
+ err:
+    free(c_log_dir);
+    free(kernel_version);
+    free(process_name);
+    return XCC_ERRNO_NOMEM;
+}
+
+void xc_common_set_ready(void) {
+    __atomic_store_n(&xc_common_ready, 1, __ATOMIC_RELEASE);
+}
+
+//called from the signal handlers too, so nanosleep() instead of usleep()
+int xc_common_wait_ready(void) {
+    struct timespec ts = {.tv_sec = 0, .tv_nsec = XC_COMMON_READY_WAIT_INTERVAL_MS * 1000 * 1000};
+    int             i;
+
+    for (i = 0; i < XC_COMMON_READY_WAIT_MS / XC_COMMON_READY_WAIT_INTERVAL_MS; i++) {
+        if (__atomic_load_n(&xc_common_ready, __ATOMIC_ACQUIRE)) return 0;
+        nanosleep(&ts, NULL);
+    }
+    return __atomic_load_n(&xc_common_ready, __ATOMIC_ACQUIRE) ? 0 : XCC_ERRNO_STATE;
+}
+
+static int xc_common_open_log(int is_crash, const char *suffix, uint64_t timestamp,
                               char *pathname, size_t pathname_len, 
                               int *from_placeholder) {
 
@@ -231,9 +284,10 @@ static int xc_common_open_log(int is_crash, uint64_t timestamp,
     long               n, i;
     xcc_util_dirent_t *ent;
 
+    if (0 != xc_common_wait_ready()) return -1;
+
     xcc_fmt_snprintf(pathname, pathname_len, "%s/"XC_COMMON_LOG_PREFIX"_%020"PRIu64"_%s__%s%s",
-                     xc_common_log_dir, timestamp, xc_common_app_version, xc_common_process_name,
-                     is_crash ? XC_COMMON_LOG_SUFFIX_CRASH : XC_COMMON_LOG_SUFFIX_TRACE);
+                     xc_common_log_dir, timestamp, xc_common_app_version, xc_common_process_name, suffix);
 
     //open dir
     if ((fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(xc_common_log_dir, XC_COMMON_OPEN_DIR_FLAGS))) < 0) {
@@ -292,11 +346,34 @@ static void xc_common_close_log(int fd, int is_crash) {
 }
 
 int xc_common_open_crash_log(char *pathname, size_t pathname_len, int *from_placeholder) {
-    return xc_common_open_log(1, xc_common_start_time, pathname, pathname_len, from_placeholder);
+    return xc_common_open_log(1, XC_COMMON_LOG_SUFFIX_CRASH, xc_common_start_time, pathname, pathname_len, from_placeholder);
 }
 
 int xc_common_open_trace_log(char *pathname, size_t pathname_len, uint64_t trace_time) {
-    return xc_common_open_log(0, trace_time, pathname, pathname_len, NULL);
+    return xc_common_open_log(0, XC_COMMON_LOG_SUFFIX_TRACE, trace_time, pathname, pathname_len, NULL);
+}
+
+//watchdog traces are kept apart from the SIGQUIT ones, they are closed by xc_common_close_trace_log() too
+int xc_common_open_watchdog_log(char *pathname, size_t pathname_len, uint64_t trace_time) {
+    return xc_common_open_log(0, XC_COMMON_LOG_SUFFIX_WATCHDOG, trace_time, pathname, pathname_len, NULL);
+}
+
+//snapshots are closed by xc_common_close_trace_log(), they share the prepared fd with the traces
+int xc_common_open_snapshot_log(char *pathname, size_t pathname_len, uint64_t snapshot_time) {
+    return xc_common_open_log(0, XC_COMMON_LOG_SUFFIX_SNAPSHOT, snapshot_time, pathname, pathname_len, NULL);
+}
+
+int xc_common_open_profile_log(char *pathname, size_t pathname_len, uint64_t profile_time) {
+    //profiles are written from a normal thread, no placeholder or prepared fd is needed
+    if (0 != xc_common_wait_ready()) return -1;
+
+    xcc_fmt_snprintf(pathname, pathname_len, "%s/"XC_COMMON_LOG_PREFIX"_%020"PRIu64"_%s__%s"XC_COMMON_LOG_SUFFIX_PROFILE,
+                     xc_common_log_dir, profile_time, xc_common_app_version, xc_common_process_name);
+
+    //no O_APPEND, the samples header is rewritten in place when profiling stops
+    return XCC_UTIL_TEMP_FAILURE_RETRY(open(pathname,
+            O_CREAT | O_WRONLY | O_CLOEXEC | O_TRUNC,
+            XC_COMMON_OPEN_NEW_FILE_MODE));
 }
 
 void xc_common_close_crash_log(int fd) {
@@ -312,9 +389,17 @@ int xc_common_seek_to_content_end(int fd) {
     ssize_t readed, n;
     off_t   offset = 0;
 
-    //placeholder file
-    if (lseek(fd, 0, SEEK_SET) < 0) 
-        goto err;
+    //binary log, the zero bytes in it are not padding
+    if (0 == xcc_binlog_check(fd, &offset, NULL)) {
+        if (lseek(fd, offset, SEEK_SET) < 0)
+            goto err;
+    } else {
+        offset = 0;
+
+        //placeholder file
+        if (lseek(fd, 0, SEEK_SET) < 0)
+            goto err;
+    }
 
     while(1) {
         readed = XCC_UTIL_TEMP_FAILURE_RETRY(read(fd, buf, sizeof(buf)));
@@ -342,4 +427,53 @@ int xc_common_seek_to_content_end(int fd) {
     return -1;
 }
 
+int xc_common_render_binary_log(const char *src_pathname, const char *dst_pathname) {
+    int src_fd = -1;
+    int dst_fd = -1;
+    int r;
+
+    if ((src_fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(src_pathname, O_RDONLY | O_CLOEXEC))) < 0) {
+        r = XCC_ERRNO_SYS;
+        goto end;
+    }
+    if ((dst_fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(dst_pathname,
+            O_CREAT | O_WRONLY | O_CLOEXEC | O_TRUNC, XC_COMMON_OPEN_NEW_FILE_MODE))) < 0) {
+        r = XCC_ERRNO_SYS;
+        goto end;
+    }
+
+    r = xcc_binlog_render(src_fd, dst_fd);
+
+ end:
+    if (src_fd >= 0) close(src_fd);
+    if (dst_fd >= 0) {
+        close(dst_fd);
+        //a truncated log is rendered as far as possible, followed by the marker
+        if (0 != r && XCC_ERRNO_MISSING != r) unlink(dst_pathname);
+    }
+    return r;
+}
+
+int xc_common_record_java_crash_sections(const char *pathname, unsigned int logcat_system_lines,
+                                         unsigned int logcat_events_lines, unsigned int logcat_main_lines,
+                                         int dump_fds, int dump_network_info) {
+    int fd;
+    int r = 0;
+
+    //appended to the log file written by the Java side, nothing is allocated on the Java heap
+    if ((fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(pathname, O_WRONLY | O_APPEND | O_CLOEXEC))) < 0) return XCC_ERRNO_SYS;
+
+    if (0 != (r = xcc_util_record_logcat(fd, xc_common_process_id, xc_common_api_level,
+            logcat_system_lines, logcat_events_lines, logcat_main_lines))) goto end;
+    if (dump_fds)
+        if (0 != (r = xcc_util_record_fds(fd, xc_common_process_id))) goto end;
+    if (dump_network_info)
+        if (0 != (r = xcc_util_record_network_info(fd, xc_common_process_id, xc_common_api_level))) goto end;
+    r = xcc_meminfo_record(fd, xc_common_process_id);
+
+ end:
+    close(fd);
+    return r;
+}
+
 #pragma clang diagnostic pop
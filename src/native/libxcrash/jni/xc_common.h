@@ -35,6 +35,9 @@ extern "C" {
 // log filename format:
 // tombstone_01234567890123456789_appversion__processname.native.xcrash
 // tombstone_01234567890123456789_appversion__processname.trace.xcrash
+// tombstone_01234567890123456789_appversion__processname.watchdog.trace.xcrash
+// tombstone_01234567890123456789_appversion__processname.profile.xcrash
+// tombstone_01234567890123456789_appversion__processname.snapshot.xcrash
 // placeholder_01234567890123456789.clean.xcrash
 #define XC_COMMON_LOG_PREFIX           "tombstone"
 #define XC_COMMON_LOG_PREFIX_LEN       9
@@ -42,6 +45,10 @@ extern "C" {
 #define XC_COMMON_LOG_SUFFIX_TRACE     ".trace.xcrash"
 #define XC_COMMON_LOG_SUFFIX_TRACE_LEN 13
 #define XC_COMMON_LOG_NAME_MIN_TRACE   (9 + 1 + 20 + 1 + 2 + 13)
+#define XC_COMMON_LOG_SUFFIX_WATCHDOG  ".watchdog.trace.xcrash"
+#define XC_COMMON_LOG_SUFFIX_WATCHDOG_LEN 22
+#define XC_COMMON_LOG_SUFFIX_PROFILE   ".profile.xcrash"
+#define XC_COMMON_LOG_SUFFIX_SNAPSHOT  ".snapshot.xcrash"
 #define XC_COMMON_PLACEHOLDER_PREFIX   "placeholder"
 #define XC_COMMON_PLACEHOLDER_SUFFIX   ".clean.xcrash"
 
@@ -88,12 +95,25 @@ int xc_common_init(int         api_level,
                    const char *app_lib_dir,
                    const char *log_dir);
 
+//the lazy mode calls xc_common_init() with a NULL log_dir, then these from the background initializer
+int xc_common_init_late(const char *log_dir);
+void xc_common_set_ready(void);
+int xc_common_wait_ready(void);
+
 int xc_common_open_crash_log(char *pathname, size_t pathname_len, int *from_placeholder);
 int xc_common_open_trace_log(char *pathname, size_t pathname_len, uint64_t trace_time);
+int xc_common_open_watchdog_log(char *pathname, size_t pathname_len, uint64_t trace_time);
+int xc_common_open_snapshot_log(char *pathname, size_t pathname_len, uint64_t snapshot_time);
+int xc_common_open_profile_log(char *pathname, size_t pathname_len, uint64_t profile_time);
 void xc_common_close_crash_log(int fd);
 void xc_common_close_trace_log(int fd);
 int xc_common_seek_to_content_end(int fd);
 
+int xc_common_render_binary_log(const char *src_pathname, const char *dst_pathname);
+int xc_common_record_java_crash_sections(const char *pathname, unsigned int logcat_system_lines,
+                                         unsigned int logcat_events_lines, unsigned int logcat_main_lines,
+                                         int dump_fds, int dump_network_info);
+
 #ifdef __cplusplus
 }
 #endif
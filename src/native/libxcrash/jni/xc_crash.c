@@ -37,13 +37,16 @@
 #include <stdio.h>
 #include <pthread.h>
 #include <sched.h>
+#include <signal.h>
 #include <setjmp.h>
 #include <sys/eventfd.h>
 #include <sys/prctl.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <sys/syscall.h>
+#include <sys/socket.h>
 #include <sys/uio.h>
+#include <sys/stat.h>
 #include <android/log.h>
 #include "xcc_errno.h"
 #include "xcc_spot.h"
@@ -51,6 +54,8 @@
 #include "xcc_unwind.h"
 #include "xcc_signal.h"
 #include "xcc_b64.h"
+#include "xcc_binlog.h"
+#include "xcc_manifest.h"
 #include "xcc_util.h"
 #include "xc_crash.h"
 #include "xc_trace.h"
@@ -70,6 +75,8 @@
 #define XC_CRASH_ERR_TITLE                 "\n\nxcrash error:\n"
 
 static pthread_mutex_t  xc_crash_mutex   = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t  xc_crash_snapshot_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t  xc_crash_maps_mutex = PTHREAD_MUTEX_INITIALIZER;
 static int              xc_crash_rethrow;
 static char            *xc_crash_dumper_pathname;
 static char            *xc_crash_emergency;
@@ -78,8 +85,16 @@ static char            *xc_crash_emergency;
 static int              xc_crash_prepared_fd = -1;
 static int              xc_crash_log_fd  = -1;
 static int              xc_crash_log_from_placeholder;
+static int              xc_crash_compress_log = 0;
+static char            *xc_crash_compress_dict = NULL;
+static int              xc_crash_compress_sock[2] = {-1, -1}; //the crash dumper waits on it to compress the log file
+static pid_t            xc_crash_compress_dumper_pid = 0;
 static char             xc_crash_log_pathname[1024] = "\0";
 
+//the maps baseline
+static int              xc_crash_dump_map_delta = 0;
+static char             xc_crash_maps_baseline_pathname[1024] = "\0";
+
 //the crash
 static pid_t            xc_crash_tid = 0;
 static int              xc_crash_dump_java_stacktrace = 0; //try to dump java stacktrace in java layer
@@ -102,6 +117,9 @@ static int              xc_crash_child_notifier[2];
 static xcc_spot_t       xc_crash_spot;
 static char            *xc_crash_dump_all_threads_whitelist = NULL;
 
+//the running snapshot (or profile) dumper, it is killed by the crash handler
+static volatile pid_t   xc_crash_snapshot_dumper_pid = 0;
+
 static int xc_crash_fork(int (*fn)(void *)) {
 #ifndef __i386__
     return clone(fn, xc_crash_child_stack, CLONE_VFORK | CLONE_FS | CLONE_UNTRACED, NULL);
@@ -136,7 +154,7 @@ static int xc_crash_exec_dumper(void *arg) {
     //keep the log_fd open for writing error msg before execl()
     int i;
     for(i = 0; i < 1024; i++)
-        if(i != xc_crash_log_fd)
+        if(i != xc_crash_log_fd && i != xc_crash_compress_sock[1])
             syscall(SYS_close, i);
 
     //hold the fd 0, 1, 2
@@ -157,6 +175,10 @@ static int xc_crash_exec_dumper(void *arg) {
     }
     XCC_UTIL_TEMP_FAILURE_RETRY(dup2(devnull, STDOUT_FILENO));
     XCC_UTIL_TEMP_FAILURE_RETRY(dup2(devnull, STDERR_FILENO));
+
+    //the crash dumper talks with the crashed process on its stdout when it's going to compress the log file
+    if (xc_crash_compress_sock[1] >= 0)
+        XCC_UTIL_TEMP_FAILURE_RETRY(dup2(xc_crash_compress_sock[1], STDOUT_FILENO));
     
     //create args pipe
     int pipefd[2];
@@ -181,6 +203,8 @@ static int xc_crash_exec_dumper(void *arg) {
                           xc_crash_spot.build_fingerprint_len +
                           xc_crash_spot.app_id_len +
                           xc_crash_spot.app_version_len +
+                          xc_crash_spot.compress_dict_pathname_len +
+                          xc_crash_spot.maps_baseline_pathname_len +
                           xc_crash_spot.dump_all_threads_whitelist_len);
     errno = 0;
     if(fcntl(pipefd[1], F_SETPIPE_SZ, write_len) < write_len) {
@@ -191,7 +215,7 @@ static int xc_crash_exec_dumper(void *arg) {
     }
 
     //write args to pipe
-    struct iovec iovs[12] = {
+    struct iovec iovs[14] = {
         {.iov_base = &xc_crash_spot,             .iov_len = sizeof(xcc_spot_t)},
         {.iov_base = xc_crash_log_pathname,      .iov_len = xc_crash_spot.log_pathname_len},
         {.iov_base = xc_common_os_version,       .iov_len = xc_crash_spot.os_version_len},
@@ -206,12 +230,14 @@ static int xc_crash_exec_dumper(void *arg) {
         },
         {.iov_base = xc_common_app_id, .iov_len = xc_crash_spot.app_id_len},
         {.iov_base = xc_common_app_version, .iov_len = xc_crash_spot.app_version_len},
+        {.iov_base = xc_crash_compress_dict, .iov_len = xc_crash_spot.compress_dict_pathname_len},
+        {.iov_base = xc_crash_maps_baseline_pathname, .iov_len = xc_crash_spot.maps_baseline_pathname_len},
         {
             .iov_base = xc_crash_dump_all_threads_whitelist,
             .iov_len = xc_crash_spot.dump_all_threads_whitelist_len
         }
     };
-    int iovs_cnt = (0 == xc_crash_spot.dump_all_threads_whitelist_len ? 11 : 12);
+    int iovs_cnt = (0 == xc_crash_spot.dump_all_threads_whitelist_len ? 13 : 14);
     errno = 0;
     ssize_t ret = XCC_UTIL_TEMP_FAILURE_RETRY(writev(pipefd[1], iovs, iovs_cnt));
     if((ssize_t)write_len != ret) {
@@ -383,6 +409,7 @@ static int xc_crash_check_backtrace_valid() {
     char   line[512];
     size_t i = 0;
     int    r = 0;
+    off_t  end;
     
     if ((fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(xc_crash_log_pathname, O_RDONLY | O_CLOEXEC))) < 0) {
         if(xc_crash_prepared_fd >= 0) {
@@ -392,6 +419,13 @@ static int xc_crash_check_backtrace_valid() {
         if((fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(xc_crash_log_pathname, O_RDONLY | O_CLOEXEC))) < 0)
             return 0; //failed
     }
+
+    //binary log
+    if (xc_crash_spot.dump_binary) {
+        if (0 != xcc_binlog_check(fd, &end, &r)) r = 0;
+        close(fd);
+        return r;
+    }
     
     while(NULL != xcc_util_gets(line, sizeof(line), fd)) {
         if(0 == memcmp(line, "backtrace:\n", 11)) {
@@ -408,12 +442,53 @@ static int xc_crash_check_backtrace_valid() {
     return r;    
 }
 
+//the fallback log is always text, drop the broken binary log before writing anything else
+static void xc_crash_drop_binary_log(void) {
+    if (xc_crash_log_fd < 0 || !xc_crash_spot.dump_binary) return;
+
+    if (0 != ftruncate(xc_crash_log_fd, 0) || lseek(xc_crash_log_fd, 0, SEEK_SET) < 0) {
+        close(xc_crash_log_fd);
+        xc_crash_log_fd = -1;
+    }
+}
+
+//compress the finished log file in the dumper process, the log file path is changed on success
+//(the crash dumper is still waiting after the dump, it exits without compressing if compress is 0)
+static void xc_crash_compress(int compress) {
+    char cmd = (compress ? 1 : 0);
+    int  status = 0;
+    int  r = -1;
+
+    if (xc_crash_compress_dumper_pid > 0) {
+        if (1 == XCC_UTIL_TEMP_FAILURE_RETRY(write(xc_crash_compress_sock[0], &cmd, 1))
+            && -1 != XCC_UTIL_TEMP_FAILURE_RETRY(waitpid(xc_crash_compress_dumper_pid, &status, __WALL))
+            && WIFEXITED(status) && 0 == WEXITSTATUS(status)) {
+            r = 0;
+        }
+        xc_crash_compress_dumper_pid = 0;
+    }
+    if (xc_crash_compress_sock[0] >= 0) {
+        close(xc_crash_compress_sock[0]);
+        xc_crash_compress_sock[0] = -1;
+    }
+    if (!compress || 0 != r) return;
+
+    //the dumper chooses the suffix by the format
+    strcat(xc_crash_log_pathname, XCC_UTIL_XCDZ_SUFFIX);
+    if (0 != access(xc_crash_log_pathname, F_OK)) {
+        xc_crash_log_pathname[xc_crash_spot.log_pathname_len] = '\0';
+        strcat(xc_crash_log_pathname, XCC_UTIL_XZ_SUFFIX);
+    }
+    xc_crash_spot.log_pathname_len = strlen(xc_crash_log_pathname);
+}
+
 static void xc_crash_signal_handler(int sig, siginfo_t* si, void* uc) {
     struct timespec crash_tp;
     int             restore_orig_ptracer = 0;
     int             restore_orig_dumpable = 0;
     int             orig_dumpable = 0;
     int             dump_ok = 0;
+    int             manifest_added = 0;
 
     (void) sig;
 
@@ -493,6 +568,9 @@ static void xc_crash_signal_handler(int sig, siginfo_t* si, void* uc) {
         restore_orig_ptracer = 1;
     }
 
+    //the threads traced by a running snapshot dumper can't be attached by the crash dumper
+    if (xc_crash_snapshot_dumper_pid > 0) kill(xc_crash_snapshot_dumper_pid, SIGKILL);
+
     //set crash spot info
     xc_crash_spot.crash_time = xc_crash_time;
     xc_crash_spot.crash_tid = xc_crash_tid;
@@ -500,9 +578,22 @@ static void xc_crash_signal_handler(int sig, siginfo_t* si, void* uc) {
     memcpy(&(xc_crash_spot.ucontext), uc, sizeof(ucontext_t));
     xc_crash_spot.log_pathname_len = strlen(xc_crash_log_pathname);
 
+    //the crash dumper waits to compress the log file after the java stacktrace is appended,
+    //so no other dumper is spawned for it (XCC_UTIL_XCDZ_SUFFIX is the longer suffix)
+    if (xc_crash_compress_log
+        && xc_crash_spot.log_pathname_len + strlen(XCC_UTIL_XCDZ_SUFFIX) < sizeof(xc_crash_log_pathname)
+        && 0 == socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, xc_crash_compress_sock)) {
+        xc_crash_spot.compress = 1;
+    }
+
     //spawn crash dumper process
     errno = 0;
     pid_t dumper_pid = xc_crash_fork(xc_crash_exec_dumper);
+    xc_crash_spot.compress = 0;
+    if (xc_crash_compress_sock[1] >= 0) {
+        close(xc_crash_compress_sock[1]);
+        xc_crash_compress_sock[1] = -1;
+    }
     if(-1 == dumper_pid) {
         xcc_util_write_format_safe(xc_crash_log_fd,
                 XC_CRASH_ERR_TITLE"fork failed, errno=%d\n\n",
@@ -514,9 +605,17 @@ static void xc_crash_signal_handler(int sig, siginfo_t* si, void* uc) {
     //parent process ...
 
     //wait the crash dumper process terminated
+    //(the one going to compress the log file tells it's done on the socket, it exits later)
     errno = 0;
     int status = 0;
-    int wait_r = XCC_UTIL_TEMP_FAILURE_RETRY(waitpid(dumper_pid, &status, __WALL));
+    int wait_r;
+    char done;
+    if (xc_crash_compress_sock[0] >= 0 && 1 == XCC_UTIL_TEMP_FAILURE_RETRY(read(xc_crash_compress_sock[0], &done, 1))) {
+        wait_r = dumper_pid;
+        xc_crash_compress_dumper_pid = dumper_pid;
+    } else {
+        wait_r = XCC_UTIL_TEMP_FAILURE_RETRY(waitpid(dumper_pid, &status, __WALL));
+    }
 
     //the crash dumper process should have written a lot of logs,
     //so we need to seek to the end of log file
@@ -525,6 +624,12 @@ static void xc_crash_signal_handler(int sig, siginfo_t* si, void* uc) {
             goto end;
         }
     }
+
+    //keep the following error messages in the text fallback log
+    if (-1 == wait_r || !(WIFEXITED(status)) || 0 != WEXITSTATUS(status)) {
+        xc_crash_drop_binary_log();
+        if (xc_crash_log_fd < 0) goto end;
+    }
     
     if(-1 == wait_r) {
         xcc_util_write_format_safe(xc_crash_log_fd,
@@ -558,9 +663,14 @@ static void xc_crash_signal_handler(int sig, siginfo_t* si, void* uc) {
         }
     }
 
+    //the dumper adds the log file to the manifest before it exits normally
+    manifest_added = 1;
+
     //check the backtrace
-    if (!xc_crash_check_backtrace_valid())
+    if (!xc_crash_check_backtrace_valid()) {
+        xc_crash_drop_binary_log();
         goto end;
+    }
     
     dump_ok = 1;
 
@@ -579,7 +689,7 @@ static void xc_crash_signal_handler(int sig, siginfo_t* si, void* uc) {
                                   xc_crash_time,
                                   xc_crash_emergency,
                                   XC_CRASH_EMERGENCY_BUF_LEN);
-        
+
         if (xc_crash_log_fd >= 0) {
             if(0 != xc_fallback_record(xc_crash_log_fd,
                                        xc_crash_emergency,
@@ -602,8 +712,17 @@ static void xc_crash_signal_handler(int sig, siginfo_t* si, void* uc) {
         //we have written all the required information in the native layer, close the FD
         close(xc_crash_log_fd);
         xc_crash_log_fd = -1;
+
+        //compress the log file, the JNI callback gets the compressed one
+        xc_crash_compress(dump_ok);
+
+        //the log file written without the dumper is not in the manifest yet
+        if (!manifest_added) xcc_manifest_add(xc_crash_log_pathname, XCC_UTIL_CRASH_TYPE_NATIVE, xc_crash_time, 0);
     }
 
+    //the crash dumper waiting to compress the log file exits without compressing
+    if (xc_crash_compress_sock[0] >= 0) xc_crash_compress(0);
+
     //JNI callback
     xc_crash_callback();
 
@@ -618,13 +737,14 @@ static void xc_crash_signal_handler(int sig, siginfo_t* si, void* uc) {
     _exit(1);
 }
 
-static void xc_crash_init_dump_all_threads_whitelist(const char** whitelist, size_t whitelist_len) {
+static char *xc_crash_encode_threads_whitelist(const char** whitelist, size_t whitelist_len, size_t *whitelist_encoded_len) {
     size_t  i, len;
     size_t  encoded_len, total_encoded_len = 0, cur_encoded_len = 0;
     char   *total_encoded_whitelist, *tmp;
     
+    *whitelist_encoded_len = 0;
     if (NULL == whitelist || 0 == whitelist_len)
-        return;
+        return NULL;
 
     //get total encoded length
     for (i = 0; i < whitelist_len; i++) {
@@ -635,13 +755,13 @@ static void xc_crash_init_dump_all_threads_whitelist(const char** whitelist, siz
     }
 
     if (0 == total_encoded_len)
-        return;
+        return NULL;
     total_encoded_len += whitelist_len; //separator ('|')
     total_encoded_len += 1; //terminating null byte ('\0')
 
     //alloc encode buffer
     if (NULL == (total_encoded_whitelist = calloc(1, total_encoded_len))) 
-        return;
+        return NULL;
 
     //to base64 encode each whitelist item
     for (i = 0; i < whitelist_len; i++) {
@@ -652,7 +772,7 @@ static void xc_crash_init_dump_all_threads_whitelist(const char** whitelist, siz
             continue;
 
         if (NULL != (tmp = xcc_b64_encode((const uint8_t *)(whitelist[i]), len, &encoded_len))) {
-            if(cur_encoded_len + encoded_len + 1 >= total_encoded_len) return; //impossible
+            if(cur_encoded_len + encoded_len + 1 >= total_encoded_len) return NULL; //impossible
             
             memcpy(total_encoded_whitelist + cur_encoded_len, tmp, encoded_len);
             cur_encoded_len += encoded_len;
@@ -671,11 +791,80 @@ static void xc_crash_init_dump_all_threads_whitelist(const char** whitelist, siz
 
     if (0 == cur_encoded_len) {
         free(total_encoded_whitelist);
-        return;
+        return NULL;
     }
 
-    xc_crash_spot.dump_all_threads_whitelist_len = cur_encoded_len;
-    xc_crash_dump_all_threads_whitelist = total_encoded_whitelist;
+    *whitelist_encoded_len = cur_encoded_len;
+    return total_encoded_whitelist;
+}
+
+//save the current maps as the baseline, named by the FNV-1a hash of the content
+static int xc_crash_save_maps_baseline(void) {
+    char     pathname[1024];
+    char     tmp_pathname[1024];
+    char    *buf = NULL, *tmp;
+    size_t   buf_len = 0, buf_size = 0;
+    ssize_t  n;
+    uint64_t hash;
+    int      fd;
+    int      r = 0;
+
+    //read the maps
+    if (0 > (fd = XCC_UTIL_TEMP_FAILURE_RETRY(open("/proc/self/maps", O_RDONLY | O_CLOEXEC)))) return XCC_ERRNO_SYS;
+    while (1) {
+        if (buf_len == buf_size) {
+            if (NULL == (tmp = realloc(buf, buf_size + 64 * 1024))) {
+                r = XCC_ERRNO_NOMEM;
+                break;
+            }
+            buf = tmp;
+            buf_size += 64 * 1024;
+        }
+        if (0 >= (n = XCC_UTIL_TEMP_FAILURE_RETRY(read(fd, buf + buf_len, buf_size - buf_len)))) {
+            if (0 > n) r = XCC_ERRNO_SYS;
+            break;
+        }
+        buf_len += (size_t)n;
+    }
+    close(fd);
+    if (0 != r) goto end;
+    if (0 == buf_len) {
+        r = XCC_ERRNO_MISSING;
+        goto end;
+    }
+
+    hash = xcc_util_fnv1a(XCC_UTIL_FNV1A_INIT, buf, buf_len);
+    snprintf(pathname, sizeof(pathname), "%s/"XCC_UTIL_MAPS_BASELINE_PREFIX"%016"PRIx64 XCC_UTIL_MAPS_BASELINE_SUFFIX,
+             xc_common_log_dir, hash);
+
+    if (0 == access(pathname, F_OK)) {
+        //the same baseline has been saved, keep it as the newest one
+        utimensat(AT_FDCWD, pathname, NULL, 0);
+    } else {
+        //write to a temporary file first, the dumper never sees a partial baseline
+        snprintf(tmp_pathname, sizeof(tmp_pathname), "%s.tmp", pathname);
+        if (0 > (fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(tmp_pathname, O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644)))) {
+            r = XCC_ERRNO_SYS;
+            goto end;
+        }
+        r = xcc_util_write(fd, buf, buf_len);
+        close(fd);
+        if (0 == r && 0 != rename(tmp_pathname, pathname)) r = XCC_ERRNO_SYS;
+        if (0 != r) {
+            unlink(tmp_pathname);
+            goto end;
+        }
+    }
+
+    //only the pathname is changed under xc_crash_mutex, the crash handler is never blocked by the I/O above
+    pthread_mutex_lock(&xc_crash_mutex);
+    strncpy(xc_crash_maps_baseline_pathname, pathname, sizeof(xc_crash_maps_baseline_pathname) - 1);
+    xc_crash_spot.maps_baseline_pathname_len = strlen(xc_crash_maps_baseline_pathname);
+    pthread_mutex_unlock(&xc_crash_mutex);
+
+ end:
+    free(buf);
+    return r;
 }
 
 static void xc_crash_init_callback(JNIEnv *env) {
@@ -706,15 +895,24 @@ int xc_crash_init(JNIEnv *env,
                   unsigned int logcat_main_lines,
                   int dump_elf_hash,
                   int dump_map,
+                  int dump_map_delta,
+                  int dump_map_summary,
                   int dump_fds,
                   int dump_network_info,
                   int dump_all_threads,
                   unsigned int dump_all_threads_count_max,
                   const char **dump_all_threads_whitelist,
-                  size_t dump_all_threads_whitelist_len) {
+                  size_t dump_all_threads_whitelist_len,
+                  int dump_binary,
+                  int dump_proto,
+                  int dump_minidump,
+                  int compress_log,
+                  const char *compress_dict) {
 
     xc_crash_prepared_fd = XCC_UTIL_TEMP_FAILURE_RETRY(open("/dev/null", O_RDWR));
     xc_crash_rethrow = rethrow;
+    xc_crash_compress_log = compress_log;
+    xc_crash_dump_map_delta = (dump_map && dump_map_delta && !dump_map_summary);
 
     if (NULL == (xc_crash_emergency = calloc(XC_CRASH_EMERGENCY_BUF_LEN, 1)))
         return XCC_ERRNO_NOMEM;
@@ -741,11 +939,14 @@ int xc_crash_init(JNIEnv *env,
     xc_crash_spot.logcat_events_lines = logcat_events_lines;
     xc_crash_spot.logcat_main_lines = logcat_main_lines;
     xc_crash_spot.dump_elf_hash = dump_elf_hash;
-    xc_crash_spot.dump_map = dump_map;
+    xc_crash_spot.dump_map = (dump_map ? (dump_map_summary ? XCC_UTIL_DUMP_MAP_SUMMARY : XCC_UTIL_DUMP_MAP_FULL) : XCC_UTIL_DUMP_MAP_NONE);
     xc_crash_spot.dump_fds = dump_fds;
     xc_crash_spot.dump_network_info = dump_network_info;
     xc_crash_spot.dump_all_threads = dump_all_threads;
     xc_crash_spot.dump_all_threads_count_max = dump_all_threads_count_max;
+    xc_crash_spot.dump_binary = dump_binary;
+    xc_crash_spot.dump_proto = dump_proto;
+    xc_crash_spot.dump_minidump = dump_minidump;
     xc_crash_spot.os_version_len = strlen(xc_common_os_version);
     xc_crash_spot.kernel_version_len = strlen(xc_common_kernel_version);
     xc_crash_spot.abi_list_len = strlen(xc_common_abi_list);
@@ -755,9 +956,20 @@ int xc_crash_init(JNIEnv *env,
     xc_crash_spot.build_fingerprint_len = strlen(xc_common_build_fingerprint);
     xc_crash_spot.app_id_len = strlen(xc_common_app_id);
     xc_crash_spot.app_version_len = strlen(xc_common_app_version);
+
+    //the dictionary is only used when compressing the log file
+    //(in the lazy mode, it's saved by xc_crash_init_late() with the kernel version)
+    if (compress_log && NULL != compress_dict) {
+        if (NULL == (xc_crash_compress_dict = strdup(compress_dict))) return XCC_ERRNO_NOMEM;
+        xc_crash_spot.compress_dict_pathname_len = strlen(xc_crash_compress_dict);
+    }
     
-    xc_crash_init_dump_all_threads_whitelist(dump_all_threads_whitelist, 
-            dump_all_threads_whitelist_len);
+    xc_crash_dump_all_threads_whitelist = xc_crash_encode_threads_whitelist(
+            dump_all_threads_whitelist, dump_all_threads_whitelist_len,
+            &(xc_crash_spot.dump_all_threads_whitelist_len));
+
+    //the full memory map is recorded if the baseline is not saved
+    if (xc_crash_dump_map_delta && NULL != xc_common_log_dir) xc_crash_save_maps_baseline();
 
     //for clone and fork
 #ifndef __i386__
@@ -771,4 +983,199 @@ int xc_crash_init(JNIEnv *env,
     return xcc_signal_crash_register(xc_crash_signal_handler);
 }
 
+//called before xc_common_set_ready(), the crash handler doesn't read the spot until then
+int xc_crash_init_late(const char *compress_dict) {
+    xc_crash_spot.kernel_version_len = strlen(xc_common_kernel_version);
+
+    if (xc_crash_compress_log && NULL != compress_dict && NULL == xc_crash_compress_dict) {
+        if (NULL == (xc_crash_compress_dict = strdup(compress_dict))) return XCC_ERRNO_NOMEM;
+        xc_crash_spot.compress_dict_pathname_len = strlen(xc_crash_compress_dict);
+    }
+    return 0;
+}
+
+//spawn the dumper for the live process, the caller holds xc_crash_mutex
+//the spot is copied into the child (no CLONE_VM), it can be restored once this returns
+static int xc_crash_spawn_dumper(pid_t *dumper_pid, int *orig_dumpable, int *restore_orig_ptracer) {
+    //set dumpable and traceable
+    *orig_dumpable = prctl(PR_GET_DUMPABLE);
+    *restore_orig_ptracer = 0;
+    if (0 != prctl(PR_SET_DUMPABLE, 1)) return XCC_ERRNO_SYS;
+    if (0 == prctl(PR_SET_PTRACER, PR_SET_PTRACER_ANY)) {
+        *restore_orig_ptracer = 1;
+    } else if (EINVAL != errno) {
+        prctl(PR_SET_DUMPABLE, *orig_dumpable);
+        return XCC_ERRNO_SYS;
+    }
+
+    //spawn the dumper process
+    if (-1 == (*dumper_pid = xc_crash_fork(xc_crash_exec_dumper))) {
+        if (*restore_orig_ptracer) prctl(PR_SET_PTRACER, 0);
+        prctl(PR_SET_DUMPABLE, *orig_dumpable);
+        return XCC_ERRNO_SYS;
+    }
+    xc_crash_snapshot_dumper_pid = *dumper_pid;
+    return 0;
+}
+
+//wait for the dumper without xc_crash_mutex, so a crash on another thread is not blocked by it
+static int xc_crash_wait_dumper(pid_t dumper_pid, int orig_dumpable, int restore_orig_ptracer) {
+    siginfo_t info;
+    int       status = 0;
+    int       r = 0;
+
+    //keep the zombie until the pid is cleared, the crash handler may be killing it
+    if (0 != XCC_UTIL_TEMP_FAILURE_RETRY(waitid(P_PID, (id_t)dumper_pid, &info, WEXITED | WNOWAIT | __WALL)))
+        r = XCC_ERRNO_SYS;
+    xc_crash_snapshot_dumper_pid = 0;
+
+    if (-1 == XCC_UTIL_TEMP_FAILURE_RETRY(waitpid(dumper_pid, &status, __WALL))) {
+        r = XCC_ERRNO_SYS;
+    } else if (0 == r && (!WIFEXITED(status) || 0 != WEXITSTATUS(status))) {
+        r = XCC_ERRNO_UNKNOWN;
+    }
+
+    //the crash handler owns dumpable and traceable while it is running,
+    //wait for it (it only holds the lock briefly otherwise), the process is going away if it has crashed
+    pthread_mutex_lock(&xc_crash_mutex);
+    if (!xc_common_native_crashed) {
+        if (restore_orig_ptracer) prctl(PR_SET_PTRACER, 0);
+        prctl(PR_SET_DUMPABLE, orig_dumpable);
+    }
+    pthread_mutex_unlock(&xc_crash_mutex);
+    return r;
+}
+
+int xc_crash_dump_threads(const char **whitelist,
+                          size_t whitelist_len,
+                          unsigned int count_max,
+                          char *pathname,
+                          size_t pathname_len) {
+    struct timespec  tp;
+    char            *encoded_whitelist;
+    size_t           encoded_whitelist_len;
+    char            *orig_whitelist;
+    size_t           orig_whitelist_len;
+    unsigned int     orig_count_max;
+    int              log_fd;
+    pid_t            dumper_pid = -1;
+    int              orig_dumpable = 0;
+    int              restore_orig_ptracer = 0;
+    int              r = 0;
+
+    //the dumper is only available when native crash capturing is enabled
+    if (NULL == xc_crash_dumper_pathname) return XCC_ERRNO_STATE;
+
+    encoded_whitelist = xc_crash_encode_threads_whitelist(whitelist,
+            whitelist_len, &encoded_whitelist_len);
+
+    //one snapshot (or profile) at a time
+    pthread_mutex_lock(&xc_crash_snapshot_mutex);
+
+    //the spot and the child stack are shared with the crash handler, only held while spawning
+    pthread_mutex_lock(&xc_crash_mutex);
+
+    if (xc_common_native_crashed || xc_common_java_crashed) {
+        pthread_mutex_unlock(&xc_crash_mutex);
+        r = XCC_ERRNO_STATE;
+        goto end;
+    }
+
+    //create and open log file
+    clock_gettime(CLOCK_REALTIME, &tp);
+    xc_crash_spot.crash_time = (uint64_t)(tp.tv_sec) * 1000 * 1000 + (uint64_t)tp.tv_nsec / 1000;
+    if ((log_fd = xc_common_open_snapshot_log(pathname, pathname_len, xc_crash_spot.crash_time)) < 0) {
+        pthread_mutex_unlock(&xc_crash_mutex);
+        r = XCC_ERRNO_FD;
+        goto end;
+    }
+
+    //set snapshot spot info
+    orig_whitelist = xc_crash_dump_all_threads_whitelist;
+    orig_whitelist_len = xc_crash_spot.dump_all_threads_whitelist_len;
+    orig_count_max = xc_crash_spot.dump_all_threads_count_max;
+    xc_crash_dump_all_threads_whitelist = encoded_whitelist;
+    xc_crash_spot.dump_all_threads_whitelist_len = encoded_whitelist_len;
+    xc_crash_spot.dump_all_threads_count_max = count_max;
+    xc_crash_spot.snapshot = 1;
+    xc_crash_spot.crash_tid = 0;
+    strncpy(xc_crash_log_pathname, pathname, sizeof(xc_crash_log_pathname) - 1);
+    xc_crash_spot.log_pathname_len = strlen(xc_crash_log_pathname);
+    xc_crash_log_fd = log_fd;
+
+    r = xc_crash_spawn_dumper(&dumper_pid, &orig_dumpable, &restore_orig_ptracer);
+
+    //restore crash spot info
+    xc_crash_log_fd = -1;
+    xc_crash_log_pathname[0] = '\0';
+    xc_crash_spot.snapshot = 0;
+    xc_crash_spot.dump_all_threads_count_max = orig_count_max;
+    xc_crash_spot.dump_all_threads_whitelist_len = orig_whitelist_len;
+    xc_crash_dump_all_threads_whitelist = orig_whitelist;
+
+    pthread_mutex_unlock(&xc_crash_mutex);
+
+    if (0 == r) r = xc_crash_wait_dumper(dumper_pid, orig_dumpable, restore_orig_ptracer);
+
+    xc_common_close_trace_log(log_fd);
+    if (0 != r) unlink(pathname);
+
+ end:
+    pthread_mutex_unlock(&xc_crash_snapshot_mutex);
+    if (NULL != encoded_whitelist) free(encoded_whitelist);
+    return r;
+}
+
+int xc_crash_refresh_maps_baseline(void) {
+    int r;
+
+    if (!xc_crash_dump_map_delta) return XCC_ERRNO_STATE;
+
+    pthread_mutex_lock(&xc_crash_maps_mutex);
+    r = xc_crash_save_maps_baseline();
+    pthread_mutex_unlock(&xc_crash_maps_mutex);
+    return r;
+}
+
+int xc_crash_dump_profile(int log_fd, const char *pathname) {
+    pid_t dumper_pid = -1;
+    int   orig_dumpable = 0;
+    int   restore_orig_ptracer = 0;
+    int   r;
+
+    //the dumper is only available when native crash capturing is enabled
+    if (NULL == xc_crash_dumper_pathname) return XCC_ERRNO_STATE;
+
+    pthread_mutex_lock(&xc_crash_snapshot_mutex);
+    pthread_mutex_lock(&xc_crash_mutex);
+
+    if (xc_common_native_crashed || xc_common_java_crashed) {
+        pthread_mutex_unlock(&xc_crash_mutex);
+        r = XCC_ERRNO_STATE;
+        goto end;
+    }
+
+    //set profile spot info
+    xc_crash_spot.profile = 1;
+    xc_crash_spot.crash_tid = 0;
+    strncpy(xc_crash_log_pathname, pathname, sizeof(xc_crash_log_pathname) - 1);
+    xc_crash_spot.log_pathname_len = strlen(xc_crash_log_pathname);
+    xc_crash_log_fd = log_fd;
+
+    r = xc_crash_spawn_dumper(&dumper_pid, &orig_dumpable, &restore_orig_ptracer);
+
+    //restore crash spot info
+    xc_crash_log_fd = -1;
+    xc_crash_log_pathname[0] = '\0';
+    xc_crash_spot.profile = 0;
+
+    pthread_mutex_unlock(&xc_crash_mutex);
+
+    if (0 == r) r = xc_crash_wait_dumper(dumper_pid, orig_dumpable, restore_orig_ptracer);
+
+ end:
+    pthread_mutex_unlock(&xc_crash_snapshot_mutex);
+    return r;
+}
+
 #pragma clang diagnostic pop
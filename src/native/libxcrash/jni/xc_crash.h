@@ -39,12 +39,31 @@ int xc_crash_init(JNIEnv *env,
                   unsigned int logcat_main_lines,
                   int dump_elf_hash,
                   int dump_map,
+                  int dump_map_delta,
+                  int dump_map_summary,
                   int dump_fds,
                   int dump_network_info,
                   int dump_all_threads,
                   unsigned int dump_all_threads_count_max,
                   const char **dump_all_threads_whitelist,
-                  size_t dump_all_threads_whitelist_len);
+                  size_t dump_all_threads_whitelist_len,
+                  int dump_binary,
+                  int dump_proto,
+                  int dump_minidump,
+                  int compress_log,
+                  const char *compress_dict);
+
+int xc_crash_init_late(const char *compress_dict);
+
+int xc_crash_dump_threads(const char **whitelist,
+                          size_t whitelist_len,
+                          unsigned int count_max,
+                          char *pathname,
+                          size_t pathname_len);
+
+int xc_crash_dump_profile(int log_fd, const char *pathname);
+
+int xc_crash_refresh_maps_baseline(void);
 
 #ifdef __cplusplus
 }
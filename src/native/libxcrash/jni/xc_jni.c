@@ -35,6 +35,9 @@
 #include "xc_common.h"
 #include "xc_crash.h"
 #include "xc_trace.h"
+#include "xc_profile.h"
+#include "xc_archive.h"
+#include "xc_xz.h"
 #include "xc_util.h"
 #include "xc_test.h"
 
@@ -66,18 +69,26 @@ static jint xc_jni_init(JNIEnv*       env,
                         jint          crash_logcat_main_lines,
                         jboolean      crash_dump_elf_hash,
                         jboolean      crash_dump_map,
+                        jboolean      crash_dump_map_delta,
+                        jboolean      crash_dump_map_summary,
                         jboolean      crash_dump_fds,
                         jboolean      crash_dump_network_info,
                         jboolean      crash_dump_all_threads,
                         jint          crash_dump_all_threads_count_max,
                         jobjectArray  crash_dump_all_threads_whitelist,
+                        jboolean      crash_dump_binary,
+                        jboolean      crash_dump_proto,
+                        jboolean      crash_dump_minidump,
+                        jboolean      crash_compress_log,
+                        jstring       crash_compress_dict,
                         jboolean      trace_enable,
                         jboolean      trace_rethrow,
                         jint          trace_logcat_system_lines,
                         jint          trace_logcat_events_lines,
                         jint          trace_logcat_main_lines,
                         jboolean      trace_dump_fds,
-                        jboolean      trace_dump_network_info) {
+                        jboolean      trace_dump_network_info,
+                        jint          trace_thread_stat_interval_ms) {
 
     int              r_crash                               = XCC_ERRNO_JNI;
     int              r_trace                               = XCC_ERRNO_JNI;
@@ -92,6 +103,7 @@ static jint xc_jni_init(JNIEnv*       env,
     const char*     c_app_version                          = NULL;
     const char*     c_app_lib_dir                          = NULL;
     const char*     c_log_dir                              = NULL;
+    const char*     c_crash_compress_dict                  = NULL;
     
     const char**    c_crash_dump_all_threads_whitelist     = NULL;
     size_t          c_crash_dump_all_threads_whitelist_len = 0;
@@ -106,13 +118,14 @@ static jint xc_jni_init(JNIEnv*       env,
     if(xc_jni_inited) return XCC_ERRNO_JNI;
     xc_jni_inited = 1;
 
-    if (!env || !(*env) || (!crash_enable && ! trace_enable) || api_level < 0 ||
+    //the lazy mode may only load the library here, the trace is inited by xc_jni_init_late()
+    if (!env || !(*env) || (!crash_enable && ! trace_enable && log_dir) || api_level < 0 ||
             !os_version || !abi_list || !manufacturer || !brand || !model || !build_fingerprint ||
-            !app_id || !app_version || !app_lib_dir || !log_dir ||
+            !app_id || !app_version || !app_lib_dir ||
             crash_logcat_system_lines < 0 || crash_logcat_events_lines < 0 ||
             crash_logcat_main_lines < 0 || crash_dump_all_threads_count_max < 0 ||
             trace_logcat_system_lines < 0 || trace_logcat_events_lines < 0 ||
-            trace_logcat_main_lines < 0) {
+            trace_logcat_main_lines < 0 || trace_thread_stat_interval_ms < 0) {
 
         return XCC_ERRNO_INVAL;
     }
@@ -135,7 +148,8 @@ static jint xc_jni_init(JNIEnv*       env,
         goto clean;
     if (NULL == (c_app_lib_dir = (*env)->GetStringUTFChars(env, app_lib_dir, 0)))
         goto clean;
-    if (NULL == (c_log_dir = (*env)->GetStringUTFChars(env, log_dir, 0)))
+    //NULL in the lazy mode, see xc_jni_init_late()
+    if (log_dir && NULL == (c_log_dir = (*env)->GetStringUTFChars(env, log_dir, 0)))
         goto clean;
 
     //common init
@@ -175,6 +189,10 @@ static jint xc_jni_init(JNIEnv*       env,
             }
         }
 
+        if (crash_compress_dict) {
+            c_crash_compress_dict = (*env)->GetStringUTFChars(env, crash_compress_dict, 0);
+        }
+
         //crash init
         r_crash = xc_crash_init(env,
                                 crash_rethrow ? 1 : 0,
@@ -183,12 +201,19 @@ static jint xc_jni_init(JNIEnv*       env,
                                 (unsigned int)crash_logcat_main_lines,
                                 crash_dump_elf_hash ? 1 : 0,
                                 crash_dump_map ? 1 : 0,
+                                crash_dump_map_delta ? 1 : 0,
+                                crash_dump_map_summary ? 1 : 0,
                                 crash_dump_fds ? 1 : 0,
                                 crash_dump_network_info ? 1 : 0,
                                 crash_dump_all_threads ? 1 : 0,
                                 (unsigned int)crash_dump_all_threads_count_max,
                                 c_crash_dump_all_threads_whitelist,
-                                c_crash_dump_all_threads_whitelist_len);
+                                c_crash_dump_all_threads_whitelist_len,
+                                crash_dump_binary ? 1 : 0,
+                                crash_dump_proto ? 1 : 0,
+                                crash_dump_minidump ? 1 : 0,
+                                crash_compress_log ? 1 : 0,
+                                c_crash_compress_dict);
     }
     
     if (trace_enable) {
@@ -199,7 +224,8 @@ static jint xc_jni_init(JNIEnv*       env,
                             (unsigned int)trace_logcat_events_lines,
                             (unsigned int)trace_logcat_main_lines,
                             trace_dump_fds ? 1 : 0,
-                            trace_dump_network_info ? 1 : 0);
+                            trace_dump_network_info ? 1 : 0,
+                            (unsigned int)trace_thread_stat_interval_ms);
     }
     
  clean:
@@ -225,6 +251,9 @@ static jint xc_jni_init(JNIEnv*       env,
     if (log_dir && c_log_dir) {
         (*env)->ReleaseStringUTFChars(env, log_dir, c_log_dir);
     }
+    if (crash_compress_dict && c_crash_compress_dict) {
+        (*env)->ReleaseStringUTFChars(env, crash_compress_dict, c_crash_compress_dict);
+    }
 
     if (crash_dump_all_threads_whitelist && NULL != c_crash_dump_all_threads_whitelist) {
         for (i = 0; i < c_crash_dump_all_threads_whitelist_len; i++) {
@@ -242,6 +271,75 @@ static jint xc_jni_init(JNIEnv*       env,
     return (0 == r_crash && 0 == r_trace) ? 0 : XCC_ERRNO_JNI;
 }
 
+static jint xc_jni_init_late(JNIEnv*       env,
+                             jobject       thiz,
+                             jstring       log_dir,
+                             jstring       crash_compress_dict,
+                             jboolean      trace_enable,
+                             jboolean      trace_rethrow,
+                             jint          trace_logcat_system_lines,
+                             jint          trace_logcat_events_lines,
+                             jint          trace_logcat_main_lines,
+                             jboolean      trace_dump_fds,
+                             jboolean      trace_dump_network_info,
+                             jint          trace_thread_stat_interval_ms) {
+
+    int             r                     = XCC_ERRNO_JNI;
+    const char*     c_log_dir             = NULL;
+    const char*     c_crash_compress_dict = NULL;
+
+    (void) thiz;
+
+    //only once, after xc_jni_init() in the lazy mode
+    if (!xc_jni_inited || NULL != xc_common_log_dir) return XCC_ERRNO_STATE;
+
+    if (!env || !(*env) || !log_dir ||
+            trace_logcat_system_lines < 0 || trace_logcat_events_lines < 0 ||
+            trace_logcat_main_lines < 0 || trace_thread_stat_interval_ms < 0) {
+
+        return XCC_ERRNO_INVAL;
+    }
+
+    if (NULL == (c_log_dir = (*env)->GetStringUTFChars(env, log_dir, 0)))
+        goto clean;
+    if (crash_compress_dict && NULL == (c_crash_compress_dict = (*env)->GetStringUTFChars(env, crash_compress_dict, 0)))
+        goto clean;
+
+    //common init, the rest of it
+    if (0 != (r = xc_common_init_late(c_log_dir))) goto clean;
+
+    //crash init, the rest of it (the signal handler has been registered by xc_jni_init())
+    if (0 != (r = xc_crash_init_late(c_crash_compress_dict))) goto clean;
+
+    //the crash handler waiting for the log directory goes on from here
+    xc_common_set_ready();
+
+    //the baseline is not saved by xc_crash_init() without the log directory
+    xc_crash_refresh_maps_baseline();
+
+    if (trace_enable) {
+        //trace init
+        r = xc_trace_init(env,
+                          trace_rethrow ? 1 : 0,
+                          (unsigned int)trace_logcat_system_lines,
+                          (unsigned int)trace_logcat_events_lines,
+                          (unsigned int)trace_logcat_main_lines,
+                          trace_dump_fds ? 1 : 0,
+                          trace_dump_network_info ? 1 : 0,
+                          (unsigned int)trace_thread_stat_interval_ms);
+    }
+
+ clean:
+    if (log_dir && c_log_dir) {
+        (*env)->ReleaseStringUTFChars(env, log_dir, c_log_dir);
+    }
+    if (crash_compress_dict && c_crash_compress_dict) {
+        (*env)->ReleaseStringUTFChars(env, crash_compress_dict, c_crash_compress_dict);
+    }
+
+    return r;
+}
+
 static void xc_jni_notify_java_crashed(JNIEnv *env, jobject thiz) {
     (void)env;
     (void)thiz;
@@ -249,6 +347,272 @@ static void xc_jni_notify_java_crashed(JNIEnv *env, jobject thiz) {
     xc_common_java_crashed = 1;
 }
 
+static jint xc_jni_notify_anr_watchdog(JNIEnv *env, jobject thiz) {
+    (void)env;
+    (void)thiz;
+
+    return xc_trace_notify_watchdog();
+}
+
+static jstring xc_jni_dump_threads(JNIEnv      *env,
+                                   jobject      thiz,
+                                   jobjectArray whitelist,
+                                   jint         count_max) {
+    const char** c_whitelist     = NULL;
+    size_t       c_whitelist_len = 0;
+    char         pathname[1024];
+    jstring      j_pathname      = NULL;
+    size_t       len, i;
+    jstring      tmp_str;
+    const char*  tmp_c_str;
+
+    (void)thiz;
+
+    if (count_max < 0) return NULL;
+
+    if (whitelist) {
+        len = (size_t)(*env)->GetArrayLength(env, whitelist);
+        if (len > 0) {
+            if (NULL != (c_whitelist = calloc(len, sizeof(char*)))) {
+                c_whitelist_len = len;
+                for (i = 0; i < len; i++) {
+                    tmp_str = (jstring)((*env)->GetObjectArrayElement(env, whitelist, (jsize)i));
+                    c_whitelist[i] = (tmp_str ? (*env)->GetStringUTFChars(env, tmp_str, 0) : NULL);
+                }
+            }
+        }
+    }
+
+    if (0 == xc_crash_dump_threads(c_whitelist, c_whitelist_len,
+            (unsigned int)count_max, pathname, sizeof(pathname))) {
+        j_pathname = (*env)->NewStringUTF(env, pathname);
+        XC_JNI_IGNORE_PENDING_EXCEPTION();
+    }
+
+    if (whitelist && NULL != c_whitelist) {
+        for (i = 0; i < c_whitelist_len; i++) {
+            tmp_str = (jstring)((*env)->GetObjectArrayElement(env, whitelist, (jsize)i));
+            tmp_c_str = c_whitelist[i];
+            if (tmp_str && NULL != tmp_c_str) {
+                (*env)->ReleaseStringUTFChars(env, tmp_str, tmp_c_str);
+            }
+        }
+        free(c_whitelist);
+    }
+
+    return j_pathname;
+}
+
+static jint xc_jni_refresh_maps_baseline(JNIEnv *env, jobject thiz) {
+    (void)env;
+    (void)thiz;
+
+    return xc_crash_refresh_maps_baseline();
+}
+
+static jint xc_jni_start_profile(JNIEnv *env, jobject thiz, jint frequency, jint duration_ms_max) {
+    (void)thiz;
+
+    if (frequency < 0 || duration_ms_max < 0) return XCC_ERRNO_INVAL;
+
+    return xc_profile_start(env, (unsigned int)frequency, (unsigned int)duration_ms_max);
+}
+
+static jstring xc_jni_stop_profile(JNIEnv *env, jobject thiz) {
+    char    pathname[1024];
+    jstring j_pathname = NULL;
+
+    (void)thiz;
+
+    if (0 == xc_profile_stop(pathname, sizeof(pathname))) {
+        j_pathname = (*env)->NewStringUTF(env, pathname);
+        XC_JNI_IGNORE_PENDING_EXCEPTION();
+    }
+
+    return j_pathname;
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wpadded"
+typedef struct {
+    JNIEnv    *env;
+    jobject    progress;
+    jmethodID  method;
+} xc_jni_archive_progress_t;
+#pragma clang diagnostic pop
+
+static int xc_jni_archive_progress(void *arg, uint64_t processed_size, uint64_t total_size) {
+    xc_jni_archive_progress_t *self = (xc_jni_archive_progress_t *)arg;
+    JNIEnv                    *env = self->env;
+    jboolean                   r;
+
+    //return false from the Java callback to cancel
+    r = (*env)->CallBooleanMethod(env, self->progress, self->method, (jlong)processed_size, (jlong)total_size);
+    XC_JNI_IGNORE_PENDING_EXCEPTION();
+    return r ? 0 : 1;
+}
+
+static jint xc_jni_archive_logs(JNIEnv       *env,
+                                jobject       thiz,
+                                jobjectArray  log_pathnames,
+                                jstring       archive_pathname,
+                                jint          threads,
+                                jlong         memory_limit,
+                                jobject       progress) {
+    const char**              c_log_pathnames     = NULL;
+    size_t                    c_log_pathnames_len = 0;
+    const char*               c_archive_pathname  = NULL;
+    xc_jni_archive_progress_t c_progress;
+    jclass                    cls;
+    size_t                    i;
+    jstring                   tmp_str;
+    const char*               tmp_c_str;
+    jint                      r = XCC_ERRNO_JNI;
+
+    (void)thiz;
+
+    if (!log_pathnames || !archive_pathname || threads < 0 || memory_limit < 0) return XCC_ERRNO_INVAL;
+
+    if (progress) {
+        c_progress.env = env;
+        c_progress.progress = progress;
+        cls = (*env)->GetObjectClass(env, progress);
+        XC_JNI_CHECK_NULL_AND_PENDING_EXCEPTION(cls, end);
+        c_progress.method = (*env)->GetMethodID(env, cls, "onProgress", "(JJ)Z");
+        XC_JNI_CHECK_NULL_AND_PENDING_EXCEPTION(c_progress.method, end);
+    }
+
+    if (0 == (c_log_pathnames_len = (size_t)(*env)->GetArrayLength(env, log_pathnames))) {
+        r = XCC_ERRNO_INVAL;
+        goto end;
+    }
+    if (NULL == (c_log_pathnames = calloc(c_log_pathnames_len, sizeof(char*)))) {
+        r = XCC_ERRNO_NOMEM;
+        goto end;
+    }
+    for (i = 0; i < c_log_pathnames_len; i++) {
+        tmp_str = (jstring)((*env)->GetObjectArrayElement(env, log_pathnames, (jsize)i));
+        c_log_pathnames[i] = (tmp_str ? (*env)->GetStringUTFChars(env, tmp_str, 0) : NULL);
+        if (tmp_str) (*env)->DeleteLocalRef(env, tmp_str);
+    }
+    if (NULL == (c_archive_pathname = (*env)->GetStringUTFChars(env, archive_pathname, 0))) goto end;
+
+    r = xc_archive_create(c_log_pathnames, c_log_pathnames_len, c_archive_pathname,
+                          (unsigned int)threads, (uint64_t)memory_limit,
+                          progress ? xc_jni_archive_progress : NULL, &c_progress);
+
+ end:
+    if (NULL != c_archive_pathname) (*env)->ReleaseStringUTFChars(env, archive_pathname, c_archive_pathname);
+    if (NULL != c_log_pathnames) {
+        for (i = 0; i < c_log_pathnames_len; i++) {
+            tmp_str = (jstring)((*env)->GetObjectArrayElement(env, log_pathnames, (jsize)i));
+            tmp_c_str = c_log_pathnames[i];
+            if (tmp_str && NULL != tmp_c_str) {
+                (*env)->ReleaseStringUTFChars(env, tmp_str, tmp_c_str);
+            }
+            if (tmp_str) (*env)->DeleteLocalRef(env, tmp_str);
+        }
+        free(c_log_pathnames);
+    }
+    return r;
+}
+
+static jint xc_jni_render_binary_log(JNIEnv *env, jobject thiz, jstring src_pathname, jstring dst_pathname) {
+    const char *c_src_pathname = NULL;
+    const char *c_dst_pathname = NULL;
+    jint        r = XCC_ERRNO_JNI;
+
+    (void)thiz;
+
+    if (!src_pathname || !dst_pathname) return XCC_ERRNO_INVAL;
+
+    if (NULL == (c_src_pathname = (*env)->GetStringUTFChars(env, src_pathname, 0))) goto end;
+    if (NULL == (c_dst_pathname = (*env)->GetStringUTFChars(env, dst_pathname, 0))) goto end;
+
+    r = xc_common_render_binary_log(c_src_pathname, c_dst_pathname);
+
+ end:
+    if (NULL != c_src_pathname) (*env)->ReleaseStringUTFChars(env, src_pathname, c_src_pathname);
+    if (NULL != c_dst_pathname) (*env)->ReleaseStringUTFChars(env, dst_pathname, c_dst_pathname);
+    return r;
+}
+
+static jbyteArray xc_jni_xz_decompress(JNIEnv *env, jobject thiz, jbyteArray data, jbyteArray dict) {
+    jbyte      *c_data = NULL;
+    jbyte      *c_dict = NULL;
+    uint8_t    *dst = NULL;
+    size_t      dst_size = 0;
+    jbyteArray  result = NULL;
+
+    (void)thiz;
+
+    if (!data) return NULL;
+
+    if (NULL == (c_data = (*env)->GetByteArrayElements(env, data, NULL))) goto end;
+    if (dict && NULL == (c_dict = (*env)->GetByteArrayElements(env, dict, NULL))) goto end;
+
+    if (0 != xc_xz_decompress((const uint8_t *)c_data, (size_t)(*env)->GetArrayLength(env, data),
+                              (const uint8_t *)c_dict, c_dict ? (size_t)(*env)->GetArrayLength(env, dict) : 0,
+                              &dst, &dst_size)) goto end;
+
+    if (NULL == (result = (*env)->NewByteArray(env, (jsize)dst_size))) goto end;
+    (*env)->SetByteArrayRegion(env, result, 0, (jsize)dst_size, (const jbyte *)dst);
+
+ end:
+    if (NULL != c_data) (*env)->ReleaseByteArrayElements(env, data, c_data, JNI_ABORT);
+    if (NULL != c_dict) (*env)->ReleaseByteArrayElements(env, dict, c_dict, JNI_ABORT);
+    if (NULL != dst) free(dst);
+    return result;
+}
+
+static jint xc_jni_xz_append(JNIEnv *env, jobject thiz, jstring pathname, jbyteArray data) {
+    const char *c_pathname = NULL;
+    jbyte      *c_data = NULL;
+    jint        r = XCC_ERRNO_JNI;
+
+    (void)thiz;
+
+    if (!pathname || !data) return XCC_ERRNO_INVAL;
+
+    if (NULL == (c_pathname = (*env)->GetStringUTFChars(env, pathname, 0))) goto end;
+    if (NULL == (c_data = (*env)->GetByteArrayElements(env, data, NULL))) goto end;
+
+    r = xc_xz_append(c_pathname, (const uint8_t *)c_data, (size_t)(*env)->GetArrayLength(env, data));
+
+ end:
+    if (NULL != c_pathname) (*env)->ReleaseStringUTFChars(env, pathname, c_pathname);
+    if (NULL != c_data) (*env)->ReleaseByteArrayElements(env, data, c_data, JNI_ABORT);
+    return r;
+}
+
+static jint xc_jni_record_java_crash(JNIEnv  *env,
+                                     jobject  thiz,
+                                     jstring  log_pathname,
+                                     jint     logcat_system_lines,
+                                     jint     logcat_events_lines,
+                                     jint     logcat_main_lines,
+                                     jboolean dump_fds,
+                                     jboolean dump_network_info) {
+    const char *c_log_pathname = NULL;
+    jint        r;
+
+    (void)thiz;
+
+    if (!log_pathname || logcat_system_lines < 0 || logcat_events_lines < 0 || logcat_main_lines < 0) return XCC_ERRNO_INVAL;
+
+    if (NULL == (c_log_pathname = (*env)->GetStringUTFChars(env, log_pathname, 0))) return XCC_ERRNO_JNI;
+
+    r = xc_common_record_java_crash_sections(c_log_pathname,
+                                             (unsigned int)logcat_system_lines,
+                                             (unsigned int)logcat_events_lines,
+                                             (unsigned int)logcat_main_lines,
+                                             JNI_TRUE == dump_fds ? 1 : 0,
+                                             JNI_TRUE == dump_network_info ? 1 : 0);
+
+    (*env)->ReleaseStringUTFChars(env, log_pathname, c_log_pathname);
+    return r;
+}
+
 static void xc_jni_test_crash(JNIEnv *env, jobject thiz, jint run_in_new_thread) {
     (void)env;
     (void)thiz;
@@ -281,19 +645,44 @@ static JNINativeMethod xc_jni_methods[] = {
         "Z"
         "Z"
         "Z"
+        "Z"
+        "Z"
         "I"
         "[Ljava/lang/String;"
         "Z"
         "Z"
+        "Z"
+        "Z"
+        "Ljava/lang/String;"
+        "Z"
+        "Z"
         "I"
         "I"
         "I"
         "Z"
         "Z"
+        "I"
         ")"
         "I",
         (void*) xc_jni_init
     },
+    {
+        "nativeInitLate",
+        "("
+        "Ljava/lang/String;"
+        "Ljava/lang/String;"
+        "Z"
+        "Z"
+        "I"
+        "I"
+        "I"
+        "Z"
+        "Z"
+        "I"
+        ")"
+        "I",
+        (void*) xc_jni_init_late
+    },
     {
         "nativeNotifyJavaCrashed",
         "("
@@ -301,6 +690,97 @@ static JNINativeMethod xc_jni_methods[] = {
         "V",
         (void*) xc_jni_notify_java_crashed
     },
+    {
+        "nativeNotifyAnrWatchdog",
+        "("
+        ")"
+        "I",
+        (void*) xc_jni_notify_anr_watchdog
+    },
+    {
+        "nativeDumpThreads",
+        "("
+        "[Ljava/lang/String;"
+        "I"
+        ")"
+        "Ljava/lang/String;",
+        (void*) xc_jni_dump_threads
+    },
+    {
+        "nativeRefreshMapsBaseline",
+        "("
+        ")"
+        "I",
+        (void*) xc_jni_refresh_maps_baseline
+    },
+    {
+        "nativeStartProfile",
+        "("
+        "I"
+        "I"
+        ")"
+        "I",
+        (void*) xc_jni_start_profile
+    },
+    {
+        "nativeStopProfile",
+        "("
+        ")"
+        "Ljava/lang/String;",
+        (void*) xc_jni_stop_profile
+    },
+    {
+        "nativeRenderBinaryLog",
+        "("
+        "Ljava/lang/String;"
+        "Ljava/lang/String;"
+        ")"
+        "I",
+        (void*) xc_jni_render_binary_log
+    },
+    {
+        "nativeXzDecompress",
+        "("
+        "[B"
+        "[B"
+        ")"
+        "[B",
+        (void*) xc_jni_xz_decompress
+    },
+    {
+        "nativeXzAppend",
+        "("
+        "Ljava/lang/String;"
+        "[B"
+        ")"
+        "I",
+        (void*) xc_jni_xz_append
+    },
+    {
+        "nativeArchiveLogs",
+        "("
+        "[Ljava/lang/String;"
+        "Ljava/lang/String;"
+        "I"
+        "J"
+        "Lxcrash/IArchiveProgress;"
+        ")"
+        "I",
+        (void*) xc_jni_archive_logs
+    },
+    {
+        "nativeRecordJavaCrash",
+        "("
+        "Ljava/lang/String;"
+        "I"
+        "I"
+        "I"
+        "Z"
+        "Z"
+        ")"
+        "I",
+        (void*) xc_jni_record_java_crash
+    },
     {
         "nativeTestCrash",
         "("
@@ -0,0 +1,463 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Created by agent on 2026-10-17.
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wreserved-id-macro"
+#define _GNU_SOURCE
+#pragma clang diagnostic pop
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <pthread.h>
+#include <ucontext.h>
+#include <sys/syscall.h>
+#include "xcc_errno.h"
+#include "xcc_util.h"
+#include "xcc_signal.h"
+#include "xcc_manifest.h"
+#include "xcc_profile.h"
+#include "xc_profile.h"
+#include "xc_common.h"
+#include "xc_crash.h"
+#include "xc_jni.h"
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wgnu-statement-expression"
+
+#define XC_PROFILE_CALLBACK_METHOD_NAME      "profileCallback"
+#define XC_PROFILE_CALLBACK_METHOD_SIGNATURE "()Ljava/lang/String;"
+
+#define XC_PROFILE_FREQUENCY_DEFAULT     100
+#define XC_PROFILE_FREQUENCY_MAX         1000
+#define XC_PROFILE_DURATION_MS_DEFAULT   (10 * 1000)
+#define XC_PROFILE_DURATION_MS_MAX       (30 * 1000)
+
+//samples in flight between the signal handler and the sampler thread
+#define XC_PROFILE_RING_SLOTS            32
+
+//the raw samples are folded when stopping, stop sampling before they take more space than this
+#define XC_PROFILE_LOG_SIZE_MAX          (32 * 1024 * 1024)
+
+//tags the ticks sent by the sampler thread, all the other SIGPROFs are chained to the previous action
+#define XC_PROFILE_TICK_MAGIC            0x78637066
+
+//how long to wait for the ticks still pending on the main thread before unregistering the handler
+#define XC_PROFILE_UNREGISTER_WAIT_MS    100
+
+//skip ticks while the time spent in the signal handler is above this (per mille of the wall time)
+#define XC_PROFILE_OVERHEAD_PERMILLE_MAX 20
+
+static pthread_mutex_t       xc_profile_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int                   xc_profile_handler_registered = 0;
+static int                   xc_profile_started = 0;
+static pthread_t             xc_profile_thd;
+static int                   xc_profile_log_fd = -1;
+static size_t                xc_profile_log_size = 0;
+static char                  xc_profile_log_pathname[1024];
+static xcc_profile_header_t  xc_profile_header;
+static uint64_t              xc_profile_start_time; //us, monotonic
+static uint64_t              xc_profile_duration_max; //us
+static siginfo_t             xc_profile_tick;
+static uintptr_t             xc_profile_stack_end;
+static jmethodID             xc_profile_cb_method = NULL;
+
+//shared with the signal handler
+static xcc_profile_sample_t *xc_profile_ring = NULL;
+static uint32_t              xc_profile_ring_head = 0; //written by the signal handler
+static uint32_t              xc_profile_ring_tail = 0; //written by the sampler thread
+static int                   xc_profile_active = 0;
+static int                   xc_profile_handler_busy = 0;
+static uint64_t              xc_profile_handler_time = 0;
+static int                   xc_profile_stop_requested = 0;
+static uint32_t              xc_profile_ticks_sent = 0; //written by the sampler thread
+static uint32_t              xc_profile_ticks_handled = 0; //written by the signal handler
+
+static uint64_t xc_profile_get_monotonic_us(void) {
+    struct timespec ts;
+
+    if (0 != clock_gettime(CLOCK_MONOTONIC, &ts)) return 0;
+    return (uint64_t)ts.tv_sec * 1000 * 1000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static uintptr_t xc_profile_get_sp(ucontext_t *uc) {
+#if defined(__arm__)
+    return (uintptr_t)uc->uc_mcontext.arm_sp;
+#elif defined(__aarch64__)
+    return (uintptr_t)uc->uc_mcontext.sp;
+#elif defined(__i386__)
+    return (uintptr_t)uc->uc_mcontext.gregs[REG_ESP];
+#elif defined(__x86_64__)
+    return (uintptr_t)uc->uc_mcontext.gregs[REG_RSP];
+#endif
+}
+
+//the main thread's stack is the "[stack]" mapping, it only grows downward
+static uintptr_t xc_profile_get_main_stack_end(void) {
+    FILE      *fp;
+    char       line[512];
+    uintptr_t  start, end;
+    uintptr_t  r = 0;
+
+    if (NULL == (fp = fopen("/proc/self/maps", "re"))) return 0;
+    while (fgets(line, sizeof(line), fp)) {
+        if (NULL == strstr(line, "[stack]")) continue;
+        if (2 == sscanf(line, "%"SCNxPTR"-%"SCNxPTR, &start, &end)) r = end;
+        break;
+    }
+    fclose(fp);
+    return r;
+}
+
+static void xc_profile_signal_handler(int sig, siginfo_t *si, void *uc) {
+    int                   errno_saved = errno;
+    uint64_t              begin;
+    uint32_t              head, tail;
+    xcc_profile_sample_t *sample;
+    uintptr_t             sp;
+
+    __atomic_add_fetch(&xc_profile_handler_busy, 1, __ATOMIC_ACQ_REL);
+
+    //only the ticks sent by the sampler thread are handled, the others go to the previous action
+    if (SI_QUEUE != si->si_code || xc_common_process_id != si->si_pid
+        || XC_PROFILE_TICK_MAGIC != si->si_value.sival_int) {
+        xcc_signal_profile_chain(sig, si, uc);
+        goto end;
+    }
+    __atomic_add_fetch(&xc_profile_ticks_handled, 1, __ATOMIC_RELEASE);
+    if (!__atomic_load_n(&xc_profile_active, __ATOMIC_ACQUIRE)) goto end;
+
+    begin = xc_profile_get_monotonic_us();
+
+    head = __atomic_load_n(&xc_profile_ring_head, __ATOMIC_RELAXED);
+    tail = __atomic_load_n(&xc_profile_ring_tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= XC_PROFILE_RING_SLOTS) goto end; //should not happen, the sampler thread checks it before sending
+
+    //copy registers and the used part of the stack
+    sample = &(xc_profile_ring[head % XC_PROFILE_RING_SLOTS]);
+    sample->time = begin;
+    memcpy(&(sample->uc), uc, sizeof(ucontext_t));
+    sample->java_len = 0;
+    sp = xc_profile_get_sp((ucontext_t *)uc);
+    if (sp < xc_profile_stack_end && xc_profile_stack_end - sp <= 8 * 1024 * 1024) {
+        sample->stack_addr = sp;
+        sample->stack_len = xc_profile_stack_end - sp;
+        if (sample->stack_len > XCC_PROFILE_STACK_SIZE) sample->stack_len = XCC_PROFILE_STACK_SIZE;
+        memcpy(sample->stack, (void *)sp, sample->stack_len);
+    } else {
+        sample->stack_addr = 0;
+        sample->stack_len = 0;
+    }
+    __atomic_store_n(&xc_profile_ring_head, head + 1, __ATOMIC_RELEASE);
+
+    __atomic_add_fetch(&xc_profile_handler_time, xc_profile_get_monotonic_us() - begin, __ATOMIC_RELAXED);
+
+ end:
+    __atomic_sub_fetch(&xc_profile_handler_busy, 1, __ATOMIC_ACQ_REL);
+    errno = errno_saved;
+}
+
+//move all the finished samples from the ring to the log file
+static void xc_profile_drain(void) {
+    uint32_t              head, tail;
+    xcc_profile_sample_t *sample;
+
+    head = __atomic_load_n(&xc_profile_ring_head, __ATOMIC_ACQUIRE);
+    tail = __atomic_load_n(&xc_profile_ring_tail, __ATOMIC_RELAXED);
+    while (tail != head) {
+        sample = &(xc_profile_ring[tail % XC_PROFILE_RING_SLOTS]);
+        if (0 == xcc_util_write(xc_profile_log_fd, (const char *)sample, XCC_PROFILE_SAMPLE_HEAD_LEN + sample->stack_len)
+            && 0 == xcc_util_write(xc_profile_log_fd, sample->java, sample->java_len)) {
+            xc_profile_header.samples++;
+            xc_profile_log_size += XCC_PROFILE_SAMPLE_HEAD_LEN + sample->stack_len + sample->java_len;
+        } else
+            xc_profile_header.dropped++;
+        tail++;
+        __atomic_store_n(&xc_profile_ring_tail, tail, __ATOMIC_RELEASE);
+    }
+}
+
+//take the main thread's Java stack right after the native sample, ART pauses the main thread at its next suspend point
+static void xc_profile_record_java(JNIEnv *env, uint32_t head, uint64_t wait_us) {
+    xcc_profile_sample_t *sample;
+    jstring               j_stack;
+    const char           *chars;
+    const char           *stack;
+    size_t                len;
+    uint64_t              begin;
+
+    //wait for the signal handler, the main thread may not be scheduled at once
+    begin = xc_profile_get_monotonic_us();
+    while (__atomic_load_n(&xc_profile_ticks_handled, __ATOMIC_ACQUIRE) != __atomic_load_n(&xc_profile_ticks_sent, __ATOMIC_ACQUIRE)) {
+        if (xc_profile_get_monotonic_us() - begin >= wait_us) return;
+        usleep(100);
+    }
+    if (__atomic_load_n(&xc_profile_ring_head, __ATOMIC_ACQUIRE) != head + 1) return; //the handler did not record it
+    sample = &(xc_profile_ring[head % XC_PROFILE_RING_SLOTS]);
+
+    begin = xc_profile_get_monotonic_us();
+    j_stack = (*env)->CallStaticObjectMethod(env, xc_common_cb_class, xc_profile_cb_method);
+    XC_JNI_IGNORE_PENDING_EXCEPTION();
+    if (NULL != j_stack) {
+        if (NULL != (chars = (*env)->GetStringUTFChars(env, j_stack, NULL))) {
+            //keep the innermost frames if it is too long
+            stack = chars;
+            len = strlen(stack);
+            if (len >= XCC_PROFILE_JAVA_SIZE) {
+                stack += len - (XCC_PROFILE_JAVA_SIZE - 1);
+                while ('\0' != *stack && ';' != *stack) stack++;
+                if (';' == *stack) stack++;
+                len = strlen(stack);
+            }
+            memcpy(sample->java, stack, len);
+            sample->java_len = len;
+            (*env)->ReleaseStringUTFChars(env, j_stack, chars);
+        }
+        (*env)->DeleteLocalRef(env, j_stack);
+    }
+    xc_profile_header.java_time += xc_profile_get_monotonic_us() - begin;
+}
+
+static void *xc_profile_sampler(void *arg) {
+    struct timespec next;
+    uint64_t        period_ns = 1000000000ULL / xc_profile_header.frequency;
+    uint64_t        now, elapsed, handler_time;
+    uint32_t        head, tail;
+    JNIEnv         *env = NULL;
+
+    (void)arg;
+
+    pthread_detach(pthread_self());
+    pthread_setname_np(pthread_self(), "xcrash_profile");
+
+    //the Java stacks are only taken if the callback is available
+    JavaVMAttachArgs attach_args = {
+        .version = XC_JNI_VERSION,
+        .name    = "xcrash_profile",
+        .group   = NULL
+    };
+    if (NULL == xc_profile_cb_method || JNI_OK != (*xc_common_vm)->AttachCurrentThread(xc_common_vm, &env, &attach_args))
+        env = NULL;
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (!__atomic_load_n(&xc_profile_stop_requested, __ATOMIC_ACQUIRE)) {
+        //wait for the next tick
+        next.tv_nsec += (long)period_ns;
+        while (next.tv_nsec >= 1000000000) {
+            next.tv_sec++;
+            next.tv_nsec -= 1000000000;
+        }
+        while (EINTR == clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL));
+
+        now = xc_profile_get_monotonic_us();
+        elapsed = now - xc_profile_start_time;
+        if (elapsed >= xc_profile_duration_max) break;
+
+        //the samples in flight may take the whole stack size, they must all fit in the log file
+        head = __atomic_load_n(&xc_profile_ring_head, __ATOMIC_ACQUIRE);
+        tail = __atomic_load_n(&xc_profile_ring_tail, __ATOMIC_RELAXED);
+        if (xc_profile_log_size + (head - tail + 1) * sizeof(xcc_profile_sample_t) > XC_PROFILE_LOG_SIZE_MAX) {
+            xc_profile_header.truncated = 1;
+            break;
+        }
+
+        //keep the overhead of the main thread bounded (it is paused while its Java stack is taken)
+        handler_time = __atomic_load_n(&xc_profile_handler_time, __ATOMIC_RELAXED) + xc_profile_header.java_time;
+        if (handler_time * 1000 > elapsed * XC_PROFILE_OVERHEAD_PERMILLE_MAX) {
+            xc_profile_header.skipped++;
+        } else if (head - tail >= XC_PROFILE_RING_SLOTS) {
+            xc_profile_header.dropped++;
+        } else if (0 == syscall(SYS_rt_tgsigqueueinfo, xc_common_process_id, xc_common_process_id, SIGPROF, &xc_profile_tick)) {
+            __atomic_add_fetch(&xc_profile_ticks_sent, 1, __ATOMIC_RELEASE);
+            if (NULL != env) xc_profile_record_java(env, head, period_ns / 1000 / 2);
+        }
+
+        xc_profile_drain();
+    }
+
+    if (NULL != env) (*xc_common_vm)->DetachCurrentThread(xc_common_vm);
+    __atomic_store_n(&xc_profile_active, 0, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void xc_profile_init_callback(JNIEnv *env) {
+    if (NULL == xc_common_cb_class) return;
+
+    xc_profile_cb_method = (*env)->GetStaticMethodID(env,
+            xc_common_cb_class, XC_PROFILE_CALLBACK_METHOD_NAME,
+            XC_PROFILE_CALLBACK_METHOD_SIGNATURE);
+
+    XC_JNI_CHECK_NULL_AND_PENDING_EXCEPTION(xc_profile_cb_method, err);
+    return;
+
+ err:
+    xc_profile_cb_method = NULL;
+}
+
+int xc_profile_start(JNIEnv *env, unsigned int frequency, unsigned int duration_ms_max) {
+    struct timespec tp;
+    int             r = 0;
+
+    if (0 != xc_common_wait_ready()) return XCC_ERRNO_STATE;
+
+    if (0 == frequency) frequency = XC_PROFILE_FREQUENCY_DEFAULT;
+    if (frequency > XC_PROFILE_FREQUENCY_MAX) frequency = XC_PROFILE_FREQUENCY_MAX;
+    if (0 == duration_ms_max) duration_ms_max = XC_PROFILE_DURATION_MS_DEFAULT;
+    if (duration_ms_max > XC_PROFILE_DURATION_MS_MAX) duration_ms_max = XC_PROFILE_DURATION_MS_MAX;
+
+    pthread_mutex_lock(&xc_profile_mutex);
+
+    if (xc_profile_started) {
+        r = XCC_ERRNO_STATE;
+        goto end;
+    }
+
+    if (NULL == xc_profile_cb_method) xc_profile_init_callback(env);
+
+    if (0 == (xc_profile_stack_end = xc_profile_get_main_stack_end())) {
+        r = XCC_ERRNO_NOTFND;
+        goto end;
+    }
+
+    if (NULL == xc_profile_ring) {
+        if (NULL == (xc_profile_ring = calloc(XC_PROFILE_RING_SLOTS, sizeof(xcc_profile_sample_t)))) {
+            r = XCC_ERRNO_NOMEM;
+            goto end;
+        }
+    }
+
+    //the handler stays registered if a tick of the previous profile is still pending
+    if (!xc_profile_handler_registered) {
+        if (0 != (r = xcc_signal_profile_register(xc_profile_signal_handler))) goto end;
+        xc_profile_handler_registered = 1;
+    }
+
+    //create the log file, the header is rewritten when stopping
+    clock_gettime(CLOCK_REALTIME, &tp);
+    memset(&xc_profile_header, 0, sizeof(xc_profile_header));
+    xc_profile_header.magic = XCC_PROFILE_MAGIC;
+    xc_profile_header.frequency = frequency;
+    xc_profile_header.pid = xc_common_process_id;
+    xc_profile_header.tid = xc_common_process_id;
+    xc_profile_header.start_time = (uint64_t)(tp.tv_sec) * 1000 * 1000 + (uint64_t)tp.tv_nsec / 1000;
+    if ((xc_profile_log_fd = xc_common_open_profile_log(xc_profile_log_pathname,
+            sizeof(xc_profile_log_pathname), xc_profile_header.start_time)) < 0) {
+        r = XCC_ERRNO_FD;
+        goto end;
+    }
+    if (0 != (r = xcc_util_write(xc_profile_log_fd, (const char *)&xc_profile_header, sizeof(xc_profile_header)))) goto err;
+    xc_profile_log_size = sizeof(xc_profile_header);
+
+    //start sampling
+    xc_profile_start_time = xc_profile_get_monotonic_us();
+    xc_profile_duration_max = (uint64_t)duration_ms_max * 1000;
+    xc_profile_ring_head = 0;
+    xc_profile_ring_tail = 0;
+    xc_profile_handler_time = 0;
+    xc_profile_stop_requested = 0;
+    memset(&xc_profile_tick, 0, sizeof(xc_profile_tick));
+    xc_profile_tick.si_signo = SIGPROF;
+    xc_profile_tick.si_code = SI_QUEUE;
+    xc_profile_tick.si_pid = xc_common_process_id;
+    xc_profile_tick.si_uid = getuid();
+    xc_profile_tick.si_value.sival_int = XC_PROFILE_TICK_MAGIC;
+    __atomic_store_n(&xc_profile_active, 1, __ATOMIC_RELEASE);
+    if (0 != pthread_create(&xc_profile_thd, NULL, xc_profile_sampler, NULL)) {
+        __atomic_store_n(&xc_profile_active, 0, __ATOMIC_RELEASE);
+        r = XCC_ERRNO_SYS;
+        goto err;
+    }
+
+    xc_profile_started = 1;
+    goto end;
+
+ err:
+    close(xc_profile_log_fd);
+    xc_profile_log_fd = -1;
+    unlink(xc_profile_log_pathname);
+ end:
+    pthread_mutex_unlock(&xc_profile_mutex);
+    return r;
+}
+
+int xc_profile_stop(char *pathname, size_t pathname_len) {
+    int i;
+    int r = 0;
+
+    pthread_mutex_lock(&xc_profile_mutex);
+
+    if (!xc_profile_started) {
+        r = XCC_ERRNO_STATE;
+        goto end;
+    }
+    xc_profile_started = 0;
+
+    //wait for the sampler thread and any signal handler still running
+    __atomic_store_n(&xc_profile_stop_requested, 1, __ATOMIC_RELEASE);
+    while (__atomic_load_n(&xc_profile_active, __ATOMIC_ACQUIRE)) usleep(1000);
+    for (i = 0; i < XC_PROFILE_UNREGISTER_WAIT_MS; i++) {
+        if (__atomic_load_n(&xc_profile_ticks_handled, __ATOMIC_ACQUIRE) == __atomic_load_n(&xc_profile_ticks_sent, __ATOMIC_ACQUIRE)) break;
+        usleep(1000);
+    }
+    while (__atomic_load_n(&xc_profile_handler_busy, __ATOMIC_ACQUIRE)) usleep(1000);
+    xc_profile_drain();
+
+    //give SIGPROF back to the previous action, unless a tick is still pending (the main thread is stuck)
+    if (__atomic_load_n(&xc_profile_ticks_handled, __ATOMIC_ACQUIRE) == __atomic_load_n(&xc_profile_ticks_sent, __ATOMIC_ACQUIRE)) {
+        xcc_signal_profile_unregister();
+        xc_profile_handler_registered = 0;
+    }
+
+    //update the header
+    xc_profile_header.duration = xc_profile_get_monotonic_us() - xc_profile_start_time;
+    xc_profile_header.handler_time = xc_profile_handler_time;
+    if ((ssize_t)sizeof(xc_profile_header) != pwrite(xc_profile_log_fd, &xc_profile_header, sizeof(xc_profile_header), 0)) {
+        r = XCC_ERRNO_SYS;
+        goto err;
+    }
+
+    //unwind and fold the samples in the dumper process
+    if (0 != (r = xc_crash_dump_profile(xc_profile_log_fd, xc_profile_log_pathname))) goto err;
+
+    close(xc_profile_log_fd);
+    xc_profile_log_fd = -1;
+    xcc_manifest_add(xc_profile_log_pathname, XCC_UTIL_CRASH_TYPE_PROFILE, xc_profile_header.start_time, 0);
+    strncpy(pathname, xc_profile_log_pathname, pathname_len - 1);
+    pathname[pathname_len - 1] = '\0';
+    goto end;
+
+ err:
+    close(xc_profile_log_fd);
+    xc_profile_log_fd = -1;
+    unlink(xc_profile_log_pathname);
+ end:
+    pthread_mutex_unlock(&xc_profile_mutex);
+    return r;
+}
+
+#pragma clang diagnostic pop
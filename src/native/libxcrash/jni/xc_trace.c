@@ -21,10 +21,17 @@
 
 // Created by caikelun on 2019-08-13.
 
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wreserved-id-macro"
+#define _GNU_SOURCE
+#pragma clang diagnostic pop
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <time.h>
+#include <fcntl.h>
 #include <pthread.h>
 #include <inttypes.h>
 #include <errno.h>
@@ -36,8 +43,12 @@
 #include <android/log.h>
 #include "xcc_errno.h"
 #include "xcc_util.h"
+#include "xcc_index.h"
+#include "xcc_manifest.h"
 #include "xcc_signal.h"
 #include "xcc_meminfo.h"
+#include "xcc_threadstat.h"
+#include "xcc_pressure.h"
 #include "xcc_version.h"
 #include "xc_trace.h"
 #include "xc_common.h"
@@ -50,13 +61,38 @@
 #pragma clang diagnostic ignored "-Wgnu-statement-expression"
 
 #define XC_TRACE_CALLBACK_METHOD_NAME      "traceCallback"
-#define XC_TRACE_CALLBACK_METHOD_SIGNATURE "(Ljava/lang/String;Ljava/lang/String;)V"
+#define XC_TRACE_CALLBACK_METHOD_SIGNATURE "(Ljava/lang/String;Ljava/lang/String;Z)V"
 
 #define XC_TRACE_SIGNAL_CATCHER_TID_UNLOAD    (-2)
 #define XC_TRACE_SIGNAL_CATCHER_TID_UNKNOWN   (-1)
 #define XC_TRACE_SIGNAL_CATCHER_THREAD_NAME   "Signal Catcher"
 #define XC_TRACE_SIGNAL_CATCHER_THREAD_SIGBLK 0x1000
 
+//SIGQUITs arriving within this interval after the previous SIGQUIT trace are coalesced into it
+#define XC_TRACE_MIN_INTERVAL_US              (1 * 1000 * 1000)
+//only the ART runtime dump is recorded for traces within this interval after the previous full SIGQUIT one
+#define XC_TRACE_FULL_INTERVAL_US             (10 * 1000 * 1000)
+
+//values added to the notifier, the eventfd sums them up until the dumper reads it
+#define XC_TRACE_NOTIFY_SIGQUIT               1
+#define XC_TRACE_NOTIFY_WATCHDOG              (1 << 16)
+
+#define XC_TRACE_CAPTURE_PIPE_SIZE            (1024 * 1024)
+#define XC_TRACE_CAPTURE_BUF_SIZE_INIT        (256 * 1024)
+#define XC_TRACE_CAPTURE_BUF_SIZE_MAX         (16 * 1024 * 1024)
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wpadded"
+typedef struct {
+    int        fd;
+    pthread_t  thd;
+    char      *buf;
+    size_t     buf_len;
+    size_t     buf_cap;
+    size_t     dropped;
+} xc_trace_capture_t;
+#pragma clang diagnostic pop
+
 static int xc_trace_is_lollipop = 0;
 static pid_t xc_trace_signal_catcher_tid = XC_TRACE_SIGNAL_CATCHER_TID_UNLOAD;
 
@@ -76,11 +112,19 @@ static unsigned int                     xc_trace_logcat_events_lines;
 static unsigned int                     xc_trace_logcat_main_lines;
 static int                              xc_trace_dump_fds;
 static int                              xc_trace_dump_network_info;
+static unsigned int                     xc_trace_thread_stat_interval_ms;
 
 //callback
 static jmethodID                        xc_trace_cb_method = NULL;
 static int                              xc_trace_notifier = -1;
 
+//trace scheduling (monotonic time in microseconds)
+static uint64_t                         xc_trace_last_time = 0;
+static uint64_t                         xc_trace_last_full_time = 0;
+
+//in-memory capture of the ART runtime dump
+static xc_trace_capture_t               xc_trace_capture = {.fd = -1, .buf = NULL, .buf_len = 0, .buf_cap = 0, .dropped = 0};
+
 xc_trace_dump_status_t xc_trace_dump_status = XC_TRACE_DUMP_NOT_START;
 sigjmp_buf jmpenv;
 
@@ -261,8 +305,10 @@ static int xc_trace_check_address_valid() {
     return r;
 }
 
-static int xc_trace_logs_filter(const struct dirent* entry) {
+//the SIGQUIT traces and the watchdog traces are kept in their own slots
+static int xc_trace_logs_match(const struct dirent* entry, int watchdog) {
     size_t len;
+    int    is_watchdog;
     
     if(DT_REG != entry->d_type) return 0;
 
@@ -277,16 +323,28 @@ static int xc_trace_logs_filter(const struct dirent* entry) {
             XC_COMMON_LOG_SUFFIX_TRACE, XC_COMMON_LOG_SUFFIX_TRACE_LEN))
         return 0;
 
-    return 1;
+    is_watchdog = ((len >= XC_COMMON_LOG_SUFFIX_WATCHDOG_LEN &&
+            0 == memcmp(entry->d_name + (len - XC_COMMON_LOG_SUFFIX_WATCHDOG_LEN),
+                    XC_COMMON_LOG_SUFFIX_WATCHDOG, XC_COMMON_LOG_SUFFIX_WATCHDOG_LEN)) ? 1 : 0);
+
+    return (is_watchdog == watchdog) ? 1 : 0;
+}
+
+static int xc_trace_logs_filter(const struct dirent* entry) {
+    return xc_trace_logs_match(entry, 0);
 }
 
-static int xc_trace_logs_clean(void) {
+static int xc_trace_logs_filter_watchdog(const struct dirent* entry) {
+    return xc_trace_logs_match(entry, 1);
+}
+
+static int xc_trace_logs_clean(int watchdog) {
     struct dirent **entry_list;
     char            pathname[1024];
     int             n, i, r = 0;
 
     if (0 > (n = scandir(xc_common_log_dir, &entry_list,
-            xc_trace_logs_filter, alphasort)))
+            watchdog ? xc_trace_logs_filter_watchdog : xc_trace_logs_filter, alphasort)))
         return XCC_ERRNO_SYS;
 
     for(i = 0; i < n; i++) {
@@ -294,6 +352,11 @@ static int xc_trace_logs_clean(void) {
                 xc_common_log_dir, entry_list[i]->d_name);
 
         if(0 != unlink(pathname)) r = XCC_ERRNO_SYS;
+        xcc_manifest_remove(pathname);
+
+        //the section index goes with the log file
+        strncat(pathname, XCC_INDEX_SUFFIX, sizeof(pathname) - strlen(pathname) - 1);
+        unlink(pathname);
     }
     free(entry_list);
     return r;
@@ -324,11 +387,121 @@ static int xc_trace_write_header(int fd, uint64_t trace_time) {
             xc_common_process_id, xc_common_process_name);
 }
 
+static uint64_t xc_trace_get_monotonic_us(void) {
+    struct timespec ts;
+
+    if(0 != clock_gettime(CLOCK_MONOTONIC, &ts)) return 0;
+    return (uint64_t)ts.tv_sec * 1000 * 1000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static void *xc_trace_capture_drainer(void *arg) {
+    xc_trace_capture_t *cap = (xc_trace_capture_t *)arg;
+    char                discard[4096];
+    char               *buf;
+    size_t              new_cap;
+    ssize_t             n;
+
+    while(1) {
+        //grow the buffer when it is full
+        if(cap->buf_len == cap->buf_cap && cap->buf_cap < XC_TRACE_CAPTURE_BUF_SIZE_MAX) {
+            new_cap = (0 == cap->buf_cap ? XC_TRACE_CAPTURE_BUF_SIZE_INIT : cap->buf_cap * 2);
+            if(NULL != (buf = realloc(cap->buf, new_cap))) {
+                cap->buf = buf;
+                cap->buf_cap = new_cap;
+            }
+        }
+
+        //keep draining even if the buffer is exhausted, the runtime must never block on us
+        if(cap->buf_len < cap->buf_cap) {
+            n = XCC_UTIL_TEMP_FAILURE_RETRY(read(cap->fd, cap->buf + cap->buf_len, cap->buf_cap - cap->buf_len));
+            if(n <= 0) break;
+            cap->buf_len += (size_t)n;
+        } else {
+            n = XCC_UTIL_TEMP_FAILURE_RETRY(read(cap->fd, discard, sizeof(discard)));
+            if(n <= 0) break;
+            cap->dropped += (size_t)n;
+        }
+    }
+
+    return NULL;
+}
+
+//redirect stderr into a pipe, which is drained into memory by a second thread
+static int xc_trace_capture_start(void) {
+    int pipefd[2];
+    int r;
+
+    xc_trace_capture.buf_len = 0;
+    xc_trace_capture.dropped = 0;
+
+    if(0 != pipe2(pipefd, O_CLOEXEC)) return XCC_ERRNO_SYS;
+
+    //the larger the pipe, the fewer times the runtime gets scheduled out
+    fcntl(pipefd[1], F_SETPIPE_SZ, XC_TRACE_CAPTURE_PIPE_SIZE);
+
+    xc_trace_capture.fd = pipefd[0];
+    if(0 != pthread_create(&xc_trace_capture.thd, NULL, xc_trace_capture_drainer, &xc_trace_capture)) {
+        r = XCC_ERRNO_NOMEM;
+        goto err;
+    }
+
+    if(dup2(pipefd[1], STDERR_FILENO) < 0) {
+        r = XCC_ERRNO_SYS;
+        close(pipefd[1]);
+        pthread_join(xc_trace_capture.thd, NULL);
+        goto end;
+    }
+    close(pipefd[1]);
+    return 0;
+
+ err:
+    close(pipefd[1]);
+ end:
+    close(pipefd[0]);
+    xc_trace_capture.fd = -1;
+    return r;
+}
+
+//stderr must have been redirected elsewhere before this, so that the drainer gets EOF
+static int xc_trace_capture_finish(int fd) {
+    int r = 0;
+
+    if(xc_trace_capture.fd < 0) return XCC_ERRNO_STATE;
+
+    pthread_join(xc_trace_capture.thd, NULL);
+    close(xc_trace_capture.fd);
+    xc_trace_capture.fd = -1;
+
+    if(xc_trace_capture.buf_len > 0)
+        if(0 != (r = xcc_util_write(fd, xc_trace_capture.buf, xc_trace_capture.buf_len))) return r;
+
+    if(xc_trace_capture.dropped > 0)
+        r = xcc_util_write_format(fd, "\n(%zu bytes of runtime dump truncated)\n", xc_trace_capture.dropped);
+
+    //release the memory when the dump was unusually large
+    if(xc_trace_capture.buf_cap > XC_TRACE_CAPTURE_BUF_SIZE_INIT) {
+        free(xc_trace_capture.buf);
+        xc_trace_capture.buf = NULL;
+        xc_trace_capture.buf_cap = 0;
+    }
+    xc_trace_capture.buf_len = 0;
+
+    return r;
+}
+
 static void *xc_trace_dumper(void *arg) {
     JNIEnv         *env = NULL;
     uint64_t        data;
+    int             sigquit;
     uint64_t        trace_time;
     int             fd;
+    int             captured;
+    int             rethrown;
+    int             cheap;
+    xcc_pressure_t *pressure;
+    uint64_t        now;
+    uint64_t        dump_start;
+    uint64_t        dump_time;
     struct timeval  tv;
     char            pathname[1024];
     jstring         j_pathname;
@@ -348,24 +521,47 @@ static void *xc_trace_dumper(void *arg) {
         goto exit;
 
     while(1) {
-        //block here, waiting for sigquit
+        //block here, waiting for sigquit or the ANR watchdog
+        data = XC_TRACE_NOTIFY_SIGQUIT;
         XCC_UTIL_TEMP_FAILURE_RETRY(read(xc_trace_notifier, &data, sizeof(data)));
         
         //check if process already crashed
         if(xc_common_native_crashed || xc_common_java_crashed) break;
 
+        //only the SIGQUIT is handed over to ART Signal Catcher, the watchdog is our own business
+        sigquit = ((0 != data % XC_TRACE_NOTIFY_WATCHDOG) ? 1 : 0);
+
+        //coalesce SIGQUITs which are too close to the previous SIGQUIT trace,
+        //but still hand them over to ART Signal Catcher
+        //(a watchdog trace never swallows a SIGQUIT, the system ANR needs its own trace and state check)
+        now = xc_trace_get_monotonic_us();
+        if(0 != xc_trace_last_time && now - xc_trace_last_time < XC_TRACE_MIN_INTERVAL_US) {
+            if(xc_trace_rethrow && sigquit) xc_trace_send_sigquit();
+            continue;
+        }
+
+        //follow-up traces in a short window only record the ART runtime dump
+        cheap = ((0 != xc_trace_last_full_time && now - xc_trace_last_full_time < XC_TRACE_FULL_INTERVAL_US) ? 1 : 0);
+
         //trace time
         if(0 != gettimeofday(&tv, NULL)) break;
         trace_time = (uint64_t)(tv.tv_sec) * 1000 * 1000 + (uint64_t)tv.tv_usec;
 
-        //Keep only one current trace.
-        if(0 != xc_trace_logs_clean()) continue;
+        //Keep only one current trace in each slot, a watchdog trace never deletes a SIGQUIT one.
+        if(0 != xc_trace_logs_clean(!sigquit)) continue;
 
         //create and open log file
-        if((fd = xc_common_open_trace_log(pathname,
-                sizeof(pathname), trace_time)) < 0)
+        if((fd = (sigquit ? xc_common_open_trace_log(pathname, sizeof(pathname), trace_time) :
+                  xc_common_open_watchdog_log(pathname, sizeof(pathname), trace_time))) < 0)
             continue;
 
+        captured = 0;
+        rethrown = 0;
+
+        //start collecting the system pressure while ART is dumping
+        pressure = NULL;
+        if (!cheap) xcc_pressure_create(&pressure);
+
         //write header info
         if(0 != xc_trace_write_header(fd, trace_time)) goto end;
 
@@ -376,6 +572,8 @@ static void *xc_trace_dumper(void *arg) {
 
         if (0 != xcc_util_write_str(fd, "Mode: ART DumpForSigQuit\n"))
             goto end;
+        if (0 != xcc_util_write_format(fd, "Trigger: %s\n", sigquit ? "SIGQUIT" : "watchdog"))
+            goto end;
         if (0 != xc_trace_load_symbols()) {
             if(0 != xcc_util_write_str(fd, "Failed to load symbols.\n"))
                 goto end;
@@ -386,12 +584,17 @@ static void *xc_trace_dumper(void *arg) {
                 goto end;
             goto skip;
         }
-        if (dup2(fd, STDERR_FILENO) < 0) {
+
+        //capture the runtime dump in memory, fall back to writing the log file directly
+        if (0 == xc_trace_capture_start()) {
+            captured = 1;
+        } else if (dup2(fd, STDERR_FILENO) < 0) {
             if(0 != xcc_util_write_str(fd, "Failed to duplicate FD.\n")) goto end;
             goto skip;
         }
 
         xc_trace_dump_status = XC_TRACE_DUMP_ON_GOING;
+        dump_start = xc_trace_get_monotonic_us();
         if (sigsetjmp(jmpenv, 1) == 0) {
             if (xc_trace_is_lollipop)
                 xc_trace_libart_dbg_suspend();
@@ -406,13 +609,31 @@ static void *xc_trace_dumper(void *arg) {
             fflush(NULL);
             XCD_LOG_WARN("longjmp to skip dumping trace\n");
         }
+        dump_time = xc_trace_get_monotonic_us() - dump_start;
 
         dup2(xc_common_fd_null, STDERR_FILENO);
-                            
+
+        //rethrow SIGQUIT to ART Signal Catcher before any disk I/O
+        if (xc_trace_rethrow && sigquit && (XC_TRACE_DUMP_ART_CRASH != xc_trace_dump_status)) {
+            xc_trace_send_sigquit();
+            rethrown = 1;
+        }
+
+        //persist the captured runtime dump
+        if (captured) {
+            if (0 != xc_trace_capture_finish(fd)) goto end;
+        }
+        if (0 != xcc_util_write_format(fd, "\nDump time: %"PRIu64".%03"PRIu64" ms\n",
+                dump_time / 1000, dump_time % 1000))
+            goto end;
+
     skip:
         if (0 != xcc_util_write_str(fd, "\n"XCC_UTIL_THREAD_END"\n"))
             goto end;
 
+        //skip the expensive parts for follow-up traces
+        if (cheap) goto end;
+
         //write other info
         if (0 != xcc_util_record_logcat(fd, xc_common_process_id,
                 xc_common_api_level, xc_trace_logcat_system_lines,
@@ -428,25 +649,40 @@ static void *xc_trace_dumper(void *arg) {
                 goto end;
             }
         }
+        if (0 != xcc_threadstat_record(fd, xc_common_process_id,
+                xc_trace_thread_stat_interval_ms, XCC_THREADSTAT_TOP_N)) {
+            goto end;
+        }
+        if (0 != xcc_pressure_record(pressure, fd))
+            goto end;
         if (0 != xcc_meminfo_record(fd, xc_common_process_id))
             goto end;
 
     end:
         //close log file
         xc_common_close_trace_log(fd);
+        xcc_pressure_destroy(&pressure);
+
+        //section index of the log file
+        xcc_index_build(pathname);
+        xcc_manifest_add(pathname, XCC_UTIL_CRASH_TYPE_TRACE, trace_time, 0);
 
-        //rethrow SIGQUIT to ART Signal Catcher
-        if (xc_trace_rethrow && (XC_TRACE_DUMP_ART_CRASH != xc_trace_dump_status))
+        //rethrow SIGQUIT to ART Signal Catcher (if it has not been done yet)
+        if (xc_trace_rethrow && sigquit && !rethrown && (XC_TRACE_DUMP_ART_CRASH != xc_trace_dump_status))
             xc_trace_send_sigquit();
         xc_trace_dump_status = XC_TRACE_DUMP_END;
 
+        //save the time when this trace finished, only the SIGQUITs are coalesced
+        if (sigquit) xc_trace_last_time = xc_trace_get_monotonic_us();
+        if (sigquit && !cheap) xc_trace_last_full_time = now;
+
         //JNI callback
         //Do we need to implement an emergency buffer for disk exhausted?
         if(NULL == xc_trace_cb_method) continue;
         if(NULL == (j_pathname = (*env)->NewStringUTF(env, pathname))) continue;
 
         (*env)->CallStaticVoidMethod(env, xc_common_cb_class,
-                xc_trace_cb_method, j_pathname, NULL);
+                xc_trace_cb_method, j_pathname, NULL, sigquit ? JNI_FALSE : JNI_TRUE);
         XC_JNI_IGNORE_PENDING_EXCEPTION();
         (*env)->DeleteLocalRef(env, j_pathname);
     }
@@ -467,11 +703,19 @@ static void xc_trace_handler(int sig, siginfo_t *si, void *uc) {
     (void)uc;
 
     if(xc_trace_notifier >= 0) {
-        data = 1;
+        data = XC_TRACE_NOTIFY_SIGQUIT;
         XCC_UTIL_TEMP_FAILURE_RETRY(write(xc_trace_notifier, &data, sizeof(data)));
     }
 }
 
+int xc_trace_notify_watchdog(void) {
+    uint64_t data = XC_TRACE_NOTIFY_WATCHDOG;
+
+    if(xc_trace_notifier < 0) return XCC_ERRNO_STATE;
+    if(sizeof(data) != XCC_UTIL_TEMP_FAILURE_RETRY(write(xc_trace_notifier, &data, sizeof(data)))) return XCC_ERRNO_SYS;
+    return 0;
+}
+
 static void xc_trace_init_callback(JNIEnv *env) {
     if(NULL == xc_common_cb_class) return;
     
@@ -490,7 +734,8 @@ int xc_trace_init(JNIEnv *env, int rethrow,
                   unsigned int logcat_system_lines,
                   unsigned int logcat_events_lines,
                   unsigned int logcat_main_lines,
-                  int dump_fds, int dump_network_info) {
+                  int dump_fds, int dump_network_info,
+                  unsigned int thread_stat_interval_ms) {
 
     int r;
     pthread_t thd;
@@ -509,6 +754,7 @@ int xc_trace_init(JNIEnv *env, int rethrow,
     xc_trace_logcat_main_lines = logcat_main_lines;
     xc_trace_dump_fds = dump_fds;
     xc_trace_dump_network_info = dump_network_info;
+    xc_trace_thread_stat_interval_ms = thread_stat_interval_ms;
 
     //init for JNI callback
     xc_trace_init_callback(env);
@@ -49,7 +49,11 @@ int xc_trace_init(JNIEnv *env,
                   unsigned int logcat_events_lines,
                   unsigned int logcat_main_lines,
                   int dump_fds,
-                  int dump_network_info);
+                  int dump_network_info,
+                  unsigned int thread_stat_interval_ms);
+
+//dump the trace of this process without SIGQUIT, for the main thread blocked too long
+int xc_trace_notify_watchdog(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,310 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// Created by agent on 2026-10-17.
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include "xcc_errno.h"
+#include "xcc_util.h"
+#include "xc_xz.h"
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wreserved-id-macro"
+#pragma clang diagnostic ignored "-Wpadded"
+#include "7zCrc.h"
+#include "Xz.h"
+#include "XzCrc64.h"
+#include "XzEnc.h"
+#include "Lzma2Dec.h"
+#pragma clang diagnostic pop
+
+//the preset dictionary member (see "xcd_util_xz_compress_dict()" in "xcd_util.c"):
+//magic(6) + dictionary ID(4) + dictionary size(4) + LZMA2 dictionary size(1) + LZMA2 chunks + CRC32 of the data(4)
+#define XC_XZ_DICT_HEADER_LEN    15
+#define XC_XZ_DICT_CHECK_LEN     4
+
+//the dictionary is fed to the LZMA2 decoder as stored chunks, the first one resets the decoder dictionary
+#define XC_XZ_STORED_CHUNK_MAX   0x10000
+#define XC_XZ_STORED_RESET_DIC   1
+#define XC_XZ_STORED             2
+
+//the appended text is small, so is the dictionary
+#define XC_XZ_APPEND_DICT_SIZE   (1 << 16)
+
+static const uint8_t xc_xz_dict_magic[6] = {0xFD, 'X', 'C', 'D', 'Z', 0x00};
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wpadded"
+typedef struct {
+    uint8_t *buf;
+    size_t   len;
+    size_t   cap;
+} xc_xz_out_t;
+
+typedef struct {
+    ISeqInStream   in;
+    const uint8_t *data;
+    size_t         remaining;
+} xc_xz_in_t;
+
+typedef struct {
+    ISeqOutStream out;
+    int           fd;
+    int           r;
+} xc_xz_file_t;
+#pragma clang diagnostic pop
+
+static pthread_once_t xc_xz_crc_once = PTHREAD_ONCE_INIT;
+
+static void xc_xz_crc_init(void) {
+    CrcGenerateTable();
+    Crc64GenerateTable();
+}
+
+static void *xc_xz_alloc(ISzAllocPtr p, size_t size) {
+    (void)p;
+    return malloc(size);
+}
+
+static void xc_xz_free(ISzAllocPtr p, void *address) {
+    (void)p;
+    free(address);
+}
+
+static uint32_t xc_xz_get_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+//make sure there is some free space at the end of the output buffer
+static int xc_xz_out_reserve(xc_xz_out_t *out) {
+    uint8_t *buf;
+    size_t   cap;
+
+    if (out->len < out->cap) return 0;
+
+    cap = (0 == out->cap ? 64 * 1024 : out->cap * 2);
+    if (NULL == (buf = realloc(out->buf, cap))) return XCC_ERRNO_NOMEM;
+    out->buf = buf;
+    out->cap = cap;
+    return 0;
+}
+
+//decode the LZMA2 chunks in src, *src_used is set to the number of bytes consumed
+static int xc_xz_lzma2_decode(CLzma2Dec *dec, const uint8_t *src, size_t src_size, size_t *src_used,
+                              xc_xz_out_t *out, ELzmaStatus *status) {
+    SizeT src_len, dst_len;
+    int   r;
+
+    *src_used = 0;
+    while (1) {
+        if (0 != (r = xc_xz_out_reserve(out))) return r;
+
+        src_len = src_size - *src_used;
+        dst_len = out->cap - out->len;
+        if (SZ_OK != Lzma2Dec_DecodeToBuf(dec, out->buf + out->len, &dst_len, src + *src_used, &src_len,
+                                          LZMA_FINISH_ANY, status)) return XCC_ERRNO_FORMAT;
+        *src_used += src_len;
+        out->len += dst_len;
+
+        if (LZMA_STATUS_FINISHED_WITH_MARK == *status) return 0;
+        if (out->len < out->cap && (*src_used == src_size || (0 == src_len && 0 == dst_len))) return 0;
+    }
+}
+
+static int xc_xz_decode_dict_member(const uint8_t *src, size_t src_size, size_t *src_used,
+                                    const uint8_t *dict, size_t dict_size, xc_xz_out_t *out) {
+    ISzAlloc     alloc = {.Alloc = xc_xz_alloc, .Free = xc_xz_free};
+    CLzma2Dec    dec;
+    ELzmaStatus  status;
+    uint8_t     *stored = NULL;
+    size_t       stored_len = 0, pos, n, used, out_start = out->len;
+    int          r;
+
+    if (src_size < XC_XZ_DICT_HEADER_LEN || src[14] > 40) return XCC_ERRNO_FORMAT;
+    if (NULL == dict || xc_xz_get_le32(src + 10) != dict_size) return XCC_ERRNO_MISSING;
+    if (xc_xz_get_le32(src + 6) != CrcCalc(dict, dict_size)) return XCC_ERRNO_MISSING;
+
+    //the dictionary as stored chunks
+    if (NULL == (stored = malloc(dict_size + (dict_size / XC_XZ_STORED_CHUNK_MAX + 1) * 3))) return XCC_ERRNO_NOMEM;
+    for (pos = 0; pos < dict_size; pos += n) {
+        n = (dict_size - pos > XC_XZ_STORED_CHUNK_MAX ? XC_XZ_STORED_CHUNK_MAX : dict_size - pos);
+        stored[stored_len++] = (0 == pos ? XC_XZ_STORED_RESET_DIC : XC_XZ_STORED);
+        stored[stored_len++] = (uint8_t)((n - 1) >> 8);
+        stored[stored_len++] = (uint8_t)((n - 1) & 0xFF);
+        memcpy(stored + stored_len, dict + pos, n);
+        stored_len += n;
+    }
+
+    Lzma2Dec_Construct(&dec);
+    if (SZ_OK != Lzma2Dec_Allocate(&dec, src[14], &alloc)) {
+        free(stored);
+        return XCC_ERRNO_NOMEM;
+    }
+    Lzma2Dec_Init(&dec);
+
+    //the dictionary first, then the data, the first chunk of the data doesn't reset the dictionary
+    if (0 != (r = xc_xz_lzma2_decode(&dec, stored, stored_len, &used, out, &status))) goto end;
+    if (out->len - out_start != dict_size) {
+        r = XCC_ERRNO_FORMAT;
+        goto end;
+    }
+    if (0 != (r = xc_xz_lzma2_decode(&dec, src + XC_XZ_DICT_HEADER_LEN, src_size - XC_XZ_DICT_HEADER_LEN,
+                                     &used, out, &status))) goto end;
+    if (LZMA_STATUS_FINISHED_WITH_MARK != status) {
+        r = XCC_ERRNO_FORMAT;
+        goto end;
+    }
+
+    //drop the dictionary, then check the data
+    memmove(out->buf + out_start, out->buf + out_start + dict_size, out->len - out_start - dict_size);
+    out->len -= dict_size;
+    pos = XC_XZ_DICT_HEADER_LEN + used;
+    if (src_size - pos < XC_XZ_DICT_CHECK_LEN ||
+        xc_xz_get_le32(src + pos) != CrcCalc(out->buf + out_start, out->len - out_start)) {
+        r = XCC_ERRNO_FORMAT;
+        goto end;
+    }
+    *src_used = pos + XC_XZ_DICT_CHECK_LEN;
+
+ end:
+    Lzma2Dec_Free(&dec, &alloc);
+    free(stored);
+    return r;
+}
+
+//the concatenated streams and the stream padding are handled by the unpacker
+static int xc_xz_decode_streams(const uint8_t *src, size_t src_size, xc_xz_out_t *out) {
+    ISzAlloc     alloc = {.Alloc = xc_xz_alloc, .Free = xc_xz_free};
+    CXzUnpacker  state;
+    ECoderStatus status;
+    SizeT        src_len, dst_len;
+    size_t       pos = 0;
+    int          r = 0;
+
+    XzUnpacker_Construct(&state, &alloc);
+    XzUnpacker_Init(&state);
+    while (1) {
+        if (0 != (r = xc_xz_out_reserve(out))) break;
+
+        src_len = src_size - pos;
+        dst_len = out->cap - out->len;
+        if (SZ_OK != XzUnpacker_Code(&state, out->buf + out->len, &dst_len, src + pos, &src_len,
+                                     1, CODER_FINISH_ANY, &status)) {
+            r = XCC_ERRNO_FORMAT;
+            break;
+        }
+        pos += src_len;
+        out->len += dst_len;
+
+        if (out->len < out->cap && (pos == src_size || (0 == src_len && 0 == dst_len))) {
+            if (!XzUnpacker_IsStreamWasFinished(&state)) r = XCC_ERRNO_FORMAT;
+            break;
+        }
+    }
+    XzUnpacker_Free(&state);
+    return r;
+}
+
+int xc_xz_decompress(const uint8_t *src, size_t src_size, const uint8_t *dict, size_t dict_size,
+                     uint8_t **dst, size_t *dst_size) {
+    xc_xz_out_t out = {.buf = NULL, .len = 0, .cap = 0};
+    size_t      pos = 0;
+    int         r = 0;
+
+    pthread_once(&xc_xz_crc_once, xc_xz_crc_init);
+
+    //the preset dictionary member can only be the first one
+    if (src_size >= sizeof(xc_xz_dict_magic) && 0 == memcmp(src, xc_xz_dict_magic, sizeof(xc_xz_dict_magic))) {
+        if (0 != (r = xc_xz_decode_dict_member(src, src_size, &pos, dict, dict_size, &out))) goto end;
+
+        //stream padding
+        while (pos < src_size && 0 == src[pos]) pos++;
+    }
+
+    //the XZ streams, including the ones appended after the crash
+    if (pos < src_size || NULL == out.buf)
+        r = xc_xz_decode_streams(src + pos, src_size - pos, &out);
+
+ end:
+    if (0 != r) {
+        free(out.buf);
+        return r;
+    }
+    *dst = out.buf;
+    *dst_size = out.len;
+    return 0;
+}
+
+static SRes xc_xz_read(const ISeqInStream *p, void *buf, size_t *size) {
+    xc_xz_in_t *self = (xc_xz_in_t *)((uintptr_t)p - offsetof(xc_xz_in_t, in));
+
+    if (*size > self->remaining) *size = self->remaining;
+    memcpy(buf, self->data, *size);
+    self->data += *size;
+    self->remaining -= *size;
+    return SZ_OK;
+}
+
+static size_t xc_xz_write(const ISeqOutStream *p, const void *buf, size_t size) {
+    xc_xz_file_t *self = (xc_xz_file_t *)((uintptr_t)p - offsetof(xc_xz_file_t, out));
+
+    if (0 != (self->r = xcc_util_write(self->fd, (const char *)buf, size))) return 0;
+    return size;
+}
+
+int xc_xz_append(const char *pathname, const uint8_t *data, size_t data_size) {
+    ISzAlloc     alloc = {.Alloc = xc_xz_alloc, .Free = xc_xz_free};
+    xc_xz_in_t   in = {.in = {.Read = xc_xz_read}, .data = data, .remaining = data_size};
+    xc_xz_file_t out = {.out = {.Write = xc_xz_write}, .fd = -1, .r = 0};
+    CXzProps     props;
+    CXzEncHandle xz;
+    SRes         res;
+
+    pthread_once(&xc_xz_crc_once, xc_xz_crc_init);
+
+    if ((out.fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(pathname, O_WRONLY | O_APPEND | O_CLOEXEC))) < 0) return XCC_ERRNO_SYS;
+
+    XzProps_Init(&props);
+    props.lzma2Props.lzmaProps.dictSize = XC_XZ_APPEND_DICT_SIZE;
+    props.lzma2Props.lzmaProps.reduceSize = data_size;
+    props.checkId = XZ_CHECK_CRC32;
+    props.numTotalThreads = 1;
+    props.reduceSize = data_size;
+
+    if (NULL == (xz = XzEnc_Create(&alloc, &alloc))) {
+        res = SZ_ERROR_MEM;
+    } else {
+        if (SZ_OK == (res = XzEnc_SetProps(xz, &props)))
+            res = XzEnc_Encode(xz, &(out.out), &(in.in), NULL);
+        XzEnc_Destroy(xz);
+    }
+    close(out.fd);
+
+    if (0 != out.r) return out.r;
+    if (SZ_ERROR_MEM == res) return XCC_ERRNO_NOMEM;
+    return (SZ_OK == res ? 0 : XCC_ERRNO_UNKNOWN);
+}
@@ -15,7 +15,7 @@ LOCAL_CFLAGS            := -std=c11 -Weverything -Werror \
                            -Wno-padded \
                            -Wno-cast-qual \
                            -Wno-strict-prototypes \
-                           -fPIE \
+                           -fPIC \
                            -Oz \
                            -flto \
                            -D_7ZIP_ST
@@ -23,16 +23,21 @@ LOCAL_C_INCLUDES        := $(LOCAL_PATH)
 LOCAL_EXPORT_C_INCLUDES := $(LOCAL_PATH)
 LOCAL_SRC_FILES         := 7zCrc.c      \
                            7zCrcOpt.c   \
+                           Alloc.c      \
                            CpuArch.c    \
                            Bra.c        \
                            Bra86.c      \
                            BraIA64.c    \
                            Delta.c      \
+                           LzFind.c     \
                            Lzma2Dec.c   \
+                           Lzma2Enc.c   \
                            LzmaDec.c    \
+                           LzmaEnc.c    \
                            Sha256.c     \
                            Xz.c         \
                            XzCrc64.c    \
                            XzCrc64Opt.c \
-                           XzDec.c
+                           XzDec.c      \
+                           XzEnc.c
 include $(BUILD_STATIC_LIBRARY)
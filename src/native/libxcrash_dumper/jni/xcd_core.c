@@ -41,12 +41,18 @@
 #include <android/log.h>
 #include "queue.h"
 #include "xcc_errno.h"
+#include "xcc_binlog.h"
+#include "xcc_index.h"
+#include "xcc_manifest.h"
+#include "xcc_pressure.h"
 #include "xcc_signal.h"
 #include "xcc_unwind.h"
 #include "xcc_util.h"
 #include "xcc_spot.h"
 #include "xcd_log.h"
 #include "xcd_process.h"
+#include "xcd_profile.h"
+#include "xcd_signature.h"
 #include "xcd_sys.h"
 #include "xcd_util.h"
 
@@ -56,6 +62,10 @@
 static int                    xcd_core_handled      = 0;
 static int                    xcd_core_log_fd       = -1;
 static xcd_process_t         *xcd_core_proc         = NULL;
+static xcc_pressure_t        *xcd_core_pressure     = NULL;
+static xcc_binlog_t          *xcd_core_binlog       = NULL;
+static uint64_t               xcd_core_signature    = 0;
+static xcc_binlog_t           xcd_core_binlog_buf;
 
 static xcc_spot_t             xcd_core_spot;
 static char                  *xcd_core_log_pathname      = NULL;
@@ -68,6 +78,8 @@ static char                  *xcd_core_model             = NULL;
 static char                  *xcd_core_build_fingerprint = NULL;
 static char                  *xcd_core_app_id            = NULL;
 static char                  *xcd_core_app_version       = NULL;
+static char                  *xcd_core_compress_dict_pathname = NULL;
+static char                  *xcd_core_maps_baseline_pathname = NULL;
 static char                  *xcd_core_dump_all_threads_whitelist = NULL;
 
 static int xcd_core_read_stdin(void *buf, size_t len)
@@ -107,6 +119,10 @@ static int xcd_core_read_args()
     if(0 != (r = xcd_core_read_stdin_extra(&xcd_core_build_fingerprint, xcd_core_spot.build_fingerprint_len))) return r;
     if(0 != (r = xcd_core_read_stdin_extra(&xcd_core_app_id, xcd_core_spot.app_id_len))) return r;
     if(0 != (r = xcd_core_read_stdin_extra(&xcd_core_app_version, xcd_core_spot.app_version_len))) return r;
+    if(xcd_core_spot.compress_dict_pathname_len > 0)
+        if(0 != (r = xcd_core_read_stdin_extra(&xcd_core_compress_dict_pathname, xcd_core_spot.compress_dict_pathname_len))) return r;
+    if(xcd_core_spot.maps_baseline_pathname_len > 0)
+        if(0 != (r = xcd_core_read_stdin_extra(&xcd_core_maps_baseline_pathname, xcd_core_spot.maps_baseline_pathname_len))) return r;
     if(xcd_core_spot.dump_all_threads_whitelist_len > 0)
         if(0 != (r = xcd_core_read_stdin_extra(&xcd_core_dump_all_threads_whitelist, xcd_core_spot.dump_all_threads_whitelist_len))) return r;
     
@@ -143,6 +159,173 @@ static void xcd_core_signal_handler(int sig, siginfo_t* si, void* uc) {
     xcc_signal_crash_queue(si);
 }
 
+static void xcd_core_record_proto(void)
+{
+    char proto_pathname[1024];
+    int  proto_fd;
+
+    snprintf(proto_pathname, sizeof(proto_pathname), "%s"XCC_UTIL_PROTO_SUFFIX, xcd_core_log_pathname);
+    if(0 > (proto_fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(proto_pathname, O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644)))) return;
+
+    if(0 != xcd_process_record_proto(xcd_core_proc,
+                                     proto_fd,
+                                     xcd_core_build_fingerprint,
+                                     xcd_core_spot.time_zone,
+                                     xcd_core_spot.start_time,
+                                     xcd_core_spot.crash_time,
+                                     xcd_core_spot.logcat_system_lines,
+                                     xcd_core_spot.logcat_events_lines,
+                                     xcd_core_spot.logcat_main_lines,
+                                     xcd_core_spot.dump_fds,
+                                     xcd_core_spot.api_level))
+    {
+        close(proto_fd);
+        unlink(proto_pathname);
+        return;
+    }
+    close(proto_fd);
+}
+
+static void xcd_core_record_minidump(void)
+{
+    char minidump_pathname[1024];
+    int  minidump_fd;
+
+    snprintf(minidump_pathname, sizeof(minidump_pathname), "%s"XCC_UTIL_MINIDUMP_SUFFIX, xcd_core_log_pathname);
+    if(0 > (minidump_fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(minidump_pathname, O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644)))) return;
+
+    if(0 != xcd_process_record_minidump(xcd_core_proc, minidump_fd, xcd_core_spot.crash_time))
+    {
+        close(minidump_fd);
+        unlink(minidump_pathname);
+        return;
+    }
+    close(minidump_fd);
+}
+
+static int xcd_core_load_compress_dict(uint8_t **dict, size_t *dict_size)
+{
+    struct stat st;
+    int         fd;
+    size_t      nread = 0;
+    ssize_t     n;
+    int         r = 0;
+
+    if(0 > (fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(xcd_core_compress_dict_pathname, O_RDONLY | O_CLOEXEC)))) return XCC_ERRNO_SYS;
+    if(0 != fstat(fd, &st))
+    {
+        r = XCC_ERRNO_SYS;
+        goto end;
+    }
+    if(st.st_size <= 0 || st.st_size > XCC_UTIL_XZ_DICT_SIZE_MAX)
+    {
+        r = XCC_ERRNO_INVAL;
+        goto end;
+    }
+    if(NULL == (*dict = malloc((size_t)st.st_size)))
+    {
+        r = XCC_ERRNO_NOMEM;
+        goto end;
+    }
+
+    while(nread < (size_t)st.st_size)
+    {
+        n = XCC_UTIL_TEMP_FAILURE_RETRY(read(fd, *dict + nread, (size_t)st.st_size - nread));
+        if(n <= 0)
+        {
+            free(*dict);
+            *dict = NULL;
+            r = XCC_ERRNO_SYS;
+            goto end;
+        }
+        nread += (size_t)n;
+    }
+    *dict_size = nread;
+
+ end:
+    close(fd);
+    return r;
+}
+
+static int xcd_core_compress_log(void)
+{
+    char     xz_pathname[1024];
+    int      xz_fd;
+    uint8_t  buf[1024];
+    uint8_t *dict = NULL;
+    size_t   dict_size = 0;
+    off_t    end;
+    ssize_t  readed, n;
+    int      r;
+
+    //the log file may come from a placeholder file, drop the zero padding at the end
+    if((end = lseek(xcd_core_log_fd, 0, SEEK_END)) < 0) return XCC_ERRNO_SYS;
+    while(end > 0)
+    {
+        n = (end > (off_t)sizeof(buf) ? (ssize_t)sizeof(buf) : (ssize_t)end);
+        readed = XCC_UTIL_TEMP_FAILURE_RETRY(pread(xcd_core_log_fd, buf, (size_t)n, end - n));
+        if(readed != n) return XCC_ERRNO_SYS;
+        for(; n > 0; n--)
+            if(0 != buf[n - 1]) break;
+        end -= (off_t)(readed - n);
+        if(n > 0) break;
+    }
+    if(0 == end) return XCC_ERRNO_MISSING;
+    if(lseek(xcd_core_log_fd, 0, SEEK_SET) < 0) return XCC_ERRNO_SYS;
+
+    //prime the compressor with the dictionary built from the recent logs, fall back to plain XZ if it fails
+    //(the dictionary primed file is not an XZ file, it has its own suffix)
+    if(NULL != xcd_core_compress_dict_pathname && 0 == xcd_core_load_compress_dict(&dict, &dict_size))
+    {
+        snprintf(xz_pathname, sizeof(xz_pathname), "%s"XCC_UTIL_XCDZ_SUFFIX, xcd_core_log_pathname);
+        if(0 <= (xz_fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(xz_pathname, O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644))))
+        {
+            r = xcd_util_xz_compress_dict(xcd_core_log_fd, (size_t)end, dict, dict_size, xz_fd);
+            close(xz_fd);
+            if(0 == r)
+            {
+                free(dict);
+                goto end;
+            }
+            unlink(xz_pathname);
+        }
+        free(dict);
+        if(lseek(xcd_core_log_fd, 0, SEEK_SET) < 0) return XCC_ERRNO_SYS;
+    }
+
+    snprintf(xz_pathname, sizeof(xz_pathname), "%s"XCC_UTIL_XZ_SUFFIX, xcd_core_log_pathname);
+    if(0 > (xz_fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(xz_pathname, O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644)))) return XCC_ERRNO_SYS;
+    r = xcd_util_xz_compress(xcd_core_log_fd, (size_t)end, xz_fd);
+    close(xz_fd);
+
+    //keep the plain log file if anything goes wrong
+    if(0 != r)
+    {
+        unlink(xz_pathname);
+        return r;
+    }
+
+ end:
+    unlink(xcd_core_log_pathname);
+
+    //the compressed log file replaces the plain one in the manifest
+    xcc_manifest_resize(xz_pathname);
+    return 0;
+}
+
+//the crashed process appends the java stacktrace after the dump, then it tells on our stdout whether to compress
+static void xcd_core_wait_compress(void)
+{
+    char cmd = 0;
+
+    if(1 != XCC_UTIL_TEMP_FAILURE_RETRY(write(STDOUT_FILENO, &cmd, 1))) return;
+    if(1 != XCC_UTIL_TEMP_FAILURE_RETRY(read(STDOUT_FILENO, &cmd, 1)) || 0 == cmd) return;
+
+    //the compression has its own time limit
+    alarm(30);
+    if(0 != xcd_core_compress_log()) exit(7);
+}
+
 int main(int argc, char** argv) {
     (void)argc;
     (void)argv;
@@ -153,13 +336,24 @@ int main(int argc, char** argv) {
     //read args from stdin
     if(0 != xcd_core_read_args()) exit(1);
 
-    //open log file
-    if(0 > (xcd_core_log_fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(xcd_core_log_pathname, O_WRONLY | O_CLOEXEC)))) exit(2);
+    //open log file (the profile samples are read back from it, the finished log is read back when compressing)
+    if(0 > (xcd_core_log_fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(xcd_core_log_pathname,
+                                                               ((xcd_core_spot.profile || xcd_core_spot.compress) ? O_RDWR : O_WRONLY) | O_CLOEXEC)))) exit(2);
 
     //register signal handler for catching self-crashing
     xcc_unwind_init(xcd_core_spot.api_level);
     xcc_signal_crash_register(xcd_core_signal_handler);
 
+    if(xcd_core_spot.profile)
+    {
+        //unwind and fold the main thread samples, the process is not stopped
+        if(0 != xcd_profile_record(xcd_core_log_fd, xcd_core_spot.crash_pid)) exit(4);
+        return 0;
+    }
+
+    //start collecting the system pressure, it takes a while to read sysfs
+    if(!xcd_core_spot.snapshot) xcc_pressure_create(&xcd_core_pressure);
+
     //create process object
     if(0 != xcd_process_create(&xcd_core_proc,
                                xcd_core_spot.crash_pid,
@@ -167,14 +361,34 @@ int main(int argc, char** argv) {
                                &(xcd_core_spot.siginfo),
                                &(xcd_core_spot.ucontext))) exit(3);
 
-    //suspend all threads in the process
-    xcd_process_suspend_threads(xcd_core_proc);
+    if(xcd_core_spot.snapshot)
+    {
+        //snapshot the live threads one by one, each of them is resumed immediately
+        if(0 != xcd_process_snapshot_threads(xcd_core_proc,
+                                             xcd_core_spot.dump_all_threads_count_max,
+                                             xcd_core_dump_all_threads_whitelist))
+            exit(4);
+    }
+    else
+    {
+        //suspend all threads in the process
+        xcd_process_suspend_threads(xcd_core_proc);
 
-    //load process info
-    if(0 != xcd_process_load_info(xcd_core_proc)) exit(4);
+        //load process info
+        if(0 != xcd_process_load_info(xcd_core_proc)) exit(4);
+    }
+
+    //binary log, everything except the backtraces and the crashed thread's build-id and memory is kept as text sections
+    if(xcd_core_spot.dump_binary && !xcd_core_spot.snapshot)
+    {
+        xcd_core_binlog = &xcd_core_binlog_buf;
+        if(0 != xcc_binlog_write_header(xcd_core_log_fd)) exit(5);
+        if(0 != xcc_binlog_section_begin(xcd_core_binlog, xcd_core_log_fd, XCC_BINLOG_SECTION_TEXT)) exit(5);
+    }
 
     //record system info
     if(0 != xcd_sys_record(xcd_core_log_fd,
+                           xcd_core_spot.snapshot ? XCC_UTIL_CRASH_TYPE_TRACE : XCC_UTIL_CRASH_TYPE_NATIVE,
                            xcd_core_spot.time_zone,
                            xcd_core_spot.start_time,
                            xcd_core_spot.crash_time,
@@ -187,27 +401,65 @@ int main(int argc, char** argv) {
                            xcd_core_manufacturer,
                            xcd_core_brand,
                            xcd_core_model,
-                           xcd_core_build_fingerprint)) 
+                           xcd_core_build_fingerprint))
         exit(5);
 
-    //record process info
-    if(0 != xcd_process_record(xcd_core_proc,
-                               xcd_core_log_fd,
-                               xcd_core_spot.logcat_system_lines,
-                               xcd_core_spot.logcat_events_lines,
-                               xcd_core_spot.logcat_main_lines,
-                               xcd_core_spot.dump_elf_hash,
-                               xcd_core_spot.dump_map,
-                               xcd_core_spot.dump_fds,
-                               xcd_core_spot.dump_network_info,
-                               xcd_core_spot.dump_all_threads,
-                               xcd_core_spot.dump_all_threads_count_max,
-                               xcd_core_dump_all_threads_whitelist,
-                               xcd_core_spot.api_level)) 
-        exit(6);
-
-    //resume all threads in the process
-    xcd_process_resume_threads(xcd_core_proc);
+    if(xcd_core_spot.snapshot)
+    {
+        //record the snapshot, all threads are running now
+        if(0 != xcd_process_record_snapshot(xcd_core_proc, xcd_core_log_fd)) exit(6);
+    }
+    else
+    {
+        //record process info
+        if(0 != xcd_process_record(xcd_core_proc,
+                                   xcd_core_log_fd,
+                                   xcd_core_spot.logcat_system_lines,
+                                   xcd_core_spot.logcat_events_lines,
+                                   xcd_core_spot.logcat_main_lines,
+                                   xcd_core_spot.dump_elf_hash,
+                                   xcd_core_spot.dump_map,
+                                   xcd_core_maps_baseline_pathname,
+                                   xcd_core_spot.dump_fds,
+                                   xcd_core_spot.dump_network_info,
+                                   xcd_core_spot.dump_all_threads,
+                                   xcd_core_spot.dump_all_threads_count_max,
+                                   xcd_core_dump_all_threads_whitelist,
+                                   xcd_core_spot.api_level,
+                                   xcd_core_pressure,
+                                   xcd_core_binlog,
+                                   &xcd_core_signature))
+            exit(6);
+
+        if(NULL != xcd_core_binlog)
+        {
+            if(0 != xcc_binlog_section_end(xcd_core_binlog)) exit(6);
+            if(0 != xcc_binlog_write_end(xcd_core_log_fd)) exit(6);
+        }
+
+        //protobuf tombstone, the log file is complete even if this fails
+        if(xcd_core_spot.dump_proto) xcd_core_record_proto();
+
+        //minidump, the ELFs loaded while unwinding are reused for the build-ids
+        if(xcd_core_spot.dump_minidump) xcd_core_record_minidump();
+
+        //resume all threads in the process
+        xcd_process_resume_threads(xcd_core_proc);
+
+        //count the crash by its signature
+        if(0 != xcd_core_signature) xcd_signature_save(xcd_core_log_pathname, xcd_core_signature, xcd_core_spot.crash_time);
+    }
+
+    //section index of the text log file, the sections appended later are not indexed
+    if(NULL == xcd_core_binlog) xcc_index_build(xcd_core_log_pathname);
+
+    //add the log file to the manifest, the Java side only appends sections to it later
+    xcc_manifest_add(xcd_core_log_pathname,
+                     xcd_core_spot.snapshot ? XCC_UTIL_CRASH_TYPE_SNAPSHOT : XCC_UTIL_CRASH_TYPE_NATIVE,
+                     xcd_core_spot.crash_time, xcd_core_signature);
+
+    //compress the finished log file out of the crashed process for the memory usage, without spawning another dumper
+    if(xcd_core_spot.compress) xcd_core_wait_compress();
 
 #if XCD_CORE_DEBUG
     XCD_LOG_DEBUG("CORE: done");
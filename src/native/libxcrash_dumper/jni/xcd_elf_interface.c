@@ -36,7 +36,20 @@
 #include "xcd_memory.h"
 #include "xcd_log.h"
 #include "xcd_util.h"
-#include "queue.h"
+
+#ifndef NT_GNU_BUILD_ID
+#define NT_GNU_BUILD_ID 3
+#endif
+
+//the header tables and the section names are read at once, into the stack if they fit
+#define XCD_ELF_INTERFACE_SCRATCH_SIZE       4096
+#define XCD_ELF_INTERFACE_NAMES_SCRATCH_SIZE 1024
+#define XCD_ELF_INTERFACE_NAMES_SIZE_MAX     (64 * 1024)
+
+//the extra descriptors are ignored
+#define XCD_ELF_INTERFACE_LOADS_MAX   4
+#define XCD_ELF_INTERFACE_SYMBOLS_MAX 4
+#define XCD_ELF_INTERFACE_STRTABS_MAX 8
 
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wpadded"
@@ -45,10 +58,8 @@ typedef struct xcd_elf_load
     uintptr_t vaddr;
     size_t    offset;
     size_t    size;
-    TAILQ_ENTRY(xcd_elf_load,) link;
 } xcd_elf_load_t;
 #pragma clang diagnostic pop
-typedef TAILQ_HEAD(xcd_elf_load_queue, xcd_elf_load,) xcd_elf_load_queue_t;
 
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wpadded"
@@ -59,10 +70,8 @@ typedef struct xcd_elf_symbols
     size_t sym_entry_size;
     size_t str_offset;
     size_t str_end;
-    TAILQ_ENTRY(xcd_elf_symbols,) link;
 } xcd_elf_symbols_t;
 #pragma clang diagnostic pop
-typedef TAILQ_HEAD(xcd_elf_symbols_queue, xcd_elf_symbols,) xcd_elf_symbols_queue_t;
 
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wpadded"
@@ -70,10 +79,8 @@ typedef struct xcd_elf_strtab
 {
     size_t addr;
     size_t offset;
-    TAILQ_ENTRY(xcd_elf_strtab,) link;
 } xcd_elf_strtab_t;
 #pragma clang diagnostic pop
-typedef TAILQ_HEAD(xcd_elf_strtab_queue, xcd_elf_strtab,) xcd_elf_strtab_queue_t;
 
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wpadded"
@@ -86,13 +93,16 @@ struct xcd_elf_interface
     int                      is_gnu;
 
     //PT_LOAD(s) in program headers
-    xcd_elf_load_queue_t     loads;
+    xcd_elf_load_t           loads[XCD_ELF_INTERFACE_LOADS_MAX];
+    size_t                   loads_num;
 
     //symbols (.dynsym with .dynstr, .symtab with .strtab)
-    xcd_elf_symbols_queue_t  symbolsq;
+    xcd_elf_symbols_t        symbols[XCD_ELF_INTERFACE_SYMBOLS_MAX];
+    size_t                   symbols_num;
 
     //string tables
-    xcd_elf_strtab_queue_t   strtabq;
+    xcd_elf_strtab_t         strtabs[XCD_ELF_INTERFACE_STRTABS_MAX];
+    size_t                   strtabs_num;
 
     //.note.gnu.build-id
     size_t                   build_id_offset;
@@ -165,20 +175,49 @@ static int xcd_elf_interface_check_valid(ElfW(Ehdr) *ehdr)
     return 0;
 }
 
+//read a whole table at once, into the scratch buffer if it fits
+static uint8_t *xcd_elf_interface_read_table(xcd_memory_t *memory, uintptr_t offset, size_t size, uint8_t *scratch, size_t scratch_size)
+{
+    uint8_t *buf;
+
+    if(NULL == (buf = (size <= scratch_size ? scratch : malloc(size)))) return NULL;
+
+    if(0 != xcd_memory_read_fully(memory, offset, buf, size))
+    {
+        if(buf != scratch) free(buf);
+        return NULL;
+    }
+
+    return buf;
+}
+
+static const char *xcd_elf_interface_get_section_name(const char *names, size_t names_size, size_t name_offset)
+{
+    if(NULL == names || name_offset >= names_size) return NULL;
+    if(NULL == memchr(names + name_offset, '\0', names_size - name_offset)) return NULL;
+
+    return names + name_offset;
+}
+
 static int xcd_elf_interface_read_program_headers(xcd_elf_interface_t *self, ElfW(Ehdr) *ehdr, uintptr_t *load_bias)
 {
+    uint8_t         scratch[XCD_ELF_INTERFACE_SCRATCH_SIZE];
+    uint8_t        *buf;
     size_t          i;
     ElfW(Phdr)      phdr;
-    xcd_elf_load_t *load, *load_tmp;
-    int             r;
-    
-    for(i = 0; i < ehdr->e_phnum * ehdr->e_phentsize; i += ehdr->e_phentsize)
+    xcd_elf_load_t *load;
+
+    if(0 == ehdr->e_phnum) return 0;
+    if(ehdr->e_phentsize < sizeof(phdr)) return XCC_ERRNO_FORMAT;
+
+    //read the program header table at once
+    if(NULL == (buf = xcd_elf_interface_read_table(self->memory, ehdr->e_phoff,
+                                                   (size_t)ehdr->e_phnum * ehdr->e_phentsize,
+                                                   scratch, sizeof(scratch)))) return XCC_ERRNO_MEM;
+
+    for(i = 0; i < ehdr->e_phnum; i++)
     {
-        if(0 != xcd_memory_read_fully(self->memory, ehdr->e_phoff + i, &phdr, sizeof(phdr)))
-        {
-            r = XCC_ERRNO_MEM;
-            goto err;
-        }
+        memcpy(&phdr, buf + i * ehdr->e_phentsize, sizeof(phdr));
 
         switch(phdr.p_type)
         {
@@ -193,16 +232,12 @@ static int xcd_elf_interface_read_program_headers(xcd_elf_interface_t *self, Elf
                     
                     if(NULL != load_bias) *load_bias = self->load_bias;
                 }
-                
-                if(NULL == (load = malloc(sizeof(xcd_elf_load_t))))
-                {
-                    r = XCC_ERRNO_NOMEM;
-                    goto err;
-                }
+
+                if(self->loads_num >= XCD_ELF_INTERFACE_LOADS_MAX) continue;
+                load = &(self->loads[self->loads_num++]);
                 load->vaddr  = phdr.p_vaddr;
                 load->offset = phdr.p_offset;
                 load->size   = phdr.p_memsz;
-                TAILQ_INSERT_TAIL(&(self->loads), load, link);
                 break;
             }
         case PT_GNU_EH_FRAME:
@@ -221,106 +256,91 @@ static int xcd_elf_interface_read_program_headers(xcd_elf_interface_t *self, Elf
             break;
         }
     }
-    return 0;
 
- err:
-    TAILQ_FOREACH_SAFE(load, &(self->loads), link, load_tmp)
-    {
-        TAILQ_REMOVE(&(self->loads), load, link);
-        free(load);
-    }
-    return r;
+    if(buf != scratch) free(buf);
+    return 0;
 }
 
 static int xcd_elf_interface_read_section_headers(xcd_elf_interface_t *self, ElfW(Ehdr) *ehdr)
 {
+    uint8_t            scratch[XCD_ELF_INTERFACE_SCRATCH_SIZE];
+    uint8_t            names_scratch[XCD_ELF_INTERFACE_NAMES_SCRATCH_SIZE];
+    uint8_t           *buf;
+    char              *names = NULL;
+    size_t             names_size = 0;
     size_t             i;
     ElfW(Shdr)         shdr;
     ElfW(Shdr)         str_shdr;
-    size_t             sec_offset = 0;
-    size_t             sec_size   = 0;
-    xcd_elf_symbols_t *symbols, *symbols_tmp;
-    xcd_elf_strtab_t  *strtab, *strtab_tmp;
-    char               name[128];
-    int                r;
-
-    //get section header entry that contains the section names
+    const char        *name;
+    xcd_elf_symbols_t *symbols;
+    xcd_elf_strtab_t  *strtab;
+
+    if(0 == ehdr->e_shnum) return 0;
+    if(ehdr->e_shentsize < sizeof(shdr)) return XCC_ERRNO_FORMAT;
+
+    //read the section header table at once
+    if(NULL == (buf = xcd_elf_interface_read_table(self->memory, ehdr->e_shoff,
+                                                   (size_t)ehdr->e_shnum * ehdr->e_shentsize,
+                                                   scratch, sizeof(scratch)))) return XCC_ERRNO_MEM;
+
+    //read the section names at once
     if(ehdr->e_shstrndx < ehdr->e_shnum)
     {
-        if(0 != xcd_memory_read_fully(self->memory, ehdr->e_shoff + ehdr->e_shstrndx * ehdr->e_shentsize,
-                                      &shdr, sizeof(shdr))) return XCC_ERRNO_MEM;
-        sec_offset = shdr.sh_offset;
-        sec_size   = shdr.sh_size;
+        memcpy(&shdr, buf + (size_t)ehdr->e_shstrndx * ehdr->e_shentsize, sizeof(shdr));
+        if(shdr.sh_size > 0 && shdr.sh_size <= XCD_ELF_INTERFACE_NAMES_SIZE_MAX &&
+           NULL != (names = (char *)xcd_elf_interface_read_table(self->memory, shdr.sh_offset, shdr.sh_size,
+                                                                 names_scratch, sizeof(names_scratch))))
+            names_size = shdr.sh_size;
     }
 
-    for(i = ehdr->e_shentsize; i < ehdr->e_shnum * ehdr->e_shentsize; i += ehdr->e_shentsize)
+    for(i = 1; i < ehdr->e_shnum; i++)
     {
-        if(0 != xcd_memory_read_fully(self->memory, ehdr->e_shoff + i, &shdr, sizeof(shdr)))
-        {
-            r = XCC_ERRNO_MEM;
-            goto err;
-        }
+        memcpy(&shdr, buf + i * ehdr->e_shentsize, sizeof(shdr));
 
         switch(shdr.sh_type)
         {
         case SHT_NOTE:
             {
-                if(shdr.sh_name >= sec_size) continue;
-                if(0 != xcd_memory_read_string(self->memory, sec_offset + shdr.sh_name, name, sizeof(name), UINTPTR_MAX))
-                    continue;
+                if(NULL == (name = xcd_elf_interface_get_section_name(names, names_size, shdr.sh_name))) continue;
                 
                 if(0 == strcmp(name, ".note.gnu.build-id"))
                 {
                     self->build_id_offset = shdr.sh_offset;
                     self->build_id_size = shdr.sh_size;
                 }
+                break;
             }
         case SHT_SYMTAB:
         case SHT_DYNSYM:
             {
+                if(self->symbols_num >= XCD_ELF_INTERFACE_SYMBOLS_MAX) continue;
+
                 //get the associated strtab section
                 if(shdr.sh_link >= ehdr->e_shnum) continue;
-                if(0 != xcd_memory_read_fully(self->memory, ehdr->e_shoff + shdr.sh_link * ehdr->e_shentsize, &str_shdr, sizeof(str_shdr)))
-                {
-                    r = XCC_ERRNO_MEM;
-                    goto err;
-                }
+                memcpy(&str_shdr, buf + (size_t)shdr.sh_link * ehdr->e_shentsize, sizeof(str_shdr));
                 if(SHT_STRTAB != str_shdr.sh_type) continue;
 
                 //save symbols and the associated strtab
-                if(NULL == (symbols = malloc(sizeof(xcd_elf_symbols_t))))
-                {
-                    r = XCC_ERRNO_NOMEM;
-                    goto err;
-                }
+                symbols = &(self->symbols[self->symbols_num++]);
                 symbols->sym_offset = shdr.sh_offset;
                 symbols->sym_end = shdr.sh_offset + shdr.sh_size;
                 symbols->sym_entry_size = shdr.sh_entsize;
                 symbols->str_offset = str_shdr.sh_offset;
                 symbols->str_end = str_shdr.sh_offset + str_shdr.sh_size;
-                TAILQ_INSERT_TAIL(&(self->symbolsq), symbols, link);
                 break;
             }
         case SHT_STRTAB:
             {
-                if(NULL == (strtab = malloc(sizeof(xcd_elf_strtab_t))))
-                {
-                    r = XCC_ERRNO_NOMEM;
-                    goto err;
-                }
+                if(self->strtabs_num >= XCD_ELF_INTERFACE_STRTABS_MAX) continue;
+
+                strtab = &(self->strtabs[self->strtabs_num++]);
                 strtab->addr = shdr.sh_addr;
                 strtab->offset = shdr.sh_offset;
-                TAILQ_INSERT_TAIL(&(self->strtabq), strtab, link);
                 break;
             }
         case SHT_PROGBITS:
             {
-                if(shdr.sh_name >= sec_size) continue;
-                if(0 != xcd_memory_read_string(self->memory, sec_offset + shdr.sh_name, name, sizeof(name), UINTPTR_MAX))
-                {
-                    r = XCC_ERRNO_MEM;
-                    goto err;
-                }
+                if(NULL == (name = xcd_elf_interface_get_section_name(names, names_size, shdr.sh_name))) continue;
                 
                 if(0 == strcmp(name, ".debug_frame"))
                 {
@@ -349,20 +369,9 @@ static int xcd_elf_interface_read_section_headers(xcd_elf_interface_t *self, Elf
         }
     }
 
+    if(NULL != names && names != (char *)names_scratch) free(names);
+    if(buf != scratch) free(buf);
     return 0;
-    
- err:
-    TAILQ_FOREACH_SAFE(symbols, &(self->symbolsq), link, symbols_tmp)
-    {
-        TAILQ_REMOVE(&(self->symbolsq), symbols, link);
-        free(symbols);
-    }
-    TAILQ_FOREACH_SAFE(strtab, &(self->strtabq), link, strtab_tmp)
-    {
-        TAILQ_REMOVE(&(self->strtabq), strtab, link);
-        free(strtab);
-    }
-    return r;
 }
 
 int xcd_elf_interface_create(xcd_elf_interface_t **self, pid_t pid, xcd_memory_t *memory, uintptr_t *load_bias)
@@ -380,9 +389,6 @@ int xcd_elf_interface_create(xcd_elf_interface_t **self, pid_t pid, xcd_memory_t
     if(NULL == (*self = calloc(1, sizeof(xcd_elf_interface_t)))) return XCC_ERRNO_NOMEM;
     (*self)->pid = pid;
     (*self)->memory = memory;
-    TAILQ_INIT(&((*self)->loads));
-    TAILQ_INIT(&((*self)->symbolsq));
-    TAILQ_INIT(&((*self)->strtabq));
 
     //read program headers, save and return load_bias
     if(0 != (r = xcd_elf_interface_read_program_headers(*self, &ehdr, load_bias)))
@@ -516,6 +522,7 @@ int xcd_elf_interface_arm_exidx_step(xcd_elf_interface_t *self, uintptr_t step_p
 int xcd_elf_interface_get_function_info(xcd_elf_interface_t *self, uintptr_t addr, char **name, size_t *name_offset)
 {
     xcd_elf_symbols_t *symbols;
+    size_t             i;
     size_t             offset;
     size_t             start_offset;
     size_t             end_offset;
@@ -523,8 +530,9 @@ int xcd_elf_interface_get_function_info(xcd_elf_interface_t *self, uintptr_t add
     ElfW(Sym)          sym;
     char               buf[512];
 
-    TAILQ_FOREACH(symbols, &(self->symbolsq), link)
+    for(i = 0; i < self->symbols_num; i++)
     {
+        symbols = &(self->symbols[i]);
         for(offset = symbols->sym_offset; offset < symbols->sym_end; offset += symbols->sym_entry_size)
         {
             if(0 != xcd_memory_read_fully(self->memory, offset, &sym, sizeof(sym))) break;
@@ -554,13 +562,15 @@ int xcd_elf_interface_get_function_info(xcd_elf_interface_t *self, uintptr_t add
 int xcd_elf_interface_get_symbol_addr(xcd_elf_interface_t *self, const char *name, uintptr_t *addr)
 {
     xcd_elf_symbols_t *symbols;
+    size_t             i;
     size_t             offset;
     size_t             str_offset;
     ElfW(Sym)          sym;
     char               buf[512];
 
-    TAILQ_FOREACH(symbols, &(self->symbolsq), link)
+    for(i = 0; i < self->symbols_num; i++)
     {
+        symbols = &(self->symbols[i]);
         for(offset = symbols->sym_offset; offset < symbols->sym_end; offset += symbols->sym_entry_size)
         {
             //read .symtab / .dynsym
@@ -591,7 +601,9 @@ int xcd_elf_interface_get_build_id(xcd_elf_interface_t *self, uint8_t *build_id,
     uintptr_t  addr;
     int        r;
 
-    if(0 == self->build_id_offset || 0 == self->build_id_size) return XCC_ERRNO_MISSING;
+    //no section headers, try the program headers
+    if(0 == self->build_id_offset || 0 == self->build_id_size)
+        return xcd_elf_interface_read_build_id(self->memory, build_id, build_id_len, build_id_len_ret);
     if(self->build_id_size < sizeof(nhdr)) return XCC_ERRNO_FORMAT;
 
     //read .note.gnu.build-id header
@@ -607,11 +619,64 @@ int xcd_elf_interface_get_build_id(xcd_elf_interface_t *self, uint8_t *build_id,
     return 0;
 }
 
+//only walk the PT_NOTE segments, they are mapped even if the section headers are stripped or not mapped
+int xcd_elf_interface_read_build_id(xcd_memory_t *memory, uint8_t *build_id, size_t build_id_len, size_t *build_id_len_ret)
+{
+    ElfW(Ehdr) ehdr;
+    ElfW(Phdr) phdr;
+    ElfW(Nhdr) nhdr;
+    char       name[4];
+    size_t     i, align, name_size, desc_size;
+    uintptr_t  addr, name_addr;
+    size_t     remain;
+    int        r;
+
+    if(0 != (r = xcd_memory_read_fully(memory, 0, &ehdr, sizeof(ehdr)))) return r;
+    if(0 != (r = xcd_elf_interface_check_valid(&ehdr))) return r;
+    if(ehdr.e_phentsize < sizeof(phdr)) return XCC_ERRNO_FORMAT;
+
+    for(i = 0; i < ehdr.e_phnum; i++)
+    {
+        if(0 != (r = xcd_memory_read_fully(memory, ehdr.e_phoff + i * ehdr.e_phentsize, &phdr, sizeof(phdr)))) return r;
+        if(PT_NOTE != phdr.p_type) continue;
+
+        //the name and the desc are padded to the alignment of the segment (4 in most cases)
+        align = (8 == phdr.p_align ? 8 : 4);
+        addr = phdr.p_offset;
+        remain = phdr.p_filesz;
+        while(remain >= sizeof(nhdr))
+        {
+            if(0 != xcd_memory_read_fully(memory, addr, &nhdr, sizeof(nhdr))) break;
+            name_size = (nhdr.n_namesz + align - 1) & ~(align - 1);
+            desc_size = (nhdr.n_descsz + align - 1) & ~(align - 1);
+            if(name_size > remain - sizeof(nhdr) || desc_size > remain - sizeof(nhdr) - name_size) break;
+
+            name_addr = addr + sizeof(nhdr);
+            addr += sizeof(nhdr) + name_size + desc_size;
+            remain -= sizeof(nhdr) + name_size + desc_size;
+
+            //should be "GNU\0": 0x47 0x4e 0x55 0x00
+            if(NT_GNU_BUILD_ID != nhdr.n_type || sizeof(name) != nhdr.n_namesz) continue;
+            if(0 != xcd_memory_read_fully(memory, name_addr, name, sizeof(name)) || 0 != memcmp(name, "GNU", sizeof(name))) continue;
+
+            if(0 == nhdr.n_descsz) return XCC_ERRNO_MISSING;
+            if(nhdr.n_descsz > build_id_len) return XCC_ERRNO_NOSPACE;
+            if(0 != (r = xcd_memory_read_fully(memory, name_addr + name_size, build_id, nhdr.n_descsz))) return r;
+
+            if(NULL != build_id_len_ret) *build_id_len_ret = nhdr.n_descsz;
+            return 0;
+        }
+    }
+
+    return XCC_ERRNO_NOTFND;
+}
+
 char *xcd_elf_interface_get_so_name(xcd_elf_interface_t *self)
 {
     uintptr_t         offset;
     ElfW(Dyn)         dyn;
     xcd_elf_strtab_t *strtab;
+    size_t            i;
     uintptr_t         strtab_addr = 0;
     uintptr_t         strtab_size = 0;
     uintptr_t         soname_offset = 0;
@@ -640,8 +705,9 @@ char *xcd_elf_interface_get_so_name(xcd_elf_interface_t *self)
         }
     }
 
-    TAILQ_FOREACH(strtab, &(self->strtabq), link)
+    for(i = 0; i < self->strtabs_num; i++)
     {
+        strtab = &(self->strtabs[i]);
         if(strtab->addr == strtab_addr)
         {
             soname_offset += strtab->offset;
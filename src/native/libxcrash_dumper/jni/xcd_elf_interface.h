@@ -48,6 +48,7 @@ int xcd_elf_interface_get_function_info(xcd_elf_interface_t *self, uintptr_t add
 int xcd_elf_interface_get_symbol_addr(xcd_elf_interface_t *self, const char *name, uintptr_t *addr);
 
 int xcd_elf_interface_get_build_id(xcd_elf_interface_t *self, uint8_t *build_id, size_t build_id_len, size_t *build_id_len_ret);
+int xcd_elf_interface_read_build_id(xcd_memory_t *memory, uint8_t *build_id, size_t build_id_len, size_t *build_id_len_ret);
 char *xcd_elf_interface_get_so_name(xcd_elf_interface_t *self);
 
 #ifdef __cplusplus
@@ -34,6 +34,7 @@
 #include "queue.h"
 #include "xcc_errno.h"
 #include "xcc_util.h"
+#include "xcc_binlog.h"
 #include "xcd_frames.h"
 #include "xcd_md5.h"
 #include "xcd_util.h"
@@ -246,13 +247,186 @@ int xcd_frames_create(xcd_frames_t **self, xcd_regs_t *regs, xcd_maps_t *maps, p
     return 0;
 }
 
+void xcd_frames_destroy(xcd_frames_t **self)
+{
+    xcd_frame_t *frame, *frame_tmp;
+
+    if(NULL == self || NULL == *self) return;
+
+    TAILQ_FOREACH_SAFE(frame, &((*self)->frames), link, frame_tmp)
+    {
+        TAILQ_REMOVE(&((*self)->frames), frame, link);
+        if(frame->func_name) free(frame->func_name);
+        free(frame);
+    }
+    free(*self);
+    *self = NULL;
+}
+
+static void xcd_frames_get_fold_name(xcd_frames_t *self, xcd_frame_t *frame, char *buf, size_t buf_len)
+{
+    xcd_elf_t  *elf;
+    const char *name = NULL;
+    const char *name_embedded;
+
+    if(NULL == frame->map)
+    {
+        name = "<unknown>";
+    }
+    else if(NULL == frame->map->name || '\0' == frame->map->name[0])
+    {
+        name = "<anonymous>";
+    }
+    else
+    {
+        if(0 != frame->map->elf_start_offset)
+        {
+            elf = xcd_map_get_elf(frame->map, self->pid, (void *)self->maps);
+            if(NULL != elf)
+            {
+                name_embedded = xcd_elf_get_so_name(elf);
+                if(NULL != name_embedded && strlen(name_embedded) > 0) name = name_embedded;
+            }
+        }
+        if(NULL == name) name = frame->map->name;
+        if(NULL != strrchr(name, '/')) name = strrchr(name, '/') + 1;
+    }
+
+    if(NULL != frame->func_name)
+        snprintf(buf, buf_len, "%s!%s", name, frame->func_name);
+    else
+        snprintf(buf, buf_len, "%s+0x%"PRIxPTR, name, frame->rel_pc);
+}
+
+//the Java code (compiled, JIT or interpreted) and the ART entry points which run it
+static int xcd_frames_is_managed(xcd_frame_t *frame)
+{
+    static const char *suffixes[] = {".oat", ".odex", ".vdex", ".art", ".dex", ".jar", ".apk"};
+    const char        *name;
+    size_t             len, suffix_len, i;
+
+    if(NULL == frame->map) return 0;
+    if(NULL == frame->map->name || '\0' == frame->map->name[0]) return 1; //JIT code cache before Android P
+
+    name = frame->map->name;
+    len = strlen(name);
+    for(i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); i++)
+    {
+        suffix_len = strlen(suffixes[i]);
+        if(len > suffix_len && 0 == strcmp(name + len - suffix_len, suffixes[i])) return 1;
+    }
+    if(NULL != strstr(name, "jit-code-cache") || NULL != strstr(name, "jit-cache")) return 1;
+
+    if(NULL != frame->func_name && NULL != strstr(name, "libart.so"))
+    {
+        if(0 == strncmp(frame->func_name, "art_quick_", 10)) return 1;
+        if(0 == strncmp(frame->func_name, "nterp_", 6)) return 1;
+        if(NULL != strstr(frame->func_name, "ExecuteMterpImpl")) return 1;
+        if(NULL != strstr(frame->func_name, "ExecuteNterpImpl")) return 1;
+        if(NULL != strstr(frame->func_name, "11interpreter")) return 1;
+        if(NULL != strstr(frame->func_name, "ArtMethod6Invoke")) return 1;
+    }
+
+    return 0;
+}
+
+//native_only: only the frames called by the innermost Java frame, the Java frames are taken by the caller
+size_t xcd_frames_fold(xcd_frames_t *self, uintptr_t stack_start, uintptr_t stack_end, int native_only, char *buf, size_t buf_len)
+{
+    xcd_frame_t *frame;
+    xcd_frame_t *last = NULL;
+    char         name[512];
+    size_t       len = 0;
+    size_t       name_len;
+
+    if(0 == buf_len) return 0;
+    buf[0] = '\0';
+
+    //the frames found outside the copied stack were unwound from garbage
+    TAILQ_FOREACH(frame, &(self->frames), link)
+    {
+        if(NULL != last && (frame->sp < stack_start || frame->sp >= stack_end)) break;
+        if(native_only && xcd_frames_is_managed(frame)) break;
+        last = frame;
+    }
+
+    //outermost frame first: "frame;frame;frame"
+    for(frame = last; NULL != frame; frame = TAILQ_PREV(frame, xcd_frame_queue, link))
+    {
+        xcd_frames_get_fold_name(self, frame, name, sizeof(name));
+        name_len = strlen(name);
+        if(len + name_len + 2 > buf_len) break;
+        if(len > 0) buf[len++] = ';';
+        memcpy(buf + len, name, name_len);
+        len += name_len;
+        buf[len] = '\0';
+    }
+
+    return len;
+}
+
+static char *xcd_frames_get_map_name(xcd_frames_t *self, xcd_map_t *map, char *buf, size_t len)
+{
+    xcd_elf_t *elf;
+    char      *name_embedded;
+
+    if(NULL == map) return "<unknown>";
+
+    if(NULL == map->name || '\0' == map->name[0])
+    {
+        snprintf(buf, len, "<anonymous:%"XCC_UTIL_FMT_ADDR">", map->start);
+        return buf;
+    }
+
+    if(0 != map->elf_start_offset)
+    {
+        elf = xcd_map_get_elf(map, self->pid, (void *)self->maps);
+        if(NULL != elf)
+        {
+            name_embedded = xcd_elf_get_so_name(elf);
+            if(NULL != name_embedded && strlen(name_embedded) > 0)
+            {
+                snprintf(buf, len, "%s!%s", map->name, name_embedded);
+                return buf;
+            }
+        }
+    }
+
+    return map->name;
+}
+
+//the top frames by the build-id (or the name) of the ELF, the relative PC and the function name
+uint64_t xcd_frames_get_signature(xcd_frames_t *self, uint64_t hash, size_t frames_max)
+{
+    xcd_frame_t *frame;
+    char         build_id[64 * 2 + 1];
+    const char  *module;
+    size_t       i = 0;
+
+    TAILQ_FOREACH(frame, &(self->frames), link)
+    {
+        if(i++ >= frames_max) break;
+
+        module = NULL;
+        if(NULL != frame->map)
+        {
+            if(NULL == (module = xcd_map_get_build_id(frame->map, self->pid, (void *)self->maps, build_id, sizeof(build_id))))
+                module = frame->map->name;
+        }
+
+        if(NULL != module) hash = xcc_util_fnv1a(hash, module, strlen(module) + 1);
+        hash = xcc_util_fnv1a(hash, &(frame->rel_pc), sizeof(frame->rel_pc));
+        if(NULL != frame->func_name) hash = xcc_util_fnv1a(hash, frame->func_name, strlen(frame->func_name) + 1);
+    }
+
+    return hash;
+}
+
 int xcd_frames_record_backtrace(xcd_frames_t *self, int log_fd)
 {
     xcd_frame_t *frame;
-    xcd_elf_t   *elf;
     char        *name;
     char         name_buf[512];
-    char        *name_embedded;
     char        *offset;
     char         offset_buf[64];
     char        *func;
@@ -264,33 +438,7 @@ int xcd_frames_record_backtrace(xcd_frames_t *self, int log_fd)
     TAILQ_FOREACH(frame, &(self->frames), link)
     {
         //name
-        name = NULL;
-        if(NULL == frame->map)
-        {
-            name = "<unknown>";
-        }
-        else if(NULL == frame->map->name || '\0' == frame->map->name[0])
-        {
-            snprintf(name_buf, sizeof(name_buf), "<anonymous:%"XCC_UTIL_FMT_ADDR">", frame->map->start);
-            name = name_buf;
-        }
-        else
-        {
-            if(0 != frame->map->elf_start_offset)
-            {
-                elf = xcd_map_get_elf(frame->map, self->pid, (void *)self->maps);
-                if(NULL != elf)
-                {
-                    name_embedded = xcd_elf_get_so_name(elf);
-                    if(NULL != name_embedded && strlen(name_embedded) > 0)
-                    {
-                        snprintf(name_buf, sizeof(name_buf), "%s!%s", frame->map->name, name_embedded);
-                        name = name_buf;
-                    }
-                }
-            }
-            if(NULL == name) name = frame->map->name;
-        }
+        name = xcd_frames_get_map_name(self, frame->map, name_buf, sizeof(name_buf));
 
         //offset
         if(NULL != frame->map && 0 != frame->map->elf_start_offset)
@@ -326,31 +474,101 @@ int xcd_frames_record_backtrace(xcd_frames_t *self, int log_fd)
     return 0;
 }
 
-static int xcd_frames_record_buildid_line(xcd_frames_t *self, const char *name, xcd_map_t *map, int log_fd, int dump_elf_hash)
+int xcd_frames_record_backtrace_binary(xcd_frames_t *self, int log_fd, xcc_binlog_t *binlog)
 {
-    char    buf[1024];
-    size_t  offset, i;
-    char   *error_from = "?";
+    xcd_frame_t *frame;
+    xcd_map_t   *maps[XCD_FRAMES_MAX];
+    char        *funcs[XCD_FRAMES_MAX];
+    size_t       modules[XCD_FRAMES_MAX], names[XCD_FRAMES_MAX];
+    size_t       maps_num = 0, funcs_num = 0, i;
+    int          added;
+    char         name_buf[512];
+    int          r;
 
-    //pathname
-    offset = (size_t)snprintf(buf, sizeof(buf), "    %s (BuildId: ", name);
-    
-    //append build-id
-    xcd_elf_t *elf;
-    uint8_t build_id[64];
-    size_t  build_id_len = 0;
-    if(NULL != (elf = xcd_map_get_elf(map, self->pid, (void *)self->maps)) &&
-       0 == xcd_elf_get_build_id(elf, build_id, sizeof(build_id), &build_id_len))
+    //intern the modules (by map) and the function names in the log-wide tables,
+    //the frames only refer to the indexes, and only the new entries are written
+    TAILQ_FOREACH(frame, &(self->frames), link)
     {
-        for(i = 0; i < build_id_len; i++)
-            offset += (size_t)snprintf(buf + offset, sizeof(buf) - offset, "%02hhx", build_id[i]);
+        modules[frame->num] = 0;
+        if(NULL != frame->map)
+        {
+            if(0 == (modules[frame->num] = xcc_binlog_intern_module(binlog, frame->map, &added))) return XCC_ERRNO_NOMEM;
+            if(added) maps[maps_num++] = frame->map;
+        }
+
+        names[frame->num] = 0;
+        if(NULL != frame->func_name)
+        {
+            if(0 == (names[frame->num] = xcc_binlog_intern_func(binlog, frame->func_name, &added))) return XCC_ERRNO_NOMEM;
+            if(added) funcs[funcs_num++] = frame->func_name;
+        }
     }
-    else
+
+    if(0 != (r = xcc_binlog_section_begin(binlog, log_fd, XCC_BINLOG_SECTION_BACKTRACE))) return r;
+    xcc_binlog_put_varint(binlog, self->frames_num);
+    xcc_binlog_put_varint(binlog, maps_num);
+    for(i = 0; i < maps_num; i++)
+    {
+        xcc_binlog_put_str(binlog, xcd_frames_get_map_name(self, maps[i], name_buf, sizeof(name_buf)));
+        xcc_binlog_put_varint(binlog, maps[i]->elf_start_offset);
+    }
+    xcc_binlog_put_varint(binlog, funcs_num);
+    for(i = 0; i < funcs_num; i++)
+        xcc_binlog_put_str(binlog, funcs[i]);
+    TAILQ_FOREACH(frame, &(self->frames), link)
     {
-        offset += (size_t)snprintf(buf + offset, sizeof(buf) - offset, "%s", "unknown");
+        xcc_binlog_put_varint(binlog, modules[frame->num]);
+        xcc_binlog_put_varint(binlog, frame->rel_pc);
+        xcc_binlog_put_varint(binlog, names[frame->num]);
+        xcc_binlog_put_varint(binlog, frame->func_offset);
+    }
+    return xcc_binlog_section_end(binlog);
+}
+
+int xcd_frames_record_proto(xcd_frames_t *self, xcd_proto_t *proto)
+{
+    xcd_frame_t *frame;
+    char         name_buf[512];
+    char         build_id_buf[64 * 2 + 1];
+    char        *build_id;
+
+    TAILQ_FOREACH(frame, &(self->frames), link)
+    {
+        xcd_proto_begin(proto, XCD_PROTO_THREAD_CURRENT_BACKTRACE);
+        xcd_proto_put_uint64(proto, XCD_PROTO_FRAME_REL_PC, frame->rel_pc);
+        xcd_proto_put_uint64(proto, XCD_PROTO_FRAME_PC, frame->pc);
+        xcd_proto_put_uint64(proto, XCD_PROTO_FRAME_SP, frame->sp);
+        xcd_proto_put_str(proto, XCD_PROTO_FRAME_FUNCTION_NAME, frame->func_name);
+        xcd_proto_put_uint64(proto, XCD_PROTO_FRAME_FUNCTION_OFFSET, frame->func_offset);
+        if(NULL != frame->map)
+        {
+            xcd_proto_put_str(proto, XCD_PROTO_FRAME_FILE_NAME, xcd_frames_get_map_name(self, frame->map, name_buf, sizeof(name_buf)));
+            xcd_proto_put_uint64(proto, XCD_PROTO_FRAME_FILE_MAP_OFFSET, frame->map->elf_start_offset);
+            if(NULL != (build_id = xcd_map_get_build_id(frame->map, self->pid, (void *)self->maps, build_id_buf, sizeof(build_id_buf))))
+                xcd_proto_put_str(proto, XCD_PROTO_FRAME_BUILD_ID, build_id);
+        }
+        xcd_proto_end(proto);
+    }
+
+    return proto->r;
+}
+
+static int xcd_frames_record_buildid_line(xcd_frames_t *self, const char *name, xcd_map_t *map, int log_fd, int dump_elf_hash, xcc_binlog_t *binlog)
+{
+    char    buf[1024];
+    size_t  offset = 0, i;
+    char   *error_from = "?";
+    char    build_id_str[XCD_MAP_BUILD_ID_MAX * 2 + 1];
+
+    //get build-id (cached in the map, without creating the ELF)
+    const uint8_t *build_id = NULL;
+    size_t         build_id_len = 0;
+    if(0 != xcd_map_get_build_id_bytes(map, self->pid, (void *)self->maps, &build_id, &build_id_len))
+    {
+        build_id_len = 0;
     }
 
-    //open file
+    //open file (the rest of the line goes to buf)
     int fd;
     errno = 0;
 #pragma clang diagnostic push
@@ -429,10 +647,22 @@ static int xcd_frames_record_buildid_line(xcd_frames_t *self, const char *name,
 
  end:
     if(fd >= 0) close(fd);
-    return xcc_util_write_str(log_fd, buf);
+
+    if(NULL != binlog)
+    {
+        xcc_binlog_put_str(binlog, name);
+        xcc_binlog_put_varint(binlog, build_id_len);
+        xcc_binlog_put_bytes(binlog, build_id, build_id_len);
+        xcc_binlog_put_str(binlog, buf);
+        return 0;
+    }
+
+    for(i = 0; i < build_id_len; i++)
+        snprintf(build_id_str + i * 2, sizeof(build_id_str) - i * 2, "%02hhx", build_id[i]);
+    return xcc_util_write_format(log_fd, "    %s (BuildId: %s%s", name, build_id_len > 0 ? build_id_str : "unknown", buf);
 }
 
-int xcd_frames_record_buildid(xcd_frames_t *self, int log_fd, int dump_elf_hash, uintptr_t fault_addr)
+static int xcd_frames_record_buildid_lines(xcd_frames_t *self, int log_fd, int dump_elf_hash, uintptr_t fault_addr, xcc_binlog_t *binlog)
 {
     xcd_frame_t *frame, *prev_frame;
     char        *name, *prev_name, *fault_addr_name = NULL;
@@ -440,15 +670,13 @@ int xcd_frames_record_buildid(xcd_frames_t *self, int log_fd, int dump_elf_hash,
     int          repeated;
     int          r;
 
-    if(0 != (r = xcc_util_write_str(log_fd, "build id:\n"))) return r;
-
     if(fault_addr > 0)
     {
         if(NULL != (map = xcd_maps_find_map(self->maps, fault_addr)))
         {
             if(NULL != map->name && '\0' != map->name[0])
             {
-                if(0 != (r = xcd_frames_record_buildid_line(self, map->name, map, log_fd, dump_elf_hash))) return r;
+                if(0 != (r = xcd_frames_record_buildid_line(self, map->name, map, log_fd, dump_elf_hash, binlog))) return r;
                 fault_addr_name = map->name;
             }
         }
@@ -477,14 +705,32 @@ int xcd_frames_record_buildid(xcd_frames_t *self, int log_fd, int dump_elf_hash,
         }
         if(repeated) continue;
 
-        if(0 != (r = xcd_frames_record_buildid_line(self, name, frame->map, log_fd, dump_elf_hash))) return r;
+        if(0 != (r = xcd_frames_record_buildid_line(self, name, frame->map, log_fd, dump_elf_hash, binlog))) return r;
     }
 
+    return 0;
+}
+
+int xcd_frames_record_buildid(xcd_frames_t *self, int log_fd, int dump_elf_hash, uintptr_t fault_addr)
+{
+    int r;
+
+    if(0 != (r = xcc_util_write_str(log_fd, "build id:\n"))) return r;
+    if(0 != (r = xcd_frames_record_buildid_lines(self, log_fd, dump_elf_hash, fault_addr, NULL))) return r;
     if(0 != (r = xcc_util_write_str(log_fd, "\n"))) return r;
 
     return 0;
 }
 
+int xcd_frames_record_buildid_binary(xcd_frames_t *self, int log_fd, xcc_binlog_t *binlog, int dump_elf_hash, uintptr_t fault_addr)
+{
+    int r;
+
+    if(0 != (r = xcc_binlog_section_begin(binlog, log_fd, XCC_BINLOG_SECTION_BUILDID))) return r;
+    if(0 != (r = xcd_frames_record_buildid_lines(self, log_fd, dump_elf_hash, fault_addr, binlog))) return r;
+    return xcc_binlog_section_end(binlog);
+}
+
 static int xcd_frames_record_stack_segment(xcd_frames_t *self, int log_fd,
                                            uintptr_t *sp, size_t words, int label)
 {
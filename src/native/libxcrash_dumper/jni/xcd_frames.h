@@ -28,6 +28,8 @@
 #include <sys/types.h>
 #include "xcd_regs.h"
 #include "xcd_maps.h"
+#include "xcc_binlog.h"
+#include "xcd_proto.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -42,6 +44,15 @@ int xcd_frames_record_backtrace(xcd_frames_t *self, int log_fd);
 int xcd_frames_record_buildid(xcd_frames_t *self, int log_fd, int dump_elf_hash, uintptr_t fault_addr);
 int xcd_frames_record_stack(xcd_frames_t *self, int log_fd);
 
+int xcd_frames_record_backtrace_binary(xcd_frames_t *self, int log_fd, xcc_binlog_t *binlog);
+int xcd_frames_record_buildid_binary(xcd_frames_t *self, int log_fd, xcc_binlog_t *binlog, int dump_elf_hash, uintptr_t fault_addr);
+
+int xcd_frames_record_proto(xcd_frames_t *self, xcd_proto_t *proto);
+
+uint64_t xcd_frames_get_signature(xcd_frames_t *self, uint64_t hash, size_t frames_max);
+
+size_t xcd_frames_fold(xcd_frames_t *self, uintptr_t stack_start, uintptr_t stack_end, int native_only, char *buf, size_t buf_len);
+
 #ifdef __cplusplus
 }
 #endif
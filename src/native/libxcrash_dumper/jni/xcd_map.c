@@ -21,6 +21,7 @@
 
 // Created by caikelun on 2019-03-07.
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <inttypes.h>
@@ -28,6 +29,8 @@
 #include "xcc_errno.h"
 #include "xcc_util.h"
 #include "xcd_map.h"
+#include "xcd_memory.h"
+#include "xcd_elf_interface.h"
 #include "xcd_util.h"
 #include "xcd_log.h"
 
@@ -60,12 +63,18 @@ int xcd_map_init(xcd_map_t *self, uintptr_t start, uintptr_t end,
     self->elf_offset = 0;
     self->elf_start_offset = 0;
 
+    self->build_id = NULL;
+    self->build_id_len = 0;
+    self->build_id_loaded = 0;
+
     return 0;
 }
 
 void xcd_map_uninit(xcd_map_t *self) {
     free(self->name);
     self->name = NULL;
+    free(self->build_id);
+    self->build_id = NULL;
 }
 
 xcd_elf_t* xcd_map_get_elf(xcd_map_t* self, pid_t pid, void *maps_obj) {
@@ -102,3 +111,46 @@ uintptr_t xcd_map_get_abs_pc(xcd_map_t *self, uintptr_t pc, pid_t pid, void *map
     
     return self->start + pc - load_bias - self->elf_offset;
 }
+
+int xcd_map_get_build_id_bytes(xcd_map_t *self, pid_t pid, void *maps_obj, const uint8_t **build_id, size_t *build_id_len) {
+    xcd_memory_t *memory = NULL;
+    uint8_t buf[XCD_MAP_BUILD_ID_MAX];
+    size_t len = 0;
+    int r;
+
+    if (0 == self->build_id_loaded) {
+        self->build_id_loaded = 1;
+
+        //reuse the ELF if it has been created for unwinding, otherwise only read the program headers
+        if (NULL != self->elf) {
+            r = xcd_elf_get_build_id(self->elf, buf, sizeof(buf), &len);
+        } else if (0 == (r = xcd_memory_create(&memory, self, pid, maps_obj))) {
+            r = xcd_elf_interface_read_build_id(memory, buf, sizeof(buf), &len);
+            xcd_memory_destroy(&memory);
+        }
+
+        if (0 == r && len > 0 && NULL != (self->build_id = malloc(len))) {
+            memcpy(self->build_id, buf, len);
+            self->build_id_len = len;
+        }
+    }
+
+    if (NULL == self->build_id) return XCC_ERRNO_MISSING;
+
+    *build_id = self->build_id;
+    *build_id_len = self->build_id_len;
+    return 0;
+}
+
+char *xcd_map_get_build_id(xcd_map_t *self, pid_t pid, void *maps_obj, char *buf, size_t len) {
+    const uint8_t *build_id;
+    size_t build_id_len = 0, i;
+
+    if (0 != xcd_map_get_build_id_bytes(self, pid, maps_obj, &build_id, &build_id_len)) return NULL;
+    if (len < build_id_len * 2 + 1) return NULL;
+
+    for (i = 0; i < build_id_len; i++)
+        snprintf(buf + i * 2, len - i * 2, "%02hhx", build_id[i]);
+
+    return buf;
+}
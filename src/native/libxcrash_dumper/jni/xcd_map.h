@@ -34,6 +34,8 @@ extern "C" {
 
 #define XCD_MAP_PORT_DEVICE 0x8000
 
+#define XCD_MAP_BUILD_ID_MAX 64
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wpadded"
 typedef struct xcd_map
@@ -50,6 +52,11 @@ typedef struct xcd_map
     int        elf_loaded;
     size_t     elf_offset;
     size_t     elf_start_offset;
+
+    //build-id (from the PT_NOTE segments, loaded once)
+    uint8_t   *build_id;
+    size_t     build_id_len;
+    int        build_id_loaded;
 } xcd_map_t;
 #pragma clang diagnostic pop
 
@@ -60,6 +67,8 @@ void xcd_map_uninit(xcd_map_t *self);
 xcd_elf_t *xcd_map_get_elf(xcd_map_t *self, pid_t pid, void *maps_obj);
 uintptr_t xcd_map_get_rel_pc(xcd_map_t *self, uintptr_t pc, pid_t pid, void *maps_obj);
 uintptr_t xcd_map_get_abs_pc(xcd_map_t *self, uintptr_t pc, pid_t pid, void *maps_obj);
+int xcd_map_get_build_id_bytes(xcd_map_t *self, pid_t pid, void *maps_obj, const uint8_t **build_id, size_t *build_id_len);
+char *xcd_map_get_build_id(xcd_map_t *self, pid_t pid, void *maps_obj, char *buf, size_t len);
 
 #ifdef __cplusplus
 }
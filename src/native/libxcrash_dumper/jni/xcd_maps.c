@@ -52,6 +52,8 @@ struct xcd_maps
 {
     xcd_maps_item_queue_t maps;
     pid_t                 pid;
+    uintptr_t             max_size;
+    size_t                max_offset;
 };
 #pragma clang diagnostic pop
 
@@ -75,7 +77,7 @@ static int xcd_maps_parse_line(char *line, xcd_maps_item_t **mi)
     return xcd_map_init(&((*mi)->map), start, end, offset, flags, name);
 }
 
-int xcd_maps_create(xcd_maps_t **self, pid_t pid)
+static int xcd_maps_load(xcd_maps_t **self, pid_t pid, const char *pathname)
 {
     char             buf[512];
     FILE            *fp;
@@ -85,9 +87,10 @@ int xcd_maps_create(xcd_maps_t **self, pid_t pid)
     if(NULL == (*self = malloc(sizeof(xcd_maps_t)))) return XCC_ERRNO_NOMEM;
     TAILQ_INIT(&((*self)->maps));
     (*self)->pid = pid;
+    (*self)->max_size = 0;
+    (*self)->max_offset = 0;
 
-    snprintf(buf, sizeof(buf), "/proc/%d/maps", pid);
-    if(NULL == (fp = fopen(buf, "r"))) return XCC_ERRNO_SYS;
+    if(NULL == (fp = fopen(pathname, "r"))) return XCC_ERRNO_SYS;
 
     while(fgets(buf, sizeof(buf), fp))
     {
@@ -98,13 +101,40 @@ int xcd_maps_create(xcd_maps_t **self, pid_t pid)
         }
         
         if(NULL != mi)
+        {
             TAILQ_INSERT_TAIL(&((*self)->maps), mi, link);
+
+            //for the width of size and offset columns
+            if(mi->map.end - mi->map.start > (*self)->max_size) (*self)->max_size = mi->map.end - mi->map.start;
+            if(mi->map.offset > (*self)->max_offset) (*self)->max_offset = mi->map.offset;
+        }
     }
     
     fclose(fp);
     return 0;
 }
 
+int xcd_maps_create(xcd_maps_t **self, pid_t pid)
+{
+    char pathname[64];
+
+    snprintf(pathname, sizeof(pathname), "/proc/%d/maps", pid);
+    return xcd_maps_load(self, pid, pathname);
+}
+
+//the maps saved in a file (in the format of /proc/PID/maps), it's only used for comparing
+int xcd_maps_create_from_file(xcd_maps_t **self, const char *pathname)
+{
+    int r;
+
+    if(0 != (r = xcd_maps_load(self, 0, pathname)))
+    {
+        if(NULL != *self) xcd_maps_destroy(self);
+        return r;
+    }
+    return 0;
+}
+
 void xcd_maps_destroy(xcd_maps_t **self)
 {
     xcd_maps_item_t *mi, *mi_tmp;
@@ -115,6 +145,7 @@ void xcd_maps_destroy(xcd_maps_t **self)
         free(mi);
     }
 
+    free(*self);
     *self = NULL;
 }
 
@@ -188,56 +219,52 @@ uintptr_t xcd_maps_find_pc(xcd_maps_t *self, const char *pathname, const char *s
     return 0; //not found
 }
 
+static size_t xcd_maps_get_width(uintptr_t value)
+{
+    size_t width = 1;
+
+    while(value >= 0x10)
+    {
+        value /= 0x10;
+        width++;
+    }
+    return width;
+}
+
+static int xcd_maps_record_item(xcd_maps_item_t *mi, size_t width_offset, size_t width_size, const char *name, int log_fd)
+{
+    uintptr_t load_bias;
+    char      load_bias_buf[64] = "\0";
+
+    //get load_bias
+    if(NULL != mi->map.elf && 0 != (load_bias = xcd_elf_get_load_bias(mi->map.elf)))
+        snprintf(load_bias_buf, sizeof(load_bias_buf), " (load base 0x%"PRIxPTR")", load_bias);
+
+    return xcc_util_write_format(log_fd,
+                                 "    %0"XCC_UTIL_FMT_ADDR"-%0"XCC_UTIL_FMT_ADDR" %c%c%c %*"PRIxPTR" %*"PRIxPTR" %s%s\n",
+                                 mi->map.start, mi->map.end,
+                                 mi->map.flags & PROT_READ ? 'r' : '-',
+                                 mi->map.flags & PROT_WRITE ? 'w' : '-',
+                                 mi->map.flags & PROT_EXEC ? 'x' : '-',
+                                 width_offset, mi->map.offset,
+                                 width_size, mi->map.end - mi->map.start,
+                                 name, load_bias_buf);
+}
+
 int xcd_maps_record(xcd_maps_t *self, int log_fd)
 {
     int              r;
     xcd_maps_item_t *mi;
-    uintptr_t        size;
     uintptr_t        total_size = 0;
-    size_t           max_size = 0;
-    size_t           max_offset = 0;
-    size_t           width_size = 0;
-    size_t           width_offset = 0;
-    uintptr_t        load_bias = 0;
-    char             load_bias_buf[64] = "\0";
+    size_t           width_size = xcd_maps_get_width(self->max_size);
+    size_t           width_offset = xcd_maps_get_width(self->max_offset);
     char            *name = "";
     char            *prev_name = NULL;
 
-    //get width of size and offset columns
-    TAILQ_FOREACH(mi, &(self->maps), link)
-    {
-        size = mi->map.end - mi->map.start;
-        if(size > max_size) max_size = size;
-        if(mi->map.offset > max_offset) max_offset = mi->map.offset;
-    }
-    while(0 != max_size)
-    {
-        max_size /= 0x10;
-        width_size++;
-    }
-    if(0 == width_size) width_size = 1;
-    while(0 != max_offset)
-    {
-        max_offset /= 0x10;
-        width_offset++;
-    }
-    if(0 == width_offset) width_offset = 1;
-
     //dump
     if(0 != (r = xcc_util_write_str(log_fd, "memory map:\n"))) return r;
     TAILQ_FOREACH(mi, &(self->maps), link)
     {
-        //get load_bias
-        if(NULL != mi->map.elf)
-        {
-            if(0 != (load_bias = xcd_elf_get_load_bias(mi->map.elf)))
-                snprintf(load_bias_buf, sizeof(load_bias_buf), " (load base 0x%"PRIxPTR")", load_bias);
-        }
-        else
-        {
-            load_bias_buf[0] = '\0';
-        }
-
         //get name
         if(NULL != mi->map.name)
         {
@@ -257,21 +284,345 @@ int xcd_maps_record(xcd_maps_t *self, int log_fd)
         prev_name = mi->map.name;
 
         //update total size
+        total_size += mi->map.end - mi->map.start;
+
+        if(0 != (r = xcd_maps_record_item(mi, width_offset, width_size, name, log_fd))) return r;
+    }
+    if(0 != (r = xcc_util_write_format(log_fd, "    TOTAL SIZE: 0x%"PRIxPTR"K (%"PRIuPTR"K)\n\n",
+                                       total_size / 1024, total_size / 1024))) return r;
+
+    return 0;
+}
+
+#define XCD_MAPS_SUMMARY_PERM_NONE  0
+#define XCD_MAPS_SUMMARY_PERM_R     1
+#define XCD_MAPS_SUMMARY_PERM_RW    2
+#define XCD_MAPS_SUMMARY_PERM_RX    3
+#define XCD_MAPS_SUMMARY_PERM_OTHER 4
+#define XCD_MAPS_SUMMARY_PERM_CNT   5
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wpadded"
+typedef struct
+{
+    char      name[256];
+    size_t    count;
+    uintptr_t size;
+    size_t    perms[XCD_MAPS_SUMMARY_PERM_CNT];
+} xcd_maps_group_t;
+#pragma clang diagnostic pop
+
+//the anonymous mappings are grouped by their tag, the trailing detail is replaced by "*"
+//e.g. "[anon:dalvik-main space]" -> "[anon:dalvik-*]", "[anon:scudo:primary]" -> "[anon:scudo:*]"
+static void xcd_maps_get_group_name(const char *name, char *buf, size_t len)
+{
+    const char *p;
+
+    if(NULL == name)
+        snprintf(buf, len, "[anon]");
+    else if(0 == strncmp(name, "/dev/ashmem/", 12))
+        snprintf(buf, len, "/dev/ashmem/*");
+    else if(0 == strncmp(name, "/memfd:", 7))
+        snprintf(buf, len, "/memfd:*");
+    else if(0 == strncmp(name, "[anon:", 6) && NULL != (p = strpbrk(name + 6, "-:]")) && ']' != *p)
+        snprintf(buf, len, "%.*s*]", (int)(p - name + 1), name);
+    else
+        snprintf(buf, len, "%s", name);
+}
+
+static size_t xcd_maps_get_summary_perm(xcd_map_t *map)
+{
+    switch(map->flags & (PROT_READ | PROT_WRITE | PROT_EXEC))
+    {
+    case PROT_NONE:
+        return XCD_MAPS_SUMMARY_PERM_NONE;
+    case PROT_READ:
+        return XCD_MAPS_SUMMARY_PERM_R;
+    case PROT_READ | PROT_WRITE:
+        return XCD_MAPS_SUMMARY_PERM_RW;
+    case PROT_READ | PROT_EXEC:
+        return XCD_MAPS_SUMMARY_PERM_RX;
+    default:
+        return XCD_MAPS_SUMMARY_PERM_OTHER;
+    }
+}
+
+static int xcd_maps_group_cmp(const void *a, const void *b)
+{
+    const xcd_maps_group_t *ga = (const xcd_maps_group_t *)a;
+    const xcd_maps_group_t *gb = (const xcd_maps_group_t *)b;
+
+    //bigger first
+    if(ga->size != gb->size) return ga->size > gb->size ? -1 : 1;
+    return strcmp(ga->name, gb->name);
+}
+
+//the mappings are grouped by the path or the anonymous tag, with count, size and permission breakdown.
+//only the mappings around the fault address and the ones of ELFs loaded while unwinding are recorded in full.
+int xcd_maps_record_summary(xcd_maps_t *self, uintptr_t fault_addr, int log_fd)
+{
+    int               r = 0;
+    xcd_maps_item_t  *mi, *fault_mi = NULL;
+    xcd_maps_group_t *groups = NULL, *tmp;
+    size_t            groups_cnt = 0, groups_cap = 0, i;
+    char              name[256];
+    uintptr_t         total_size = 0;
+    size_t            width_size = xcd_maps_get_width(self->max_size);
+    size_t            width_offset = xcd_maps_get_width(self->max_offset);
+    int               near_fault;
+
+    //the mapping containing the fault address (or the first one above it)
+    if(0 != fault_addr)
+    {
+        TAILQ_FOREACH(mi, &(self->maps), link)
+        {
+            if(fault_addr < mi->map.end)
+            {
+                fault_mi = mi;
+                break;
+            }
+        }
+    }
+
+    //the mappings recorded in full
+    if(0 != (r = xcc_util_write_str(log_fd, "memory map excerpt:\n"))) return r;
+    TAILQ_FOREACH(mi, &(self->maps), link)
+    {
+        near_fault = (NULL != fault_mi &&
+                      (mi == fault_mi ||
+                       mi == TAILQ_PREV(fault_mi, xcd_maps_item_queue, link) ||
+                       mi == TAILQ_NEXT(fault_mi, link)));
+        if(!near_fault && (NULL == mi->map.elf || !(mi->map.flags & PROT_EXEC))) continue;
+
+        if(0 != (r = xcd_maps_record_item(mi, width_offset, width_size, NULL == mi->map.name ? "" : mi->map.name, log_fd))) return r;
+    }
+    if(0 != (r = xcc_util_write_str(log_fd, "\n"))) return r;
+
+    //group
+    TAILQ_FOREACH(mi, &(self->maps), link)
+    {
+        xcd_maps_get_group_name(mi->map.name, name, sizeof(name));
+        for(i = 0; i < groups_cnt; i++)
+            if(0 == strcmp(groups[i].name, name)) break;
+        if(i == groups_cnt)
+        {
+            if(groups_cnt == groups_cap)
+            {
+                if(NULL == (tmp = realloc(groups, (groups_cap + 64) * sizeof(xcd_maps_group_t))))
+                {
+                    r = XCC_ERRNO_NOMEM;
+                    goto end;
+                }
+                groups = tmp;
+                groups_cap += 64;
+            }
+            memset(&(groups[i]), 0, sizeof(xcd_maps_group_t));
+            strncpy(groups[i].name, name, sizeof(groups[i].name) - 1);
+            groups_cnt++;
+        }
+
+        groups[i].count++;
+        groups[i].size += mi->map.end - mi->map.start;
+        groups[i].perms[xcd_maps_get_summary_perm(&(mi->map))]++;
+        total_size += mi->map.end - mi->map.start;
+    }
+    if(groups_cnt > 0) qsort(groups, groups_cnt, sizeof(xcd_maps_group_t), xcd_maps_group_cmp);
+
+    //dump
+    if(0 != (r = xcc_util_write_format(log_fd, "memory map summary:\n    %6s %10s %5s %5s %5s %5s %5s %s\n",
+                                       "COUNT", "SIZE", "---", "r--", "rw-", "r-x", "other", "NAME"))) goto end;
+    for(i = 0; i < groups_cnt; i++)
+    {
+        if(0 != (r = xcc_util_write_format(log_fd, "    %6zu %9"PRIuPTR"K %5zu %5zu %5zu %5zu %5zu %s\n",
+                                           groups[i].count, groups[i].size / 1024,
+                                           groups[i].perms[XCD_MAPS_SUMMARY_PERM_NONE],
+                                           groups[i].perms[XCD_MAPS_SUMMARY_PERM_R],
+                                           groups[i].perms[XCD_MAPS_SUMMARY_PERM_RW],
+                                           groups[i].perms[XCD_MAPS_SUMMARY_PERM_RX],
+                                           groups[i].perms[XCD_MAPS_SUMMARY_PERM_OTHER],
+                                           groups[i].name))) goto end;
+    }
+    if(0 != (r = xcc_util_write_format(log_fd, "    TOTAL SIZE: 0x%"PRIxPTR"K (%"PRIuPTR"K)\n\n",
+                                       total_size / 1024, total_size / 1024))) goto end;
+
+ end:
+    free(groups);
+    return r;
+}
+
+static int xcd_maps_is_same(xcd_map_t *map, xcd_map_t *baseline_map)
+{
+    if(map->end != baseline_map->end || map->offset != baseline_map->offset || map->flags != baseline_map->flags) return 0;
+    if(NULL == map->name || NULL == baseline_map->name) return map->name == baseline_map->name;
+    return 0 == strcmp(map->name, baseline_map->name);
+}
+
+static int xcd_maps_record_delta_removed(xcd_map_t *map, int log_fd)
+{
+    return xcc_util_write_format(log_fd, "    - %0"XCC_UTIL_FMT_ADDR"-%0"XCC_UTIL_FMT_ADDR"\n", map->start, map->end);
+}
+
+//both of the maps are sorted by the start address, they are compared in one pass.
+//"+" for the added mappings, "*" for the changed ones (and the ones with a load base), "-" for the removed ones.
+int xcd_maps_record_delta(xcd_maps_t *self, xcd_maps_t *baseline, const char *baseline_name, int log_fd)
+{
+    int              r;
+    xcd_maps_item_t *mi;
+    xcd_maps_item_t *bmi;
+    uintptr_t        size;
+    uintptr_t        total_size = 0;
+    uintptr_t        load_bias;
+    char             load_bias_buf[64];
+    int              same;
+    char             tag;
+
+    if(0 != (r = xcc_util_write_format(log_fd, "memory map delta:\n    baseline: %s\n", baseline_name))) return r;
+
+    bmi = TAILQ_FIRST(&(baseline->maps));
+    TAILQ_FOREACH(mi, &(self->maps), link)
+    {
         size = mi->map.end - mi->map.start;
         total_size += size;
 
+        //get load_bias
+        load_bias_buf[0] = '\0';
+        if(NULL != mi->map.elf && 0 != (load_bias = xcd_elf_get_load_bias(mi->map.elf)))
+            snprintf(load_bias_buf, sizeof(load_bias_buf), " (load base 0x%"PRIxPTR")", load_bias);
+
+        //removed from the baseline
+        while(NULL != bmi && bmi->map.start < mi->map.start)
+        {
+            if(0 != (r = xcd_maps_record_delta_removed(&(bmi->map), log_fd))) return r;
+            bmi = TAILQ_NEXT(bmi, link);
+        }
+
+        //added or changed
+        if(NULL != bmi && bmi->map.start == mi->map.start)
+        {
+            same = xcd_maps_is_same(&(mi->map), &(bmi->map));
+            bmi = TAILQ_NEXT(bmi, link);
+            if(same && '\0' == load_bias_buf[0]) continue; //unchanged
+            tag = '*';
+        }
+        else
+        {
+            tag = '+';
+        }
+
         if(0 != (r = xcc_util_write_format(log_fd,
-                                           "    %0"XCC_UTIL_FMT_ADDR"-%0"XCC_UTIL_FMT_ADDR" %c%c%c %*"PRIxPTR" %*"PRIxPTR" %s%s\n",
-                                           mi->map.start, mi->map.end,
+                                           "    %c %0"XCC_UTIL_FMT_ADDR"-%0"XCC_UTIL_FMT_ADDR" %c%c%c %"PRIxPTR" %"PRIxPTR" %s%s\n",
+                                           tag, mi->map.start, mi->map.end,
                                            mi->map.flags & PROT_READ ? 'r' : '-',
                                            mi->map.flags & PROT_WRITE ? 'w' : '-',
                                            mi->map.flags & PROT_EXEC ? 'x' : '-',
-                                           width_offset, mi->map.offset,
-                                           width_size, size,
-                                           name, load_bias_buf))) return r;
+                                           mi->map.offset, size,
+                                           NULL == mi->map.name ? "" : mi->map.name, load_bias_buf))) return r;
     }
+    for(; NULL != bmi; bmi = TAILQ_NEXT(bmi, link))
+        if(0 != (r = xcd_maps_record_delta_removed(&(bmi->map), log_fd))) return r;
+
     if(0 != (r = xcc_util_write_format(log_fd, "    TOTAL SIZE: 0x%"PRIxPTR"K (%"PRIuPTR"K)\n\n",
                                        total_size / 1024, total_size / 1024))) return r;
 
     return 0;
 }
+
+int xcd_maps_record_proto(xcd_maps_t *self, xcd_proto_t *proto)
+{
+    xcd_maps_item_t *mi;
+    char             build_id_buf[64 * 2 + 1];
+    char            *build_id;
+
+    TAILQ_FOREACH(mi, &(self->maps), link)
+    {
+        xcd_proto_begin(proto, XCD_PROTO_TOMBSTONE_MEMORY_MAPPINGS);
+        xcd_proto_put_uint64(proto, XCD_PROTO_MAPPING_BEGIN_ADDRESS, mi->map.start);
+        xcd_proto_put_uint64(proto, XCD_PROTO_MAPPING_END_ADDRESS, mi->map.end);
+        xcd_proto_put_uint64(proto, XCD_PROTO_MAPPING_OFFSET, mi->map.offset);
+        xcd_proto_put_bool(proto, XCD_PROTO_MAPPING_READ, mi->map.flags & PROT_READ);
+        xcd_proto_put_bool(proto, XCD_PROTO_MAPPING_WRITE, mi->map.flags & PROT_WRITE);
+        xcd_proto_put_bool(proto, XCD_PROTO_MAPPING_EXECUTE, mi->map.flags & PROT_EXEC);
+        xcd_proto_put_str(proto, XCD_PROTO_MAPPING_MAPPING_NAME, mi->map.name);
+
+        //only the ELFs already loaded while unwinding, loading all of them takes too long
+        if(NULL != mi->map.elf)
+        {
+            if(NULL != (build_id = xcd_map_get_build_id(&(mi->map), self->pid, (void *)self, build_id_buf, sizeof(build_id_buf))))
+                xcd_proto_put_str(proto, XCD_PROTO_MAPPING_BUILD_ID, build_id);
+            xcd_proto_put_uint64(proto, XCD_PROTO_MAPPING_LOAD_BIAS, xcd_elf_get_load_bias(mi->map.elf));
+        }
+        xcd_proto_end(proto);
+    }
+
+    return proto->r;
+}
+
+//the consecutive mappings of the same file are one module, only the executable ones are recorded.
+//it reads the program headers of every module for its build-id, so it's slower than recording the maps.
+int xcd_maps_record_minidump(xcd_maps_t *self, xcd_minidump_t *md)
+{
+    xcd_maps_item_t         *mi, *first, *last, *exec;
+    uint8_t                 *list, *module;
+    uint8_t                  cv[4 + XCD_MAP_BUILD_ID_MAX];
+    const uint8_t           *build_id;
+    size_t                   build_id_len;
+    size_t                   modules_max = 0, modules_num = 0;
+    uint32_t                 name_rva;
+    xcd_minidump_location_t  loc;
+
+    //the number of executable mappings is the upper limit
+    TAILQ_FOREACH(mi, &(self->maps), link)
+        if(NULL != mi->map.name && '/' == mi->map.name[0] && (mi->map.flags & PROT_EXEC)) modules_max++;
+    if(0 == modules_max) return md->r;
+
+    //module list: count + modules
+    if(NULL == (list = calloc(1, 4 + modules_max * XCD_MINIDUMP_MODULE_SIZE))) return XCC_ERRNO_NOMEM;
+
+    mi = TAILQ_FIRST(&(self->maps));
+    while(NULL != mi)
+    {
+        if(NULL == mi->map.name || '/' != mi->map.name[0])
+        {
+            mi = TAILQ_NEXT(mi, link);
+            continue;
+        }
+
+        //group the mappings, the file offset keeps growing within a module
+        first = mi;
+        last = NULL;
+        exec = NULL;
+        while(NULL != mi && NULL != mi->map.name && 0 == strcmp(mi->map.name, first->map.name) &&
+              (NULL == last || mi->map.offset > last->map.offset))
+        {
+            if(NULL == exec && (mi->map.flags & PROT_EXEC)) exec = mi;
+            last = mi;
+            mi = TAILQ_NEXT(mi, link);
+        }
+        if(NULL == exec || NULL == last) continue;
+
+        module = list + 4 + modules_num * XCD_MINIDUMP_MODULE_SIZE;
+        modules_num++;
+
+        //base, size, checksum, timestamp, name
+        xcd_minidump_write_string(md, first->map.name, &name_rva);
+        xcd_minidump_put_u64(module, first->map.start);
+        xcd_minidump_put_u32(module + 8, (uint32_t)(last->map.end - first->map.start));
+        xcd_minidump_put_u32(module + 20, name_rva);
+
+        //CodeView record
+        if(0 == xcd_map_get_build_id_bytes(&(exec->map), self->pid, (void *)self, &build_id, &build_id_len))
+        {
+            xcd_minidump_put_u32(cv, XCD_MINIDUMP_CV_SIGNATURE_ELF);
+            memcpy(cv + 4, build_id, build_id_len);
+            xcd_minidump_write(md, cv, 4 + build_id_len, &loc);
+            xcd_minidump_put_location(module + 76, &loc);
+        }
+    }
+
+    xcd_minidump_put_u32(list, (uint32_t)modules_num);
+    xcd_minidump_write(md, list, 4 + modules_num * XCD_MINIDUMP_MODULE_SIZE, &loc);
+    xcd_minidump_add_stream(md, XCD_MINIDUMP_STREAM_MODULE_LIST, &loc);
+
+    free(list);
+    return md->r;
+}
@@ -27,6 +27,8 @@
 #include <stdint.h>
 #include <sys/types.h>
 #include "xcd_map.h"
+#include "xcd_proto.h"
+#include "xcd_minidump.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -35,6 +37,7 @@ extern "C" {
 typedef struct xcd_maps xcd_maps_t;
 
 int xcd_maps_create(xcd_maps_t **self, pid_t pid);
+int xcd_maps_create_from_file(xcd_maps_t **self, const char *pathname);
 void xcd_maps_destroy(xcd_maps_t **self);
 
 xcd_map_t *xcd_maps_find_map(xcd_maps_t *self, uintptr_t pc);
@@ -45,6 +48,10 @@ uintptr_t xcd_maps_find_abort_msg(xcd_maps_t *self);
 uintptr_t xcd_maps_find_pc(xcd_maps_t *self, const char *pathname, const char *symbol);
 
 int xcd_maps_record(xcd_maps_t *self, int log_fd);
+int xcd_maps_record_summary(xcd_maps_t *self, uintptr_t fault_addr, int log_fd);
+int xcd_maps_record_delta(xcd_maps_t *self, xcd_maps_t *baseline, const char *baseline_name, int log_fd);
+int xcd_maps_record_proto(xcd_maps_t *self, xcd_proto_t *proto);
+int xcd_maps_record_minidump(xcd_maps_t *self, xcd_minidump_t *md);
 
 #ifdef __cplusplus
 }
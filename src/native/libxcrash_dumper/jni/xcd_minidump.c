@@ -0,0 +1,313 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Created by agent on 2026-10-17.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/utsname.h>
+#include "xcc_errno.h"
+#include "xcc_util.h"
+#include "xcd_minidump.h"
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wgnu-statement-expression"
+
+#define XCD_MINIDUMP_HEADER_SIZE      32
+#define XCD_MINIDUMP_DIRECTORY_SIZE   12
+#define XCD_MINIDUMP_MEMORY_DESC_SIZE 16
+#define XCD_MINIDUMP_SYSTEM_INFO_SIZE 56
+#define XCD_MINIDUMP_PLATFORM_ANDROID 0x8203
+#define XCD_MINIDUMP_ALIGN            8
+#define XCD_MINIDUMP_STRING_MAX       1024
+
+//all supported ABIs are little-endian
+void xcd_minidump_put_u16(uint8_t *p, uint16_t v)
+{
+    memcpy(p, &v, sizeof(v));
+}
+
+void xcd_minidump_put_u32(uint8_t *p, uint32_t v)
+{
+    memcpy(p, &v, sizeof(v));
+}
+
+void xcd_minidump_put_u64(uint8_t *p, uint64_t v)
+{
+    memcpy(p, &v, sizeof(v));
+}
+
+void xcd_minidump_put_location(uint8_t *p, xcd_minidump_location_t *loc)
+{
+    xcd_minidump_put_u32(p, loc->size);
+    xcd_minidump_put_u32(p + 4, loc->rva);
+}
+
+static void xcd_minidump_append(xcd_minidump_t *self, const void *data, size_t len)
+{
+    if(0 != self->r) return;
+
+    if(len > UINT32_MAX - self->pos)
+    {
+        self->r = XCC_ERRNO_RANGE;
+        return;
+    }
+    if(0 != (self->r = xcc_util_write(self->fd, (const char *)data, len))) return;
+    self->pos += (uint32_t)len;
+}
+
+static void xcd_minidump_align(xcd_minidump_t *self)
+{
+    uint8_t zeros[XCD_MINIDUMP_ALIGN] = {0};
+    size_t  pad = (XCD_MINIDUMP_ALIGN - self->pos % XCD_MINIDUMP_ALIGN) % XCD_MINIDUMP_ALIGN;
+
+    if(pad > 0) xcd_minidump_append(self, zeros, pad);
+}
+
+void xcd_minidump_init(xcd_minidump_t *self, int fd)
+{
+    uint8_t zeros[XCD_MINIDUMP_HEADER_SIZE + sizeof(self->streams)];
+
+    self->fd = fd;
+    self->r = 0;
+    self->pos = 0;
+    self->streams_num = 0;
+    self->memory_num = 0;
+    memset(self->streams, 0, sizeof(self->streams));
+
+    //reserve the header and the stream directory
+    memset(zeros, 0, sizeof(zeros));
+    xcd_minidump_append(self, zeros, sizeof(zeros));
+}
+
+void xcd_minidump_write(xcd_minidump_t *self, const void *data, size_t len, xcd_minidump_location_t *loc)
+{
+    xcd_minidump_align(self);
+    if(NULL != loc)
+    {
+        loc->size = (uint32_t)len;
+        loc->rva = self->pos;
+    }
+    xcd_minidump_append(self, data, len);
+    if(0 != self->r && NULL != loc) loc->size = 0;
+}
+
+static size_t xcd_minidump_utf8_decode(const uint8_t *p, uint32_t *c)
+{
+    size_t len, i;
+
+    if(0xf0 == (*p & 0xf8)) len = 4;
+    else if(0xe0 == (*p & 0xf0)) len = 3;
+    else if(0xc0 == (*p & 0xe0)) len = 2;
+    else len = 1;
+
+    *c = (len > 1 ? (uint32_t)(*p & (0x7f >> len)) : *p);
+    for(i = 1; i < len; i++)
+    {
+        if(0x80 != (p[i] & 0xc0))
+        {
+            //invalid sequence, keep the byte as it is
+            *c = *p;
+            return 1;
+        }
+        *c = (*c << 6) | (p[i] & 0x3f);
+    }
+    return len;
+}
+
+void xcd_minidump_write_string(xcd_minidump_t *self, const char *str, uint32_t *rva)
+{
+    uint8_t        buf[4 + (XCD_MINIDUMP_STRING_MAX + 1) * 2];
+    const uint8_t *p = (const uint8_t *)str;
+    uint32_t       c, n = 0;
+
+    //UTF-8 to UTF-16LE
+    while('\0' != *p && n < XCD_MINIDUMP_STRING_MAX - 1)
+    {
+        p += xcd_minidump_utf8_decode(p, &c);
+
+        if(c >= 0x10000)
+        {
+            c -= 0x10000;
+            xcd_minidump_put_u16(buf + 4 + n++ * 2, (uint16_t)(0xd800 + (c >> 10)));
+            xcd_minidump_put_u16(buf + 4 + n++ * 2, (uint16_t)(0xdc00 + (c & 0x3ff)));
+        }
+        else
+        {
+            xcd_minidump_put_u16(buf + 4 + n++ * 2, (uint16_t)c);
+        }
+    }
+    xcd_minidump_put_u16(buf + 4 + n * 2, 0);
+
+    //the length in bytes, not including the terminator
+    xcd_minidump_put_u32(buf, n * 2);
+
+    xcd_minidump_align(self);
+    *rva = self->pos;
+    xcd_minidump_append(self, buf, 4 + (n + 1) * 2);
+}
+
+void xcd_minidump_write_file(xcd_minidump_t *self, uint32_t type, const char *path)
+{
+    xcd_minidump_location_t loc;
+    char                    buf[4096];
+    int                     fd;
+    ssize_t                 n;
+
+    if(0 != self->r) return;
+    if(0 > (fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(path, O_RDONLY | O_CLOEXEC)))) return; //not an error
+
+    xcd_minidump_align(self);
+    loc.rva = self->pos;
+    while(0 == self->r && 0 < (n = XCC_UTIL_TEMP_FAILURE_RETRY(read(fd, buf, sizeof(buf)))))
+        xcd_minidump_append(self, buf, (size_t)n);
+    close(fd);
+
+    loc.size = self->pos - loc.rva;
+    if(0 == self->r && loc.size > 0) xcd_minidump_add_stream(self, type, &loc);
+}
+
+void xcd_minidump_write_system_info(xcd_minidump_t *self)
+{
+    xcd_minidump_location_t loc;
+    uint8_t                 info[XCD_MINIDUMP_SYSTEM_INFO_SIZE];
+    struct utsname          uts;
+    char                    buf[512];
+    unsigned int            major = 0, minor = 0, build = 0;
+    uint32_t                rva = 0;
+    long                    cpus;
+
+    memset(info, 0, sizeof(info));
+    memset(&uts, 0, sizeof(uts));
+    buf[0] = '\0';
+    if(0 == uname(&uts))
+    {
+        sscanf(uts.release, "%u.%u.%u", &major, &minor, &build);
+        snprintf(buf, sizeof(buf), "%s %s %s %s", uts.sysname, uts.release, uts.version, uts.machine);
+    }
+    xcd_minidump_write_string(self, buf, &rva);
+    cpus = sysconf(_SC_NPROCESSORS_CONF);
+
+    xcd_minidump_put_u16(info, XCD_MINIDUMP_CPU_ARCH);
+    info[6] = (uint8_t)(cpus > 0 && cpus <= UINT8_MAX ? cpus : 1);
+    xcd_minidump_put_u32(info + 8, major);
+    xcd_minidump_put_u32(info + 12, minor);
+    xcd_minidump_put_u32(info + 16, build);
+    xcd_minidump_put_u32(info + 20, XCD_MINIDUMP_PLATFORM_ANDROID);
+    xcd_minidump_put_u32(info + 24, rva);
+
+    xcd_minidump_write(self, info, sizeof(info), &loc);
+    xcd_minidump_add_stream(self, XCD_MINIDUMP_STREAM_SYSTEM_INFO, &loc);
+}
+
+void xcd_minidump_add_stream(xcd_minidump_t *self, uint32_t type, xcd_minidump_location_t *loc)
+{
+    uint8_t *entry;
+
+    if(0 != self->r) return;
+    if(self->streams_num >= XCD_MINIDUMP_STREAMS_MAX)
+    {
+        self->r = XCC_ERRNO_RANGE;
+        return;
+    }
+
+    entry = self->streams + self->streams_num * XCD_MINIDUMP_DIRECTORY_SIZE;
+    xcd_minidump_put_u32(entry, type);
+    xcd_minidump_put_location(entry + 4, loc);
+    self->streams_num++;
+}
+
+void xcd_minidump_add_memory(xcd_minidump_t *self, uintptr_t start, const void *data, size_t len, xcd_minidump_location_t *loc)
+{
+    xcd_minidump_location_t mem_loc;
+    uint8_t                *desc;
+
+    if(NULL != loc) loc->size = 0;
+
+    //the memory list is full, this range is ignored
+    if(self->memory_num >= XCD_MINIDUMP_MEMORY_MAX) return;
+
+    xcd_minidump_write(self, data, len, &mem_loc);
+    if(0 != self->r) return;
+
+    desc = self->memory + self->memory_num * XCD_MINIDUMP_MEMORY_DESC_SIZE;
+    xcd_minidump_put_u64(desc, start);
+    xcd_minidump_put_location(desc + 8, &mem_loc);
+    self->memory_num++;
+
+    if(NULL != loc) *loc = mem_loc;
+}
+
+int xcd_minidump_has_memory(xcd_minidump_t *self, uintptr_t start, size_t len)
+{
+    uint64_t desc_start;
+    uint32_t desc_len;
+    size_t   i;
+
+    for(i = 0; i < self->memory_num; i++)
+    {
+        memcpy(&desc_start, self->memory + i * XCD_MINIDUMP_MEMORY_DESC_SIZE, sizeof(desc_start));
+        memcpy(&desc_len, self->memory + i * XCD_MINIDUMP_MEMORY_DESC_SIZE + 8, sizeof(desc_len));
+        if(start < desc_start + desc_len && desc_start < (uint64_t)start + len) return 1;
+    }
+    return 0;
+}
+
+int xcd_minidump_finish(xcd_minidump_t *self, uint32_t time)
+{
+    xcd_minidump_location_t loc;
+    uint8_t                 header[XCD_MINIDUMP_HEADER_SIZE];
+    uint8_t                 count[4];
+
+    //memory list: count + descriptors
+    if(self->memory_num > 0)
+    {
+        xcd_minidump_put_u32(count, (uint32_t)self->memory_num);
+        xcd_minidump_write(self, count, sizeof(count), &loc);
+        xcd_minidump_append(self, self->memory, self->memory_num * XCD_MINIDUMP_MEMORY_DESC_SIZE);
+        loc.size = (uint32_t)(sizeof(count) + self->memory_num * XCD_MINIDUMP_MEMORY_DESC_SIZE);
+        xcd_minidump_add_stream(self, XCD_MINIDUMP_STREAM_MEMORY_LIST, &loc);
+    }
+    if(0 != self->r) return self->r;
+
+    //header
+    memset(header, 0, sizeof(header));
+    xcd_minidump_put_u32(header, XCD_MINIDUMP_SIGNATURE);
+    xcd_minidump_put_u32(header + 4, XCD_MINIDUMP_VERSION);
+    xcd_minidump_put_u32(header + 8, self->streams_num);
+    xcd_minidump_put_u32(header + 12, XCD_MINIDUMP_HEADER_SIZE);
+    xcd_minidump_put_u32(header + 20, time);
+
+    //fill in the reserved space at the beginning of the file
+    if(sizeof(header) != XCC_UTIL_TEMP_FAILURE_RETRY(pwrite(self->fd, header, sizeof(header), 0)))
+        return XCC_ERRNO_SYS;
+    if(sizeof(self->streams) != XCC_UTIL_TEMP_FAILURE_RETRY(pwrite(self->fd, self->streams, sizeof(self->streams), XCD_MINIDUMP_HEADER_SIZE)))
+        return XCC_ERRNO_SYS;
+
+    return 0;
+}
+
+#pragma clang diagnostic pop
@@ -0,0 +1,121 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Created by agent on 2026-10-17.
+
+#ifndef XCD_MINIDUMP_H
+#define XCD_MINIDUMP_H 1
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//minidump writer, the file layout and the CPU contexts are the same as Breakpad's.
+//the header and the stream directory are reserved at the beginning of the file,
+//all other data is appended sequentially, and the header is filled in at the end.
+
+#define XCD_MINIDUMP_SIGNATURE 0x504d444d //MDMP
+#define XCD_MINIDUMP_VERSION   0xa793
+
+//stream types
+#define XCD_MINIDUMP_STREAM_THREAD_LIST       3
+#define XCD_MINIDUMP_STREAM_MODULE_LIST       4
+#define XCD_MINIDUMP_STREAM_MEMORY_LIST       5
+#define XCD_MINIDUMP_STREAM_EXCEPTION         6
+#define XCD_MINIDUMP_STREAM_SYSTEM_INFO       7
+#define XCD_MINIDUMP_STREAM_LINUX_PROC_STATUS 0x47670004
+#define XCD_MINIDUMP_STREAM_LINUX_CMD_LINE    0x47670006
+#define XCD_MINIDUMP_STREAM_LINUX_MAPS        0x47670009
+
+//record sizes
+#define XCD_MINIDUMP_THREAD_SIZE 48
+#define XCD_MINIDUMP_MODULE_SIZE 108
+
+//CodeView record of ELF modules: signature + build-id
+#define XCD_MINIDUMP_CV_SIGNATURE_ELF 0x4270454c //BpEL
+
+//CPU, only the integer and control registers are filled in the context
+#if defined(__arm__)
+#define XCD_MINIDUMP_CPU_ARCH      5          //ARM
+#define XCD_MINIDUMP_CONTEXT_FLAGS 0x40000002 //ARM | INTEGER
+#define XCD_MINIDUMP_CONTEXT_SIZE  368
+#elif defined(__aarch64__)
+#define XCD_MINIDUMP_CPU_ARCH      0x8003     //ARM64 (old)
+#define XCD_MINIDUMP_CONTEXT_FLAGS 0x80000002 //ARM64 (old) | INTEGER
+#define XCD_MINIDUMP_CONTEXT_SIZE  796
+#elif defined(__i386__)
+#define XCD_MINIDUMP_CPU_ARCH      0          //X86
+#define XCD_MINIDUMP_CONTEXT_FLAGS 0x00010003 //X86 | CONTROL | INTEGER
+#define XCD_MINIDUMP_CONTEXT_SIZE  716
+#elif defined(__x86_64__)
+#define XCD_MINIDUMP_CPU_ARCH      9          //AMD64
+#define XCD_MINIDUMP_CONTEXT_FLAGS 0x00100003 //AMD64 | CONTROL | INTEGER
+#define XCD_MINIDUMP_CONTEXT_SIZE  1232
+#endif
+
+#define XCD_MINIDUMP_STREAMS_MAX 16
+#define XCD_MINIDUMP_MEMORY_MAX  512
+
+typedef struct
+{
+    uint32_t size;
+    uint32_t rva;
+} xcd_minidump_location_t;
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wpadded"
+typedef struct
+{
+    int      fd;
+    int      r;
+    uint32_t pos;
+    uint32_t streams_num;
+    uint8_t  streams[XCD_MINIDUMP_STREAMS_MAX * 12];
+    size_t   memory_num;
+    uint8_t  memory[XCD_MINIDUMP_MEMORY_MAX * 16];
+} xcd_minidump_t;
+#pragma clang diagnostic pop
+
+void xcd_minidump_put_u16(uint8_t *p, uint16_t v);
+void xcd_minidump_put_u32(uint8_t *p, uint32_t v);
+void xcd_minidump_put_u64(uint8_t *p, uint64_t v);
+void xcd_minidump_put_location(uint8_t *p, xcd_minidump_location_t *loc);
+
+void xcd_minidump_init(xcd_minidump_t *self, int fd);
+int xcd_minidump_finish(xcd_minidump_t *self, uint32_t time);
+
+void xcd_minidump_write(xcd_minidump_t *self, const void *data, size_t len, xcd_minidump_location_t *loc);
+void xcd_minidump_write_string(xcd_minidump_t *self, const char *str, uint32_t *rva);
+void xcd_minidump_write_file(xcd_minidump_t *self, uint32_t type, const char *path);
+void xcd_minidump_write_system_info(xcd_minidump_t *self);
+
+void xcd_minidump_add_stream(xcd_minidump_t *self, uint32_t type, xcd_minidump_location_t *loc);
+void xcd_minidump_add_memory(xcd_minidump_t *self, uintptr_t start, const void *data, size_t len, xcd_minidump_location_t *loc);
+int xcd_minidump_has_memory(xcd_minidump_t *self, uintptr_t start, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -43,6 +43,8 @@
 #include "xcc_util.h"
 #include "xcc_b64.h"
 #include "xcc_meminfo.h"
+#include "xcc_threadstat.h"
+#include "xcc_libc_support.h"
 #include "xcd_log.h"
 #include "xcd_process.h"
 #include "xcd_thread.h"
@@ -50,6 +52,10 @@
 #include "xcd_regs.h"
 #include "xcd_util.h"
 #include "xcd_sys.h"
+#include "xcd_proto.h"
+#include "xcd_minidump.h"
+
+#define XCD_PROCESS_SIGNATURE_FRAMES_MAX 8
 
 typedef struct xcd_thread_info
 {
@@ -70,6 +76,8 @@ struct xcd_process
     xcd_thread_info_queue_t  thds;
     size_t                   nthds;
     xcd_maps_t              *maps;
+    int                      snapshot_matched_regex;
+    int                      snapshot_ignored_by_limit;
 };
 #pragma clang diagnostic pop
 
@@ -112,6 +120,9 @@ int xcd_process_create(xcd_process_t **self, pid_t pid, pid_t crash_tid, siginfo
     (*self)->si        = si;
     (*self)->uc        = uc;
     (*self)->nthds     = 0;
+    (*self)->maps      = NULL;
+    (*self)->snapshot_matched_regex    = 0;
+    (*self)->snapshot_ignored_by_limit = 0;
     TAILQ_INIT(&((*self)->thds));
 
     if(0 != (r = xcd_process_load_threads(*self)))
@@ -120,6 +131,9 @@ int xcd_process_create(xcd_process_t **self, pid_t pid, pid_t crash_tid, siginfo
         return r;
     }
 
+    //live snapshot, there is no crashed thread
+    if(0 == crash_tid) return 0;
+
     //check if crashed thread existed
     TAILQ_FOREACH(thd, &((*self)->thds), link)
     {
@@ -307,18 +321,17 @@ static int xcd_process_get_abort_message_14(xcd_process_t *self, char *buf, size
     return 0;
 }
 
-static int xcd_process_record_abort_message(xcd_process_t *self, int log_fd, int api_level)
+static int xcd_process_record_abort_message(xcd_process_t *self, int log_fd, int api_level, char *msg, size_t msg_len)
 {
-    char msg[256 + 1];
-    memset(msg, 0, sizeof(msg));
+    memset(msg, 0, msg_len);
 
     if(api_level >= 29)
     {
-        if(0 != xcd_process_get_abort_message_29(self, msg, sizeof(msg) - 1)) return 0;
+        if(0 != xcd_process_get_abort_message_29(self, msg, msg_len - 1)) goto err;
     }
     else
     {
-        if(0 != xcd_process_get_abort_message_14(self, msg, sizeof(msg) - 1)) return 0;
+        if(0 != xcd_process_get_abort_message_14(self, msg, msg_len - 1)) goto err;
     }
 
     //format
@@ -331,6 +344,58 @@ static int xcd_process_record_abort_message(xcd_process_t *self, int log_fd, int
 
     //write
     return xcc_util_write_format(log_fd, "Abort message: '%s'\n", msg);
+
+ err:
+    msg[0] = '\0';
+    return 0;
+}
+
+//the abort message with the numbers (such as sizes, addresses and FDs) replaced by '#'
+static void xcd_process_get_abort_message_pattern(const char *msg, char *buf, size_t len)
+{
+    size_t i = 0, j, k = 0;
+    int    has_digit;
+
+    while('\0' != msg[i] && k + 1 < len)
+    {
+        if(isxdigit(msg[i]) && (0 == i || !isalnum(msg[i - 1])))
+        {
+            has_digit = 0;
+            j = i;
+            if('0' == msg[j] && ('x' == msg[j + 1] || 'X' == msg[j + 1]) && isxdigit(msg[j + 2]))
+            {
+                has_digit = 1;
+                j += 2;
+            }
+            for(; isxdigit(msg[j]); j++)
+                if(isdigit(msg[j])) has_digit = 1;
+
+            if(has_digit && !isalnum(msg[j]))
+            {
+                buf[k++] = '#';
+                i = j;
+                continue;
+            }
+        }
+        buf[k++] = msg[i++];
+    }
+    buf[k] = '\0';
+}
+
+//stable for the same crash, the ASLR and the numbers in the abort message are ignored
+static uint64_t xcd_process_get_signature(xcd_process_t *self, xcd_thread_t *thd, const char *abort_msg)
+{
+    char     pattern[256 + 1];
+    uint64_t hash = XCC_UTIL_FNV1A_INIT;
+
+    hash = xcc_util_fnv1a(hash, &(self->si->si_signo), sizeof(self->si->si_signo));
+    hash = xcc_util_fnv1a(hash, &(self->si->si_code), sizeof(self->si->si_code));
+    hash = xcd_thread_get_signature(thd, hash, XCD_PROCESS_SIGNATURE_FRAMES_MAX);
+    xcd_process_get_abort_message_pattern(abort_msg, pattern, sizeof(pattern));
+    hash = xcc_util_fnv1a(hash, pattern, strlen(pattern));
+
+    //zero is the empty slot in the signature store
+    return 0 == hash ? 1 : hash;
 }
 
 static regex_t *xcd_process_build_whitelist_regex(char *dump_all_threads_whitelist, size_t *re_cnt)
@@ -386,6 +451,24 @@ static int xcd_process_if_need_dump(char *tname, regex_t *re, size_t re_cnt)
     return 0;
 }
 
+//only the difference from the baseline is recorded if it's available
+static int xcd_process_record_maps(xcd_process_t *self, int log_fd, const char *maps_baseline_pathname)
+{
+    xcd_maps_t *baseline;
+    const char *baseline_name;
+    int         r;
+
+    if(NULL == maps_baseline_pathname || 0 != xcd_maps_create_from_file(&baseline, maps_baseline_pathname))
+        return xcd_maps_record(self->maps, log_fd);
+
+    baseline_name = strrchr(maps_baseline_pathname, '/');
+    baseline_name = (NULL == baseline_name ? maps_baseline_pathname : baseline_name + 1);
+    r = xcd_maps_record_delta(self->maps, baseline, baseline_name, log_fd);
+
+    xcd_maps_destroy(&baseline);
+    return r;
+}
+
 int xcd_process_record(xcd_process_t *self,
                        int log_fd,
                        unsigned int logcat_system_lines,
@@ -393,15 +476,21 @@ int xcd_process_record(xcd_process_t *self,
                        unsigned int logcat_main_lines,
                        int dump_elf_hash,
                        int dump_map,
+                       const char *maps_baseline_pathname,
                        int dump_fds,
                        int dump_network_info,
                        int dump_all_threads,
                        unsigned int dump_all_threads_count_max,
                        char *dump_all_threads_whitelist,
-                       int api_level)
+                       int api_level,
+                       xcc_pressure_t *pressure,
+                       xcc_binlog_t *binlog,
+                       uint64_t *signature)
 {
     int                r = 0;
     xcd_thread_info_t *thd;
+    char               abort_msg[256 + 1];
+    int                frames_loaded;
     regex_t           *re = NULL;
     size_t             re_cnt = 0;
     unsigned int       thd_dumped = 0;
@@ -414,19 +503,49 @@ int xcd_process_record(xcd_process_t *self,
         {
             if(0 != (r = xcd_thread_record_info(&(thd->t), log_fd, self->pname))) return r;
             if(0 != (r = xcd_process_record_signal_info(self, log_fd))) return r;
-            if(0 != (r = xcd_process_record_abort_message(self, log_fd, api_level))) return r;
+            if(0 != (r = xcd_process_record_abort_message(self, log_fd, api_level, abort_msg, sizeof(abort_msg)))) return r;
+
+            //the signature needs the frames, it's in the head
+            frames_loaded = (0 == xcd_thread_load_frames(&(thd->t), self->maps) ? 1 : 0);
+            *signature = xcd_process_get_signature(self, &(thd->t), abort_msg);
+            if(0 != (r = xcc_util_write_format(log_fd, "Crash signature: '%016"PRIx64"'\n", *signature))) return r;
+
             if(0 != (r = xcd_thread_record_regs(&(thd->t), log_fd))) return r;
-            if(0 == xcd_thread_load_frames(&(thd->t), self->maps))
+            if(frames_loaded)
+            {
+                if(NULL != binlog)
+                {
+                    //structured sections in the binary log, the text around them is in text sections
+                    if(0 != (r = xcc_binlog_section_end(binlog))) return r;
+                    if(0 != (r = xcd_thread_record_backtrace_binary(&(thd->t), log_fd, binlog))) return r;
+                    if(0 != (r = xcd_thread_record_buildid_binary(&(thd->t), log_fd, binlog, dump_elf_hash, xcc_util_signal_has_si_addr(self->si) ? (uintptr_t)self->si->si_addr : 0))) return r;
+                    if(0 != (r = xcc_binlog_section_begin(binlog, log_fd, XCC_BINLOG_SECTION_TEXT))) return r;
+                    if(0 != (r = xcd_thread_record_stack(&(thd->t), log_fd))) return r;
+                    if(0 != (r = xcc_binlog_section_end(binlog))) return r;
+                    if(0 != (r = xcd_thread_record_memory_binary(&(thd->t), log_fd, binlog))) return r;
+                    if(0 != (r = xcc_binlog_section_begin(binlog, log_fd, XCC_BINLOG_SECTION_TEXT))) return r;
+                }
+                else
+                {
+                    if(0 != (r = xcd_thread_record_backtrace(&(thd->t), log_fd))) return r;
+                    if(0 != (r = xcd_thread_record_buildid(&(thd->t), log_fd, dump_elf_hash, xcc_util_signal_has_si_addr(self->si) ? (uintptr_t)self->si->si_addr : 0))) return r;
+                    if(0 != (r = xcd_thread_record_stack(&(thd->t), log_fd))) return r;
+                    if(0 != (r = xcd_thread_record_memory(&(thd->t), log_fd))) return r;
+                }
+            }
+            if(XCC_UTIL_DUMP_MAP_SUMMARY == dump_map)
             {
-                if(0 != (r = xcd_thread_record_backtrace(&(thd->t), log_fd))) return r;
-                if(0 != (r = xcd_thread_record_buildid(&(thd->t), log_fd, dump_elf_hash, xcc_util_signal_has_si_addr(self->si) ? (uintptr_t)self->si->si_addr : 0))) return r;
-                if(0 != (r = xcd_thread_record_stack(&(thd->t), log_fd))) return r;
-                if(0 != (r = xcd_thread_record_memory(&(thd->t), log_fd))) return r;
+                if(0 != (r = xcd_maps_record_summary(self->maps, xcc_util_signal_has_si_addr(self->si) ? (uintptr_t)self->si->si_addr : 0, log_fd))) return r;
+            }
+            else if(XCC_UTIL_DUMP_MAP_FULL == dump_map)
+            {
+                if(0 != (r = xcd_process_record_maps(self, log_fd, maps_baseline_pathname))) return r;
             }
-            if(dump_map) if(0 != (r = xcd_maps_record(self->maps, log_fd))) return r;
             if(0 != (r = xcc_util_record_logcat(log_fd, self->pid, api_level, logcat_system_lines, logcat_events_lines, logcat_main_lines))) return r;
             if(dump_fds) if(0 != (r = xcc_util_record_fds(log_fd, self->pid))) return r;
             if(dump_network_info) if(0 != (r = xcc_util_record_network_info(log_fd, self->pid, api_level))) return r;
+            if(0 != (r = xcc_threadstat_record(log_fd, self->pid, 0, XCC_THREADSTAT_TOP_N))) return r;
+            if(0 != (r = xcc_pressure_record(pressure, log_fd))) return r;
             if(0 != (r = xcc_meminfo_record(log_fd, self->pid))) return r;
 
             break;
@@ -460,7 +579,17 @@ int xcd_process_record(xcd_process_t *self,
             if(0 != (r = xcd_thread_record_regs(&(thd->t), log_fd))) goto end;
             if(0 == xcd_thread_load_frames(&(thd->t), self->maps))
             {
-                if(0 != (r = xcd_thread_record_backtrace(&(thd->t), log_fd))) goto end;
+                if(NULL != binlog)
+                {
+                    //the same interned records as the crashed thread's backtrace
+                    if(0 != (r = xcc_binlog_section_end(binlog))) goto end;
+                    if(0 != (r = xcd_thread_record_backtrace_binary(&(thd->t), log_fd, binlog))) goto end;
+                    if(0 != (r = xcc_binlog_section_begin(binlog, log_fd, XCC_BINLOG_SECTION_TEXT))) goto end;
+                }
+                else
+                {
+                    if(0 != (r = xcd_thread_record_backtrace(&(thd->t), log_fd))) goto end;
+                }
                 if(0 != (r = xcd_thread_record_stack(&(thd->t), log_fd))) goto end;
             }
             thd_dumped++;
@@ -486,3 +615,352 @@ int xcd_process_record(xcd_process_t *self,
  ret:
     return r;
 }
+
+static void xcd_process_record_logcat_proto(xcd_process_t *self, xcd_proto_t *proto, int api_level,
+                                            const char *buffer, unsigned int lines, char priority)
+{
+    FILE       *fp;
+    char        cmd[128];
+    char        buf[1025];
+    char        date[8], time[16], timestamp[32];
+    int         with_pid, pid, tid, n;
+    char        prio;
+    char       *tag, *msg, *p;
+    const char *prios = "VDIWEF";
+
+    with_pid = xcc_util_get_logcat_cmd(cmd, sizeof(cmd), self->pid, api_level, buffer, lines, priority);
+
+    xcd_proto_begin(proto, XCD_PROTO_TOMBSTONE_LOG_BUFFERS);
+    xcd_proto_put_str(proto, XCD_PROTO_LOG_BUFFER_NAME, buffer);
+    if(NULL != (fp = popen(cmd, "r")))
+    {
+        buf[sizeof(buf) - 1] = '\0';
+        while(NULL != fgets(buf, sizeof(buf) - 1, fp))
+        {
+            //threadtime: "MM-DD HH:MM:SS.mmm  PID  TID P TAG     : MESSAGE"
+            n = 0;
+            if(5 != sscanf(buf, "%7s %15s %d %d %c %n", date, time, &pid, &tid, &prio, &n) || 0 == n) continue;
+            if(!with_pid && pid != self->pid) continue;
+            tag = buf + n;
+            if(NULL == (msg = strstr(tag, ": "))) continue;
+            *msg = '\0';
+            msg += 2;
+            for(p = msg + strlen(msg); p > msg && '\n' == *(p - 1); p--) *(p - 1) = '\0';
+            snprintf(timestamp, sizeof(timestamp), "%s %s", date, time);
+
+            xcd_proto_begin(proto, XCD_PROTO_LOG_BUFFER_LOGS);
+            xcd_proto_put_str(proto, XCD_PROTO_LOG_MESSAGE_TIMESTAMP, timestamp);
+            xcd_proto_put_uint64(proto, XCD_PROTO_LOG_MESSAGE_PID, (uint64_t)pid);
+            xcd_proto_put_uint64(proto, XCD_PROTO_LOG_MESSAGE_TID, (uint64_t)tid);
+            if(NULL != (p = strchr(prios, prio))) //android_LogPriority, starts from VERBOSE (2)
+                xcd_proto_put_uint64(proto, XCD_PROTO_LOG_MESSAGE_PRIORITY, (uint64_t)(p - prios) + 2);
+            xcd_proto_put_str(proto, XCD_PROTO_LOG_MESSAGE_TAG, xcc_util_trim(tag));
+            xcd_proto_put_str(proto, XCD_PROTO_LOG_MESSAGE_MESSAGE, msg);
+            xcd_proto_end(proto);
+        }
+        pclose(fp);
+    }
+    xcd_proto_end(proto);
+}
+
+static void xcd_process_record_fds_proto(xcd_process_t *self, xcd_proto_t *proto)
+{
+    char           path[128];
+    char           fd_path[512];
+    DIR           *dir;
+    struct dirent *ent;
+    int            fd;
+    ssize_t        len;
+    size_t         total = 0;
+
+    snprintf(path, sizeof(path), "/proc/%d/fd", self->pid);
+    if(NULL == (dir = opendir(path))) return;
+    while(NULL != (ent = readdir(dir)))
+    {
+        if(0 != xcc_util_atoi(ent->d_name, &fd) || fd < 0) continue;
+        if(++total > 1024) break;
+
+        snprintf(path, sizeof(path), "/proc/%d/fd/%d", self->pid, fd);
+        len = readlink(path, fd_path, sizeof(fd_path) - 1);
+        if(len <= 0 || len > (ssize_t)(sizeof(fd_path) - 1))
+            strncpy(fd_path, "???", sizeof(fd_path));
+        else
+            fd_path[len] = '\0';
+
+        xcd_proto_begin(proto, XCD_PROTO_TOMBSTONE_OPEN_FDS);
+        xcd_proto_put_int64(proto, XCD_PROTO_FD_FD, fd);
+        xcd_proto_put_str(proto, XCD_PROTO_FD_PATH, fd_path);
+        xcd_proto_end(proto);
+    }
+    closedir(dir);
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wgnu-statement-expression"
+static void xcd_process_record_cmdline_proto(xcd_process_t *self, xcd_proto_t *proto)
+{
+    char     path[64];
+    char     buf[4096];
+    int      fd;
+    ssize_t  len;
+    size_t   i, begin = 0;
+
+    snprintf(path, sizeof(path), "/proc/%d/cmdline", self->pid);
+    if((fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(path, O_RDONLY | O_CLOEXEC))) < 0) return;
+    len = XCC_UTIL_TEMP_FAILURE_RETRY(read(fd, buf, sizeof(buf) - 1));
+    close(fd);
+    if(len <= 0) return;
+    buf[len] = '\0';
+
+    //arguments are separated by '\0'
+    for(i = 0; i <= (size_t)len; i++)
+    {
+        if('\0' != buf[i]) continue;
+        if(i > begin) xcd_proto_put_str(proto, XCD_PROTO_TOMBSTONE_COMMAND_LINE, buf + begin);
+        begin = i + 1;
+    }
+}
+#pragma clang diagnostic pop
+
+int xcd_process_record_proto(xcd_process_t *self,
+                             int proto_fd,
+                             const char *build_fingerprint,
+                             long time_zone,
+                             uint64_t start_time,
+                             uint64_t crash_time,
+                             unsigned int logcat_system_lines,
+                             unsigned int logcat_events_lines,
+                             unsigned int logcat_main_lines,
+                             int dump_fds,
+                             int api_level)
+{
+    xcd_proto_t        proto;
+    xcd_thread_info_t *thd;
+    time_t             crash_sec = (time_t)(crash_time / 1000000);
+    struct tm          crash_tm;
+    char               path[64];
+    char               buf[256 + 1];
+    int                r;
+
+    xcd_proto_init(&proto, proto_fd);
+
+    //process
+    xcd_proto_put_uint64(&proto, XCD_PROTO_TOMBSTONE_ARCH, XCD_PROTO_ARCH);
+    xcd_proto_put_str(&proto, XCD_PROTO_TOMBSTONE_BUILD_FINGERPRINT, build_fingerprint);
+    memset(&crash_tm, 0, sizeof(crash_tm));
+    xcc_libc_support_localtime_r(&crash_sec, time_zone, &crash_tm);
+    snprintf(buf, sizeof(buf), XCC_UTIL_TIME_FORMAT,
+             crash_tm.tm_year + 1900, crash_tm.tm_mon + 1, crash_tm.tm_mday,
+             crash_tm.tm_hour, crash_tm.tm_min, crash_tm.tm_sec, (long)(crash_time % 1000000 / 1000),
+             time_zone < 0 ? '-' : '+', labs(time_zone / 3600), labs(time_zone % 3600));
+    xcd_proto_put_str(&proto, XCD_PROTO_TOMBSTONE_TIMESTAMP, buf);
+    xcd_proto_put_uint64(&proto, XCD_PROTO_TOMBSTONE_PID, (uint64_t)self->pid);
+    xcd_proto_put_uint64(&proto, XCD_PROTO_TOMBSTONE_TID, (uint64_t)self->crash_tid);
+    xcd_proto_put_uint64(&proto, XCD_PROTO_TOMBSTONE_UID, getuid()); //the dumper is forked from the crashed process
+    snprintf(path, sizeof(path), "/proc/%d/attr/current", self->pid);
+    if(0 == xcc_util_read_file_line(path, buf, sizeof(buf)))
+        xcd_proto_put_str(&proto, XCD_PROTO_TOMBSTONE_SELINUX_LABEL, xcc_util_trim(buf));
+    xcd_process_record_cmdline_proto(self, &proto);
+    if(crash_time > start_time)
+        xcd_proto_put_uint64(&proto, XCD_PROTO_TOMBSTONE_PROCESS_UPTIME, (crash_time - start_time) / 1000000);
+
+    //signal
+    xcd_proto_begin(&proto, XCD_PROTO_TOMBSTONE_SIGNAL_INFO);
+    xcd_proto_put_int64(&proto, XCD_PROTO_SIGNAL_NUMBER, self->si->si_signo);
+    xcd_proto_put_str(&proto, XCD_PROTO_SIGNAL_NAME, xcc_util_get_signame(self->si));
+    xcd_proto_put_int64(&proto, XCD_PROTO_SIGNAL_CODE, self->si->si_code);
+    xcd_proto_put_str(&proto, XCD_PROTO_SIGNAL_CODE_NAME, xcc_util_get_sigcodename(self->si));
+    if(xcc_util_signal_has_sender(self->si, self->pid))
+    {
+        xcd_proto_put_bool(&proto, XCD_PROTO_SIGNAL_HAS_SENDER, 1);
+        xcd_proto_put_int64(&proto, XCD_PROTO_SIGNAL_SENDER_UID, self->si->si_uid);
+        xcd_proto_put_int64(&proto, XCD_PROTO_SIGNAL_SENDER_PID, self->si->si_pid);
+    }
+    if(xcc_util_signal_has_si_addr(self->si))
+    {
+        xcd_proto_put_bool(&proto, XCD_PROTO_SIGNAL_HAS_FAULT_ADDRESS, 1);
+        xcd_proto_put_uint64(&proto, XCD_PROTO_SIGNAL_FAULT_ADDRESS, (uintptr_t)self->si->si_addr);
+    }
+    xcd_proto_end(&proto);
+
+    //abort message
+    memset(buf, 0, sizeof(buf));
+    if(0 == (api_level >= 29 ? xcd_process_get_abort_message_29(self, buf, sizeof(buf) - 1) :
+                               xcd_process_get_abort_message_14(self, buf, sizeof(buf) - 1)))
+        xcd_proto_put_str(&proto, XCD_PROTO_TOMBSTONE_ABORT_MESSAGE, buf);
+
+    //threads, the crashed one with memory dumps, the others with the frames loaded while recording the text
+    TAILQ_FOREACH(thd, &(self->thds), link)
+        if(0 != (r = xcd_thread_record_proto(&(thd->t), &proto, self->maps, thd->t.tid == self->crash_tid))) return r;
+
+    //maps
+    if(NULL != self->maps)
+        if(0 != (r = xcd_maps_record_proto(self->maps, &proto))) return r;
+
+    //logcat
+    if(logcat_main_lines > 0) xcd_process_record_logcat_proto(self, &proto, api_level, "main", logcat_main_lines, 'D');
+    if(logcat_system_lines > 0) xcd_process_record_logcat_proto(self, &proto, api_level, "system", logcat_system_lines, 'W');
+    if(logcat_events_lines > 0) xcd_process_record_logcat_proto(self, &proto, api_level, "events", logcat_events_lines, 'I');
+
+    //fds
+    if(dump_fds) xcd_process_record_fds_proto(self, &proto);
+
+    return xcd_proto_finish(&proto);
+}
+
+#define XCD_PROCESS_MINIDUMP_STACK_MAX_CRASHED (64 * 1024)
+#define XCD_PROCESS_MINIDUMP_STACK_MAX_OTHERS  (16 * 1024)
+#define XCD_PROCESS_MINIDUMP_EXCEPTION_SIZE    168
+
+int xcd_process_record_minidump(xcd_process_t *self, int minidump_fd, uint64_t crash_time)
+{
+    xcd_minidump_t           md;
+    xcd_minidump_location_t  loc;
+    xcd_minidump_location_t  context;
+    xcd_minidump_location_t  crash_context = {0, 0};
+    xcd_thread_info_t       *thd;
+    uint8_t                 *list;
+    uint8_t                  exception[XCD_PROCESS_MINIDUMP_EXCEPTION_SIZE];
+    size_t                   i = 0;
+    char                     path[64];
+    int                      r;
+
+    xcd_minidump_init(&md, minidump_fd);
+
+    //system info
+    xcd_minidump_write_system_info(&md);
+
+    //thread list: count + threads, with the contexts and the stacks
+    if(NULL == (list = calloc(1, 4 + self->nthds * XCD_MINIDUMP_THREAD_SIZE))) return XCC_ERRNO_NOMEM;
+    TAILQ_FOREACH(thd, &(self->thds), link)
+    {
+        if(0 != (r = xcd_thread_record_minidump(&(thd->t), &md, self->maps,
+                                                thd->t.tid == self->crash_tid ?
+                                                XCD_PROCESS_MINIDUMP_STACK_MAX_CRASHED : XCD_PROCESS_MINIDUMP_STACK_MAX_OTHERS,
+                                                list + 4 + i * XCD_MINIDUMP_THREAD_SIZE, &context)))
+        {
+            free(list);
+            return r;
+        }
+        if(thd->t.tid == self->crash_tid) crash_context = context;
+        i++;
+    }
+    xcd_minidump_put_u32(list, (uint32_t)i);
+    xcd_minidump_write(&md, list, 4 + i * XCD_MINIDUMP_THREAD_SIZE, &loc);
+    xcd_minidump_add_stream(&md, XCD_MINIDUMP_STREAM_THREAD_LIST, &loc);
+    free(list);
+
+    //exception: thread id, code (signal number), flags (signal code), record, address, parameters, context
+    memset(exception, 0, sizeof(exception));
+    xcd_minidump_put_u32(exception, (uint32_t)self->crash_tid);
+    xcd_minidump_put_u32(exception + 8, (uint32_t)self->si->si_signo);
+    xcd_minidump_put_u32(exception + 12, (uint32_t)self->si->si_code);
+    xcd_minidump_put_u64(exception + 24, (uintptr_t)self->si->si_addr);
+    xcd_minidump_put_location(exception + 160, &crash_context);
+    xcd_minidump_write(&md, exception, sizeof(exception), &loc);
+    xcd_minidump_add_stream(&md, XCD_MINIDUMP_STREAM_EXCEPTION, &loc);
+
+    //memory near the registers of the crashed thread
+    TAILQ_FOREACH(thd, &(self->thds), link)
+        if(thd->t.tid == self->crash_tid)
+            if(0 != (r = xcd_thread_record_minidump_memory(&(thd->t), &md))) return r;
+
+    //modules
+    if(NULL != self->maps)
+        if(0 != (r = xcd_maps_record_minidump(self->maps, &md))) return r;
+
+    //linux streams, read by minidump_stackwalk and minidump-2-core
+    snprintf(path, sizeof(path), "/proc/%d/maps", self->pid);
+    xcd_minidump_write_file(&md, XCD_MINIDUMP_STREAM_LINUX_MAPS, path);
+    snprintf(path, sizeof(path), "/proc/%d/cmdline", self->pid);
+    xcd_minidump_write_file(&md, XCD_MINIDUMP_STREAM_LINUX_CMD_LINE, path);
+    snprintf(path, sizeof(path), "/proc/%d/status", self->pid);
+    xcd_minidump_write_file(&md, XCD_MINIDUMP_STREAM_LINUX_PROC_STATUS, path);
+
+    return xcd_minidump_finish(&md, (uint32_t)(crash_time / 1000000));
+}
+
+int xcd_process_snapshot_threads(xcd_process_t *self,
+                                 unsigned int dump_threads_count_max,
+                                 char *dump_threads_whitelist)
+{
+    int                r;
+    xcd_thread_info_t *thd, *thd_tmp;
+    regex_t           *re = NULL;
+    size_t             re_cnt = 0;
+    unsigned int       thd_selected = 0;
+    char               buf[256];
+
+    xcc_util_get_process_name(self->pid, buf, sizeof(buf));
+    if(NULL == (self->pname = strdup(buf))) self->pname = "unknown";
+
+    //maps are needed for locating the stack of each thread
+    if(0 != (r = xcd_maps_create(&(self->maps), self->pid)))
+    {
+        XCD_LOG_ERROR("PROCESS: create maps failed, errno=%d", r);
+        return r;
+    }
+
+    //parse thread name whitelist regex
+    re = xcd_process_build_whitelist_regex(dump_threads_whitelist, &re_cnt);
+
+    TAILQ_FOREACH_SAFE(thd, &(self->thds), link, thd_tmp)
+    {
+        xcd_thread_load_info(&(thd->t));
+
+        //only the selected threads will be interrupted
+        if(NULL != re && re_cnt > 0 && !xcd_process_if_need_dump(thd->t.tname, re, re_cnt))
+            goto ignore;
+        self->snapshot_matched_regex++;
+
+        if(dump_threads_count_max > 0 && thd_selected >= dump_threads_count_max)
+        {
+            self->snapshot_ignored_by_limit++;
+            goto ignore;
+        }
+        thd_selected++;
+
+        //stop the thread, capture regs and stack, then resume it immediately
+        xcd_thread_snapshot(&(thd->t), self->maps);
+        continue;
+
+    ignore:
+        TAILQ_REMOVE(&(self->thds), thd, link);
+        free(thd);
+    }
+
+    //all threads are running again, remote memory can not be read by ptrace from now on
+    xcd_util_ptrace_set_detached();
+    return 0;
+}
+
+int xcd_process_record_snapshot(xcd_process_t *self, int log_fd)
+{
+    int                r;
+    xcd_thread_info_t *thd;
+    unsigned int       thd_dumped = 0;
+
+    if(0 != (r = xcc_util_write_format(log_fd, "pid: %d  >>> %s <<<\n\n", self->pid, self->pname))) return r;
+
+    TAILQ_FOREACH(thd, &(self->thds), link)
+    {
+        if(0 != (r = xcc_util_write_str(log_fd, XCC_UTIL_THREAD_SEP))) return r;
+        if(0 != (r = xcd_thread_record_info(&(thd->t), log_fd, self->pname))) return r;
+        if(0 != (r = xcd_thread_record_regs(&(thd->t), log_fd))) return r;
+        if(0 == xcd_thread_load_frames(&(thd->t), self->maps))
+        {
+            if(0 != (r = xcd_thread_record_backtrace(&(thd->t), log_fd))) return r;
+            if(0 != (r = xcd_thread_record_stack(&(thd->t), log_fd))) return r;
+        }
+        thd_dumped++;
+    }
+
+    if(0 == thd_dumped)
+        if(0 != (r = xcc_util_write_str(log_fd, XCC_UTIL_THREAD_SEP))) return r;
+    if(0 != (r = xcc_util_write_format(log_fd, "total threads: %zu\n", self->nthds))) return r;
+    if(0 != (r = xcc_util_write_format(log_fd, "threads matched whitelist: %d\n", self->snapshot_matched_regex))) return r;
+    if(0 != (r = xcc_util_write_format(log_fd, "threads ignored by max count limit: %d\n", self->snapshot_ignored_by_limit))) return r;
+    if(0 != (r = xcc_util_write_format(log_fd, "dumped threads: %u\n", thd_dumped))) return r;
+
+    return xcc_util_write_str(log_fd, XCC_UTIL_THREAD_END);
+}
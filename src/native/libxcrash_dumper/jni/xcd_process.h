@@ -26,6 +26,8 @@
 
 #include <stdint.h>
 #include <sys/types.h>
+#include "xcc_pressure.h"
+#include "xcc_binlog.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -48,12 +50,35 @@ int xcd_process_record(xcd_process_t *self,
                        unsigned int logcat_main_lines,
                        int dump_elf_hash,
                        int dump_map,
+                       const char *maps_baseline_pathname,
                        int dump_fds,
                        int dump_network_info,
                        int dump_all_threads,
                        unsigned int dump_all_threads_count_max,
                        char *dump_all_threads_whitelist,
-                       int api_level);
+                       int api_level,
+                       xcc_pressure_t *pressure,
+                       xcc_binlog_t *binlog,
+                       uint64_t *signature);
+
+int xcd_process_record_proto(xcd_process_t *self,
+                             int proto_fd,
+                             const char *build_fingerprint,
+                             long time_zone,
+                             uint64_t start_time,
+                             uint64_t crash_time,
+                             unsigned int logcat_system_lines,
+                             unsigned int logcat_events_lines,
+                             unsigned int logcat_main_lines,
+                             int dump_fds,
+                             int api_level);
+
+int xcd_process_record_minidump(xcd_process_t *self, int minidump_fd, uint64_t crash_time);
+
+int xcd_process_snapshot_threads(xcd_process_t *self,
+                                 unsigned int dump_threads_count_max,
+                                 char *dump_threads_whitelist);
+int xcd_process_record_snapshot(xcd_process_t *self, int log_fd);
 
 #ifdef __cplusplus
 }
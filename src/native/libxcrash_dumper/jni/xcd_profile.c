@@ -0,0 +1,224 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// Created by agent on 2026-10-17.
+
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include "tree.h"
+#include "xcc_errno.h"
+#include "xcc_util.h"
+#include "xcc_profile.h"
+#include "xcd_profile.h"
+#include "xcd_maps.h"
+#include "xcd_regs.h"
+#include "xcd_frames.h"
+#include "xcd_util.h"
+
+#define XCD_PROFILE_FOLDED_MAX 4096
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wpadded"
+typedef struct xcd_profile_stack
+{
+    char     *folded;
+    uint64_t  count;
+    RB_ENTRY(xcd_profile_stack) link;
+} xcd_profile_stack_t;
+#pragma clang diagnostic pop
+static int xcd_profile_stack_cmp(xcd_profile_stack_t *a, xcd_profile_stack_t *b)
+{
+    return strcmp(a->folded, b->folded);
+}
+typedef RB_HEAD(xcd_profile_stack_tree, xcd_profile_stack) xcd_profile_stack_tree_t;
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused-function"
+RB_GENERATE_STATIC(xcd_profile_stack_tree, xcd_profile_stack, link, xcd_profile_stack_cmp)
+#pragma clang diagnostic pop
+
+static int xcd_profile_read(int fd, void *buf, size_t len)
+{
+    size_t  nread = 0;
+    ssize_t n;
+
+    while(len - nread > 0)
+    {
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wgnu-statement-expression"
+        n = XCC_UTIL_TEMP_FAILURE_RETRY(read(fd, (void *)((uint8_t *)buf + nread), len - nread));
+#pragma clang diagnostic pop
+        if(n <= 0) return XCC_ERRNO_FORMAT;
+        nread += (size_t)n;
+    }
+
+    return 0;
+}
+
+static int xcd_profile_add(xcd_profile_stack_tree_t *stacks, char *folded)
+{
+    xcd_profile_stack_t *stack, key;
+
+    key.folded = folded;
+    if(NULL != (stack = RB_FIND(xcd_profile_stack_tree, stacks, &key)))
+    {
+        stack->count++;
+        return 0;
+    }
+
+    if(NULL == (stack = malloc(sizeof(xcd_profile_stack_t)))) return XCC_ERRNO_NOMEM;
+    if(NULL == (stack->folded = strdup(folded)))
+    {
+        free(stack);
+        return XCC_ERRNO_NOMEM;
+    }
+    stack->count = 1;
+    RB_INSERT(xcd_profile_stack_tree, stacks, stack);
+    return 0;
+}
+
+static int xcd_profile_write(int log_fd, xcc_profile_header_t *header, uint64_t unwound,
+                             xcd_profile_stack_tree_t *stacks)
+{
+    xcd_profile_stack_t *stack;
+    uint64_t             overhead;
+    int                  r;
+
+    //comment lines never end with a number, so they are skipped by the folded stacks tools
+    overhead = (0 == header->duration ? 0 : (header->handler_time + header->java_time) * 10000 / header->duration);
+    if(0 != (r = xcc_util_write_format(log_fd,
+                                       "# xCrash main thread profile (folded stacks)\n"
+                                       "# pid: %d, tid: %d (main)\n"
+                                       "# start time: %"PRIu64" us (realtime)\n"
+                                       "# frequency: %u Hz\n"
+                                       "# duration: %"PRIu64" ms\n"
+                                       "# samples: %"PRIu64" (unwound: %"PRIu64", dropped: %"PRIu64", skipped: %"PRIu64")\n"
+                                       "# signal handler: %"PRIu64" us, java stacks: %"PRIu64" us (overhead: %"PRIu64".%02"PRIu64"%%)\n",
+                                       header->pid, header->tid,
+                                       header->start_time,
+                                       header->frequency,
+                                       header->duration / 1000,
+                                       header->samples, unwound, header->dropped, header->skipped,
+                                       header->handler_time, header->java_time, overhead / 100, overhead % 100))) return r;
+    if(header->truncated)
+        if(0 != (r = xcc_util_write_str(log_fd, "# stopped early: the raw samples reached the size limit\n"))) return r;
+
+    //"frame;frame;frame count"
+    RB_FOREACH(stack, xcd_profile_stack_tree, stacks)
+    {
+        if(0 != (r = xcc_util_write_str(log_fd, stack->folded))) return r;
+        if(0 != (r = xcc_util_write_format(log_fd, " %"PRIu64"\n", stack->count))) return r;
+    }
+
+    return 0;
+}
+
+int xcd_profile_record(int log_fd, pid_t pid)
+{
+    xcc_profile_header_t      header;
+    xcc_profile_sample_t     *sample = NULL;
+    xcd_maps_t               *maps = NULL;
+    xcd_regs_t                regs;
+    xcd_frames_t             *frames;
+    xcd_profile_stack_tree_t  stacks;
+    xcd_profile_stack_t      *stack, *stack_tmp;
+    char                      folded[XCD_PROFILE_FOLDED_MAX];
+    size_t                    len;
+    uint64_t                  i, unwound = 0;
+    int                       r = 0;
+
+    RB_INIT(&stacks);
+
+    //read the header written by the sampler
+    if(0 != lseek(log_fd, 0, SEEK_SET)) return XCC_ERRNO_SYS;
+    if(0 != (r = xcd_profile_read(log_fd, &header, sizeof(header)))) return r;
+    if(XCC_PROFILE_MAGIC != header.magic || pid != header.pid) return XCC_ERRNO_FORMAT;
+
+    if(NULL == (sample = malloc(sizeof(xcc_profile_sample_t)))) return XCC_ERRNO_NOMEM;
+    if(0 != (r = xcd_maps_create(&maps, pid))) goto end;
+
+    //the process keeps running, only the copied stacks are consistent with the registers
+    xcd_util_ptrace_set_detached();
+
+    for(i = 0; i < header.samples; i++)
+    {
+        if(0 != xcd_profile_read(log_fd, sample, XCC_PROFILE_SAMPLE_HEAD_LEN)) break;
+        if(sample->stack_len > XCC_PROFILE_STACK_SIZE) break;
+        if(sample->stack_len > 0 && 0 != xcd_profile_read(log_fd, sample->stack, sample->stack_len)) break;
+        if(sample->java_len >= XCC_PROFILE_JAVA_SIZE) break;
+        if(sample->java_len > 0 && 0 != xcd_profile_read(log_fd, sample->java, sample->java_len)) break;
+
+        //Java frames first (outermost first), then the native frames called by the innermost one
+        len = 0;
+        if(sample->java_len > 0)
+        {
+            memcpy(folded, sample->java, sample->java_len);
+            len = sample->java_len;
+            folded[len++] = ';';
+        }
+        folded[len] = '\0';
+
+        //unwind
+        xcd_util_ptrace_reset_snapshots();
+        if(sample->stack_len > 0 && 0 != (r = xcd_util_ptrace_add_snapshot(sample->stack_addr, sample->stack, sample->stack_len))) goto end;
+        xcd_regs_load_from_ucontext(&regs, &(sample->uc));
+        if(0 != xcd_frames_create(&frames, &regs, maps, pid))
+        {
+            frames = NULL;
+        }
+        else if(0 < xcd_frames_fold(frames, sample->stack_addr, sample->stack_addr + sample->stack_len,
+                                    sample->java_len > 0, folded + len, sizeof(folded) - len))
+        {
+            len += strlen(folded + len);
+        }
+        if(NULL != frames) xcd_frames_destroy(&frames);
+
+        //the Java stack alone if the main thread was running Java code
+        if(len > 0 && ';' == folded[len - 1]) folded[--len] = '\0';
+        if(0 == len) continue;
+        unwound++;
+        if(0 != (r = xcd_profile_add(&stacks, folded))) goto end;
+    }
+    xcd_util_ptrace_reset_snapshots();
+
+    //replace the samples with the folded stacks
+    if(0 != ftruncate(log_fd, 0) || 0 != lseek(log_fd, 0, SEEK_SET))
+    {
+        r = XCC_ERRNO_SYS;
+        goto end;
+    }
+    r = xcd_profile_write(log_fd, &header, unwound, &stacks);
+
+ end:
+    RB_FOREACH_SAFE(stack, xcd_profile_stack_tree, &stacks, stack_tmp)
+    {
+        RB_REMOVE(xcd_profile_stack_tree, &stacks, stack);
+        free(stack->folded);
+        free(stack);
+    }
+    if(NULL != maps) xcd_maps_destroy(&maps);
+    free(sample);
+    return r;
+}
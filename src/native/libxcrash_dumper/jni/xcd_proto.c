@@ -0,0 +1,189 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Created by agent on 2026-10-17.
+
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/types.h>
+#include "xcc_errno.h"
+#include "xcc_util.h"
+#include "xcd_proto.h"
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wgnu-statement-expression"
+
+#define XCD_PROTO_WIRE_VARINT 0
+#define XCD_PROTO_WIRE_LEN    2
+
+//a padded varint, protobuf decoders accept the redundant continuation bytes
+#define XCD_PROTO_RESERVED_LEN 5
+
+void xcd_proto_init(xcd_proto_t *self, int fd)
+{
+    self->fd = fd;
+    self->r = 0;
+    self->pos = 0;
+    self->flushed = 0;
+    self->depth = 0;
+    self->len = 0;
+}
+
+static void xcd_proto_flush(xcd_proto_t *self)
+{
+    if(0 == self->r && self->len > 0)
+        self->r = xcc_util_write(self->fd, (const char *)self->buf, self->len);
+    self->flushed += self->len;
+    self->len = 0;
+}
+
+static void xcd_proto_write(xcd_proto_t *self, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    size_t         n;
+
+    self->pos += len;
+    while(len > 0)
+    {
+        if(self->len == sizeof(self->buf)) xcd_proto_flush(self);
+
+        n = sizeof(self->buf) - self->len;
+        if(n > len) n = len;
+        memcpy(self->buf + self->len, p, n);
+        self->len += n;
+        p += n;
+        len -= n;
+    }
+}
+
+static void xcd_proto_write_varint(xcd_proto_t *self, uint64_t v)
+{
+    uint8_t buf[10];
+    size_t  n = 0;
+
+    do
+    {
+        buf[n] = (uint8_t)(v & 0x7F);
+        v >>= 7;
+        if(0 != v) buf[n] |= 0x80;
+        n++;
+    } while(0 != v);
+
+    xcd_proto_write(self, buf, n);
+}
+
+static void xcd_proto_write_tag(xcd_proto_t *self, uint32_t field, uint32_t wire_type)
+{
+    xcd_proto_write_varint(self, ((uint64_t)field << 3) | wire_type);
+}
+
+void xcd_proto_put_uint64(xcd_proto_t *self, uint32_t field, uint64_t v)
+{
+    xcd_proto_write_tag(self, field, XCD_PROTO_WIRE_VARINT);
+    xcd_proto_write_varint(self, v);
+}
+
+void xcd_proto_put_int64(xcd_proto_t *self, uint32_t field, int64_t v)
+{
+    //int32 and int64 are both sign-extended to 64 bits (not zigzag)
+    xcd_proto_put_uint64(self, field, (uint64_t)v);
+}
+
+void xcd_proto_put_bool(xcd_proto_t *self, uint32_t field, int v)
+{
+    xcd_proto_put_uint64(self, field, v ? 1 : 0);
+}
+
+void xcd_proto_put_bytes(xcd_proto_t *self, uint32_t field, const void *data, size_t len)
+{
+    xcd_proto_write_tag(self, field, XCD_PROTO_WIRE_LEN);
+    xcd_proto_write_varint(self, len);
+    if(len > 0) xcd_proto_write(self, data, len);
+}
+
+void xcd_proto_put_str(xcd_proto_t *self, uint32_t field, const char *str)
+{
+    //empty strings are the default value, they are omitted
+    if(NULL == str || '\0' == str[0]) return;
+    xcd_proto_put_bytes(self, field, str, strlen(str));
+}
+
+void xcd_proto_begin(xcd_proto_t *self, uint32_t field)
+{
+    uint8_t reserved[XCD_PROTO_RESERVED_LEN] = {0x80, 0x80, 0x80, 0x80, 0x00};
+
+    if(self->depth >= XCD_PROTO_DEPTH_MAX)
+    {
+        self->r = XCC_ERRNO_RANGE;
+        return;
+    }
+
+    xcd_proto_write_tag(self, field, XCD_PROTO_WIRE_LEN);
+    self->begins[self->depth++] = self->pos;
+    xcd_proto_write(self, reserved, sizeof(reserved));
+}
+
+void xcd_proto_end(xcd_proto_t *self)
+{
+    uint8_t buf[XCD_PROTO_RESERVED_LEN];
+    size_t  begin, len, i;
+
+    if(0 == self->depth)
+    {
+        self->r = XCC_ERRNO_RANGE;
+        return;
+    }
+
+    begin = self->begins[--self->depth];
+    len = self->pos - begin - XCD_PROTO_RESERVED_LEN;
+    if((uint64_t)len >> (7 * XCD_PROTO_RESERVED_LEN))
+    {
+        self->r = XCC_ERRNO_RANGE;
+        return;
+    }
+
+    for(i = 0; i < XCD_PROTO_RESERVED_LEN; i++)
+        buf[i] = (uint8_t)(((len >> (7 * i)) & 0x7F) | (i < XCD_PROTO_RESERVED_LEN - 1 ? 0x80 : 0));
+
+    if(begin >= self->flushed)
+    {
+        //still in the buffer
+        memcpy(self->buf + (begin - self->flushed), buf, sizeof(buf));
+    }
+    else
+    {
+        //already written (maybe partly), fill in the file directly after flushing
+        xcd_proto_flush(self);
+        if(0 == self->r && sizeof(buf) != XCC_UTIL_TEMP_FAILURE_RETRY(pwrite(self->fd, buf, sizeof(buf), (off_t)begin)))
+            self->r = XCC_ERRNO_SYS;
+    }
+}
+
+int xcd_proto_finish(xcd_proto_t *self)
+{
+    xcd_proto_flush(self);
+    if(0 == self->r && 0 != self->depth) self->r = XCC_ERRNO_STATE;
+    return self->r;
+}
+
+#pragma clang diagnostic pop
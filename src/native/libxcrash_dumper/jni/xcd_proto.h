@@ -0,0 +1,179 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Created by agent on 2026-10-17.
+
+#ifndef XCD_PROTO_H
+#define XCD_PROTO_H 1
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//streaming protobuf encoder for the platform's tombstone.proto (no protobuf runtime).
+//the length of a nested message is reserved as a fixed 5 bytes varint when the message
+//begins, and it is filled in when the message ends. so nothing is built in memory.
+
+//message Tombstone
+#define XCD_PROTO_TOMBSTONE_ARCH              1
+#define XCD_PROTO_TOMBSTONE_BUILD_FINGERPRINT 2
+#define XCD_PROTO_TOMBSTONE_REVISION          3
+#define XCD_PROTO_TOMBSTONE_TIMESTAMP         4
+#define XCD_PROTO_TOMBSTONE_PID               5
+#define XCD_PROTO_TOMBSTONE_TID               6
+#define XCD_PROTO_TOMBSTONE_UID               7
+#define XCD_PROTO_TOMBSTONE_SELINUX_LABEL     8
+#define XCD_PROTO_TOMBSTONE_COMMAND_LINE      9
+#define XCD_PROTO_TOMBSTONE_SIGNAL_INFO       10
+#define XCD_PROTO_TOMBSTONE_ABORT_MESSAGE     14
+#define XCD_PROTO_TOMBSTONE_CAUSES            15
+#define XCD_PROTO_TOMBSTONE_THREADS           16
+#define XCD_PROTO_TOMBSTONE_MEMORY_MAPPINGS   17
+#define XCD_PROTO_TOMBSTONE_LOG_BUFFERS       18
+#define XCD_PROTO_TOMBSTONE_OPEN_FDS          19
+#define XCD_PROTO_TOMBSTONE_PROCESS_UPTIME    20
+
+//enum Architecture
+#define XCD_PROTO_ARCH_ARM32  0
+#define XCD_PROTO_ARCH_ARM64  1
+#define XCD_PROTO_ARCH_X86    2
+#define XCD_PROTO_ARCH_X86_64 3
+
+#if defined(__arm__)
+#define XCD_PROTO_ARCH XCD_PROTO_ARCH_ARM32
+#elif defined(__aarch64__)
+#define XCD_PROTO_ARCH XCD_PROTO_ARCH_ARM64
+#elif defined(__i386__)
+#define XCD_PROTO_ARCH XCD_PROTO_ARCH_X86
+#elif defined(__x86_64__)
+#define XCD_PROTO_ARCH XCD_PROTO_ARCH_X86_64
+#endif
+
+//map<uint32, Thread> entry
+#define XCD_PROTO_MAP_KEY   1
+#define XCD_PROTO_MAP_VALUE 2
+
+//message Signal
+#define XCD_PROTO_SIGNAL_NUMBER            1
+#define XCD_PROTO_SIGNAL_NAME              2
+#define XCD_PROTO_SIGNAL_CODE              3
+#define XCD_PROTO_SIGNAL_CODE_NAME         4
+#define XCD_PROTO_SIGNAL_HAS_SENDER        5
+#define XCD_PROTO_SIGNAL_SENDER_UID        6
+#define XCD_PROTO_SIGNAL_SENDER_PID        7
+#define XCD_PROTO_SIGNAL_HAS_FAULT_ADDRESS 8
+#define XCD_PROTO_SIGNAL_FAULT_ADDRESS     9
+
+//message Cause
+#define XCD_PROTO_CAUSE_HUMAN_READABLE 1
+
+//message Register
+#define XCD_PROTO_REGISTER_NAME 1
+#define XCD_PROTO_REGISTER_U64  2
+
+//message Thread
+#define XCD_PROTO_THREAD_ID                1
+#define XCD_PROTO_THREAD_NAME              2
+#define XCD_PROTO_THREAD_REGISTERS         3
+#define XCD_PROTO_THREAD_CURRENT_BACKTRACE 4
+#define XCD_PROTO_THREAD_MEMORY_DUMP       5
+#define XCD_PROTO_THREAD_BACKTRACE_NOTE    7
+
+//message BacktraceFrame
+#define XCD_PROTO_FRAME_REL_PC          1
+#define XCD_PROTO_FRAME_PC              2
+#define XCD_PROTO_FRAME_SP              3
+#define XCD_PROTO_FRAME_FUNCTION_NAME   4
+#define XCD_PROTO_FRAME_FUNCTION_OFFSET 5
+#define XCD_PROTO_FRAME_FILE_NAME       6
+#define XCD_PROTO_FRAME_FILE_MAP_OFFSET 7
+#define XCD_PROTO_FRAME_BUILD_ID        8
+
+//message MemoryDump
+#define XCD_PROTO_MEMORY_DUMP_REGISTER_NAME 1
+#define XCD_PROTO_MEMORY_DUMP_MAPPING_NAME  2
+#define XCD_PROTO_MEMORY_DUMP_BEGIN_ADDRESS 3
+#define XCD_PROTO_MEMORY_DUMP_MEMORY        4
+
+//message MemoryMapping
+#define XCD_PROTO_MAPPING_BEGIN_ADDRESS 1
+#define XCD_PROTO_MAPPING_END_ADDRESS   2
+#define XCD_PROTO_MAPPING_OFFSET        3
+#define XCD_PROTO_MAPPING_READ          4
+#define XCD_PROTO_MAPPING_WRITE         5
+#define XCD_PROTO_MAPPING_EXECUTE       6
+#define XCD_PROTO_MAPPING_MAPPING_NAME  7
+#define XCD_PROTO_MAPPING_BUILD_ID      8
+#define XCD_PROTO_MAPPING_LOAD_BIAS     9
+
+//message FD
+#define XCD_PROTO_FD_FD   1
+#define XCD_PROTO_FD_PATH 2
+
+//message LogBuffer
+#define XCD_PROTO_LOG_BUFFER_NAME 1
+#define XCD_PROTO_LOG_BUFFER_LOGS 2
+
+//message LogMessage
+#define XCD_PROTO_LOG_MESSAGE_TIMESTAMP 1
+#define XCD_PROTO_LOG_MESSAGE_PID       2
+#define XCD_PROTO_LOG_MESSAGE_TID       3
+#define XCD_PROTO_LOG_MESSAGE_PRIORITY  4
+#define XCD_PROTO_LOG_MESSAGE_TAG       5
+#define XCD_PROTO_LOG_MESSAGE_MESSAGE   6
+
+#define XCD_PROTO_DEPTH_MAX 8
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wpadded"
+typedef struct
+{
+    int      fd;
+    int      r;
+    size_t   pos;
+    size_t   flushed;
+    size_t   depth;
+    size_t   begins[XCD_PROTO_DEPTH_MAX];
+    size_t   len;
+    uint8_t  buf[4096];
+} xcd_proto_t;
+#pragma clang diagnostic pop
+
+void xcd_proto_init(xcd_proto_t *self, int fd);
+int xcd_proto_finish(xcd_proto_t *self);
+
+void xcd_proto_put_uint64(xcd_proto_t *self, uint32_t field, uint64_t v);
+void xcd_proto_put_int64(xcd_proto_t *self, uint32_t field, int64_t v);
+void xcd_proto_put_bool(xcd_proto_t *self, uint32_t field, int v);
+void xcd_proto_put_bytes(xcd_proto_t *self, uint32_t field, const void *data, size_t len);
+void xcd_proto_put_str(xcd_proto_t *self, uint32_t field, const char *str);
+
+void xcd_proto_begin(xcd_proto_t *self, uint32_t field);
+void xcd_proto_end(xcd_proto_t *self);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -75,6 +75,8 @@ void xcd_regs_load_from_ptregs(xcd_regs_t *self, uintptr_t *regs, size_t regs_le
 
 int xcd_regs_record(xcd_regs_t *self, int log_fd);
 
+void xcd_regs_get_minidump_context(xcd_regs_t *self, uint8_t *ctx);
+
 int xcd_regs_try_step_sigreturn(xcd_regs_t *self, uintptr_t rel_pc, xcd_memory_t *memory, pid_t pid);
 
 uintptr_t xcd_regs_get_adjust_pc(uintptr_t rel_pc, uintptr_t load_bias, xcd_memory_t *memory);
@@ -33,6 +33,7 @@ typedef int make_iso_compilers_happy;
 #include "xcd_regs.h"
 #include "xcd_memory.h"
 #include "xcd_util.h"
+#include "xcd_minidump.h"
 
 #define XCD_REGS_R0   0
 #define XCD_REGS_R1   1
@@ -258,4 +259,15 @@ int xcd_regs_set_pc_from_lr(xcd_regs_t *self, pid_t pid)
     return 0;
 }
 
+//Breakpad's MDRawContextARM: context_flags, iregs[16], cpsr, float_save
+void xcd_regs_get_minidump_context(xcd_regs_t *self, uint8_t *ctx)
+{
+    size_t i;
+
+    memset(ctx, 0, XCD_MINIDUMP_CONTEXT_SIZE);
+    xcd_minidump_put_u32(ctx, XCD_MINIDUMP_CONTEXT_FLAGS);
+    for(i = XCD_REGS_R0; i <= XCD_REGS_PC; i++)
+        xcd_minidump_put_u32(ctx + 4 + i * 4, self->r[i]);
+}
+
 #endif
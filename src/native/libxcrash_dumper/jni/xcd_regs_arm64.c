@@ -33,6 +33,7 @@ typedef int make_iso_compilers_happy;
 #include "xcd_regs.h"
 #include "xcd_memory.h"
 #include "xcd_util.h"
+#include "xcd_minidump.h"
 
 #define XCD_REGS_X0  0
 #define XCD_REGS_X1  1
@@ -236,4 +237,16 @@ int xcd_regs_set_pc_from_lr(xcd_regs_t *self, pid_t pid)
     return 0;
 }
 
+//Breakpad's MDRawContextARM64_Old (packed): context_flags, iregs[32] (x0-x28, fp, lr, sp), pc, cpsr, float_save
+void xcd_regs_get_minidump_context(xcd_regs_t *self, uint8_t *ctx)
+{
+    size_t i;
+
+    memset(ctx, 0, XCD_MINIDUMP_CONTEXT_SIZE);
+    xcd_minidump_put_u64(ctx, XCD_MINIDUMP_CONTEXT_FLAGS);
+    for(i = XCD_REGS_X0; i <= XCD_REGS_SP; i++)
+        xcd_minidump_put_u64(ctx + 8 + i * 8, self->r[i]);
+    xcd_minidump_put_u64(ctx + 264, self->r[XCD_REGS_PC]);
+}
+
 #endif
@@ -26,6 +26,7 @@ typedef int make_iso_compilers_happy;
 #ifdef __i386__
 
 #include <stdio.h>
+#include <string.h>
 #include <ucontext.h>
 #include <sys/ptrace.h>
 #include "xcc_errno.h"
@@ -33,6 +34,7 @@ typedef int make_iso_compilers_happy;
 #include "xcd_regs.h"
 #include "xcd_memory.h"
 #include "xcd_util.h"
+#include "xcd_minidump.h"
 
 #define XCD_REGS_EAX 0
 #define XCD_REGS_ECX 1
@@ -214,4 +216,20 @@ int xcd_regs_set_pc_from_lr(xcd_regs_t *self, pid_t pid)
     return 0;
 }
 
+//Breakpad's MDRawContextX86, the segment registers and eflags are not available
+void xcd_regs_get_minidump_context(xcd_regs_t *self, uint8_t *ctx)
+{
+    memset(ctx, 0, XCD_MINIDUMP_CONTEXT_SIZE);
+    xcd_minidump_put_u32(ctx, XCD_MINIDUMP_CONTEXT_FLAGS);
+    xcd_minidump_put_u32(ctx + 156, self->r[XCD_REGS_EDI]);
+    xcd_minidump_put_u32(ctx + 160, self->r[XCD_REGS_ESI]);
+    xcd_minidump_put_u32(ctx + 164, self->r[XCD_REGS_EBX]);
+    xcd_minidump_put_u32(ctx + 168, self->r[XCD_REGS_EDX]);
+    xcd_minidump_put_u32(ctx + 172, self->r[XCD_REGS_ECX]);
+    xcd_minidump_put_u32(ctx + 176, self->r[XCD_REGS_EAX]);
+    xcd_minidump_put_u32(ctx + 180, self->r[XCD_REGS_EBP]);
+    xcd_minidump_put_u32(ctx + 184, self->r[XCD_REGS_EIP]);
+    xcd_minidump_put_u32(ctx + 196, self->r[XCD_REGS_ESP]);
+}
+
 #endif
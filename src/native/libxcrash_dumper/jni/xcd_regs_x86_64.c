@@ -26,6 +26,7 @@ typedef int make_iso_compilers_happy;
 #ifdef __x86_64__
 
 #include <stdio.h>
+#include <string.h>
 #include <ucontext.h>
 #include <sys/ptrace.h>
 #include "xcc_errno.h"
@@ -33,6 +34,7 @@ typedef int make_iso_compilers_happy;
 #include "xcd_regs.h"
 #include "xcd_memory.h"
 #include "xcd_util.h"
+#include "xcd_minidump.h"
 
 #define XCD_REGS_RAX 0
 #define XCD_REGS_RDX 1
@@ -208,4 +210,24 @@ int xcd_regs_set_pc_from_lr(xcd_regs_t *self, pid_t pid)
     return 0;
 }
 
+//Breakpad's MDRawContextAMD64, the segment registers and eflags are not available
+void xcd_regs_get_minidump_context(xcd_regs_t *self, uint8_t *ctx)
+{
+    size_t i;
+
+    memset(ctx, 0, XCD_MINIDUMP_CONTEXT_SIZE);
+    xcd_minidump_put_u32(ctx + 48, XCD_MINIDUMP_CONTEXT_FLAGS);
+    xcd_minidump_put_u64(ctx + 120, self->r[XCD_REGS_RAX]);
+    xcd_minidump_put_u64(ctx + 128, self->r[XCD_REGS_RCX]);
+    xcd_minidump_put_u64(ctx + 136, self->r[XCD_REGS_RDX]);
+    xcd_minidump_put_u64(ctx + 144, self->r[XCD_REGS_RBX]);
+    xcd_minidump_put_u64(ctx + 152, self->r[XCD_REGS_RSP]);
+    xcd_minidump_put_u64(ctx + 160, self->r[XCD_REGS_RBP]);
+    xcd_minidump_put_u64(ctx + 168, self->r[XCD_REGS_RSI]);
+    xcd_minidump_put_u64(ctx + 176, self->r[XCD_REGS_RDI]);
+    for(i = XCD_REGS_R8; i <= XCD_REGS_R15; i++)
+        xcd_minidump_put_u64(ctx + 184 + (i - XCD_REGS_R8) * 8, self->r[i]);
+    xcd_minidump_put_u64(ctx + 248, self->r[XCD_REGS_RIP]);
+}
+
 #endif
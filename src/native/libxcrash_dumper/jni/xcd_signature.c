@@ -0,0 +1,154 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// Created by agent on 2026-10-17.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "xcc_errno.h"
+#include "xcc_util.h"
+#include "xcd_signature.h"
+
+typedef struct
+{
+    char     magic[4];
+    uint32_t version;
+    uint32_t slots;
+    uint32_t reserved;
+} xcd_signature_header_t;
+
+typedef struct
+{
+    uint64_t signature;
+    uint32_t count;
+    uint32_t reserved;
+    uint64_t first_time;
+    uint64_t last_time;
+} xcd_signature_slot_t;
+
+#define XCD_SIGNATURE_STORE_SIZE (sizeof(xcd_signature_header_t) + sizeof(xcd_signature_slot_t) * XCD_SIGNATURE_SLOTS)
+
+static xcd_signature_slot_t *xcd_signature_find(xcd_signature_slot_t *slots, uint64_t signature)
+{
+    xcd_signature_slot_t *oldest = NULL;
+    size_t                i, n;
+
+    //linear probing
+    for(n = 0, i = (size_t)(signature & (XCD_SIGNATURE_SLOTS - 1)); n < XCD_SIGNATURE_SLOTS; n++, i = (i + 1) & (XCD_SIGNATURE_SLOTS - 1))
+    {
+        if(signature == slots[i].signature) return &(slots[i]);
+        if(0 == slots[i].signature)
+        {
+            slots[i].signature = signature;
+            return &(slots[i]);
+        }
+        if(NULL == oldest || slots[i].last_time < oldest->last_time) oldest = &(slots[i]);
+    }
+
+    //the table is full, reuse the slot of the signature which has not been seen for the longest time
+    memset(oldest, 0, sizeof(xcd_signature_slot_t));
+    oldest->signature = signature;
+    return oldest;
+}
+
+int xcd_signature_save(const char *log_pathname, uint64_t signature, uint64_t crash_time)
+{
+    char                    pathname[1024];
+    const char             *p;
+    struct stat             st;
+    void                   *store;
+    xcd_signature_header_t *header;
+    xcd_signature_slot_t   *slot;
+    struct flock            lock;
+    int                     fd;
+    int                     r = 0;
+
+    if(0 == signature) return XCC_ERRNO_INVAL;
+    if(NULL == (p = strrchr(log_pathname, '/'))) return XCC_ERRNO_INVAL;
+    snprintf(pathname, sizeof(pathname), "%.*s/"XCC_UTIL_SIGNATURE_STORE_FILENAME, (int)(p - log_pathname), log_pathname);
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wgnu-statement-expression"
+    if(0 > (fd = XCC_UTIL_TEMP_FAILURE_RETRY(open(pathname, O_RDWR | O_CREAT | O_CLOEXEC, 0644)))) return XCC_ERRNO_SYS;
+
+    //the dumpers of other processes may update it at the same time, and the Java side reads it
+    //with a shared FileChannel lock, so it's a fcntl(2) record lock (flock(2) doesn't exclude those)
+    memset(&lock, 0, sizeof(lock));
+    lock.l_type = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    if(0 != XCC_UTIL_TEMP_FAILURE_RETRY(fcntl(fd, F_SETLKW, &lock)))
+    {
+        r = XCC_ERRNO_SYS;
+        goto end;
+    }
+#pragma clang diagnostic pop
+
+    //create it, or start over if it's broken
+    if(0 != fstat(fd, &st))
+    {
+        r = XCC_ERRNO_SYS;
+        goto end;
+    }
+    if(XCD_SIGNATURE_STORE_SIZE != (size_t)st.st_size)
+    {
+        if(0 != ftruncate(fd, 0) || 0 != ftruncate(fd, (off_t)XCD_SIGNATURE_STORE_SIZE))
+        {
+            r = XCC_ERRNO_SYS;
+            goto end;
+        }
+    }
+
+    if(MAP_FAILED == (store = mmap(NULL, XCD_SIGNATURE_STORE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)))
+    {
+        r = XCC_ERRNO_SYS;
+        goto end;
+    }
+
+    header = (xcd_signature_header_t *)store;
+    if(0 != memcmp(header->magic, XCD_SIGNATURE_MAGIC, 4) ||
+       XCD_SIGNATURE_VERSION != header->version ||
+       XCD_SIGNATURE_SLOTS != header->slots)
+    {
+        memset(store, 0, XCD_SIGNATURE_STORE_SIZE);
+        memcpy(header->magic, XCD_SIGNATURE_MAGIC, 4);
+        header->version = XCD_SIGNATURE_VERSION;
+        header->slots = XCD_SIGNATURE_SLOTS;
+    }
+
+    //count it
+    slot = xcd_signature_find((xcd_signature_slot_t *)(header + 1), signature);
+    if(0 == slot->count) slot->first_time = crash_time;
+    slot->last_time = crash_time;
+    slot->count++;
+
+    munmap(store, XCD_SIGNATURE_STORE_SIZE);
+
+ end:
+    close(fd);
+    return r;
+}
@@ -0,0 +1,50 @@
+// Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// Created by agent on 2026-10-17.
+
+#ifndef XCD_SIGNATURE_H
+#define XCD_SIGNATURE_H 1
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//counters of the native crash signatures, a fixed size open-addressing table in the log directory
+//(XCC_UTIL_SIGNATURE_STORE_FILENAME), mapped by the dumpers of all processes (see "TombstoneSignature.java"):
+//  header: "XCSG" version(u32) slots(u32) reserved(u32)
+//  slot:   signature(u64) count(u32) reserved(u32) first_time(u64) last_time(u64)
+//all the numbers are little-endian, the empty slot has zero signature.
+#define XCD_SIGNATURE_MAGIC   "XCSG"
+#define XCD_SIGNATURE_VERSION 1
+#define XCD_SIGNATURE_SLOTS   1024
+
+int xcd_signature_save(const char *log_pathname, uint64_t signature, uint64_t crash_time);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
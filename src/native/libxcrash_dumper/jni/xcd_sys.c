@@ -29,6 +29,7 @@
 #include "xcd_sys.h"
 
 int xcd_sys_record(int fd,
+                   const char *crash_type,
                    long time_zone,
                    uint64_t start_time,
                    uint64_t crash_time,
@@ -45,7 +46,7 @@ int xcd_sys_record(int fd,
 {
     char buf[1024];
     xcc_util_get_dump_header(buf, sizeof(buf),
-                             XCC_UTIL_CRASH_TYPE_NATIVE,
+                             crash_type,
                              time_zone,
                              start_time,
                              crash_time,
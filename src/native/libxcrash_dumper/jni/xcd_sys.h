@@ -33,6 +33,7 @@ extern "C" {
 #endif
 
 int xcd_sys_record(int fd,
+                   const char *crash_type,
                    long time_zone,
                    uint64_t start_time,
                    uint64_t crash_time,
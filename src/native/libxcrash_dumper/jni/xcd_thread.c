@@ -44,6 +44,16 @@
 #include "xcd_util.h"
 #include "xcd_log.h"
 
+#ifndef PTRACE_SEIZE
+#define PTRACE_SEIZE     0x4206
+#endif
+#ifndef PTRACE_INTERRUPT
+#define PTRACE_INTERRUPT 0x4207
+#endif
+
+#define XCD_THREAD_SNAPSHOT_STACK_MAX     (256 * 1024)
+#define XCD_THREAD_SNAPSHOT_STACK_REDZONE 128
+
 void xcd_thread_init(xcd_thread_t *self, pid_t pid, pid_t tid)
 {
     self->status = XCD_THREAD_STATUS_OK;
@@ -54,17 +64,8 @@ void xcd_thread_init(xcd_thread_t *self, pid_t pid, pid_t tid)
     memset(&(self->regs), 0, sizeof(self->regs));
 }
 
-void xcd_thread_suspend(xcd_thread_t *self)
+static void xcd_thread_wait_stopped(xcd_thread_t *self)
 {
-    if(0 != ptrace(PTRACE_ATTACH, self->tid, NULL, NULL))
-    {
-#if XCD_THREAD_DEBUG
-        XCD_LOG_WARN("THREAD: ptrace ATTACH failed, errno=%d", errno);
-#endif
-        self->status = XCD_THREAD_STATUS_ATTACH;
-        return;
-    }
-
     errno = 0;
     while(waitpid(self->tid, NULL, __WALL) < 0)
     {
@@ -81,6 +82,42 @@ void xcd_thread_suspend(xcd_thread_t *self)
     }
 }
 
+void xcd_thread_suspend(xcd_thread_t *self)
+{
+    if(0 != ptrace(PTRACE_ATTACH, self->tid, NULL, NULL))
+    {
+#if XCD_THREAD_DEBUG
+        XCD_LOG_WARN("THREAD: ptrace ATTACH failed, errno=%d", errno);
+#endif
+        self->status = XCD_THREAD_STATUS_ATTACH;
+        return;
+    }
+
+    xcd_thread_wait_stopped(self);
+}
+
+static void xcd_thread_seize(xcd_thread_t *self)
+{
+    //PTRACE_SEIZE is only supported by Linux 3.4+
+    if(0 != ptrace(PTRACE_SEIZE, self->tid, NULL, NULL))
+    {
+        xcd_thread_suspend(self);
+        return;
+    }
+
+    if(0 != ptrace(PTRACE_INTERRUPT, self->tid, NULL, NULL))
+    {
+#if XCD_THREAD_DEBUG
+        XCD_LOG_WARN("THREAD: ptrace INTERRUPT failed, errno=%d", errno);
+#endif
+        ptrace(PTRACE_DETACH, self->tid, NULL, NULL);
+        self->status = XCD_THREAD_STATUS_ATTACH;
+        return;
+    }
+
+    xcd_thread_wait_stopped(self);
+}
+
 void xcd_thread_resume(xcd_thread_t *self)
 {
     ptrace(PTRACE_DETACH, self->tid, NULL, NULL);
@@ -127,6 +164,40 @@ void xcd_thread_load_regs_from_ucontext(xcd_thread_t *self, ucontext_t *uc)
     xcd_regs_load_from_ucontext(&(self->regs), uc);
 }
 
+void xcd_thread_snapshot(xcd_thread_t *self, xcd_maps_t *maps)
+{
+    xcd_map_t *map;
+    uintptr_t  sp, start, end;
+    uint8_t   *buf;
+    size_t     len;
+
+    xcd_thread_seize(self);
+    if(XCD_THREAD_STATUS_OK != self->status) return;
+
+    //capture registers
+    xcd_thread_load_regs(self);
+    if(XCD_THREAD_STATUS_OK != self->status) goto end;
+
+    //bulk copy of the stack in use, the unwinding will read from it after the thread resumed
+    sp = xcd_regs_get_sp(&(self->regs));
+    if(NULL == (map = xcd_maps_find_map(maps, sp))) goto end;
+    start = (sp - map->start > XCD_THREAD_SNAPSHOT_STACK_REDZONE ? sp - XCD_THREAD_SNAPSHOT_STACK_REDZONE : map->start);
+    end = (map->end - start > XCD_THREAD_SNAPSHOT_STACK_MAX ? start + XCD_THREAD_SNAPSHOT_STACK_MAX : map->end);
+    len = (size_t)(end - start);
+    if(NULL == (buf = malloc(len))) goto end;
+    if(0 == (len = xcd_util_process_vm_read(self->pid, start, buf, len)) &&
+       0 == (len = xcd_util_ptrace_read(self->pid, start, buf, (size_t)(end - start))))
+    {
+        free(buf);
+        goto end;
+    }
+    if(0 != xcd_util_ptrace_add_snapshot(start, buf, len)) free(buf);
+
+ end:
+    //resume immediately
+    xcd_thread_resume(self);
+}
+
 int xcd_thread_load_frames(xcd_thread_t *self, xcd_maps_t *maps)
 {
 #if XCD_THREAD_DEBUG
@@ -138,6 +209,13 @@ int xcd_thread_load_frames(xcd_thread_t *self, xcd_maps_t *maps)
     return xcd_frames_create(&(self->frames), &(self->regs), maps, self->pid);
 }
 
+uint64_t xcd_thread_get_signature(xcd_thread_t *self, uint64_t hash, size_t frames_max)
+{
+    if(XCD_THREAD_STATUS_OK != self->status || NULL == self->frames) return hash; //ignore
+
+    return xcd_frames_get_signature(self->frames, hash, frames_max);
+}
+
 int xcd_thread_record_info(xcd_thread_t *self, int log_fd, const char *pname)
 {
     return xcc_util_write_format(log_fd, "pid: %d, tid: %d, name: %s  >>> %s <<<\n",
@@ -175,11 +253,12 @@ int xcd_thread_record_stack(xcd_thread_t *self, int log_fd)
 #define XCD_THREAD_MEMORY_BYTES_TO_DUMP 256
 #define XCD_THREAD_MEMORY_BYTES_PER_LINE 16
 
-static int xcd_thread_record_memory_by_addr(xcd_thread_t *self, int log_fd,
-                                            const char *label, uintptr_t addr)
+static int xcd_thread_load_memory(xcd_thread_t *self, uintptr_t *addr_ptr,
+                                  uintptr_t data[XCD_THREAD_MEMORY_BYTES_TO_DUMP/sizeof(uintptr_t)],
+                                  uint64_t *start_ptr, size_t *total_bytes_ptr)
 {
-    int r;
-    
+    uintptr_t addr = *addr_ptr;
+
     // Align the address to sizeof(long) and start 32 bytes before the address.
     addr &= ~(sizeof(long) - 1);
     if (addr >= 4128) addr -= 32;
@@ -191,15 +270,12 @@ static int xcd_thread_record_memory_by_addr(xcd_thread_t *self, int log_fd,
 #else
         addr > 0xffff0000 - XCD_THREAD_MEMORY_BYTES_TO_DUMP) {
 #endif
-        return 0; //not an error
+        return XCC_ERRNO_INVAL;
     }
 
-    if(0 != (r = xcc_util_write_format(log_fd, "memory near %s:\n", label))) return r;
-    
     // Dump 256 bytes
-    uintptr_t data[XCD_THREAD_MEMORY_BYTES_TO_DUMP/sizeof(uintptr_t)];
     memset(data, 0, XCD_THREAD_MEMORY_BYTES_TO_DUMP);
-    size_t bytes = xcd_util_ptrace_read(self->pid, addr, data, sizeof(data));
+    size_t bytes = xcd_util_ptrace_read(self->pid, addr, data, XCD_THREAD_MEMORY_BYTES_TO_DUMP);
     if (bytes % sizeof(uintptr_t) != 0)
         bytes &= ~(sizeof(uintptr_t) - 1);
     
@@ -225,15 +301,33 @@ static int xcd_thread_record_memory_by_addr(xcd_thread_t *self, int log_fd,
         // to contain at least one page, and the total number of bytes to dump
         // is smaller than a page.
         size_t bytes2 = xcd_util_ptrace_read(self->pid, (uintptr_t)(addr + start + bytes), (uint8_t *)(data) + bytes,
-                                             (size_t)(sizeof(data) - bytes - start));
+                                             (size_t)(XCD_THREAD_MEMORY_BYTES_TO_DUMP - bytes - start));
         bytes += bytes2;
         if(bytes2 > 0 && bytes % sizeof(uintptr_t) != 0)
             bytes &= ~(sizeof(uintptr_t) - 1);
     }
+
+    *addr_ptr = addr;
+    *start_ptr = start;
+    *total_bytes_ptr = (size_t)(start + bytes);
+    return 0;
+}
+
+static int xcd_thread_record_memory_by_addr(xcd_thread_t *self, int log_fd,
+                                            const char *label, uintptr_t addr)
+{
+    uintptr_t data[XCD_THREAD_MEMORY_BYTES_TO_DUMP/sizeof(uintptr_t)];
+    uint64_t start;
+    size_t total_bytes;
+    int r;
+
+    if(0 != xcd_thread_load_memory(self, &addr, data, &start, &total_bytes)) return 0; //not an error
+
+    if(0 != (r = xcc_util_write_format(log_fd, "memory near %s:\n", label))) return r;
+
     uintptr_t *data_ptr = data;
     uint8_t *ptr;
     size_t current = 0;
-    size_t total_bytes = (size_t)(start + bytes);
     size_t i, j, k;
     char ascii[XCD_THREAD_MEMORY_BYTES_PER_LINE + 1];
     size_t ascii_idx = 0;
@@ -304,3 +398,185 @@ int xcd_thread_record_memory(xcd_thread_t *self, int log_fd)
 
     return 0;
 }
+
+int xcd_thread_record_backtrace_binary(xcd_thread_t *self, int log_fd, xcc_binlog_t *binlog)
+{
+    if(XCD_THREAD_STATUS_OK != self->status) return 0; //ignore
+
+    return xcd_frames_record_backtrace_binary(self->frames, log_fd, binlog);
+}
+
+int xcd_thread_record_buildid_binary(xcd_thread_t *self, int log_fd, xcc_binlog_t *binlog, int dump_elf_hash, uintptr_t fault_addr)
+{
+    if(XCD_THREAD_STATUS_OK != self->status) return 0; //ignore
+
+    return xcd_frames_record_buildid_binary(self->frames, log_fd, binlog, dump_elf_hash, fault_addr);
+}
+
+int xcd_thread_record_memory_binary(xcd_thread_t *self, int log_fd, xcc_binlog_t *binlog)
+{
+    xcd_regs_label_t *labels;
+    size_t            labels_count;
+    size_t            i;
+    uintptr_t         addr;
+    uintptr_t         data[XCD_THREAD_MEMORY_BYTES_TO_DUMP/sizeof(uintptr_t)];
+    uint64_t          start;
+    size_t            total_bytes;
+    int               r;
+
+    if(XCD_THREAD_STATUS_OK != self->status) return 0; //ignore
+
+    xcd_regs_get_labels(&labels, &labels_count);
+
+    //raw memory windows, only the readable words in data are meaningful
+    if(0 != (r = xcc_binlog_section_begin(binlog, log_fd, XCC_BINLOG_SECTION_MEMORY))) return r;
+    for(i = 0; i < labels_count; i++)
+    {
+        addr = (uintptr_t)(self->regs.r[labels[i].idx]);
+        if(0 != xcd_thread_load_memory(self, &addr, data, &start, &total_bytes)) continue;
+
+        xcc_binlog_put_str(binlog, labels[i].name);
+        xcc_binlog_put_varint(binlog, addr);
+        xcc_binlog_put_varint(binlog, start);
+        xcc_binlog_put_varint(binlog, total_bytes);
+        xcc_binlog_put_varint(binlog, sizeof(data));
+        xcc_binlog_put_bytes(binlog, data, sizeof(data));
+    }
+    return xcc_binlog_section_end(binlog);
+}
+
+int xcd_thread_record_proto(xcd_thread_t *self, xcd_proto_t *proto, xcd_maps_t *maps, int dump_memory)
+{
+    xcd_regs_label_t *labels;
+    size_t            labels_count;
+    size_t            i;
+    uintptr_t         addr;
+    uintptr_t         data[XCD_THREAD_MEMORY_BYTES_TO_DUMP/sizeof(uintptr_t)];
+    uint64_t          start;
+    size_t            total_bytes;
+    xcd_map_t        *map;
+
+    //an entry of map<uint32, Thread>
+    xcd_proto_begin(proto, XCD_PROTO_TOMBSTONE_THREADS);
+    xcd_proto_put_uint64(proto, XCD_PROTO_MAP_KEY, (uint64_t)self->tid);
+    xcd_proto_begin(proto, XCD_PROTO_MAP_VALUE);
+    xcd_proto_put_int64(proto, XCD_PROTO_THREAD_ID, self->tid);
+    xcd_proto_put_str(proto, XCD_PROTO_THREAD_NAME, self->tname);
+
+    if(XCD_THREAD_STATUS_OK == self->status)
+    {
+        xcd_regs_get_labels(&labels, &labels_count);
+
+        //registers
+        for(i = 0; i < labels_count; i++)
+        {
+            xcd_proto_begin(proto, XCD_PROTO_THREAD_REGISTERS);
+            xcd_proto_put_str(proto, XCD_PROTO_REGISTER_NAME, labels[i].name);
+            xcd_proto_put_uint64(proto, XCD_PROTO_REGISTER_U64, self->regs.r[labels[i].idx]);
+            xcd_proto_end(proto);
+        }
+
+        //backtrace (only if the frames have been loaded)
+        if(NULL != self->frames)
+            xcd_frames_record_proto(self->frames, proto);
+        else
+            xcd_proto_put_str(proto, XCD_PROTO_THREAD_BACKTRACE_NOTE, "backtrace not dumped");
+
+        //memory near the registers, only the readable part
+        for(i = 0; dump_memory && i < labels_count; i++)
+        {
+            addr = (uintptr_t)(self->regs.r[labels[i].idx]);
+            if(0 != xcd_thread_load_memory(self, &addr, data, &start, &total_bytes)) continue;
+            if(total_bytes <= start) continue;
+
+            xcd_proto_begin(proto, XCD_PROTO_THREAD_MEMORY_DUMP);
+            xcd_proto_put_str(proto, XCD_PROTO_MEMORY_DUMP_REGISTER_NAME, labels[i].name);
+            if(NULL != maps && NULL != (map = xcd_maps_find_map(maps, addr + start)))
+                xcd_proto_put_str(proto, XCD_PROTO_MEMORY_DUMP_MAPPING_NAME, map->name);
+            xcd_proto_put_uint64(proto, XCD_PROTO_MEMORY_DUMP_BEGIN_ADDRESS, addr + start);
+            //the readable bytes are at the beginning of data, they start at (addr + start)
+            xcd_proto_put_bytes(proto, XCD_PROTO_MEMORY_DUMP_MEMORY, data, (size_t)(total_bytes - start));
+            xcd_proto_end(proto);
+        }
+    }
+    else
+    {
+        xcd_proto_put_str(proto, XCD_PROTO_THREAD_BACKTRACE_NOTE, "thread not attached");
+    }
+
+    xcd_proto_end(proto);
+    xcd_proto_end(proto);
+    return proto->r;
+}
+
+#define XCD_THREAD_MINIDUMP_RED_ZONE 128
+
+int xcd_thread_record_minidump(xcd_thread_t *self, xcd_minidump_t *md, xcd_maps_t *maps, size_t stack_max,
+                               uint8_t *entry, xcd_minidump_location_t *context)
+{
+    uint8_t                  ctx[XCD_MINIDUMP_CONTEXT_SIZE];
+    xcd_minidump_location_t  stack = {0, 0};
+    xcd_map_t               *map;
+    uintptr_t                sp, start = 0, end;
+    uint8_t                 *buf;
+    size_t                   len;
+
+    memset(entry, 0, XCD_MINIDUMP_THREAD_SIZE);
+    xcd_minidump_put_u32(entry, (uint32_t)self->tid);
+    context->size = 0;
+    context->rva = 0;
+    if(XCD_THREAD_STATUS_OK != self->status) return md->r;
+
+    //context
+    xcd_regs_get_minidump_context(&(self->regs), ctx);
+    xcd_minidump_write(md, ctx, sizeof(ctx), context);
+
+    //stack, from the red zone below sp to the top of the stack mapping
+    sp = xcd_regs_get_sp(&(self->regs));
+    if(NULL != maps && NULL != (map = xcd_maps_find_map(maps, sp)) && (map->flags & PROT_READ))
+    {
+        start = (sp - map->start > XCD_THREAD_MINIDUMP_RED_ZONE ? sp - XCD_THREAD_MINIDUMP_RED_ZONE : map->start);
+        end = (map->end - start > stack_max ? start + stack_max : map->end);
+        if(NULL != (buf = malloc(end - start)))
+        {
+            if(0 == (len = xcd_util_process_vm_read(self->pid, start, buf, end - start)))
+                len = xcd_util_ptrace_read(self->pid, start, buf, end - start);
+            if(len > 0 && !xcd_minidump_has_memory(md, start, len))
+                xcd_minidump_add_memory(md, start, buf, len, &stack);
+            free(buf);
+        }
+    }
+
+    //thread id, suspend count, priority class, priority, teb, stack, context
+    xcd_minidump_put_u64(entry + 24, stack.size > 0 ? start : 0);
+    xcd_minidump_put_location(entry + 32, &stack);
+    xcd_minidump_put_location(entry + 40, context);
+    return md->r;
+}
+
+int xcd_thread_record_minidump_memory(xcd_thread_t *self, xcd_minidump_t *md)
+{
+    xcd_regs_label_t *labels;
+    size_t            labels_count;
+    size_t            i;
+    uintptr_t         addr;
+    uintptr_t         data[XCD_THREAD_MEMORY_BYTES_TO_DUMP/sizeof(uintptr_t)];
+    uint64_t          start;
+    size_t            total_bytes;
+
+    if(XCD_THREAD_STATUS_OK != self->status) return md->r;
+
+    //memory near the registers, the ranges already in the dump (the stack) are skipped
+    xcd_regs_get_labels(&labels, &labels_count);
+    for(i = 0; i < labels_count; i++)
+    {
+        addr = (uintptr_t)(self->regs.r[labels[i].idx]);
+        if(0 != xcd_thread_load_memory(self, &addr, data, &start, &total_bytes)) continue;
+        if(total_bytes <= start) continue;
+        if(xcd_minidump_has_memory(md, (uintptr_t)(addr + start), (size_t)(total_bytes - start))) continue;
+
+        //the readable bytes are at the beginning of data, as in the text log
+        xcd_minidump_add_memory(md, (uintptr_t)(addr + start), (uint8_t *)data, (size_t)(total_bytes - start), NULL);
+    }
+    return md->r;
+}
@@ -28,6 +28,9 @@
 #include <sys/types.h>
 #include "xcd_regs.h"
 #include "xcd_frames.h"
+#include "xcd_maps.h"
+#include "xcd_proto.h"
+#include "xcd_minidump.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -59,11 +62,13 @@ void xcd_thread_init(xcd_thread_t *self, pid_t pid, pid_t tid);
 
 void xcd_thread_suspend(xcd_thread_t *self);
 void xcd_thread_resume(xcd_thread_t *self);
+void xcd_thread_snapshot(xcd_thread_t *self, xcd_maps_t *maps);
 
 void xcd_thread_load_info(xcd_thread_t *self);
 void xcd_thread_load_regs(xcd_thread_t *self);
 void xcd_thread_load_regs_from_ucontext(xcd_thread_t *self, ucontext_t *uc);
 int xcd_thread_load_frames(xcd_thread_t *self, xcd_maps_t *maps);
+uint64_t xcd_thread_get_signature(xcd_thread_t *self, uint64_t hash, size_t frames_max);
 
 int xcd_thread_record_info(xcd_thread_t *self, int log_fd, const char *pname);
 int xcd_thread_record_regs(xcd_thread_t *self, int log_fd);
@@ -72,6 +77,16 @@ int xcd_thread_record_buildid(xcd_thread_t *self, int log_fd, int dump_elf_hash,
 int xcd_thread_record_stack(xcd_thread_t *self, int log_fd);
 int xcd_thread_record_memory(xcd_thread_t *self, int log_fd);
 
+int xcd_thread_record_backtrace_binary(xcd_thread_t *self, int log_fd, xcc_binlog_t *binlog);
+int xcd_thread_record_buildid_binary(xcd_thread_t *self, int log_fd, xcc_binlog_t *binlog, int dump_elf_hash, uintptr_t fault_addr);
+int xcd_thread_record_memory_binary(xcd_thread_t *self, int log_fd, xcc_binlog_t *binlog);
+
+int xcd_thread_record_proto(xcd_thread_t *self, xcd_proto_t *proto, xcd_maps_t *maps, int dump_memory);
+
+int xcd_thread_record_minidump(xcd_thread_t *self, xcd_minidump_t *md, xcd_maps_t *maps, size_t stack_max,
+                               uint8_t *entry, xcd_minidump_location_t *context);
+int xcd_thread_record_minidump_memory(xcd_thread_t *self, xcd_minidump_t *md);
+
 #ifdef __cplusplus
 }
 #endif
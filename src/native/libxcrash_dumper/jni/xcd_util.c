@@ -30,6 +30,8 @@
 #include <signal.h>
 #include <inttypes.h>
 #include <sys/ptrace.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include "xcc_errno.h"
@@ -43,8 +45,99 @@
 #include "7zCrc.h"
 #include "Xz.h"
 #include "XzCrc64.h"
+#include "XzEnc.h"
+#include "LzmaEnc.h"
+#include "LzmaEncLzma2.h"
 #pragma clang diagnostic pop
 
+//crash logs are small, a small dictionary keeps the memory usage low (about 3MB) at crash time
+#define XCD_UTIL_XZ_DICT_SIZE (1 << 18)
+
+//LZMA2 chunk limits (see "Lzma2Enc.c")
+#define XCD_UTIL_LZMA2_PACK_SIZE_MAX       (1 << 16)
+#define XCD_UTIL_LZMA2_UNPACK_SIZE_MAX     (1 << 21)
+#define XCD_UTIL_LZMA2_CHUNK_SIZE_MAX      ((1 << 16) + 16)
+#define XCD_UTIL_LZMA2_CONTROL_LZMA        0x80
+#define XCD_UTIL_LZMA2_CONTROL_COPY        2
+#define XCD_UTIL_LZMA2_DIC_SIZE(p)         (((uint32_t)2 | ((p) & 1)) << ((p) / 2 + 11))
+
+//the LZMA encoder stops a block this far before the unpack size limit (kNumOpts + 300 in "LzmaEnc.c")
+#define XCD_UTIL_LZMA_UNPACK_RESERVE       ((1 << 12) + 300)
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wpadded"
+typedef struct
+{
+    uintptr_t  addr;
+    uint8_t   *buf;
+    size_t     len;
+} xcd_util_snapshot_t;
+#pragma clang diagnostic pop
+
+//memory copied from the target process before its threads were resumed
+static xcd_util_snapshot_t *xcd_util_snapshots     = NULL;
+static size_t               xcd_util_snapshots_cnt = 0;
+static size_t               xcd_util_snapshots_cap = 0;
+static int                  xcd_util_detached      = 0;
+
+int xcd_util_ptrace_add_snapshot(uintptr_t addr, void *buf, size_t len)
+{
+    xcd_util_snapshot_t *snapshots;
+    size_t               cap;
+
+    if(xcd_util_snapshots_cnt == xcd_util_snapshots_cap)
+    {
+        cap = (0 == xcd_util_snapshots_cap ? 64 : xcd_util_snapshots_cap * 2);
+        if(NULL == (snapshots = realloc(xcd_util_snapshots, cap * sizeof(xcd_util_snapshot_t)))) return XCC_ERRNO_NOMEM;
+        xcd_util_snapshots = snapshots;
+        xcd_util_snapshots_cap = cap;
+    }
+
+    xcd_util_snapshots[xcd_util_snapshots_cnt].addr = addr;
+    xcd_util_snapshots[xcd_util_snapshots_cnt].buf  = (uint8_t *)buf;
+    xcd_util_snapshots[xcd_util_snapshots_cnt].len  = len;
+    xcd_util_snapshots_cnt++;
+    return 0;
+}
+
+void xcd_util_ptrace_reset_snapshots(void)
+{
+    xcd_util_snapshots_cnt = 0;
+}
+
+void xcd_util_ptrace_set_detached(void)
+{
+    xcd_util_detached = 1;
+}
+
+static size_t xcd_util_read_from_snapshots(uintptr_t addr, void *dst, size_t bytes)
+{
+    xcd_util_snapshot_t *snapshot;
+    size_t               i, n;
+
+    for(i = 0; i < xcd_util_snapshots_cnt; i++)
+    {
+        snapshot = &(xcd_util_snapshots[i]);
+        if(addr < snapshot->addr || addr - snapshot->addr >= snapshot->len) continue;
+
+        n = snapshot->len - (addr - snapshot->addr);
+        if(n > bytes) n = bytes;
+        memcpy(dst, snapshot->buf + (addr - snapshot->addr), n);
+        return n;
+    }
+    return 0;
+}
+
+size_t xcd_util_process_vm_read(pid_t pid, uintptr_t addr, void *dst, size_t bytes)
+{
+    struct iovec local  = {.iov_base = dst, .iov_len = bytes};
+    struct iovec remote = {.iov_base = (void *)addr, .iov_len = bytes};
+    long         n;
+
+    n = syscall(__NR_process_vm_readv, pid, &local, 1, &remote, 1, 0);
+    return n > 0 ? (size_t)n : 0;
+}
+
 int xcd_util_ptrace_read_long(pid_t pid, uintptr_t addr, long *value)
 {
     // ptrace() returns -1 and sets errno when the operation fails.
@@ -66,12 +159,17 @@ size_t xcd_util_ptrace_read(pid_t pid, uintptr_t addr, void *dst, size_t bytes)
     uintptr_t max_size;
     if(__builtin_add_overflow(addr, bytes, &max_size)) return 0;
 
+    //read from the snapshots first, then from the live process if the threads have been resumed
+    size_t snapshot_read;
+    if(xcd_util_snapshots_cnt > 0 && 0 != (snapshot_read = xcd_util_read_from_snapshots(addr, dst, bytes))) return snapshot_read;
+    if(xcd_util_detached) return xcd_util_process_vm_read(pid, addr, dst, bytes);
+
     size_t bytes_read = 0;
     long   data;
     size_t align_bytes = addr & (sizeof(long) - 1);
     if(align_bytes != 0)
     {
-        if(0 != xcd_util_ptrace_read_long(pid, addr & ~(sizeof(long) - 1), &data)) return 0;
+        if(0 != xcd_util_ptrace_read_long(pid, addr & ~(sizeof(long) - 1), &data)) goto fallback;
 
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wgnu-statement-expression"
@@ -85,27 +183,30 @@ size_t xcd_util_ptrace_read(pid_t pid, uintptr_t addr, void *dst, size_t bytes)
         bytes_read += copy_bytes;
     }
 
-    size_t i;
-    for(i = 0; i < bytes / sizeof(long); i++)
+    while(bytes >= sizeof(long))
     {
-        if(0 != xcd_util_ptrace_read_long(pid, addr, &data)) return bytes_read;
+        if(0 != xcd_util_ptrace_read_long(pid, addr, &data)) goto fallback;
         
         memcpy(dst, &data, sizeof(long));
         dst = (void *)((uintptr_t)dst + sizeof(long));
         addr += sizeof(long);
+        bytes -= sizeof(long);
         bytes_read += sizeof(long);
     }
 
-    size_t left_over = bytes & (sizeof(long) - 1);
-    if(left_over)
+    if(bytes > 0)
     {
-        if(0 != xcd_util_ptrace_read_long(pid, addr, &data)) return bytes_read;
+        if(0 != xcd_util_ptrace_read_long(pid, addr, &data)) goto fallback;
         
-        memcpy(dst, &data, left_over);
-        bytes_read += left_over;
+        memcpy(dst, &data, bytes);
+        bytes_read += bytes;
     }
 
     return bytes_read;
+
+ fallback:
+    //PTRACE_PEEKTEXT failed in the middle, the rest may still be readable by process_vm_readv
+    return bytes_read + xcd_util_process_vm_read(pid, addr, dst, bytes);
 }
 
 int xcd_util_ptrace_read_fully(pid_t pid, uintptr_t addr, void *dst, size_t bytes)
@@ -186,3 +287,275 @@ int xcd_util_xz_decompress(uint8_t* src, size_t src_size, uint8_t** dst, size_t*
     
     return 0;
 }
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wpadded"
+typedef struct
+{
+    int            fd;
+    size_t         remaining;
+    int            r;
+    const uint8_t *prefix;
+    size_t         prefix_remaining;
+    uint32_t       crc;
+} xcd_util_xz_file_t;
+
+typedef struct
+{
+    ISeqInStream        vt;
+    xcd_util_xz_file_t *file;
+} xcd_util_xz_in_t;
+
+typedef struct
+{
+    ISeqOutStream       vt;
+    xcd_util_xz_file_t *file;
+} xcd_util_xz_out_t;
+#pragma clang diagnostic pop
+
+static SRes xcd_util_xz_read(const ISeqInStream *p, void *buf, size_t *size)
+{
+    xcd_util_xz_file_t *file = ((const xcd_util_xz_in_t *)p)->file;
+    ssize_t             n;
+
+    //the preset dictionary goes first, it's not a part of the file content
+    if(file->prefix_remaining > 0)
+    {
+        if(*size > file->prefix_remaining) *size = file->prefix_remaining;
+        memcpy(buf, file->prefix, *size);
+        file->prefix += *size;
+        file->prefix_remaining -= *size;
+        return SZ_OK;
+    }
+
+    if(*size > file->remaining) *size = file->remaining;
+    if(0 == *size) return SZ_OK;
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wgnu-statement-expression"
+    n = XCC_UTIL_TEMP_FAILURE_RETRY(read(file->fd, buf, *size));
+#pragma clang diagnostic pop
+    if(n <= 0)
+    {
+        file->r = XCC_ERRNO_SYS;
+        return SZ_ERROR_READ;
+    }
+
+    *size = (size_t)n;
+    file->remaining -= (size_t)n;
+    file->crc = CrcUpdate(file->crc, buf, (size_t)n);
+    return SZ_OK;
+}
+
+static size_t xcd_util_xz_write(const ISeqOutStream *p, const void *buf, size_t size)
+{
+    xcd_util_xz_file_t *file = ((const xcd_util_xz_out_t *)p)->file;
+
+    if(0 != (file->r = xcc_util_write(file->fd, (const char *)buf, size))) return 0;
+    return size;
+}
+
+int xcd_util_xz_compress(int src_fd, size_t src_size, int dst_fd)
+{
+    ISzAlloc           alloc = {.Alloc = xcd_util_xz_alloc, .Free = xcd_util_xz_free};
+    xcd_util_xz_file_t src = {.fd = src_fd, .remaining = src_size, .r = 0, .prefix = NULL, .prefix_remaining = 0, .crc = CRC_INIT_VAL};
+    xcd_util_xz_file_t dst = {.fd = dst_fd, .remaining = 0, .r = 0, .prefix = NULL, .prefix_remaining = 0, .crc = CRC_INIT_VAL};
+    xcd_util_xz_in_t   in = {.vt = {.Read = xcd_util_xz_read}, .file = &src};
+    xcd_util_xz_out_t  out = {.vt = {.Write = xcd_util_xz_write}, .file = &dst};
+    CXzProps           props;
+    CXzEncHandle       xz;
+    SRes               res;
+
+    if(!xcd_util_xz_crc_gen)
+    {
+        //call these initialization functions only once
+        xcd_util_xz_crc_gen = 1;
+
+        CrcGenerateTable();
+        Crc64GenerateTable();
+    }
+
+    //single thread, fast mode, one block, streamed from src_fd to dst_fd
+    XzProps_Init(&props);
+    props.lzma2Props.lzmaProps.level = 1;
+    props.lzma2Props.lzmaProps.dictSize = XCD_UTIL_XZ_DICT_SIZE;
+    props.checkId = XZ_CHECK_CRC32;
+    props.blockSize = XZ_PROPS__BLOCK_SIZE__SOLID;
+    props.numTotalThreads = 1;
+    props.reduceSize = src_size;
+
+    if(NULL == (xz = XzEnc_Create(&alloc, &alloc))) return XCC_ERRNO_NOMEM;
+    if(SZ_OK == (res = XzEnc_SetProps(xz, &props)))
+        res = XzEnc_Encode(xz, &(out.vt), &(in.vt), NULL);
+    XzEnc_Destroy(xz);
+
+    if(0 != src.r) return src.r;
+    if(0 != dst.r) return dst.r;
+    if(SZ_ERROR_MEM == res) return XCC_ERRNO_NOMEM;
+    return SZ_OK == res ? 0 : XCC_ERRNO_FORMAT;
+}
+
+//the dictionary compressed log file (see "TombstoneXz.java"):
+//magic(6) + dictionary ID(4, CRC32 of the dictionary) + dictionary size(4) + LZMA2 dictionary size(1)
+//+ LZMA2 chunks (the first chunk doesn't reset the dictionary) + end of LZMA2(1) + CRC32 of the log(4)
+static const uint8_t xcd_util_xz_dict_magic[6] = {0xFD, 'X', 'C', 'D', 'Z', 0x00};
+
+static void xcd_util_xz_put_le32(uint8_t *buf, uint32_t v)
+{
+    buf[0] = (uint8_t)v;
+    buf[1] = (uint8_t)(v >> 8);
+    buf[2] = (uint8_t)(v >> 16);
+    buf[3] = (uint8_t)(v >> 24);
+}
+
+static int xcd_util_xz_write_stored(int fd, const uint8_t *data, size_t len)
+{
+    uint8_t header[3];
+    size_t  n;
+    int     r;
+
+    while(len > 0)
+    {
+        n = (len < XCD_UTIL_LZMA2_PACK_SIZE_MAX ? len : XCD_UTIL_LZMA2_PACK_SIZE_MAX);
+        header[0] = XCD_UTIL_LZMA2_CONTROL_COPY;
+        header[1] = (uint8_t)((n - 1) >> 8);
+        header[2] = (uint8_t)(n - 1);
+        if(0 != (r = xcc_util_write(fd, (const char *)header, sizeof(header)))) return r;
+        if(0 != (r = xcc_util_write(fd, (const char *)data, n))) return r;
+        data += n;
+        len -= n;
+    }
+    return 0;
+}
+
+int xcd_util_xz_compress_dict(int src_fd, size_t src_size, const uint8_t *dict, size_t dict_size, int dst_fd)
+{
+    ISzAlloc           alloc = {.Alloc = xcd_util_xz_alloc, .Free = xcd_util_xz_free};
+    xcd_util_xz_file_t src = {.fd = src_fd, .remaining = src_size, .r = 0, .prefix = dict, .prefix_remaining = dict_size, .crc = CRC_INIT_VAL};
+    xcd_util_xz_in_t   in = {.vt = {.Read = xcd_util_xz_read}, .file = &src};
+    CLzmaEncProps      props;
+    CLzmaEncHandle     enc;
+    Byte               props_encoded[LZMA_PROPS_SIZE];
+    SizeT              props_encoded_size = LZMA_PROPS_SIZE;
+    uint8_t            header[15];
+    uint8_t           *chunk = NULL;
+    uint32_t           dict_size_lzma;
+    unsigned int       dict_size_prop;
+    size_t             primed = 0, pack_size, header_size;
+    UInt32             unpack_size;
+    int                need_props = 1, need_state = 1, use_stored;
+    SRes               res = SZ_OK;
+    int                r = 0;
+
+    if(NULL == dict || 0 == dict_size || dict_size > XCD_UTIL_LZMA2_UNPACK_SIZE_MAX) return XCC_ERRNO_INVAL;
+
+    if(!xcd_util_xz_crc_gen)
+    {
+        //call these initialization functions only once
+        xcd_util_xz_crc_gen = 1;
+
+        CrcGenerateTable();
+        Crc64GenerateTable();
+    }
+
+    //fast mode, the window holds the whole dictionary in addition to the usual one
+    LzmaEncProps_Init(&props);
+    props.level = 1;
+    props.dictSize = (uint32_t)(XCD_UTIL_XZ_DICT_SIZE + dict_size);
+    props.reduceSize = dict_size + src_size;
+    props.numThreads = 1;
+
+    if(NULL == (enc = LzmaEnc_Create(&alloc))) return XCC_ERRNO_NOMEM;
+    if(NULL == (chunk = malloc(XCD_UTIL_LZMA2_CHUNK_SIZE_MAX)))
+    {
+        r = XCC_ERRNO_NOMEM;
+        goto end;
+    }
+    if(SZ_OK != (res = LzmaEnc_SetProps(enc, &props))) goto end;
+    if(SZ_OK != (res = LzmaEnc_WriteProperties(enc, props_encoded, &props_encoded_size))) goto end;
+    dict_size_lzma = (uint32_t)props_encoded[1] | ((uint32_t)props_encoded[2] << 8) |
+        ((uint32_t)props_encoded[3] << 16) | ((uint32_t)props_encoded[4] << 24);
+    for(dict_size_prop = 0; dict_size_prop < 40; dict_size_prop++)
+        if(dict_size_lzma <= XCD_UTIL_LZMA2_DIC_SIZE(dict_size_prop)) break;
+
+    //file header
+    memcpy(header, xcd_util_xz_dict_magic, sizeof(xcd_util_xz_dict_magic));
+    xcd_util_xz_put_le32(header + 6, CrcCalc(dict, dict_size));
+    xcd_util_xz_put_le32(header + 10, (uint32_t)dict_size);
+    header[14] = (uint8_t)dict_size_prop;
+    if(0 != (r = xcc_util_write(dst_fd, (const char *)header, sizeof(header)))) goto end;
+
+    //the input stream is the dictionary followed by the log file
+    if(SZ_OK != (res = LzmaEnc_PrepareForLzma2(enc, &(in.vt), XCD_UTIL_LZMA2_UNPACK_SIZE_MAX, &alloc, &alloc))) goto end;
+
+    //encode the dictionary and drop the output, the match finder remembers the dictionary after this
+    while(primed < dict_size)
+    {
+        pack_size = XCD_UTIL_LZMA2_CHUNK_SIZE_MAX;
+        unpack_size = (UInt32)(dict_size - primed + XCD_UTIL_LZMA_UNPACK_RESERVE);
+        if(SZ_OK != (res = LzmaEnc_CodeOneMemBlock(enc, False, chunk, &pack_size, XCD_UTIL_LZMA2_PACK_SIZE_MAX, &unpack_size))) goto end;
+        if(0 == unpack_size) break;
+        primed += unpack_size;
+    }
+
+    //the beginning of the log may be encoded together with the end of the dictionary, save it as is
+    if(primed > dict_size)
+        if(0 != (r = xcd_util_xz_write_stored(dst_fd, LzmaEnc_GetCurBuf(enc) - (primed - dict_size), primed - dict_size))) goto end;
+
+    //encode the log, the first LZMA chunk resets the state and sets the props, but keeps the dictionary
+    while(1)
+    {
+        header_size = (need_props ? 6 : 5);
+        pack_size = XCD_UTIL_LZMA2_CHUNK_SIZE_MAX - header_size;
+        unpack_size = XCD_UTIL_LZMA2_UNPACK_SIZE_MAX;
+
+        LzmaEnc_SaveState(enc);
+        res = LzmaEnc_CodeOneMemBlock(enc, need_state ? True : False, chunk + header_size, &pack_size, XCD_UTIL_LZMA2_PACK_SIZE_MAX, &unpack_size);
+        if(0 == unpack_size)
+        {
+            if(SZ_OK != res) goto end;
+            break;
+        }
+
+        if(SZ_OK == res)
+            use_stored = (pack_size + 2 >= unpack_size || pack_size > XCD_UTIL_LZMA2_PACK_SIZE_MAX);
+        else if(SZ_ERROR_OUTPUT_EOF == res)
+            use_stored = 1;
+        else
+            goto end;
+        res = SZ_OK;
+
+        if(use_stored)
+        {
+            //incompressible, the encoder state goes back to the one before this chunk
+            if(0 != (r = xcd_util_xz_write_stored(dst_fd, LzmaEnc_GetCurBuf(enc) - unpack_size, unpack_size))) goto end;
+            LzmaEnc_RestoreState(enc);
+            continue;
+        }
+
+        chunk[0] = (uint8_t)(XCD_UTIL_LZMA2_CONTROL_LZMA | ((need_state ? (need_props ? 2u : 1u) : 0u) << 5) | ((unpack_size - 1) >> 16));
+        chunk[1] = (uint8_t)((unpack_size - 1) >> 8);
+        chunk[2] = (uint8_t)(unpack_size - 1);
+        chunk[3] = (uint8_t)((pack_size - 1) >> 8);
+        chunk[4] = (uint8_t)(pack_size - 1);
+        if(need_props) chunk[5] = props_encoded[0];
+        if(0 != (r = xcc_util_write(dst_fd, (const char *)chunk, header_size + pack_size))) goto end;
+        need_props = 0;
+        need_state = 0;
+    }
+
+    //end of LZMA2 and the check
+    header[0] = 0;
+    xcd_util_xz_put_le32(header + 1, CRC_GET_DIGEST(src.crc));
+    r = xcc_util_write(dst_fd, (const char *)header, 5);
+
+ end:
+    LzmaEnc_Finish(enc);
+    LzmaEnc_Destroy(enc, &alloc, &alloc);
+    if(NULL != chunk) free(chunk);
+
+    if(0 != src.r) return src.r;
+    if(0 != r) return r;
+    if(SZ_ERROR_MEM == res) return XCC_ERRNO_NOMEM;
+    return SZ_OK == res ? 0 : XCC_ERRNO_FORMAT;
+}
@@ -54,7 +54,15 @@ int xcd_util_ptrace_read_long(pid_t pid, uintptr_t addr, long *value);
 size_t xcd_util_ptrace_read(pid_t pid, uintptr_t addr, void *dst, size_t bytes);
 int xcd_util_ptrace_read_fully(pid_t pid, uintptr_t addr, void *dst, size_t bytes);
 
+size_t xcd_util_process_vm_read(pid_t pid, uintptr_t addr, void *dst, size_t bytes);
+
+int xcd_util_ptrace_add_snapshot(uintptr_t addr, void *buf, size_t len);
+void xcd_util_ptrace_reset_snapshots(void);
+void xcd_util_ptrace_set_detached(void);
+
 int xcd_util_xz_decompress(uint8_t* src, size_t src_size, uint8_t** dst, size_t* dst_size);
+int xcd_util_xz_compress(int src_fd, size_t src_size, int dst_fd);
+int xcd_util_xz_compress_dict(int src_fd, size_t src_size, const uint8_t *dict, size_t dict_size, int dst_fd);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+# Copyright (c) 2019-present, iQIYI, Inc. All rights reserved.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+
+
+# Created by agent on 2026-10-17.
+
+"""Decompress the compressed native crash log files of xCrash on the host.
+
+  "*.native.xcrash.xz"    XZ streams (see "xcd_util_xz_compress()" in "xcd_util.c"),
+                          "xz -d" works too.
+  "*.native.xcrash.xcdz"  compressed with a preset dictionary (see "xcd_util_xz_compress_dict()"
+                          in "xcd_util.c"), optionally followed by the XZ streams appended later.
+
+The preset dictionary is the file "dictionary_<id>.dict.xcrash" in the log directory (see
+"TombstoneDict.java"), the ID is the CRC32 of the dictionary. Pull it from the device together with
+the log file, or pass it by "--dict".
+
+Usage: xcrash_unxz.py [--dict DICT_FILE] [-o OUTPUT_FILE] LOG_FILE
+"""
+
+import argparse
+import lzma
+import os
+import struct
+import sys
+import zlib
+
+XZ_MAGIC = b"\xfd7zXZ\x00"
+XCDZ_MAGIC = b"\xfdXCDZ\x00"
+XCDZ_HEADER_LEN = 15
+DICT_SIZE_MAX = 64 * 1024  # XCC_UTIL_XZ_DICT_SIZE_MAX in "xcc_util.h"
+LZMA2_CONTROL_COPY_RESET_DIC = 1
+LZMA2_CONTROL_COPY = 2
+LZMA2_COPY_CHUNK_SIZE_MAX = 1 << 16
+
+
+class FormatError(Exception):
+    pass
+
+
+def lzma2_dict_size(prop):
+    if prop > 40:
+        raise FormatError("invalid LZMA2 dictionary size")
+    if prop == 40:
+        return 0xFFFFFFFF
+    return (2 | (prop & 1)) << (prop // 2 + 11)
+
+
+def load_dict(log_path, dict_path, dict_id, dict_size):
+    if dict_path is None:
+        dict_path = os.path.join(os.path.dirname(os.path.abspath(log_path)),
+                                 "dictionary_%08x.dict.xcrash" % dict_id)
+    try:
+        with open(dict_path, "rb") as f:
+            data = f.read()
+    except IOError:
+        raise FormatError("dictionary not found: " + dict_path)
+    if len(data) != dict_size or (zlib.crc32(data) & 0xFFFFFFFF) != dict_id:
+        raise FormatError("dictionary mismatch: " + dict_path)
+    return data
+
+
+# the dictionary is fed to the decoder as stored chunks (the first one resets the dictionary),
+# the LZMA2 chunks in the file keep the dictionary and continue from it
+def decode_dict_member(data, dict_data, dict_size_prop):
+    raw = bytearray()
+    for pos in range(0, len(dict_data), LZMA2_COPY_CHUNK_SIZE_MAX):
+        chunk = dict_data[pos:pos + LZMA2_COPY_CHUNK_SIZE_MAX]
+        raw.append(LZMA2_CONTROL_COPY_RESET_DIC if pos == 0 else LZMA2_CONTROL_COPY)
+        raw += struct.pack(">H", len(chunk) - 1)
+        raw += chunk
+    raw += data
+
+    dec = lzma.LZMADecompressor(format=lzma.FORMAT_RAW, filters=[{
+        "id": lzma.FILTER_LZMA2,
+        "dict_size": max(lzma2_dict_size(dict_size_prop), len(dict_data), 4096)}])
+    try:
+        out = dec.decompress(bytes(raw))
+    except lzma.LZMAError as e:
+        raise FormatError("corrupted LZMA2 data: %s" % e)
+    if not dec.eof:
+        raise FormatError("truncated LZMA2 data")
+
+    out = out[len(dict_data):]
+    rest = dec.unused_data
+    if len(rest) < 4 or struct.unpack("<I", rest[:4])[0] != (zlib.crc32(out) & 0xFFFFFFFF):
+        raise FormatError("CRC32 mismatch")
+    return out, rest[4:]
+
+
+# the concatenated XZ streams, separated by the stream padding (multiple of 4 zero bytes)
+def decode_xz_streams(data):
+    out = bytearray()
+    while len(data) > 0:
+        stripped = data.lstrip(b"\x00")
+        if len(stripped) == 0:
+            break
+        if not stripped.startswith(XZ_MAGIC):
+            raise FormatError("not an XZ stream")
+        dec = lzma.LZMADecompressor(format=lzma.FORMAT_XZ)
+        try:
+            out += dec.decompress(stripped)
+        except lzma.LZMAError as e:
+            raise FormatError("corrupted XZ stream: %s" % e)
+        if not dec.eof:
+            raise FormatError("truncated XZ stream")
+        data = dec.unused_data
+    return bytes(out)
+
+
+def decompress(log_path, dict_path=None):
+    with open(log_path, "rb") as f:
+        data = f.read()
+
+    if data.startswith(XZ_MAGIC):
+        return decode_xz_streams(data)
+    if not data.startswith(XCDZ_MAGIC) or len(data) < XCDZ_HEADER_LEN:
+        raise FormatError("unknown format")
+
+    dict_id, dict_size = struct.unpack("<II", data[6:14])
+    if dict_size == 0 or dict_size > DICT_SIZE_MAX:
+        raise FormatError("invalid dictionary size")
+    dict_data = load_dict(log_path, dict_path, dict_id, dict_size)
+
+    out, rest = decode_dict_member(data[XCDZ_HEADER_LEN:], dict_data, data[14])
+    return out + decode_xz_streams(rest)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decompress the compressed native crash log file of xCrash.")
+    parser.add_argument("--dict", help="the preset dictionary file (default: found in the log directory by the ID)")
+    parser.add_argument("-o", "--output", help="the output file (default: stdout)")
+    parser.add_argument("log", help="the compressed log file (*.xz or *.xcdz)")
+    args = parser.parse_args()
+
+    try:
+        out = decompress(args.log, args.dict)
+    except (IOError, FormatError) as e:
+        sys.stderr.write("xcrash_unxz: %s: %s\n" % (args.log, e))
+        return 1
+
+    if args.output is None:
+        sys.stdout.buffer.write(out)
+    else:
+        with open(args.output, "wb") as f:
+            f.write(out)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())